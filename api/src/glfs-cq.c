@@ -0,0 +1,577 @@
+/*
+  Copyright (c) 2026 Red Hat, Inc. <http://www.redhat.com>
+  This file is part of GlusterFS.
+
+  This file is licensed to you under your choice of the GNU Lesser
+  General Public License, version 3 or any later version (LGPLv3 or
+  later), or the GNU General Public License, version 2 (GPLv2), in all
+  cases as published by the Free Software Foundation.
+*/
+
+/*
+ * Completion queues: ops are submitted without a callback, and their
+ * results are collected in batches by glfs_cq_wait() from whichever
+ * threads the application chooses.
+ *
+ * Reads, writes and fsyncs go through the existing *_async() calls, whose
+ * callback only queues the completion. Ops without an async form (the
+ * handle based metadata ops, glfs_pread_buf()) run the synchronous call
+ * in a synctask, so an op waiting on the network holds a task stack but
+ * no thread.
+ */
+
+#include "glfs-internal.h"
+#include "glfs-mem-types.h"
+#include <glusterfs/syncop.h>
+#include <glusterfs/syscall.h>
+#include "glfs.h"
+#include "glfs-handles.h"
+#include "gfapi-messages.h"
+
+extern int
+pub_glfs_preadv_async(struct glfs_fd *, const struct iovec *, int, off_t, int,
+                      glfs_io_cbk, void *);
+extern int
+pub_glfs_pwritev_async(struct glfs_fd *, const struct iovec *, int, off_t, int,
+                       glfs_io_cbk, void *);
+extern int
+pub_glfs_fsync_async(struct glfs_fd *, glfs_io_cbk, void *);
+extern ssize_t
+pub_glfs_pread_buf(struct glfs_fd *, size_t, off_t, int, glfs_buf_t **,
+                   struct glfs_stat *);
+extern void
+pub_glfs_buf_release(glfs_buf_t *);
+extern struct glfs_object *
+pub_glfs_h_lookupat(struct glfs *, struct glfs_object *, const char *,
+                    struct stat *, int);
+extern int
+pub_glfs_h_stat(struct glfs *, struct glfs_object *, struct stat *);
+extern struct glfs_object *
+pub_glfs_h_creat(struct glfs *, struct glfs_object *, const char *, int,
+                 mode_t, struct stat *);
+extern int
+pub_glfs_h_close(struct glfs_object *);
+
+struct glfs_cq {
+    struct glfs *fs;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    struct list_head done; /* completed ops, not yet reaped */
+    unsigned int depth;    /* max ops submitted and not reaped */
+    unsigned int inflight;
+    unsigned int ndone;
+    int notify[2]; /* readable while done is not empty */
+};
+
+struct glfs_cq_op {
+    struct list_head list;
+    glfs_cq_t *cq;
+    struct glfs_cqe cqe;
+
+    /* arguments of the ops run in a synctask */
+    int op;
+    struct glfs_fd *glfd;
+    struct glfs_object *object;
+    char *path;
+    size_t count;
+    off_t offset;
+    int flags;
+    mode_t mode;
+};
+
+GFAPI_SYMVER_PUBLIC_DEFAULT(glfs_cq_new, 10.0)
+glfs_cq_t *
+pub_glfs_cq_new(struct glfs *fs, unsigned int depth)
+{
+    glfs_cq_t *cq = NULL;
+
+    DECLARE_OLD_THIS;
+    __GLFS_ENTRY_VALIDATE_FS(fs, invalid_fs);
+
+    if (depth == 0) {
+        errno = EINVAL;
+        goto out;
+    }
+
+    cq = GF_CALLOC(1, sizeof(*cq), glfs_mt_glfs_cq_t);
+    if (!cq) {
+        errno = ENOMEM;
+        goto out;
+    }
+
+    if (pipe(cq->notify) == -1) {
+        GF_FREE(cq);
+        cq = NULL;
+        goto out;
+    }
+    (void)fcntl(cq->notify[0], F_SETFL, O_NONBLOCK);
+    (void)fcntl(cq->notify[1], F_SETFL, O_NONBLOCK);
+    (void)fcntl(cq->notify[0], F_SETFD, FD_CLOEXEC);
+    (void)fcntl(cq->notify[1], F_SETFD, FD_CLOEXEC);
+
+    cq->fs = fs;
+    cq->depth = depth;
+    INIT_LIST_HEAD(&cq->done);
+    pthread_mutex_init(&cq->mutex, NULL);
+    pthread_cond_init(&cq->cond, NULL);
+out:
+    __GLFS_EXIT_FS;
+
+invalid_fs:
+    return cq;
+}
+
+GFAPI_SYMVER_PUBLIC_DEFAULT(glfs_cq_fd, 10.0)
+int
+pub_glfs_cq_fd(glfs_cq_t *cq)
+{
+    if (!cq) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    return cq->notify[0];
+}
+
+static struct glfs_cq_op *
+glfs_cq_op_new(glfs_cq_t *cq, void *data)
+{
+    struct glfs_cq_op *op = NULL;
+
+    pthread_mutex_lock(&cq->mutex);
+    {
+        if (cq->inflight >= cq->depth) {
+            pthread_mutex_unlock(&cq->mutex);
+            errno = EAGAIN;
+            return NULL;
+        }
+        cq->inflight++;
+    }
+    pthread_mutex_unlock(&cq->mutex);
+
+    op = GF_CALLOC(1, sizeof(*op), glfs_mt_glfs_cq_op_t);
+    if (!op) {
+        pthread_mutex_lock(&cq->mutex);
+        cq->inflight--;
+        pthread_mutex_unlock(&cq->mutex);
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    INIT_LIST_HEAD(&op->list);
+    op->cq = cq;
+    op->cqe.data = data;
+
+    return op;
+}
+
+/* for an op that failed to be submitted */
+static void
+glfs_cq_op_cancel(struct glfs_cq_op *op)
+{
+    glfs_cq_t *cq = op->cq;
+
+    pthread_mutex_lock(&cq->mutex);
+    cq->inflight--;
+    pthread_mutex_unlock(&cq->mutex);
+
+    GF_FREE(op->path);
+    GF_FREE(op);
+}
+
+static void
+glfs_cq_complete(struct glfs_cq_op *op, ssize_t res, int op_errno)
+{
+    glfs_cq_t *cq = op->cq;
+    char c = 0;
+
+    op->cqe.res = (res < 0) ? -op_errno : res;
+
+    pthread_mutex_lock(&cq->mutex);
+    {
+        list_add_tail(&op->list, &cq->done);
+        if (cq->ndone++ == 0)
+            (void)sys_write(cq->notify[1], &c, 1);
+        pthread_cond_broadcast(&cq->cond);
+    }
+    pthread_mutex_unlock(&cq->mutex);
+}
+
+static void
+glfs_cq_io_cbk(glfs_fd_t *fd, ssize_t ret, struct glfs_stat *prestat,
+               struct glfs_stat *poststat, void *data)
+{
+    glfs_cq_complete(data, ret, errno);
+}
+
+GFAPI_SYMVER_PUBLIC_DEFAULT(glfs_cq_preadv, 10.0)
+int
+pub_glfs_cq_preadv(glfs_cq_t *cq, struct glfs_fd *glfd,
+                   const struct iovec *iov, int iovcnt, off_t offset,
+                   int flags, void *data)
+{
+    struct glfs_cq_op *op = NULL;
+
+    if (!cq) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    op = glfs_cq_op_new(cq, data);
+    if (!op)
+        return -1;
+
+    if (pub_glfs_preadv_async(glfd, iov, iovcnt, offset, flags, glfs_cq_io_cbk,
+                              op)) {
+        glfs_cq_op_cancel(op);
+        return -1;
+    }
+
+    return 0;
+}
+
+GFAPI_SYMVER_PUBLIC_DEFAULT(glfs_cq_pwritev, 10.0)
+int
+pub_glfs_cq_pwritev(glfs_cq_t *cq, struct glfs_fd *glfd,
+                    const struct iovec *iov, int iovcnt, off_t offset,
+                    int flags, void *data)
+{
+    struct glfs_cq_op *op = NULL;
+
+    if (!cq) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    op = glfs_cq_op_new(cq, data);
+    if (!op)
+        return -1;
+
+    if (pub_glfs_pwritev_async(glfd, iov, iovcnt, offset, flags,
+                               glfs_cq_io_cbk, op)) {
+        glfs_cq_op_cancel(op);
+        return -1;
+    }
+
+    return 0;
+}
+
+GFAPI_SYMVER_PUBLIC_DEFAULT(glfs_cq_fsync, 10.0)
+int
+pub_glfs_cq_fsync(glfs_cq_t *cq, struct glfs_fd *glfd, void *data)
+{
+    struct glfs_cq_op *op = NULL;
+
+    if (!cq) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    op = glfs_cq_op_new(cq, data);
+    if (!op)
+        return -1;
+
+    if (pub_glfs_fsync_async(glfd, glfs_cq_io_cbk, op)) {
+        glfs_cq_op_cancel(op);
+        return -1;
+    }
+
+    return 0;
+}
+
+enum glfs_cq_task_op {
+    GLFS_CQ_PREAD_BUF = 1,
+    GLFS_CQ_H_LOOKUPAT,
+    GLFS_CQ_H_STAT,
+    GLFS_CQ_H_CREAT,
+};
+
+static int
+glfs_cq_task(void *opaque)
+{
+    struct glfs_cq_op *op = opaque;
+    struct glfs *fs = op->cq->fs;
+    ssize_t res = -1;
+
+    switch (op->op) {
+        case GLFS_CQ_PREAD_BUF:
+            res = pub_glfs_pread_buf(op->glfd, op->count, op->offset,
+                                     op->flags, &op->cqe.buf, NULL);
+            break;
+        case GLFS_CQ_H_LOOKUPAT:
+            op->cqe.object = pub_glfs_h_lookupat(fs, op->object, op->path,
+                                                 &op->cqe.st, op->flags);
+            res = op->cqe.object ? 0 : -1;
+            break;
+        case GLFS_CQ_H_STAT:
+            res = pub_glfs_h_stat(fs, op->object, &op->cqe.st);
+            break;
+        case GLFS_CQ_H_CREAT:
+            op->cqe.object = pub_glfs_h_creat(fs, op->object, op->path,
+                                              op->flags, op->mode,
+                                              &op->cqe.st);
+            res = op->cqe.object ? 0 : -1;
+            break;
+        default:
+            errno = EINVAL;
+            break;
+    }
+
+    /* errno is read before the task can be moved to another thread */
+    glfs_cq_complete(op, res, errno);
+
+    return 0;
+}
+
+static int
+glfs_cq_task_submit(struct glfs_cq_op *op)
+{
+    struct glfs *fs = op->cq->fs;
+    int ret = -1;
+
+    DECLARE_OLD_THIS;
+    __GLFS_ENTRY_VALIDATE_FS(fs, invalid_fs);
+
+    ret = synctask_new(fs->ctx->env, glfs_cq_task, NULL, NULL, op);
+    if (ret)
+        errno = ENOMEM;
+
+    __GLFS_EXIT_FS;
+
+invalid_fs:
+    return ret;
+}
+
+GFAPI_SYMVER_PUBLIC_DEFAULT(glfs_cq_pread_buf, 10.0)
+int
+pub_glfs_cq_pread_buf(glfs_cq_t *cq, struct glfs_fd *glfd, size_t count,
+                      off_t offset, int flags, void *data)
+{
+    struct glfs_cq_op *op = NULL;
+
+    if (!cq || !glfd) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    op = glfs_cq_op_new(cq, data);
+    if (!op)
+        return -1;
+
+    op->op = GLFS_CQ_PREAD_BUF;
+    op->glfd = glfd;
+    op->count = count;
+    op->offset = offset;
+    op->flags = flags;
+
+    if (glfs_cq_task_submit(op)) {
+        glfs_cq_op_cancel(op);
+        return -1;
+    }
+
+    return 0;
+}
+
+GFAPI_SYMVER_PUBLIC_DEFAULT(glfs_cq_h_lookupat, 10.0)
+int
+pub_glfs_cq_h_lookupat(glfs_cq_t *cq, struct glfs_object *parent,
+                       const char *path, int follow, void *data)
+{
+    struct glfs_cq_op *op = NULL;
+
+    if (!cq || !path) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    op = glfs_cq_op_new(cq, data);
+    if (!op)
+        return -1;
+
+    op->op = GLFS_CQ_H_LOOKUPAT;
+    op->object = parent;
+    op->flags = follow;
+    op->path = gf_strdup(path);
+
+    if (!op->path || glfs_cq_task_submit(op)) {
+        glfs_cq_op_cancel(op);
+        errno = ENOMEM;
+        return -1;
+    }
+
+    return 0;
+}
+
+GFAPI_SYMVER_PUBLIC_DEFAULT(glfs_cq_h_stat, 10.0)
+int
+pub_glfs_cq_h_stat(glfs_cq_t *cq, struct glfs_object *object, void *data)
+{
+    struct glfs_cq_op *op = NULL;
+
+    if (!cq || !object) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    op = glfs_cq_op_new(cq, data);
+    if (!op)
+        return -1;
+
+    op->op = GLFS_CQ_H_STAT;
+    op->object = object;
+
+    if (glfs_cq_task_submit(op)) {
+        glfs_cq_op_cancel(op);
+        return -1;
+    }
+
+    return 0;
+}
+
+GFAPI_SYMVER_PUBLIC_DEFAULT(glfs_cq_h_creat, 10.0)
+int
+pub_glfs_cq_h_creat(glfs_cq_t *cq, struct glfs_object *parent,
+                    const char *path, int flags, mode_t mode, void *data)
+{
+    struct glfs_cq_op *op = NULL;
+
+    if (!cq || !parent || !path) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    op = glfs_cq_op_new(cq, data);
+    if (!op)
+        return -1;
+
+    op->op = GLFS_CQ_H_CREAT;
+    op->object = parent;
+    op->flags = flags;
+    op->mode = mode;
+    op->path = gf_strdup(path);
+
+    if (!op->path || glfs_cq_task_submit(op)) {
+        glfs_cq_op_cancel(op);
+        errno = ENOMEM;
+        return -1;
+    }
+
+    return 0;
+}
+
+/* Called with cq->mutex held. */
+static int
+__glfs_cq_reap(glfs_cq_t *cq, struct glfs_cqe *cqes, unsigned int max)
+{
+    struct glfs_cq_op *op = NULL;
+    char buf[64];
+    int n = 0;
+
+    while (n < max && !list_empty(&cq->done)) {
+        op = list_first_entry(&cq->done, struct glfs_cq_op, list);
+        list_del_init(&op->list);
+        cq->ndone--;
+        cq->inflight--;
+
+        cqes[n++] = op->cqe;
+        GF_FREE(op->path);
+        GF_FREE(op);
+    }
+
+    if (cq->ndone == 0) {
+        while (sys_read(cq->notify[0], buf, sizeof(buf)) > 0)
+            ;
+    }
+
+    return n;
+}
+
+GFAPI_SYMVER_PUBLIC_DEFAULT(glfs_cq_wait, 10.0)
+int
+pub_glfs_cq_wait(glfs_cq_t *cq, struct glfs_cqe *cqes, unsigned int max,
+                 unsigned int min, const struct timespec *timeout)
+{
+    struct timespec deadline = {
+        0,
+    };
+    int ret = 0;
+    int n = 0;
+
+    if (!cq || !cqes || max == 0 || min > max) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (timeout) {
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += timeout->tv_sec;
+        deadline.tv_nsec += timeout->tv_nsec;
+        if (deadline.tv_nsec >= 1000000000) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000;
+        }
+    }
+
+    pthread_mutex_lock(&cq->mutex);
+    {
+        /* nothing could ever complete the wait */
+        if (min > cq->inflight) {
+            pthread_mutex_unlock(&cq->mutex);
+            errno = EINVAL;
+            return -1;
+        }
+
+        while (cq->ndone < min) {
+            if (timeout)
+                ret = pthread_cond_timedwait(&cq->cond, &cq->mutex,
+                                             &deadline);
+            else
+                ret = pthread_cond_wait(&cq->cond, &cq->mutex);
+            if (ret == ETIMEDOUT)
+                break;
+        }
+
+        n = __glfs_cq_reap(cq, cqes, max);
+    }
+    pthread_mutex_unlock(&cq->mutex);
+
+    return n;
+}
+
+GFAPI_SYMVER_PUBLIC_DEFAULT(glfs_cq_destroy, 10.0)
+int
+pub_glfs_cq_destroy(glfs_cq_t *cq)
+{
+    struct glfs_cqe cqe;
+
+    if (!cq) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    /* Ops still in flight reference the queue, wait for them, and drop
+     * what the application did not reap. */
+    pthread_mutex_lock(&cq->mutex);
+    {
+        while (cq->inflight) {
+            while (cq->ndone == 0)
+                pthread_cond_wait(&cq->cond, &cq->mutex);
+
+            while (__glfs_cq_reap(cq, &cqe, 1)) {
+                if (cqe.object)
+                    pub_glfs_h_close(cqe.object);
+                if (cqe.buf)
+                    pub_glfs_buf_release(cqe.buf);
+            }
+        }
+    }
+    pthread_mutex_unlock(&cq->mutex);
+
+    sys_close(cq->notify[0]);
+    sys_close(cq->notify[1]);
+    pthread_cond_destroy(&cq->cond);
+    pthread_mutex_destroy(&cq->mutex);
+    GF_FREE(cq);
+
+    return 0;
+}
@@ -1838,6 +1838,268 @@ pub_glfs_pwrite(struct glfs_fd *glfd, const void *buf, size_t count,
     return ret;
 }
 
+static glfs_buf_t *
+glfs_buf_new(struct iobref *iobref, struct iovec *iov, int count)
+{
+    glfs_buf_t *buf = NULL;
+
+    buf = GF_CALLOC(1, sizeof(*buf), glfs_mt_glfs_buf_t);
+    if (!buf) {
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    buf->iobref = iobref_ref(iobref);
+    buf->iov = iov;
+    buf->count = count;
+    buf->size = iov_length(iov, count);
+
+    return buf;
+}
+
+GFAPI_SYMVER_PUBLIC_DEFAULT(glfs_buf_get, 10.0)
+glfs_buf_t *
+pub_glfs_buf_get(struct glfs *fs, size_t size)
+{
+    glfs_buf_t *buf = NULL;
+    struct iobref *iobref = NULL;
+    struct iobuf *iobuf = NULL;
+    struct iovec *iov = NULL;
+
+    DECLARE_OLD_THIS;
+    __GLFS_ENTRY_VALIDATE_FS(fs, invalid_fs);
+
+    if (size == 0 || size >= GF_UNIT_GB) {
+        errno = EINVAL;
+        goto out;
+    }
+
+    iobuf = iobuf_get2(fs->ctx->iobuf_pool, size);
+    iobref = iobref_new();
+    iov = GF_MALLOC(sizeof(*iov), gf_common_mt_iovec);
+    if (!iobuf || !iobref || !iov || iobref_add(iobref, iobuf)) {
+        errno = ENOMEM;
+        goto out;
+    }
+
+    iov->iov_base = iobuf_ptr(iobuf);
+    iov->iov_len = size;
+
+    buf = glfs_buf_new(iobref, iov, 1);
+    if (buf)
+        iov = NULL;
+out:
+    GF_FREE(iov);
+    if (iobref)
+        iobref_unref(iobref);
+    if (iobuf)
+        iobuf_unref(iobuf);
+
+    __GLFS_EXIT_FS;
+
+invalid_fs:
+    return buf;
+}
+
+GFAPI_SYMVER_PUBLIC_DEFAULT(glfs_buf_iov, 10.0)
+int
+pub_glfs_buf_iov(glfs_buf_t *buf, const struct iovec **iov)
+{
+    if (!buf || !iov) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    *iov = buf->iov;
+
+    return buf->count;
+}
+
+GFAPI_SYMVER_PUBLIC_DEFAULT(glfs_buf_release, 10.0)
+void
+pub_glfs_buf_release(glfs_buf_t *buf)
+{
+    if (!buf)
+        return;
+
+    iobref_unref(buf->iobref);
+    GF_FREE(buf->iov);
+    GF_FREE(buf);
+}
+
+GFAPI_SYMVER_PUBLIC_DEFAULT(glfs_pread_buf, 10.0)
+ssize_t
+pub_glfs_pread_buf(struct glfs_fd *glfd, size_t count, off_t offset,
+                   int flags, glfs_buf_t **buf, struct glfs_stat *poststat)
+{
+    xlator_t *subvol = NULL;
+    ssize_t ret = -1;
+    struct iovec *iov = NULL;
+    int cnt = 0;
+    struct iobref *iobref = NULL;
+    fd_t *fd = NULL;
+    struct iatt iatt = {
+        0,
+    };
+    dict_t *fop_attr = NULL;
+
+    DECLARE_OLD_THIS;
+    __GLFS_ENTRY_VALIDATE_FD(glfd, invalid_fs);
+
+    GF_REF_GET(glfd);
+
+    if (!buf) {
+        errno = EINVAL;
+        goto out;
+    }
+    *buf = NULL;
+
+    subvol = glfs_active_subvol(glfd->fs);
+    if (!subvol) {
+        ret = -1;
+        errno = EIO;
+        goto out;
+    }
+
+    fd = glfs_resolve_fd(glfd->fs, subvol, glfd);
+    if (!fd) {
+        ret = -1;
+        errno = EBADFD;
+        goto out;
+    }
+
+    ret = get_fop_attr_thrd_key(&fop_attr);
+    if (ret)
+        gf_msg_debug("gfapi", 0, "Getting leaseid from thread failed");
+
+    ret = syncop_readv(subvol, fd, count, offset, flags, &iov, &cnt, &iobref,
+                       &iatt, fop_attr, NULL);
+    DECODE_SYNCOP_ERR(ret);
+
+    if (ret >= 0 && poststat)
+        glfs_iatt_to_statx(glfd->fs, &iatt, poststat);
+
+    if (ret <= 0)
+        goto out;
+
+    /* the reply vector and its iobufs are handed over as they are */
+    *buf = glfs_buf_new(iobref, iov, cnt);
+    if (!*buf) {
+        ret = -1;
+        goto out;
+    }
+    iov = NULL;
+
+    glfd->offset = (offset + ret);
+out:
+    if (iov)
+        GF_FREE(iov);
+    if (iobref)
+        iobref_unref(iobref);
+
+    if (fd)
+        fd_unref(fd);
+    if (glfd)
+        GF_REF_PUT(glfd);
+    if (fop_attr)
+        dict_unref(fop_attr);
+
+    glfs_subvol_done(glfd->fs, subvol);
+
+    __GLFS_EXIT_FS;
+
+invalid_fs:
+    return ret;
+}
+
+GFAPI_SYMVER_PUBLIC_DEFAULT(glfs_pwrite_buf, 10.0)
+ssize_t
+pub_glfs_pwrite_buf(struct glfs_fd *glfd, glfs_buf_t *buf, size_t count,
+                    off_t offset, int flags, struct glfs_stat *prestat,
+                    struct glfs_stat *poststat)
+{
+    xlator_t *subvol = NULL;
+    ssize_t ret = -1;
+    struct iovec *iov = NULL;
+    int cnt = 0;
+    fd_t *fd = NULL;
+    struct iatt preiatt =
+                    {
+                        0,
+                    },
+                postiatt = {
+                    0,
+                };
+    dict_t *fop_attr = NULL;
+
+    DECLARE_OLD_THIS;
+    __GLFS_ENTRY_VALIDATE_FD(glfd, invalid_fs);
+
+    GF_REF_GET(glfd);
+
+    if (!buf || count == 0 || count > buf->size) {
+        errno = EINVAL;
+        goto out;
+    }
+
+    subvol = glfs_active_subvol(glfd->fs);
+    if (!subvol) {
+        ret = -1;
+        errno = EIO;
+        goto out;
+    }
+
+    fd = glfs_resolve_fd(glfd->fs, subvol, glfd);
+    if (!fd) {
+        ret = -1;
+        errno = EBADFD;
+        goto out;
+    }
+
+    /* the segments covering the first count bytes, no data is copied */
+    cnt = iov_subset(buf->iov, buf->count, 0, count, &iov, 0);
+    if (cnt <= 0) {
+        ret = -1;
+        errno = ENOMEM;
+        goto out;
+    }
+
+    ret = get_fop_attr_thrd_key(&fop_attr);
+    if (ret)
+        gf_msg_debug("gfapi", 0, "Getting leaseid from thread failed");
+
+    ret = syncop_writev(subvol, fd, iov, cnt, offset, buf->iobref, flags,
+                        &preiatt, &postiatt, fop_attr, NULL);
+    DECODE_SYNCOP_ERR(ret);
+
+    if (ret >= 0) {
+        if (prestat)
+            glfs_iatt_to_statx(glfd->fs, &preiatt, prestat);
+        if (poststat)
+            glfs_iatt_to_statx(glfd->fs, &postiatt, poststat);
+    }
+
+    if (ret <= 0)
+        goto out;
+
+    glfd->offset = (offset + ret);
+out:
+    GF_FREE(iov);
+    if (fd)
+        fd_unref(fd);
+    if (glfd)
+        GF_REF_PUT(glfd);
+    if (fop_attr)
+        dict_unref(fop_attr);
+
+    glfs_subvol_done(glfd->fs, subvol);
+
+    __GLFS_EXIT_FS;
+
+invalid_fs:
+    return ret;
+}
+
 extern glfs_t *
 pub_glfs_from_glfd(glfs_fd_t *);
 
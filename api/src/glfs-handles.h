@@ -350,6 +350,26 @@ uint32_t
 glfs_upcall_lease_get_lease_type(glfs_upcall_lease_t *arg) __THROW
     GFAPI_PUBLIC(glfs_upcall_lease_get_lease_type, 4.1.6);
 
+/*
+ * Handle ops submitted to a completion queue, see glfs_cq_new(). The
+ * stat of the object is returned in st of the completion, and the object
+ * looked up or created in its object, to be closed with glfs_h_close().
+ * @parent and @object must stay open until the op is reaped.
+ */
+int
+glfs_cq_h_lookupat(glfs_cq_t *cq, glfs_object_t *parent, const char *path,
+                   int follow, void *data) __THROW
+    GFAPI_PUBLIC(glfs_cq_h_lookupat, 10.0);
+
+int
+glfs_cq_h_stat(glfs_cq_t *cq, glfs_object_t *object, void *data) __THROW
+    GFAPI_PUBLIC(glfs_cq_h_stat, 10.0);
+
+int
+glfs_cq_h_creat(glfs_cq_t *cq, glfs_object_t *parent, const char *path,
+                int flags, mode_t mode, void *data) __THROW
+    GFAPI_PUBLIC(glfs_cq_h_creat, 10.0);
+
 __END_DECLS
 
 #endif /* !_GLFS_HANDLES_H */
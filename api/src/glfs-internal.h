@@ -294,6 +294,15 @@ struct glfs_xreaddirp_stat {
     uint32_t flags_handled;     /* final set of flags successfulyy handled */
 };
 
+/* A library buffer lent to the application, see glfs_buf_get() and
+ * glfs_pread_buf(). iov points into the iobufs held by iobref. */
+struct glfs_buf {
+    struct iobref *iobref;
+    struct iovec *iov;
+    int count;
+    size_t size;
+};
+
 #define DEFAULT_EVENT_POOL_SIZE 16384
 #define GF_MEMPOOL_COUNT_OF_DICT_T 4096
 #define GF_MEMPOOL_COUNT_OF_DATA_T (GF_MEMPOOL_COUNT_OF_DICT_T * 4)
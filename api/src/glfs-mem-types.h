@@ -30,6 +30,9 @@ enum glfs_mem_types_ {
     glfs_mt_upcall_inode_t,
     glfs_mt_realpath_t,
     glfs_mt_xreaddirp_stat_t,
+    glfs_mt_glfs_buf_t,
+    glfs_mt_glfs_cq_t,
+    glfs_mt_glfs_cq_op_t,
     glfs_mt_end
 };
 #endif
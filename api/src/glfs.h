@@ -748,6 +748,293 @@ glfs_pwritev_async(glfs_fd_t *fd, const struct iovec *iov, int count,
                    off_t offset, int flags, glfs_io_cbk fn, void *data) __THROW
     GFAPI_PUBLIC(glfs_pwritev_async, 6.0);
 
+// glfs_{pread,pwrite}_buf, zero-copy I/O on library buffers
+
+/*
+ * A glfs_buf_t is memory owned by the library and lent to the
+ * application, so that data need not be copied between the application
+ * and the buffers the library sends and receives.
+ *
+ * glfs_pread_buf() returns the reply of a read as a buffer, which may be
+ * made of several segments. glfs_buf_get() gives a single segment buffer
+ * for the application to fill and pass to glfs_pwrite_buf(). A buffer
+ * from glfs_pread_buf() may be passed to glfs_pwrite_buf() too.
+ *
+ * The memory stays valid until glfs_buf_release(), but it may be shared
+ * with caches of the library: the segments of a read buffer must not be
+ * modified, and a buffer must not be modified once it has been passed to
+ * glfs_pwrite_buf(), as the write may still be in flight behind the
+ * call's return.
+ */
+
+struct glfs_buf;
+typedef struct glfs_buf glfs_buf_t;
+
+/*
+  SYNOPSIS
+
+  glfs_buf_get: Get a library buffer to write from.
+
+  PARAMETERS
+
+  @fs: The 'virtual mount' object the buffer will be written to.
+
+  @size: Size of the buffer in bytes.
+
+  RETURN VALUES
+
+  NULL : Failure. @errno will be set with the type of failure.
+  Others : The buffer, a single segment of at least @size bytes.
+
+ */
+
+glfs_buf_t *
+glfs_buf_get(glfs_t *fs, size_t size) __THROW
+    GFAPI_PUBLIC(glfs_buf_get, 10.0);
+
+/*
+  SYNOPSIS
+
+  glfs_buf_iov: Segments of a library buffer.
+
+  PARAMETERS
+
+  @buf: The buffer.
+
+  @iov: Set to the array of segments, valid as long as @buf.
+
+  RETURN VALUES
+
+  The number of segments.
+
+ */
+
+int
+glfs_buf_iov(glfs_buf_t *buf, const struct iovec **iov) __THROW
+    GFAPI_PUBLIC(glfs_buf_iov, 10.0);
+
+/*
+  SYNOPSIS
+
+  glfs_buf_release: Give a library buffer back.
+
+  DESCRIPTION
+
+  Drops the application's reference on @buf, which came from
+  glfs_buf_get() or glfs_pread_buf(). Every buffer must be released
+  exactly once, and neither @buf nor the segments from glfs_buf_iov() may
+  be used afterwards.
+
+  The memory itself may outlive the call: a write of the buffer still in
+  flight, or a cache of the library, keeps its own reference and frees it
+  when done. Releasing a buffer right after glfs_pwrite_buf() returns is
+  therefore safe. A buffer is not tied to its fd and may be released
+  after glfs_close(), but not after glfs_fini() of its 'virtual mount'.
+
+  PARAMETERS
+
+  @buf: The buffer. NULL is ignored.
+
+ */
+
+void
+glfs_buf_release(glfs_buf_t *buf) __THROW
+    GFAPI_PUBLIC(glfs_buf_release, 10.0);
+
+/*
+  SYNOPSIS
+
+  glfs_pread_buf: Read into a buffer lent by the library.
+
+  PARAMETERS
+
+  @fd: The fd to read from.
+
+  @count: Number of bytes to read at most.
+
+  @offset: Offset to read from.
+
+  @flags: As for glfs_pread().
+
+  @buf: Set to the buffer holding the data on success, to be released
+  with glfs_buf_release(). Left NULL when nothing was read.
+
+  @poststat: As for glfs_pread().
+
+  RETURN VALUES
+
+  -1 : Failure. @errno will be set with the type of failure.
+  Others : Number of bytes read.
+
+ */
+
+ssize_t
+glfs_pread_buf(glfs_fd_t *fd, size_t count, off_t offset, int flags,
+               glfs_buf_t **buf, struct glfs_stat *poststat) __THROW
+    GFAPI_PUBLIC(glfs_pread_buf, 10.0);
+
+/*
+  SYNOPSIS
+
+  glfs_pwrite_buf: Write the first @count bytes of a library buffer.
+
+  DESCRIPTION
+
+  The buffer is not released, but must not be modified afterwards.
+
+  RETURN VALUES
+
+  -1 : Failure. @errno will be set with the type of failure.
+  Others : Number of bytes written.
+
+ */
+
+ssize_t
+glfs_pwrite_buf(glfs_fd_t *fd, glfs_buf_t *buf, size_t count, off_t offset,
+                int flags, struct glfs_stat *prestat,
+                struct glfs_stat *poststat) __THROW
+    GFAPI_PUBLIC(glfs_pwrite_buf, 10.0);
+
+// glfs_cq_*, completion queues for asynchronous ops
+
+/*
+ * A completion queue collects the results of the ops submitted to it,
+ * instead of calling back into the application for each of them. Any
+ * number of threads may submit and reap; the results come back in
+ * completion order, tagged with the @data pointer given at submission.
+ *
+ * glfs_cq_fd() gives a descriptor which polls readable while
+ * completions wait to be reaped, so that a queue can be driven from the
+ * application's own event loop.
+ *
+ * An fd must not be closed while ops on it are outstanding: the result
+ * of an op on a closed fd is dropped, and the queue then waits for it
+ * forever.
+ */
+
+struct glfs_cq;
+typedef struct glfs_cq glfs_cq_t;
+
+struct glfs_object;
+
+struct glfs_cqe {
+    void *data;  /* as given at submission */
+    ssize_t res; /* as returned by the synchronous call, or -errno */
+    struct stat st;             /* glfs_cq_h_* */
+    struct glfs_object *object; /* glfs_cq_h_lookupat, glfs_cq_h_creat */
+    glfs_buf_t *buf;            /* glfs_cq_pread_buf */
+};
+
+/*
+  SYNOPSIS
+
+  glfs_cq_new: Create a completion queue.
+
+  PARAMETERS
+
+  @fs: The 'virtual mount' object ops will be submitted on.
+
+  @depth: Maximum number of ops submitted and not yet reaped. Submitting
+  more fails with EAGAIN.
+
+  RETURN VALUES
+
+  NULL : Failure. @errno will be set with the type of failure.
+  Others : The queue, to be destroyed with glfs_cq_destroy().
+
+ */
+
+glfs_cq_t *
+glfs_cq_new(glfs_t *fs, unsigned int depth) __THROW
+    GFAPI_PUBLIC(glfs_cq_new, 10.0);
+
+int
+glfs_cq_fd(glfs_cq_t *cq) __THROW GFAPI_PUBLIC(glfs_cq_fd, 10.0);
+
+/*
+  SYNOPSIS
+
+  glfs_cq_preadv, glfs_cq_pwritev, glfs_cq_fsync, glfs_cq_pread_buf:
+  Submit an op on an fd.
+
+  DESCRIPTION
+
+  The arguments are those of the synchronous calls; @iov and the memory
+  it points to must stay valid until the op is reaped. res of the
+  completion is what the synchronous call would have returned, and buf
+  is the buffer of glfs_cq_pread_buf().
+
+  RETURN VALUES
+
+  -1 : Failure, nothing will complete. @errno will be set with the type
+  of failure.
+  0  : Submitted.
+
+ */
+
+int
+glfs_cq_preadv(glfs_cq_t *cq, glfs_fd_t *fd, const struct iovec *iov,
+               int iovcnt, off_t offset, int flags, void *data) __THROW
+    GFAPI_PUBLIC(glfs_cq_preadv, 10.0);
+
+int
+glfs_cq_pwritev(glfs_cq_t *cq, glfs_fd_t *fd, const struct iovec *iov,
+                int iovcnt, off_t offset, int flags, void *data) __THROW
+    GFAPI_PUBLIC(glfs_cq_pwritev, 10.0);
+
+int
+glfs_cq_fsync(glfs_cq_t *cq, glfs_fd_t *fd, void *data) __THROW
+    GFAPI_PUBLIC(glfs_cq_fsync, 10.0);
+
+int
+glfs_cq_pread_buf(glfs_cq_t *cq, glfs_fd_t *fd, size_t count, off_t offset,
+                  int flags, void *data) __THROW
+    GFAPI_PUBLIC(glfs_cq_pread_buf, 10.0);
+
+/*
+  SYNOPSIS
+
+  glfs_cq_wait: Reap completions.
+
+  PARAMETERS
+
+  @cq: The queue.
+
+  @cqes: Array of @max entries to fill.
+
+  @min: Wait until at least @min completions are ready, or @timeout has
+  passed. 0 only reaps what is ready.
+
+  @timeout: Relative time to wait at most, or NULL to wait for @min.
+
+  RETURN VALUES
+
+  -1 : Failure. @errno will be set with the type of failure; EINVAL if
+  fewer than @min ops are outstanding.
+  Others : Number of entries filled, up to @max.
+
+ */
+
+int
+glfs_cq_wait(glfs_cq_t *cq, struct glfs_cqe *cqes, unsigned int max,
+             unsigned int min, const struct timespec *timeout) __THROW
+    GFAPI_PUBLIC(glfs_cq_wait, 10.0);
+
+/*
+  SYNOPSIS
+
+  glfs_cq_destroy: Destroy a completion queue.
+
+  DESCRIPTION
+
+  Waits for the ops still outstanding. The objects and buffers of
+  completions not reaped are released.
+
+ */
+
+int
+glfs_cq_destroy(glfs_cq_t *cq) __THROW GFAPI_PUBLIC(glfs_cq_destroy, 10.0);
+
 off_t
 glfs_lseek(glfs_fd_t *fd, off_t offset, int whence) __THROW
     GFAPI_PUBLIC(glfs_lseek, 3.4.0);
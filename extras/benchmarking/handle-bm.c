@@ -0,0 +1,149 @@
+/*
+   Copyright (c) 2021 Red Hat, Inc. <http://www.redhat.com>
+   This file is part of GlusterFS.
+
+   This file is licensed to you under your choice of the GNU Lesser
+   General Public License, version 3 or any later version (LGPLv3 or
+   later), or the GNU General Public License, version 2 (GPLv2), in all
+   cases as published by the Free Software Foundation.
+*/
+
+/*
+  handle-bm: measures gfid based entry operations as a function of the
+  depth of the parent directory.
+
+  A chain of directories 64 levels deep is made under the volume root.
+  For each measured depth, files are created and unlinked through the
+  handle of the directory at that depth, which makes the brick resolve
+  the directory gfid to a path for every operation. Compare runs with
+  storage.handle-cache-size set to 0 and to a non-zero value.
+*/
+#define _GNU_SOURCE
+#define _FILE_OFFSET_BITS 64
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <glusterfs/api/glfs.h>
+#include <glusterfs/api/glfs-handles.h>
+
+#define MAX_DEPTH 64
+
+static double
+now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int
+run(glfs_t *fs, struct glfs_object *dir, int depth, int count)
+{
+    struct glfs_object *obj = NULL;
+    char name[64];
+    double start = 0;
+    double create = 0;
+    double unlink = 0;
+    int i = 0;
+
+    start = now();
+    for (i = 0; i < count; i++) {
+        snprintf(name, sizeof(name), "f%d", i);
+        obj = glfs_h_creat(fs, dir, name, O_RDWR, 0644, NULL);
+        if (!obj) {
+            perror("glfs_h_creat");
+            return -1;
+        }
+        glfs_h_close(obj);
+    }
+    create = now() - start;
+
+    start = now();
+    for (i = 0; i < count; i++) {
+        snprintf(name, sizeof(name), "f%d", i);
+        if (glfs_h_unlink(fs, dir, name) != 0) {
+            perror("glfs_h_unlink");
+            return -1;
+        }
+    }
+    unlink = now() - start;
+
+    printf("%5d %12.0f %12.0f\n", depth, count / create, count / unlink);
+    return 0;
+}
+
+int
+main(int argc, char *argv[])
+{
+    struct glfs_object *dirs[MAX_DEPTH + 1] = {
+        NULL,
+    };
+    struct glfs_object *root = NULL;
+    glfs_t *fs = NULL;
+    char name[64];
+    int count = 1000;
+    int depth = 0;
+    int ret = 1;
+
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s <volume> <host> [files per depth]\n",
+                argv[0]);
+        return 1;
+    }
+    if (argc > 3)
+        count = atoi(argv[3]);
+
+    fs = glfs_new(argv[1]);
+    if (!fs)
+        return 1;
+    glfs_set_volfile_server(fs, "tcp", argv[2], 24007);
+    glfs_set_logging(fs, "/dev/null", 0);
+    if (glfs_init(fs) != 0) {
+        perror("glfs_init");
+        goto out;
+    }
+
+    root = glfs_h_lookupat(fs, NULL, "/", NULL, 0);
+    if (!root) {
+        perror("glfs_h_lookupat");
+        goto out;
+    }
+
+    snprintf(name, sizeof(name), "handle-bm.%d", getpid());
+    dirs[0] = glfs_h_mkdir(fs, root, name, 0755, NULL);
+    for (depth = 1; dirs[depth - 1] && depth <= MAX_DEPTH; depth++) {
+        snprintf(name, sizeof(name), "d%d", depth);
+        dirs[depth] = glfs_h_mkdir(fs, dirs[depth - 1], name, 0755, NULL);
+    }
+    if (!dirs[MAX_DEPTH]) {
+        perror("glfs_h_mkdir");
+        goto cleanup;
+    }
+
+    printf("%5s %12s %12s\n", "depth", "creates/s", "unlinks/s");
+    for (depth = 1; depth <= MAX_DEPTH; depth *= 2) {
+        if (run(fs, dirs[depth], depth, count) != 0)
+            goto cleanup;
+    }
+    ret = 0;
+
+cleanup:
+    for (depth = MAX_DEPTH; depth >= 0; depth--) {
+        if (!dirs[depth])
+            continue;
+        glfs_h_close(dirs[depth]);
+        snprintf(name, sizeof(name), depth ? "d%d" : "handle-bm.%d",
+                 depth ? depth : getpid());
+        glfs_h_unlink(fs, depth ? dirs[depth - 1] : root, name);
+    }
+    glfs_h_close(root);
+out:
+    glfs_fini(fs);
+    return ret;
+}
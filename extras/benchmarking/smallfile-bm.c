@@ -0,0 +1,136 @@
+/*
+   Copyright (c) 2021 Red Hat, Inc. <http://www.redhat.com>
+   This file is part of GlusterFS.
+
+   This file is licensed to you under your choice of the GNU Lesser
+   General Public License, version 3 or any later version (LGPLv3 or
+   later), or the GNU General Public License, version 2 (GPLv2), in all
+   cases as published by the Free Software Foundation.
+*/
+
+/*
+  smallfile-bm: creates, reads back and deletes a number of small files
+  through gfapi and reports the rate of each phase.
+
+  Run it on a volume with the settings to compare (brick layout, ctime,
+  gfid2path, storage.mdata-flush-interval...). Client side caching only
+  hides the brick, so turn off performance.stat-prefetch,
+  performance.quick-read and performance.io-cache for the read phase to
+  reach the bricks.
+*/
+#define _GNU_SOURCE
+#define _FILE_OFFSET_BITS 64
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <glusterfs/api/glfs.h>
+
+static double
+now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void
+report(const char *phase, int count, size_t size, double secs)
+{
+    printf("%-8s %8d files %10.0f files/s %10.2f MB/s\n", phase, count,
+           count / secs, (double)count * size / secs / (1024 * 1024));
+}
+
+int
+main(int argc, char *argv[])
+{
+    glfs_t *fs = NULL;
+    glfs_fd_t *fd = NULL;
+    char path[256];
+    char dir[64];
+    char *buf = NULL;
+    size_t size = 4096;
+    double start = 0;
+    int count = 10000;
+    int ret = 1;
+    int i = 0;
+
+    if (argc < 3) {
+        fprintf(stderr,
+                "usage: %s <volume> <host> [files] [file size in bytes]\n",
+                argv[0]);
+        return 1;
+    }
+    if (argc > 3)
+        count = atoi(argv[3]);
+    if (argc > 4)
+        size = strtoul(argv[4], NULL, 0);
+
+    buf = malloc(size);
+    if (!buf)
+        return 1;
+    memset(buf, 0x5a, size);
+
+    fs = glfs_new(argv[1]);
+    if (!fs)
+        goto out;
+    glfs_set_volfile_server(fs, "tcp", argv[2], 24007);
+    glfs_set_logging(fs, "/dev/null", 0);
+    if (glfs_init(fs) != 0) {
+        perror("glfs_init");
+        goto out;
+    }
+
+    snprintf(dir, sizeof(dir), "/smallfile-bm.%d", getpid());
+    if (glfs_mkdir(fs, dir, 0755) != 0) {
+        perror("glfs_mkdir");
+        goto out;
+    }
+
+    start = now();
+    for (i = 0; i < count; i++) {
+        snprintf(path, sizeof(path), "%s/f%d", dir, i);
+        fd = glfs_creat(fs, path, O_WRONLY | O_EXCL, 0644);
+        if (!fd || glfs_write(fd, buf, size, 0) != (ssize_t)size) {
+            perror("create");
+            goto out;
+        }
+        glfs_close(fd);
+    }
+    report("create", count, size, now() - start);
+
+    start = now();
+    for (i = 0; i < count; i++) {
+        snprintf(path, sizeof(path), "%s/f%d", dir, i);
+        fd = glfs_open(fs, path, O_RDONLY);
+        if (!fd || glfs_read(fd, buf, size, 0) != (ssize_t)size) {
+            perror("read");
+            goto out;
+        }
+        glfs_close(fd);
+    }
+    report("read", count, size, now() - start);
+
+    start = now();
+    for (i = 0; i < count; i++) {
+        snprintf(path, sizeof(path), "%s/f%d", dir, i);
+        if (glfs_unlink(fs, path) != 0) {
+            perror("unlink");
+            goto out;
+        }
+    }
+    report("delete", count, size, now() - start);
+
+    glfs_rmdir(fs, dir);
+    ret = 0;
+out:
+    if (fs)
+        glfs_fini(fs);
+    free(buf);
+    return ret;
+}
@@ -259,6 +259,8 @@ static struct argp_option gf_options[] = {
      "disable/enable fuse event-history"},
     {"reader-thread-count", ARGP_READER_THREAD_COUNT_KEY, "INTEGER",
      OPTION_ARG_OPTIONAL, "set fuse reader thread count"},
+    {"fuse-max-write", ARGP_FUSE_MAX_WRITE_KEY, "SIZE", 0,
+     "largest read/write request size offered to fuse [default: 1MB]"},
     {"kernel-writeback-cache", ARGP_KERNEL_WRITEBACK_CACHE_KEY, "BOOL",
      OPTION_ARG_OPTIONAL, "enable fuse in-kernel writeback cache"},
     {"attr-times-granularity", ARGP_ATTR_TIMES_GRANULARITY_KEY, "NS",
@@ -495,6 +497,10 @@ set_fuse_mount_options(glusterfs_ctx_t *ctx, dict_t *options)
         DICT_SET_VAL(dict_set_uint32, options, "reader-thread-count",
                      cmd_args->reader_thread_count, glusterfsd_msg_3);
     }
+    if (cmd_args->fuse_max_write) {
+        DICT_SET_VAL(dict_set_static_ptr, options, "fuse-max-write",
+                     cmd_args->fuse_max_write, glusterfsd_msg_3);
+    }
 
     DICT_SET_VAL(dict_set_uint32, options, "auto-invalidation",
                  cmd_args->fuse_auto_inval, glusterfsd_msg_3);
@@ -759,6 +765,7 @@ parse_opts(int key, char *arg, struct argp_state *state)
 {
     cmd_args_t *cmd_args = NULL;
     uint32_t n = 0;
+    uint64_t size = 0;
 #ifdef GF_LINUX_HOST_OS
     int32_t k = 0;
     struct oom_api_info *api = NULL;
@@ -1297,6 +1304,19 @@ parse_opts(int key, char *arg, struct argp_state *state)
 
             break;
 
+        case ARGP_FUSE_MAX_WRITE_KEY:
+            if (gf_string2bytesize_uint64(arg, &size) ||
+                (size < 128 * GF_UNIT_KB) || (size > 16 * GF_UNIT_MB)) {
+                argp_failure(state, -1, 0,
+                             "Invalid fuse max write size %s. "
+                             "Valid range: [\"128KB, 16MB\"]",
+                             arg);
+                break;
+            }
+
+            cmd_args->fuse_max_write = gf_strdup(arg);
+            break;
+
         case ARGP_KERNEL_WRITEBACK_CACHE_KEY:
             if (!arg)
                 arg = "yes";
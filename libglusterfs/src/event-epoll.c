@@ -1017,6 +1017,31 @@ unlock:
     return ret;
 }
 
+static int
+event_clear_error_epoll(struct event_pool *event_pool, int fd, int idx,
+                        int gen)
+{
+    struct event_slot_epoll *slot = NULL;
+
+    slot = event_slot_get(event_pool, idx);
+    if (!slot) {
+        gf_smsg("epoll", GF_LOG_ERROR, 0, LG_MSG_SLOT_NOT_FOUND, "fd=%d", fd,
+                "idx=%d", idx, NULL);
+        return -1;
+    }
+
+    LOCK(&slot->lock);
+    {
+        if (gen == slot->gen)
+            slot->handled_error = 0;
+    }
+    UNLOCK(&slot->lock);
+
+    event_slot_unref(event_pool, slot, idx);
+
+    return 0;
+}
+
 struct event_ops event_ops_epoll = {
     .new = event_pool_new_epoll,
     .event_register = event_register_epoll,
@@ -1027,6 +1052,7 @@ struct event_ops event_ops_epoll = {
     .event_reconfigure_threads = event_reconfigure_threads_epoll,
     .event_pool_destroy = event_pool_destroy_epoll,
     .event_handled = event_handled_epoll,
+    .event_clear_error = event_clear_error_epoll,
 };
 
 #endif
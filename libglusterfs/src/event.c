@@ -303,3 +303,17 @@ gf_event_handled(struct event_pool *event_pool, int fd, int idx, int gen)
 
     return ret;
 }
+
+/* Called from within a handler that found the error it was given to be
+ * spurious (e.g. only MSG_ZEROCOPY completions on the socket error queue),
+ * so that later events on the fd are still delivered. */
+int
+gf_event_clear_error(struct event_pool *event_pool, int fd, int idx, int gen)
+{
+    int ret = 0;
+
+    if (event_pool->ops->event_clear_error)
+        ret = event_pool->ops->event_clear_error(event_pool, fd, idx, gen);
+
+    return ret;
+}
@@ -136,7 +136,8 @@ enum gf_lease_types_t {
     NONE = 0,
     GF_RD_LEASE = 1,
     GF_RW_LEASE = 2,
-    GF_LEASE_MAX_TYPE = 2 + 1,
+    GF_DIR_LEASE = 4,
+    GF_LEASE_MAX_TYPE = 4 + 1,
 };
 typedef enum gf_lease_types_t gf_lease_types_t;
 
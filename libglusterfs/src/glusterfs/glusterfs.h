@@ -199,6 +199,9 @@ enum gf_internal_fop_indicator {
 
 #define GLUSTERFS_WRITE_IS_APPEND "glusterfs.write-is-append"
 #define GLUSTERFS_WRITE_UPDATE_ATOMIC "glusterfs.write-update-atomic"
+/* ftruncate which only frees the blocks preallocated past the end of the
+ * file. It does nothing when the size is not the offset any more. */
+#define GLUSTERFS_TRIM_PREALLOC "glusterfs.trim-prealloc"
 #define GLUSTERFS_OPEN_FD_COUNT "glusterfs.open-fd-count"
 #define GLUSTERFS_ACTIVE_FD_COUNT "glusterfs.open-active-fd-count"
 #define GLUSTERFS_INODELK_COUNT "glusterfs.inodelk-count"
@@ -583,6 +586,7 @@ struct _cmd_args {
     bool brick_mux;
 
     uint32_t fuse_dev_eperm_ratelimit_ns;
+    char *fuse_max_write;
 };
 typedef struct _cmd_args cmd_args_t;
 
@@ -130,6 +130,10 @@ struct syncenv {
 
     int destroy; /* FLAG to mark syncenv is in destroy mode
                     so that no more synctasks are accepted*/
+
+    gf_boolean_t async; /* tasks are run by the gf_async thread pool
+                           instead of syncprocs of our own */
+    int tasks;          /* live tasks, only counted when @async */
 };
 
 typedef enum { LOCK_NULL = 0, LOCK_TASK, LOCK_THREAD } lock_type_t;
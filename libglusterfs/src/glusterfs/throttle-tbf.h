@@ -20,7 +20,8 @@ typedef enum tbf_ops {
     TBF_OP_HASH = 0,    /* checksum calculation  */
     TBF_OP_READ = 1,    /* inode read(s)         */
     TBF_OP_READDIR = 2, /* dentry read(s)        */
-    TBF_OP_MAX = 3,
+    TBF_OP_RECLAIM = 3, /* space freed           */
+    TBF_OP_MAX = 4,
 } tbf_ops_t;
 
 /**
@@ -68,6 +69,9 @@ tbf_mod(tbf_t *, tbf_opspec_t *);
 void
 tbf_throttle(tbf_t *, tbf_ops_t, unsigned long);
 
+void
+tbf_fini(tbf_t *);
+
 #define TBF_THROTTLE_BEGIN(tbf, op, tokens) (tbf_throttle(tbf, op, tokens))
 #define TBF_THROTTLE_END(tbf, op, tokens)
 
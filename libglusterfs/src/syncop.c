@@ -8,7 +8,10 @@
   cases as published by the Free Software Foundation.
 */
 
+#include <sys/mman.h>
+
 #include "glusterfs/syncop.h"
+#include "glusterfs/async.h"
 #include "glusterfs/libglusterfs-messages.h"
 
 #ifdef HAVE_TSAN_API
@@ -158,9 +161,128 @@ out:
     return ret;
 }
 
+/* Stacks are mapped with a guard page below them, so that an overflow
+ * faults instead of corrupting the neighbouring allocation, and only the
+ * pages a task touches are ever backed by memory. Freed stacks are kept
+ * for reuse, up to SYNCSTACK_CACHE_MAX of them. */
+#define SYNCSTACK_CACHE_MAX 256
+
+struct syncstack_free {
+    struct syncstack_free *next;
+    size_t size;
+};
+
+static struct {
+    pthread_mutex_t lock;
+    struct syncstack_free *head;
+    uint32_t count;
+} syncstack_cache = {PTHREAD_MUTEX_INITIALIZER, NULL, 0};
+
+static size_t
+syncstack_guard_size(void)
+{
+    static size_t pagesize = 0;
+
+    if (!pagesize)
+        pagesize = sysconf(_SC_PAGESIZE);
+
+    return pagesize;
+}
+
+static void *
+syncstack_get(size_t size)
+{
+    struct syncstack_free **prev = NULL;
+    struct syncstack_free *stack = NULL;
+    size_t guard = syncstack_guard_size();
+    char *base = NULL;
+
+    pthread_mutex_lock(&syncstack_cache.lock);
+    {
+        for (prev = &syncstack_cache.head; *prev; prev = &(*prev)->next) {
+            if ((*prev)->size == size) {
+                stack = *prev;
+                *prev = stack->next;
+                syncstack_cache.count--;
+                break;
+            }
+        }
+    }
+    pthread_mutex_unlock(&syncstack_cache.lock);
+
+    if (stack)
+        return stack;
+
+    base = mmap(NULL, size + guard, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED)
+        return NULL;
+
+    if (mprotect(base, guard, PROT_NONE) != 0) {
+        munmap(base, size + guard);
+        return NULL;
+    }
+
+    return base + guard;
+}
+
+static void
+syncstack_put(void *stack, size_t size)
+{
+    struct syncstack_free *free_stack = stack;
+
+    pthread_mutex_lock(&syncstack_cache.lock);
+    {
+        if (syncstack_cache.count < SYNCSTACK_CACHE_MAX) {
+            free_stack->size = size;
+            free_stack->next = syncstack_cache.head;
+            syncstack_cache.head = free_stack;
+            syncstack_cache.count++;
+            stack = NULL;
+        }
+    }
+    pthread_mutex_unlock(&syncstack_cache.lock);
+
+    if (stack)
+        munmap((char *)stack - syncstack_guard_size(),
+               size + syncstack_guard_size());
+}
+
+/* What a synctask needs to be run by the gf_async thread pool. It's kept
+ * out of struct synctask so that syncop.h doesn't depend on urcu. */
+typedef struct {
+    struct synctask task;
+    gf_async_t async;
+    gf_lock_t lock; /* protects the task state when env->async, in place
+                       of env->mutex */
+} synctask_async_t;
+
+#define synctask_async(_task) caa_container_of(_task, synctask_async_t, task)
+
+static void
+synctask_lock(struct synctask *task)
+{
+    if (task->env->async)
+        LOCK(&synctask_async(task)->lock);
+    else
+        pthread_mutex_lock(&task->env->mutex);
+}
+
+static void
+synctask_unlock(struct synctask *task)
+{
+    if (task->env->async)
+        UNLOCK(&synctask_async(task)->lock);
+    else
+        pthread_mutex_unlock(&task->env->mutex);
+}
+
 void *
 syncenv_processor(void *thdata);
 
+static void
+synctask_async_run(xlator_t *xl, gf_async_t *async);
+
 static void
 __run(struct synctask *task)
 {
@@ -178,7 +300,8 @@ __run(struct synctask *task)
             gf_msg_debug(task->xl->name, 0,
                          "re-running already running"
                          " task");
-            env->runcount--;
+            if (!env->async)
+                env->runcount--;
             break;
         case SYNCTASK_WAIT:
             break;
@@ -193,9 +316,17 @@ __run(struct synctask *task)
             return;
     }
 
-    list_add_tail(&task->all_tasks, &env->runq);
     task->state = SYNCTASK_RUN;
 
+    if (env->async) {
+        /* Queued once: a wake before it runs must not queue it again. */
+        task->slept = 0;
+        gf_async(&synctask_async(task)->async, task->xl, synctask_async_run);
+        return;
+    }
+
+    list_add_tail(&task->all_tasks, &env->runq);
+
     env->runcount++;
 
     total = env->procs + env->runcount - env->procs_idle;
@@ -230,7 +361,8 @@ __wait(struct synctask *task)
         case SYNCTASK_SUSPEND:
             break;
         case SYNCTASK_RUN:
-            env->runcount--;
+            if (!env->async)
+                env->runcount--;
             break;
         case SYNCTASK_WAIT:
             gf_msg(task->xl->name, GF_LOG_WARNING, 0, LG_MSG_REWAITING_TASK,
@@ -247,7 +379,8 @@ __wait(struct synctask *task)
             return;
     }
 
-    list_add_tail(&task->all_tasks, &env->waitq);
+    if (!env->async)
+        list_add_tail(&task->all_tasks, &env->waitq);
     task->state = SYNCTASK_WAIT;
 }
 
@@ -305,17 +438,14 @@ __synctask_wake(struct synctask *task)
     if (task->slept)
         __run(task);
 
-    pthread_cond_broadcast(&task->env->cond);
+    if (!task->env->async)
+        pthread_cond_broadcast(&task->env->cond);
 }
 
 void
 synctask_wake(struct synctask *task)
 {
-    struct syncenv *env = NULL;
-
-    env = task->env;
-
-    pthread_mutex_lock(&env->mutex);
+    synctask_lock(task);
     {
         if (task->timer != NULL) {
             if (gf_timer_call_cancel(task->xl->ctx, task->timer) != 0) {
@@ -329,7 +459,7 @@ synctask_wake(struct synctask *task)
         __synctask_wake(task);
     }
 unlock:
-    pthread_mutex_unlock(&env->mutex);
+    synctask_unlock(task);
 }
 
 void
@@ -356,7 +486,7 @@ synctask_destroy(struct synctask *task)
     if (!task)
         return;
 
-    GF_FREE(task->stack);
+    syncstack_put(task->stack, task->ctx.uc_stack.ss_size);
 
     if (task->opframe && (task->opframe != task->frame))
         STACK_DESTROY(task->opframe->root);
@@ -366,6 +496,8 @@ synctask_destroy(struct synctask *task)
         pthread_cond_destroy(&task->cond);
     }
 
+    LOCK_DESTROY(&synctask_async(task)->lock);
+
 #ifdef HAVE_TSAN_API
     __tsan_destroy_fiber(task->tsan.fiber);
 #endif
@@ -409,8 +541,10 @@ struct synctask *
 synctask_create(struct syncenv *env, size_t stacksize, synctask_fn_t fn,
                 synctask_cbk_t cbk, call_frame_t *frame, void *opaque)
 {
+    synctask_async_t *newasync = NULL;
     struct synctask *newtask = NULL;
     xlator_t *this = THIS;
+    size_t pagesize = syncstack_guard_size();
     int destroymode = 0;
 
     VALIDATE_OR_GOTO(env, err);
@@ -429,9 +563,11 @@ synctask_create(struct syncenv *env, size_t stacksize, synctask_fn_t fn,
     if (destroymode)
         return NULL;
 
-    newtask = GF_CALLOC(1, sizeof(*newtask), gf_common_mt_synctask);
-    if (!newtask)
+    newasync = GF_CALLOC(1, sizeof(*newasync), gf_common_mt_synctask);
+    if (!newasync)
         return NULL;
+    newtask = &newasync->task;
+    LOCK_INIT(&newasync->lock);
 
     newtask->frame = frame;
     if (!frame) {
@@ -464,17 +600,15 @@ synctask_create(struct syncenv *env, size_t stacksize, synctask_fn_t fn,
         goto err;
     }
 
-    if (stacksize <= 0) {
-        newtask->stack = GF_CALLOC(1, env->stacksize, gf_common_mt_syncstack);
-        newtask->ctx.uc_stack.ss_size = env->stacksize;
-    } else {
-        newtask->stack = GF_CALLOC(1, stacksize, gf_common_mt_syncstack);
-        newtask->ctx.uc_stack.ss_size = stacksize;
-    }
+    if (stacksize <= 0)
+        stacksize = env->stacksize;
+    stacksize = (stacksize + pagesize - 1) & ~(pagesize - 1);
 
+    newtask->stack = syncstack_get(stacksize);
     if (!newtask->stack) {
         goto err;
     }
+    newtask->ctx.uc_stack.ss_size = stacksize;
 
     newtask->ctx.uc_stack.ss_sp = newtask->stack;
 
@@ -497,15 +631,20 @@ synctask_create(struct syncenv *env, size_t stacksize, synctask_fn_t fn,
         newtask->done = 0;
     }
 
+    if (env->async)
+        uatomic_inc(&env->tasks);
+
     synctask_wake(newtask);
 
     return newtask;
 err:
     if (newtask) {
-        GF_FREE(newtask->stack);
+        if (newtask->stack)
+            syncstack_put(newtask->stack, stacksize);
         if (newtask->opframe && (newtask->opframe != newtask->frame))
             STACK_DESTROY(newtask->opframe->root);
-        GF_FREE(newtask);
+        LOCK_DESTROY(&newasync->lock);
+        GF_FREE(newasync);
     }
 
     return NULL;
@@ -633,14 +772,25 @@ synctask_timer(void *data)
         task->ret = -ETIMEDOUT;
     }
 
-    pthread_mutex_lock(&task->env->mutex);
+    synctask_lock(task);
 
     gf_timer_call_cancel(task->xl->ctx, task->timer);
     task->timer = NULL;
 
     __synctask_wake(task);
 
-    pthread_mutex_unlock(&task->env->mutex);
+    synctask_unlock(task);
+}
+
+static void
+syncenv_task_gone(struct syncenv *env)
+{
+    if (uatomic_add_return(&env->tasks, -1) == 0) {
+        /* syncenv_destroy() may be waiting for the last one */
+        pthread_mutex_lock(&env->mutex);
+        pthread_cond_broadcast(&env->cond);
+        pthread_mutex_unlock(&env->mutex);
+    }
 }
 
 void
@@ -669,10 +819,12 @@ synctask_switchto(struct synctask *task)
 
     if (task->state == SYNCTASK_DONE) {
         synctask_done(task);
+        if (env->async)
+            syncenv_task_gone(env);
         return;
     }
 
-    pthread_mutex_lock(&env->mutex);
+    synctask_lock(task);
     {
         if (task->woken) {
             __run(task);
@@ -688,7 +840,40 @@ synctask_switchto(struct synctask *task)
 
         task->delta = NULL;
     }
-    pthread_mutex_unlock(&env->mutex);
+    synctask_unlock(task);
+}
+
+/* Scheduler context of a gf_async worker, for the synctasks it runs. */
+static __thread struct syncproc syncenv_async_proc;
+
+static void
+synctask_async_run(xlator_t *xl, gf_async_t *async)
+{
+    synctask_async_t *sa = caa_container_of(async, synctask_async_t, async);
+    struct syncproc *proc = &syncenv_async_proc;
+    struct synctask *task = &sa->task;
+
+#ifdef HAVE_TSAN_API
+    if (proc->tsan.fiber == NULL) {
+        proc->tsan.fiber = __tsan_create_fiber(0);
+        snprintf(proc->tsan.name, TSAN_THREAD_NAMELEN,
+                 "<sched of async worker@%p>", proc);
+        __tsan_set_fiber_name(proc->tsan.fiber, proc->tsan.name);
+    }
+#endif
+
+    LOCK(&sa->lock);
+    {
+        task->woken = 0;
+        task->slept = 0;
+        task->proc = proc;
+    }
+    UNLOCK(&sa->lock);
+
+    synctask_switchto(task);
+
+    /* The worker goes on with jobs which are not synctasks. */
+    synctask_set(NULL);
 }
 
 void *
@@ -748,7 +933,7 @@ syncenv_destroy(struct syncenv *env)
         /* when the syncenv_task() thread is exiting, it broadcasts to
          * wake the below wait.
          */
-        while (env->procs != 0) {
+        while (env->procs != 0 || uatomic_read(&env->tasks) != 0) {
             pthread_cond_wait(&env->cond, &env->mutex);
         }
     }
@@ -795,7 +980,11 @@ syncenv_new(size_t stacksize, int procmin, int procmax)
     newenv->procmax = procmax;
     newenv->procs_idle = 0;
 
-    for (i = 0; i < newenv->procmin; i++) {
+    /* With the global thread pool running there is no need for threads of
+     * our own: runnable tasks are queued to it like any other job. */
+    newenv->async = gf_async_ctrl.enabled;
+
+    for (i = 0; !newenv->async && i < newenv->procmin; i++) {
         newenv->proc[i].env = newenv;
         ret = gf_thread_create(&newenv->proc[i].processor, NULL,
                                syncenv_processor, &newenv->proc[i], "sproc%d",
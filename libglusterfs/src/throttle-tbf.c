@@ -86,16 +86,17 @@ _tbf_dispatch_queued(tbf_bucket_t *bucket)
     }
 }
 
+/**
+ * Rate and limit are read on every tick, so that tbf_mod() takes effect
+ * without restarting the generator. A zero rate leaves the bucket
+ * unthrottled, see tbf_mod_bucket().
+ */
 void *
 tbf_tokengenerator(void *arg)
 {
-    unsigned long tokenrate = 0;
-    unsigned long maxtokens = 0;
     unsigned long token_gen_interval = 0;
     tbf_bucket_t *bucket = arg;
 
-    tokenrate = bucket->tokenrate;
-    maxtokens = bucket->maxtokens;
     token_gen_interval = bucket->token_gen_interval;
 
     while (1) {
@@ -103,13 +104,17 @@ tbf_tokengenerator(void *arg)
 
         LOCK(&bucket->lock);
         {
-            bucket->tokens += tokenrate;
-            if (bucket->tokens > maxtokens)
-                bucket->tokens = maxtokens;
+            if (!bucket->tokenrate)
+                goto unlock;
+
+            bucket->tokens += bucket->tokenrate;
+            if (bucket->tokens > bucket->maxtokens)
+                bucket->tokens = bucket->maxtokens;
 
             if (!list_empty(&bucket->queued))
                 _tbf_dispatch_queued(bucket);
         }
+    unlock:
         UNLOCK(&bucket->lock);
     }
 
@@ -208,6 +213,13 @@ tbf_mod_bucket(tbf_bucket_t *bucket, tbf_opspec_t *spec)
         bucket->tokens = 0;
         bucket->tokenrate = spec->rate;
         bucket->maxtokens = spec->maxlimit;
+
+        /* no rate? no throttling: let the queued requests go now */
+        if (!spec->rate) {
+            bucket->tokens = ULONG_MAX;
+            _tbf_dispatch_queued(bucket);
+            bucket->tokens = 0;
+        }
     }
     UNLOCK(&bucket->lock);
 
@@ -260,6 +272,9 @@ tbf_throttle(tbf_t *tbf, tbf_ops_t op, unsigned long tokens_requested)
          * to throttle the request: therefore, consume the required
          * number of tokens and continue.
          */
+        if (!bucket->tokenrate) /* throttling turned off by tbf_mod() */
+            goto unblock;
+
         if (tokens_requested <= bucket->tokens) {
             bucket->tokens -= tokens_requested;
         } else {
@@ -288,3 +303,32 @@ unblock:
         GF_FREE(throttle);
     }
 }
+
+/**
+ * Stop the token generators and free @tbf. Nobody may be throttled on
+ * it any more.
+ */
+void
+tbf_fini(tbf_t *tbf)
+{
+    int32_t i = 0;
+    tbf_bucket_t *bucket = NULL;
+
+    if (!tbf)
+        return;
+
+    for (i = 0; i < TBF_OP_MAX; i++) {
+        bucket = *(tbf->bucket + i);
+        if (!bucket)
+            continue;
+
+        /* the generator only sleeps outside of the bucket lock */
+        (void)pthread_cancel(bucket->tokener);
+        (void)pthread_join(bucket->tokener, NULL);
+
+        LOCK_DESTROY(&bucket->lock);
+        GF_FREE(bucket);
+    }
+
+    GF_FREE(tbf);
+}
@@ -351,6 +351,9 @@ rpc_transport_load(glusterfs_ctx_t *ctx, dict_t *options, char *trans_name)
 
     INIT_LIST_HEAD(&trans->list);
     GF_ATOMIC_INIT(trans->disconnect_progress, 0);
+    GF_ATOMIC_INIT(trans->fq_depth, 0);
+    GF_ATOMIC_INIT(trans->fq_dispatched, 0);
+    GF_ATOMIC_INIT(trans->fq_wait_usec, 0);
 
     return_trans = trans;
 
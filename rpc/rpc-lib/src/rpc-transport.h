@@ -206,6 +206,11 @@ struct rpc_transport {
     gf_boolean_t connect_failed;
     char notify_poller_death;
     char poller_death_accept;
+
+    /* rpcsvc fair-share queueing of the requests from this connection */
+    gf_atomic_t fq_depth;
+    gf_atomic_t fq_dispatched;
+    gf_atomic_t fq_wait_usec;
 };
 
 struct rpc_transport_pollin {
@@ -77,6 +77,11 @@ typedef struct rpcsvc_state {
     gf_boolean_t register_portmap;
     gf_boolean_t root_squash;
     gf_boolean_t all_squash;
+
+    /* deficit round robin between clients in the request queues */
+    gf_boolean_t fair_share;
+    int fq_weight;
+    int fq_weight_internal;
 } rpcsvc_t;
 
 /* DRC START */
@@ -82,6 +82,111 @@ rpcsvc_toggle_queue_status(rpcsvc_program_t *prog,
                                                       __BITS_PER_LONG));
 }
 
+static gf_boolean_t
+__rpcsvc_queue_empty(rpcsvc_request_queue_t *queue)
+{
+    return list_empty(&queue->request_queue) &&
+           list_empty(&queue->fq_express) && list_empty(&queue->fq_flows);
+}
+
+/* Requests are grouped per client (the client_t the connection is bound to,
+ * so all connections of one mount share a flow) and the flows are served
+ * deficit round robin, with the message size as the cost. The weight goes
+ * by the pid of each request, so the internal requests of a client (e.g.
+ * self-heal from a mount) get a flow of their own. */
+static void
+__rpcsvc_queue_request(rpcsvc_t *svc, rpcsvc_request_queue_t *queue,
+                       rpcsvc_request_t *req, rpcsvc_actor_t *actor)
+{
+    rpcsvc_fq_flow_t *flow = NULL;
+    void *key = NULL;
+    gf_boolean_t internal = (req->pid < 0);
+
+    if (!svc->fair_share) {
+        list_add_tail(&req->request_list, &queue->request_queue);
+        return;
+    }
+
+    timespec_now(&req->queued);
+    GF_ATOMIC_INC(req->trans->fq_depth);
+
+    if (actor->express) {
+        list_add_tail(&req->request_list, &queue->fq_express);
+        return;
+    }
+
+    key = req->trans->xl_private ? (void *)req->trans->xl_private
+                                 : (void *)req->trans;
+
+    list_for_each_entry(flow, &queue->fq_flows, list)
+    {
+        if ((flow->key == key) && (flow->internal == internal))
+            goto queue;
+    }
+
+    flow = GF_CALLOC(1, sizeof(*flow), gf_common_mt_rpcsvc_fq_flow_t);
+    if (!flow) {
+        list_add_tail(&req->request_list, &queue->request_queue);
+        return;
+    }
+
+    INIT_LIST_HEAD(&flow->requests);
+    flow->key = key;
+    flow->internal = internal;
+    flow->weight = internal ? svc->fq_weight_internal : svc->fq_weight;
+    list_add_tail(&flow->list, &queue->fq_flows);
+
+queue:
+    list_add_tail(&req->request_list, &flow->requests);
+}
+
+/* One DRR round over the active flows. Every flow gets its quantum and
+ * sends as long as the deficit covers its next request. */
+static void
+__rpcsvc_fq_dequeue_round(rpcsvc_request_queue_t *queue,
+                          struct list_head *batch)
+{
+    rpcsvc_fq_flow_t *flow = NULL, *tmp = NULL;
+    rpcsvc_request_t *req = NULL;
+    size_t cost = 0;
+
+    list_for_each_entry_safe(flow, tmp, &queue->fq_flows, list)
+    {
+        flow->deficit += flow->weight * RPCSVC_FQ_QUANTUM;
+
+        while (!list_empty(&flow->requests)) {
+            req = list_first_entry(&flow->requests, rpcsvc_request_t,
+                                   request_list);
+            cost = iov_length(req->msg, req->count);
+            if ((int64_t)cost > flow->deficit)
+                break;
+
+            flow->deficit -= cost;
+            list_move_tail(&req->request_list, batch);
+        }
+
+        if (list_empty(&flow->requests)) {
+            list_del(&flow->list);
+            GF_FREE(flow);
+        }
+    }
+}
+
+static void
+rpcsvc_fq_account(rpcsvc_request_t *req)
+{
+    struct timespec now;
+
+    if (!req->queued.tv_sec)
+        return;
+
+    timespec_now(&now);
+    GF_ATOMIC_DEC(req->trans->fq_depth);
+    GF_ATOMIC_INC(req->trans->fq_dispatched);
+    GF_ATOMIC_ADD(req->trans->fq_wait_usec,
+                  gf_tsdiff(&req->queued, &now) / 1000);
+}
+
 int
 rpcsvc_get_free_queue_index(rpcsvc_program_t *prog)
 {
@@ -651,7 +756,7 @@ rpcsvc_queue_event_thread_death(rpcsvc_t *svc, rpcsvc_program_t *prog, int gen)
 
     pthread_mutex_lock(&queue->queue_lock);
     {
-        empty = list_empty(&queue->request_queue);
+        empty = __rpcsvc_queue_empty(queue);
 
         list_add_tail(&req->request_list, &queue->request_queue);
         queue->gen = gen;
@@ -873,9 +978,9 @@ rpcsvc_handle_rpc_call(rpcsvc_t *svc, rpc_transport_t *trans,
 
             pthread_mutex_lock(&queue->queue_lock);
             {
-                empty = list_empty(&queue->request_queue);
+                empty = __rpcsvc_queue_empty(queue);
 
-                list_add_tail(&req->request_list, &queue->request_queue);
+                __rpcsvc_queue_request(svc, queue, req, actor);
 
                 if (empty && queue->waiting)
                     pthread_cond_signal(&queue->queue_cond);
@@ -2181,22 +2286,22 @@ rpcsvc_request_handler(void *arg)
     while (1) {
         pthread_mutex_lock(&queue->queue_lock);
         {
-            if (!program->alive && list_empty(&queue->request_queue)) {
+            if (!program->alive && __rpcsvc_queue_empty(queue)) {
                 done = 1;
                 goto unlock;
             }
 
-            while (list_empty(&queue->request_queue)) {
+            while (__rpcsvc_queue_empty(queue)) {
                 queue->waiting = _gf_true;
                 pthread_cond_wait(&queue->queue_cond, &queue->queue_lock);
             }
 
             queue->waiting = _gf_false;
 
-            if (!list_empty(&queue->request_queue)) {
-                INIT_LIST_HEAD(&tmp_list);
-                list_splice_init(&queue->request_queue, &tmp_list);
-            }
+            INIT_LIST_HEAD(&tmp_list);
+            list_splice_init(&queue->request_queue, &tmp_list);
+            list_append_init(&queue->fq_express, &tmp_list);
+            __rpcsvc_fq_dequeue_round(queue, &tmp_list);
         }
     unlock:
         pthread_mutex_unlock(&queue->queue_lock);
@@ -2205,6 +2310,7 @@ rpcsvc_request_handler(void *arg)
         {
             if (req) {
                 list_del_init(&req->request_list);
+                rpcsvc_fq_account(req);
 
                 if (req->prognum == RPCSVC_INFRA_PROGRAM) {
                     switch (req->procnum) {
@@ -2305,6 +2411,8 @@ rpcsvc_program_register(rpcsvc_t *svc, rpcsvc_program_t *program,
         pthread_mutexattr_init(&attr[i]);
         pthread_mutexattr_settype(&attr[i], PTHREAD_MUTEX_ADAPTIVE_NP);
         INIT_LIST_HEAD(&newprog->request_queue[i].request_queue);
+        INIT_LIST_HEAD(&newprog->request_queue[i].fq_express);
+        INIT_LIST_HEAD(&newprog->request_queue[i].fq_flows);
         pthread_mutex_init(&newprog->request_queue[i].queue_lock, &attr[i]);
         pthread_cond_init(&newprog->request_queue[i].queue_cond, NULL);
         newprog->request_queue[i].program = newprog;
@@ -2704,6 +2812,40 @@ rpcsvc_set_outstanding_rpc_limit(rpcsvc_t *svc, dict_t *options, int defvalue)
     return (0);
 }
 
+/*
+ * Configure() rpc.fair-share and the weights of the two client classes.
+ * Missing keys fall back to the defaults.
+ */
+int
+rpcsvc_set_fair_share(rpcsvc_t *svc, dict_t *options)
+{
+    int weight = RPCSVC_DEFAULT_FQ_WEIGHT;
+    int weight_internal = RPCSVC_DEFAULT_FQ_WEIGHT_INTERNAL;
+
+    if ((!svc) || (!options))
+        return (-1);
+
+    svc->fair_share = dict_get_str_boolean(options, "rpc.fair-share",
+                                           _gf_false);
+
+    if (dict_get_int32(options, "rpc.fair-share-weight", &weight))
+        weight = RPCSVC_DEFAULT_FQ_WEIGHT;
+    if (dict_get_int32(options, "rpc.fair-share-internal-weight",
+                       &weight_internal))
+        weight_internal = RPCSVC_DEFAULT_FQ_WEIGHT_INTERNAL;
+
+    svc->fq_weight = max(1, min(weight, RPCSVC_MAX_FQ_WEIGHT));
+    svc->fq_weight_internal = max(1, min(weight_internal,
+                                         RPCSVC_MAX_FQ_WEIGHT));
+
+    gf_log(GF_RPCSVC, GF_LOG_DEBUG,
+           "fair-share %s, weights %d (clients) %d (internal)",
+           svc->fair_share ? "on" : "off", svc->fq_weight,
+           svc->fq_weight_internal);
+
+    return (0);
+}
+
 /*
  * Enable throttling for rpcsvc_t svc.
  * Returns 0 on success, -1 otherwise.
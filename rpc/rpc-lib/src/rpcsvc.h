@@ -50,6 +50,15 @@ typedef enum {
 #define RPCSVC_FRAGHDR_SIZE 4 /* 4-byte RPC fragment header size */
 #define RPCSVC_DEFAULT_LISTEN_PORT GF_DEFAULT_BASE_PORT
 #define RPCSVC_DEFAULT_MEMFACTOR 8
+
+/* Fair-share scheduling of the ownthread request queues: the number of
+ * RPCSVC_FQ_QUANTUM bytes of requests a flow may dispatch per round, for
+ * the requests of regular clients and for those of the internal daemons
+ * (rebalance, self-heal, ...) which run with negative pids. */
+#define RPCSVC_DEFAULT_FQ_WEIGHT 8
+#define RPCSVC_DEFAULT_FQ_WEIGHT_INTERNAL 2
+#define RPCSVC_MAX_FQ_WEIGHT 1024
+#define RPCSVC_FQ_QUANTUM (4 * GF_UNIT_KB)
 #define RPCSVC_EVENTPOOL_SIZE_MULT 1024
 #define RPCSVC_POOLCOUNT_MULT 64
 #define RPCSVC_CONN_READ (128 * GF_UNIT_KB)
@@ -264,8 +273,9 @@ struct rpcsvc_request {
     gf_boolean_t ownthread;
 
     gf_boolean_t synctask;
-    struct timespec begin; /*req handling start time*/
-    struct timespec end;   /*req handling end time*/
+    struct timespec begin;  /*req handling start time*/
+    struct timespec end;    /*req handling end time*/
+    struct timespec queued; /*time it entered a fair-share queue*/
 };
 
 #define rpcsvc_request_program(req) ((rpcsvc_program_t *)((req)->prog))
@@ -376,8 +386,24 @@ typedef struct rpcsvc_actor_desc {
     /* Can actor be ran on behalf an unprivileged requestor? */
     drc_op_type_t op_type;
     gf_boolean_t unprivileged;
+
+    /* Short, latency sensitive call (lookup, stat, ...) which is served
+     * ahead of the fair-share queues. */
+    gf_boolean_t express;
 } rpcsvc_actor_t;
 
+/* Requests of one client waiting in a request queue, those with negative
+ * pids apart. Only exists while the client has requests of the kind queued,
+ * which is also when DRR drops its deficit. */
+typedef struct rpcsvc_fq_flow {
+    struct list_head list; /* in rpcsvc_request_queue_t.fq_flows */
+    struct list_head requests;
+    void *key;
+    gf_boolean_t internal;
+    int weight;
+    int64_t deficit;
+} rpcsvc_fq_flow_t;
+
 typedef struct rpcsvc_request_queue {
     struct list_head request_queue;
     pthread_mutex_t queue_lock;
@@ -386,6 +412,10 @@ typedef struct rpcsvc_request_queue {
     struct rpcsvc_program *program;
     int gen;
     gf_boolean_t waiting;
+
+    /* with rpc.fair-share: express calls, then active flows in DRR order */
+    struct list_head fq_express;
+    struct list_head fq_flows;
 } rpcsvc_request_queue_t;
 
 /* Describes a program and its version along with the function pointers
@@ -670,6 +700,9 @@ rpcsvc_set_all_squash(rpcsvc_t *svc, dict_t *options);
 int
 rpcsvc_set_outstanding_rpc_limit(rpcsvc_t *svc, dict_t *options, int defvalue);
 
+int
+rpcsvc_set_fair_share(rpcsvc_t *svc, dict_t *options);
+
 int
 rpcsvc_set_throttle_on(rpcsvc_t *svc);
 
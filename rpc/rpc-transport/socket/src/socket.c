@@ -32,6 +32,22 @@
 #include <errno.h>
 #include <rpc/xdr.h>
 #include <sys/ioctl.h>
+#include <poll.h>
+
+#if defined(GF_LINUX_HOST_OS) && defined(MSG_ZEROCOPY) && defined(SO_ZEROCOPY)
+#include <linux/errqueue.h>
+#define HAVE_SOCKET_ZEROCOPY 1
+#endif
+
+#if defined(SSL_OP_ENABLE_KTLS) && defined(BIO_get_ktls_send)
+#define HAVE_SOCKET_KTLS 1
+#endif
+
+/* Once kernel TLS has taken over a direction, the socket is read/written
+ * directly and OpenSSL is only needed for the other one (if any). */
+#define SOCKET_SSL_TX(priv) ((priv)->use_ssl && !(priv)->ktls_tx)
+#define SOCKET_SSL_RX(priv) ((priv)->use_ssl && !(priv)->ktls_rx)
+
 #define GF_LOG_ERRNO(errno) ((errno == ENOTCONN) ? GF_LOG_DEBUG : GF_LOG_ERROR)
 #define SA(ptr) ((struct sockaddr *)ptr)
 
@@ -45,6 +61,7 @@
 #define SSL_EC_CURVE_OPT "transport.socket.ssl-ec-curve"
 #define SSL_CRL_PATH_OPT "transport.socket.ssl-crl-path"
 #define OWN_THREAD_OPT "transport.socket.own-thread"
+#define SSL_KTLS_OPT "transport.socket.ssl-ktls"
 
 /* TBD: do automake substitutions etc. (ick) to set these. */
 #if !defined(DEFAULT_ETC_SSL)
@@ -448,6 +465,32 @@ ssl_error:
     return NULL;
 }
 
+static void
+ssl_setup_ktls(rpc_transport_t *this)
+{
+    socket_private_t *priv = this->private;
+
+    priv->ktls_tx = 0;
+    priv->ktls_rx = 0;
+
+#ifdef HAVE_SOCKET_KTLS
+    if (!priv->ktls)
+        return;
+
+    /* OpenSSL has already handed the keys to the kernel at the end of the
+     * handshake if it could, we only need to find out what it managed */
+    priv->ktls_tx = !!BIO_get_ktls_send(SSL_get_wbio(priv->ssl_ssl));
+    /* anything OpenSSL read ahead would be lost to a plain read */
+    if (!SSL_has_pending(priv->ssl_ssl))
+        priv->ktls_rx = !!BIO_get_ktls_recv(SSL_get_rbio(priv->ssl_ssl));
+
+    gf_log(this->name, GF_LOG_INFO,
+           "kernel TLS is %s for sending and %s for receiving (peer: %s)",
+           priv->ktls_tx ? "on" : "off", priv->ktls_rx ? "on" : "off",
+           this->peerinfo.identifier);
+#endif
+}
+
 static int
 ssl_complete_connection(rpc_transport_t *this)
 {
@@ -486,6 +529,7 @@ ssl_complete_connection(rpc_transport_t *this)
                 ret = -1;
             } else {
                 this->ssl_name = cname;
+                ssl_setup_ktls(this);
                 if (priv->is_server) {
                     priv->ssl_accepted = _gf_true;
                     gf_log(this->name, GF_LOG_TRACE, "ssl_accepted!");
@@ -560,7 +604,7 @@ __socket_ssl_readv(rpc_transport_t *this, struct iovec *opvector, int opcount)
     priv = this->private;
     sock = priv->sock;
 
-    if (priv->use_ssl) {
+    if (SOCKET_SSL_RX(priv)) {
         gf_log(this->name, GF_LOG_TRACE, "***** reading over SSL");
         ret = ssl_read_one(this, opvector->iov_base, opvector->iov_len);
     } else {
@@ -587,67 +631,90 @@ __socket_ssl_read(rpc_transport_t *this, void *buf, size_t count)
     return ret;
 }
 
+/* Receive as much as fits into the receive buffer with a single read.
+ * Returns what __socket_ssl_read() returned. */
+static ssize_t
+__socket_rx_fill(rpc_transport_t *this)
+{
+    socket_private_t *priv = this->private;
+    struct gf_sock_incoming *in = &priv->incoming;
+    struct iobuf *iobuf = NULL;
+    size_t avail = 0;
+    ssize_t ret = -1;
+
+    if (!in->rx_iobuf) {
+        in->rx_iobuf = iobuf_get2(this->ctx->iobuf_pool,
+                                  GF_SOCKET_RX_BUF_SIZE);
+        if (!in->rx_iobuf) {
+            errno = ENOMEM;
+            goto out;
+        }
+        in->rx_start = in->rx_end = 0;
+        in->rx_shared = 0;
+    }
+
+    avail = in->rx_end - in->rx_start;
+
+    if (!avail && !in->rx_shared) {
+        in->rx_start = in->rx_end = 0;
+    } else if (iobuf_size(in->rx_iobuf) - in->rx_end < GF_SOCKET_RX_MIN_FREE) {
+        /* Out of room at the tail. Move the unconsumed bytes to the front,
+         * into a fresh buffer if records still point into this one. */
+        if (in->rx_shared) {
+            iobuf = iobuf_get2(this->ctx->iobuf_pool, GF_SOCKET_RX_BUF_SIZE);
+            if (!iobuf) {
+                errno = ENOMEM;
+                goto out;
+            }
+            memcpy(iobuf_ptr(iobuf), (char *)iobuf_ptr(in->rx_iobuf) +
+                   in->rx_start, avail);
+            iobuf_unref(in->rx_iobuf);
+            in->rx_iobuf = iobuf;
+            in->rx_shared = 0;
+        } else {
+            memmove(iobuf_ptr(in->rx_iobuf),
+                    (char *)iobuf_ptr(in->rx_iobuf) + in->rx_start, avail);
+        }
+        in->rx_start = 0;
+        in->rx_end = avail;
+    }
+
+    ret = __socket_ssl_read(this, (char *)iobuf_ptr(in->rx_iobuf) + in->rx_end,
+                            iobuf_size(in->rx_iobuf) - in->rx_end);
+    if (ret > 0)
+        in->rx_end += ret;
+out:
+    return ret;
+}
+
 static int
 __socket_cached_read(rpc_transport_t *this, struct iovec *opvector, int opcount)
 {
     socket_private_t *priv = NULL;
     struct gf_sock_incoming *in = NULL;
-    int req_len = -1;
+    size_t req_len = 0;
     int ret = -1;
 
     priv = this->private;
     in = &priv->incoming;
     req_len = iov_length(opvector, opcount);
 
-    if (in->record_state == SP_STATE_READING_FRAGHDR) {
-        in->ra_read = 0;
-        in->ra_served = 0;
-        in->ra_max = 0;
-        in->ra_buf = NULL;
-        goto uncached;
-    }
-
-    if (!in->ra_max) {
-        /* first call after passing SP_STATE_READING_FRAGHDR */
-        in->ra_max = min(RPC_FRAGSIZE(in->fraghdr), GF_SOCKET_RA_MAX);
-        /* Note that the in->iobuf is the primary iobuf into which
-           headers are read into, and in->frag.fragcurrent points to
-           some position in the buffer. By using this itself as our
-           read-ahead cache, we can avoid memory copies in iov_load
-        */
-        in->ra_buf = in->frag.fragcurrent;
-    }
-
-    /* fill read-ahead */
-    if (in->ra_read < in->ra_max) {
-        ret = __socket_ssl_read(this, &in->ra_buf[in->ra_read],
-                                (in->ra_max - in->ra_read));
-        if (ret > 0)
-            in->ra_read += ret;
+    if (in->rx_start == in->rx_end) {
+        /* Large reads (payloads) skip the buffer and land in place */
+        if (req_len >= GF_SOCKET_RX_BUF_SIZE)
+            goto uncached;
 
-        /* we proceed to test if there is still cached data to
-           be served even if readahead could not progress */
+        ret = __socket_rx_fill(this);
+        if (ret <= 0)
+            goto out;
     }
 
-    /* serve cached */
-    if (in->ra_served < in->ra_read) {
-        ret = iov_load(opvector, opcount, &in->ra_buf[in->ra_served],
-                       min(req_len, (in->ra_read - in->ra_served)));
-
-        in->ra_served += ret;
-        /* Do not read uncached and cached in the same call */
-        goto out;
-    }
+    ret = iov_load(opvector, opcount,
+                   (char *)iobuf_ptr(in->rx_iobuf) + in->rx_start,
+                   min(req_len, in->rx_end - in->rx_start));
+    in->rx_start += ret;
+    goto out;
 
-    if (in->ra_read < in->ra_max)
-        /* If there was no cached data to be served, (and we are
-           guaranteed to have already performed an attempt to progress
-           readahead above), and we have not yet read out the full
-           readahead capacity, then bail out for now without doing
-           the uncached read below (as that will overtake future cached
-           read)
-        */
-        goto out;
 uncached:
     ret = __socket_ssl_readv(this, opvector, opcount);
 out:
@@ -718,7 +785,7 @@ __socket_rwv(rpc_transport_t *this, struct iovec *vector, int count,
             gf_log(this->name, GF_LOG_TRACE,
                    "### no priv->ssl_ssl yet; ret = -1;");
         } else if (write) {
-            if (priv->use_ssl) {
+            if (SOCKET_SSL_TX(priv)) {
                 ret = ssl_write_one(this, opvector->iov_base,
                                     opvector->iov_len);
             } else {
@@ -1144,6 +1211,11 @@ __socket_reset(rpc_transport_t *this)
         priv->incoming.iobuf = NULL;
     }
 
+    if (priv->incoming.rx_iobuf) {
+        iobuf_unref(priv->incoming.rx_iobuf);
+        priv->incoming.rx_iobuf = NULL;
+    }
+
     GF_FREE(priv->incoming.request_info);
 
     memset(&priv->incoming, 0, sizeof(priv->incoming));
@@ -1161,6 +1233,8 @@ __socket_reset(rpc_transport_t *this)
     priv->sock = -1;
     priv->idx = -1;
     priv->connected = -1;
+    priv->ktls_tx = 0;
+    priv->ktls_rx = 0;
     priv->ssl_connected = _gf_false;
     priv->ssl_accepted = _gf_false;
     priv->ssl_context_created = _gf_false;
@@ -1279,6 +1353,25 @@ out:
     return;
 }
 
+static gf_boolean_t
+__socket_zerocopy_completed(socket_private_t *priv, struct ioq *entry)
+{
+    return ((int32_t)(priv->zc_done - entry->zc_seq) > 0);
+}
+
+/* An entry that went out with MSG_ZEROCOPY may still have its pages
+ * referenced by the kernel; park it until the completion shows up. */
+static void
+__socket_ioq_entry_done(socket_private_t *priv, struct ioq *entry)
+{
+    if (entry->zerocopy && !__socket_zerocopy_completed(priv, entry)) {
+        list_move_tail(&entry->list, &priv->zc_pending);
+        return;
+    }
+
+    __socket_ioq_entry_free(entry);
+}
+
 static void
 __socket_ioq_flush(socket_private_t *priv)
 {
@@ -1288,6 +1381,219 @@ __socket_ioq_flush(socket_private_t *priv)
         entry = priv->ioq_next;
         __socket_ioq_entry_free(entry);
     }
+
+    while (!list_empty(&priv->zc_pending)) {
+        entry = list_first_entry(&priv->zc_pending, struct ioq, list);
+        __socket_ioq_entry_free(entry);
+    }
+}
+
+static void
+__socket_zerocopy_enable(rpc_transport_t *this)
+{
+    socket_private_t *priv = this->private;
+#ifdef HAVE_SOCKET_ZEROCOPY
+    int on = 1;
+#endif
+
+    priv->zc_active = 0;
+    priv->zc_sent = 0;
+    priv->zc_done = 0;
+
+    if (!priv->zerocopy || priv->use_ssl)
+        return;
+
+#ifdef HAVE_SOCKET_ZEROCOPY
+    if (setsockopt(priv->sock, SOL_SOCKET, SO_ZEROCOPY, &on, sizeof(on)) !=
+        0) {
+        gf_log(this->name, GF_LOG_DEBUG,
+               "SO_ZEROCOPY on %d failed (%s), copying writes", priv->sock,
+               strerror(errno));
+        return;
+    }
+
+    priv->zc_active = 1;
+#endif
+}
+
+/* Reads MSG_ZEROCOPY completion notifications off the socket error queue
+ * and releases the entries they cover. Returns the number of notifications
+ * read, or -1 if the error queue could not be read. */
+static int
+__socket_zerocopy_reap(rpc_transport_t *this)
+{
+    int reaped = 0;
+#ifdef HAVE_SOCKET_ZEROCOPY
+    socket_private_t *priv = this->private;
+    struct sock_extended_err *serr = NULL;
+    struct cmsghdr *cm = NULL;
+    struct ioq *entry = NULL;
+    struct ioq *tmp = NULL;
+    struct msghdr msg = {
+        0,
+    };
+    char control[CMSG_SPACE(sizeof(*serr) + sizeof(struct sockaddr_in6))];
+    uint32_t hi = 0;
+
+    for (;;) {
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+
+        if (recvmsg(priv->sock, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) {
+            if (errno == EINTR)
+                continue;
+            if (errno != EAGAIN)
+                reaped = -1;
+            break;
+        }
+
+        cm = CMSG_FIRSTHDR(&msg);
+        if (!cm)
+            continue;
+        if (!((cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR) ||
+              (cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR)))
+            continue;
+
+        serr = (struct sock_extended_err *)CMSG_DATA(cm);
+        if (serr->ee_origin != SO_EE_ORIGIN_ZEROCOPY || serr->ee_errno != 0)
+            continue;
+
+        reaped++;
+
+        /* TCP completes sends in order, ee_data is the newest one */
+        hi = serr->ee_data;
+        if ((int32_t)(hi + 1 - priv->zc_done) > 0)
+            priv->zc_done = hi + 1;
+
+        if ((serr->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) && priv->zc_active) {
+            /* e.g. loopback: the kernel copied anyway, and pinning the
+             * pages first only made it slower */
+            gf_log(this->name, GF_LOG_DEBUG,
+                   "zerocopy sends on %d were copied, disabling", priv->sock);
+            priv->zc_active = 0;
+        }
+    }
+
+    list_for_each_entry_safe(entry, tmp, &priv->zc_pending, list)
+    {
+        if (!__socket_zerocopy_completed(priv, entry))
+            break;
+        __socket_ioq_entry_free(entry);
+    }
+#endif
+    return reaped;
+}
+
+static size_t
+__socket_iov_advance(struct iovec **vector, int *count, size_t bytes)
+{
+    while (*count > 0) {
+        if (bytes < (*vector)->iov_len) {
+            (*vector)->iov_base += bytes;
+            (*vector)->iov_len -= bytes;
+            return 0;
+        }
+        bytes -= (*vector)->iov_len;
+        (*vector)++;
+        (*count)--;
+    }
+
+    return bytes;
+}
+
+/* Writes out as many queued entries as fit in one sendmsg(). Same return
+ * convention as __socket_rwv(): 0 when everything gathered went out, > 0
+ * when the socket filled up and -1 on error. */
+static int
+__socket_ioq_churn_batch(rpc_transport_t *this)
+{
+    socket_private_t *priv = this->private;
+    struct iovec vector[GF_SOCKET_BATCH_IOVEC];
+    struct msghdr msg = {
+        0,
+    };
+    struct ioq *entry = NULL;
+    struct ioq *tmp = NULL;
+    int max = IOV_MIN(GF_SOCKET_BATCH_IOVEC);
+    int count = 0;
+    int flags = 0;
+    int i = 0;
+    ssize_t ret = -1;
+    size_t bytes = 0;
+    gf_boolean_t partial = _gf_false;
+
+    if (!list_empty(&priv->zc_pending))
+        __socket_zerocopy_reap(this);
+
+    list_for_each_entry(entry, &priv->ioq, list)
+    {
+        if (count + entry->pending_count > max)
+            break;
+
+        for (i = 0; i < entry->pending_count; i++) {
+            if (priv->zc_active &&
+                entry->pending_vector[i].iov_len >= priv->zerocopy_threshold)
+                flags = MSG_ZEROCOPY;
+            vector[count++] = entry->pending_vector[i];
+        }
+    }
+
+    msg.msg_iov = vector;
+    msg.msg_iovlen = count;
+
+    for (;;) {
+        ret = sendmsg(priv->sock, &msg, flags);
+        if (ret >= 0)
+            break;
+        if (errno == EINTR)
+            continue;
+        if (errno == ENOBUFS && flags) {
+            /* out of optmem for pinned pages, copy this one */
+            flags = 0;
+            continue;
+        }
+        break;
+    }
+
+    if (ret <= 0) {
+        if ((ret == 0) || (errno == EAGAIN))
+            return 1;
+
+        if (__does_socket_rwv_error_need_logging(priv, 1)) {
+            GF_LOG_OCCASIONALLY(priv->log_ctr, this->name, GF_LOG_WARNING,
+                                "sendmsg on %s failed (%s)",
+                                this->peerinfo.identifier, strerror(errno));
+        }
+        return -1;
+    }
+
+    this->total_bytes_write += ret;
+    bytes = ret;
+
+    list_for_each_entry_safe(entry, tmp, &priv->ioq, list)
+    {
+        if (!bytes)
+            break;
+
+        if (flags) {
+            entry->zerocopy = 1;
+            entry->zc_seq = priv->zc_sent;
+        }
+
+        bytes = __socket_iov_advance(&entry->pending_vector,
+                                     &entry->pending_count, bytes);
+        if (entry->pending_count) {
+            partial = _gf_true;
+            break;
+        }
+
+        __socket_ioq_entry_done(priv, entry);
+    }
+
+    if (flags)
+        priv->zc_sent++;
+
+    return partial;
 }
 
 static int
@@ -1317,10 +1623,13 @@ __socket_ioq_churn(rpc_transport_t *this)
     priv = this->private;
 
     while (!list_empty(&priv->ioq)) {
-        /* pick next entry */
-        entry = priv->ioq_next;
-
-        ret = __socket_ioq_churn_entry(this, entry);
+        if (SOCKET_SSL_TX(priv)) {
+            /* SSL_write() takes one buffer at a time anyway */
+            entry = priv->ioq_next;
+            ret = __socket_ioq_churn_entry(this, entry);
+        } else {
+            ret = __socket_ioq_churn_batch(this);
+        }
 
         if (ret != 0)
             break;
@@ -2301,6 +2610,128 @@ __socket_reset_priv(socket_private_t *priv)
     memset(&in->payload_vector, 0, sizeof(in->payload_vector));
 }
 
+/* Hand a complete, single fragment record sitting in the receive buffer to
+ * the upper layers without copying it. Returns 1 if a record was consumed,
+ * 0 if it has to go through the state machine (partial, large or vectored
+ * records) and -1 on error. */
+static int
+__socket_read_inline_record(rpc_transport_t *this,
+                            rpc_transport_pollin_t **pollin)
+{
+    socket_private_t *priv = this->private;
+    struct gf_sock_incoming *in = &priv->incoming;
+    rpc_request_info_t *request_info = NULL;
+    struct iobref *iobref = NULL;
+    struct iovec vector = {
+        0,
+    };
+    char *buf = NULL;
+    uint32_t fraghdr = 0;
+    uint32_t size = 0;
+    uint32_t prognum = 0, progver = 0, procnum = 0;
+    msg_type_t msg_type = 0;
+    int ret = 0;
+
+    if ((in->rx_end - in->rx_start) < sizeof(fraghdr)) {
+        if (__socket_rx_fill(this) <= 0)
+            goto out;
+    }
+
+    buf = (char *)iobuf_ptr(in->rx_iobuf) + in->rx_start;
+    memcpy(&fraghdr, buf, sizeof(fraghdr));
+    fraghdr = ntoh32(fraghdr);
+    size = RPC_FRAGSIZE(fraghdr);
+
+    if (!RPC_LASTFRAG(fraghdr) || (size > GF_SOCKET_RX_INLINE_MAX) ||
+        (size < RPC_MSGTYPE_SIZE))
+        goto out;
+
+    if ((in->rx_end - in->rx_start) < (sizeof(fraghdr) + size)) {
+        /* The rest of a small record is most likely already queued */
+        if (__socket_rx_fill(this) <= 0)
+            goto out;
+        buf = (char *)iobuf_ptr(in->rx_iobuf) + in->rx_start;
+        if ((in->rx_end - in->rx_start) < (sizeof(fraghdr) + size))
+            goto out;
+    }
+
+    buf += sizeof(fraghdr);
+    msg_type = ntoh32(*((uint32_t *)rpc_msgtype_addr(buf)));
+
+    if (msg_type == CALL) {
+        if (size < (RPC_MSGTYPE_SIZE + RPC_CALL_BODY_SIZE))
+            goto out;
+
+        if (priv->is_server) {
+            prognum = ntoh32(*((uint32_t *)rpc_prognum_addr(buf)));
+            progver = ntoh32(*((uint32_t *)rpc_progver_addr(buf)));
+            procnum = ntoh32(*((uint32_t *)rpc_procnum_addr(buf)));
+            if (rpcsvc_get_program_vector_sizer((rpcsvc_t *)this->mydata,
+                                                prognum, progver, procnum))
+                goto out;
+        }
+    } else if (msg_type == REPLY) {
+        request_info = GF_CALLOC(1, sizeof(*request_info),
+                                 gf_common_mt_rpc_trans_reqinfo_t);
+        if (!request_info) {
+            ret = -1;
+            goto out;
+        }
+
+        request_info->xid = ntoh32(*((uint32_t *)rpc_xid_addr(buf)));
+
+        in->frag.state = SP_STATE_NOTIFYING_XID;
+        ret = rpc_transport_notify(this, RPC_TRANSPORT_MAP_XID_REQUEST,
+                                   request_info);
+        in->frag.state = SP_STATE_RPCFRAG_INIT;
+        if (ret < 0) {
+            gf_log(this->name, GF_LOG_WARNING,
+                   "notify for event MAP_XID failed for %s",
+                   this->peerinfo.identifier);
+            goto out;
+        }
+
+        /* read replies land in the caller's buffers */
+        if ((request_info->prognum == GLUSTER_FOP_PROGRAM) &&
+            (request_info->procnum == GF_FOP_READ))
+            goto out;
+    } else {
+        /* let the state machine complain */
+        goto out;
+    }
+
+    iobref = iobref_new();
+    if (!iobref) {
+        ret = -1;
+        goto out;
+    }
+
+    vector.iov_base = buf;
+    vector.iov_len = size;
+
+    *pollin = rpc_transport_pollin_alloc(this, &vector, 1, in->rx_iobuf, iobref,
+                                         request_info);
+    iobref_unref(iobref);
+    if (*pollin == NULL) {
+        gf_log(this->name, GF_LOG_WARNING, "transport pollin allocation failed");
+        ret = -1;
+        goto out;
+    }
+
+    if (msg_type == REPLY)
+        (*pollin)->is_reply = 1;
+
+    request_info = NULL;
+    in->msg_type = msg_type;
+    in->rx_start += sizeof(fraghdr) + size;
+    in->rx_shared = 1;
+    this->total_bytes_read += sizeof(fraghdr) + size;
+    ret = 1;
+out:
+    GF_FREE(request_info);
+    return ret;
+}
+
 static int
 __socket_proto_state_machine(rpc_transport_t *this,
                              rpc_transport_pollin_t **pollin)
@@ -2324,6 +2755,17 @@ __socket_proto_state_machine(rpc_transport_t *this,
     while (in->record_state != SP_STATE_COMPLETE) {
         switch (in->record_state) {
             case SP_STATE_NADA:
+                if (pollin != NULL) {
+                    ret = __socket_read_inline_record(this, pollin);
+                    if (ret < 0)
+                        goto out;
+                    if (ret > 0) {
+                        ret = 0;
+                        in->record_state = SP_STATE_COMPLETE;
+                        break;
+                    }
+                }
+
                 in->total_bytes_read = 0;
                 in->payload_vector.iov_len = 0;
 
@@ -2520,19 +2962,35 @@ socket_event_poll_in(rpc_transport_t *this, gf_boolean_t notify_handled)
 {
     int ret = -1;
     rpc_transport_pollin_t *pollin = NULL;
+    rpc_transport_pollin_t *next = NULL;
     socket_private_t *priv = this->private;
     glusterfs_ctx_t *ctx = NULL;
 
     ctx = this->ctx;
 
-    ret = socket_proto_state_machine(this, &pollin);
+    for (;;) {
+        ret = socket_proto_state_machine(this, &next);
+        if (!next)
+            break;
 
-    if (pollin) {
         pthread_mutex_lock(&priv->notify.lock);
         {
             priv->notify.in_progress++;
         }
         pthread_mutex_unlock(&priv->notify.lock);
+
+        if (pollin) {
+            rpc_transport_ref(this);
+            gf_async(&pollin->async, THIS, socket_event_poll_in_async);
+        }
+        pollin = next;
+        next = NULL;
+
+        /* The socket is only rearmed once we are done with it, so parse
+         * every record that already made it into the receive buffer. */
+        if ((ret < 0) || (priv->incoming.record_state != SP_STATE_NADA) ||
+            (priv->incoming.rx_start == priv->incoming.rx_end))
+            break;
     }
 
     if (notify_handled && (ret >= 0))
@@ -2849,6 +3307,51 @@ socket_complete_connection(rpc_transport_t *this)
     return ret;
 }
 
+/* MSG_ZEROCOPY completions are delivered on the socket error queue, which
+ * raises EPOLLERR. Returns true if that is all the error condition was. */
+static gf_boolean_t
+socket_event_poll_zerocopy(rpc_transport_t *this)
+{
+    socket_private_t *priv = this->private;
+    struct pollfd pfd = {
+        0,
+    };
+    int sockerr = 0;
+    socklen_t len = sizeof(sockerr);
+    int reaped = 0;
+    int tries = 0;
+
+    for (tries = 0; tries < 4; tries++) {
+        pthread_mutex_lock(&priv->out_lock);
+        {
+            if (priv->sock < 0 || priv->zc_sent == 0)
+                reaped = -1;
+            else
+                reaped = __socket_zerocopy_reap(this);
+        }
+        pthread_mutex_unlock(&priv->out_lock);
+
+        if (reaped < 0)
+            break;
+
+        if (getsockopt(priv->sock, SOL_SOCKET, SO_ERROR, &sockerr, &len) ||
+            sockerr)
+            break;
+
+        pfd.fd = priv->sock;
+        pfd.revents = 0;
+        if (poll(&pfd, 1, 0) < 0)
+            break;
+        if (pfd.revents & (POLLHUP | POLLNVAL))
+            break;
+        if (!(pfd.revents & POLLERR))
+            return _gf_true;
+        /* more completions came in meanwhile */
+    }
+
+    return _gf_false;
+}
+
 /* reads rpc_requests during pollin */
 static void
 socket_event_handler(int fd, int idx, int gen, void *data, int poll_in,
@@ -2893,6 +3396,11 @@ socket_event_handler(int fd, int idx, int gen, void *data, int poll_in,
            (priv->is_server ? "server" : "client"), priv->sock, poll_in,
            poll_out, poll_err);
 
+    if (poll_err && socket_event_poll_zerocopy(this)) {
+        gf_event_clear_error(ctx->event_pool, fd, idx, gen);
+        poll_err = 0;
+    }
+
     if (!poll_err) {
         if (!socket_is_connected(priv)) {
             gf_log(this->name, GF_LOG_TRACE,
@@ -3169,6 +3677,10 @@ socket_server_event_handler(int fd, int idx, int gen, void *data, int poll_in,
         new_priv->sock = new_sock;
 
         new_priv->ssl_enabled = priv->ssl_enabled;
+        new_priv->zerocopy = priv->zerocopy;
+        new_priv->zerocopy_threshold = priv->zerocopy_threshold;
+        if (new_sockaddr.ss_family != AF_UNIX)
+            __socket_zerocopy_enable(new_trans);
         new_priv->connected = 1;
         new_priv->is_server = _gf_true;
 
@@ -3453,6 +3965,8 @@ socket_connect(rpc_transport_t *this, int port)
                     gf_log(this->name, GF_LOG_ERROR,
                            "Failed to set keep-alive: %s", strerror(errno));
             }
+
+            __socket_zerocopy_enable(this);
         }
 
         SA(&this->myinfo.sockaddr)->sa_family = SA(&this->peerinfo.sockaddr)
@@ -3803,10 +4317,18 @@ socket_submit_outgoing_msg(rpc_transport_t *this, rpc_transport_msg_t *msg)
             goto unlock;
 
         if (list_empty(&priv->ioq)) {
-            ret = __socket_ioq_churn_entry(this, entry);
+            if (SOCKET_SSL_TX(priv)) {
+                ret = __socket_ioq_churn_entry(this, entry);
 
-            if (ret == 0) {
+                if (ret == 0) {
+                    need_append = 0;
+                }
+            } else {
+                /* the batch path may keep the entry around until a
+                 * MSG_ZEROCOPY completion, so it has to be queued */
+                list_add_tail(&entry->list, &priv->ioq);
                 need_append = 0;
+                ret = __socket_ioq_churn_batch(this);
             }
             if (ret > 0) {
                 need_poll_out = 1;
@@ -3815,8 +4337,8 @@ socket_submit_outgoing_msg(rpc_transport_t *this, rpc_transport_msg_t *msg)
 
         if (need_append) {
             list_add_tail(&entry->list, &priv->ioq);
-            ret = 0;
         }
+        ret = 0;
         if (need_poll_out) {
             /* first entry to wait. continue writing on POLLOUT */
             priv->idx = gf_event_select_on(ctx->event_pool, priv->sock,
@@ -4035,6 +4557,30 @@ reconfigure(rpc_transport_t *this, dict_t *options)
 
     priv->windowsize = (int)windowsize;
 
+    /* takes effect on the next connection */
+    priv->zerocopy = 0;
+    if (dict_get_str_sizen(options, "transport.socket.zerocopy", &optstr) ==
+        0) {
+        if (gf_string2boolean(optstr, &tmp_bool) != 0) {
+            gf_log(this->name, GF_LOG_ERROR,
+                   "'transport.socket.zerocopy' takes only "
+                   "boolean options, not taking any action");
+            tmp_bool = 0;
+        }
+        priv->zerocopy = tmp_bool;
+    }
+
+    priv->zerocopy_threshold = GF_SOCKET_ZEROCOPY_THRESHOLD;
+    if (dict_get_str_sizen(options, "transport.socket.zerocopy-threshold",
+                           &optstr) == 0) {
+        if (gf_string2bytesize_uint64(optstr, &priv->zerocopy_threshold) !=
+            0) {
+            gf_log(this->name, GF_LOG_ERROR, "invalid number format: %s",
+                   optstr);
+            priv->zerocopy_threshold = GF_SOCKET_ZEROCOPY_THRESHOLD;
+        }
+    }
+
     data = dict_get_sizen(options, "non-blocking-io");
     if (data) {
         optstr = data_to_str(data);
@@ -4293,6 +4839,22 @@ ssl_setup_connection_params(rpc_transport_t *this)
     if (!dict_get_str_sizen(this->options, SSL_EC_CURVE_OPT, &ec_curve)) {
         gf_log(this->name, GF_LOG_INFO, "using EC curve %s", ec_curve);
     }
+    priv->ktls = 0;
+    if (!dict_get_str_sizen(this->options, SSL_KTLS_OPT, &optstr)) {
+        gf_boolean_t ktls = _gf_false;
+
+        if (gf_string2boolean(optstr, &ktls) != 0) {
+            gf_log(this->name, GF_LOG_ERROR,
+                   "invalid value given for %s boolean", SSL_KTLS_OPT);
+        }
+        priv->ktls = ktls;
+#ifndef HAVE_SOCKET_KTLS
+        if (ktls)
+            gf_log(this->name, GF_LOG_WARNING,
+                   "OpenSSL has no kernel TLS support, %s ignored",
+                   SSL_KTLS_OPT);
+#endif
+    }
 
     if (priv->ssl_enabled || priv->mgmt_ssl) {
         BIO *bio = NULL;
@@ -4392,6 +4954,15 @@ ssl_setup_connection_params(rpc_transport_t *this)
 
         SSL_CTX_set_options(priv->ssl_ctx, SSL_OP_CIPHER_SERVER_PREFERENCE);
 
+#ifdef HAVE_SOCKET_KTLS
+        if (priv->ktls) {
+            SSL_CTX_set_options(priv->ssl_ctx, SSL_OP_ENABLE_KTLS);
+            /* TLS 1.3 session tickets arrive as post-handshake records,
+             * which a plain read() of a kTLS socket cannot take */
+            SSL_CTX_set_num_tickets(priv->ssl_ctx, 0);
+        }
+#endif
+
         if (!SSL_CTX_use_certificate_chain_file(priv->ssl_ctx,
                                                 priv->ssl_own_cert)) {
             gf_log(this->name, GF_LOG_ERROR, "could not load our cert at %s",
@@ -4475,6 +5046,8 @@ socket_init(rpc_transport_t *this)
     priv->ssl_connected = _gf_false;
     priv->windowsize = GF_DEFAULT_SOCKET_WINDOW_SIZE;
     INIT_LIST_HEAD(&priv->ioq);
+    INIT_LIST_HEAD(&priv->zc_pending);
+    priv->zerocopy_threshold = GF_SOCKET_ZEROCOPY_THRESHOLD;
     pthread_mutex_init(&priv->notify.lock, NULL);
     pthread_cond_init(&priv->notify.cond, NULL);
 
@@ -4580,6 +5153,28 @@ socket_init(rpc_transport_t *this)
         priv->backlog = GLUSTERFS_SOCKET_LISTEN_BACKLOG;
     }
 
+    if (dict_get_str_sizen(this->options, "transport.socket.zerocopy",
+                           &optstr) == 0) {
+        if (gf_string2boolean(optstr, &tmp_bool) != 0) {
+            gf_log(this->name, GF_LOG_ERROR,
+                   "'transport.socket.zerocopy' takes only "
+                   "boolean options, not taking any action");
+            tmp_bool = 0;
+        }
+        priv->zerocopy = tmp_bool;
+    }
+
+    optstr = NULL;
+    if (dict_get_str_sizen(this->options, "transport.socket.zerocopy-threshold",
+                           &optstr) == 0) {
+        if (gf_string2bytesize_uint64(optstr, &priv->zerocopy_threshold) !=
+            0) {
+            gf_log(this->name, GF_LOG_ERROR, "invalid number format: %s",
+                   optstr);
+            priv->zerocopy_threshold = GF_SOCKET_ZEROCOPY_THRESHOLD;
+        }
+    }
+
     optstr = NULL;
 
     /* Check if socket read failures are to be logged */
@@ -4742,6 +5337,19 @@ struct volume_options options[] = {
      .type = GF_OPTION_TYPE_INT,
      .op_version = {GD_OP_VERSION_3_10_2},
      .default_value = "9"},
+    {.key = {"transport.socket.zerocopy"},
+     .type = GF_OPTION_TYPE_BOOL,
+     .op_version = {GD_OP_VERSION_10_0},
+     .default_value = "off",
+     .description = "Send large payloads with MSG_ZEROCOPY instead of "
+                    "copying them into the socket buffer. Not used with "
+                    "SSL."},
+    {.key = {"transport.socket.zerocopy-threshold"},
+     .type = GF_OPTION_TYPE_SIZET,
+     .op_version = {GD_OP_VERSION_10_0},
+     .default_value = "64KB",
+     .min = 4096,
+     .description = "Smallest payload buffer sent with MSG_ZEROCOPY."},
     {.key = {"transport.socket.read-fail-log"}, .type = GF_OPTION_TYPE_BOOL},
     {.key = {SSL_ENABLED_OPT}, .type = GF_OPTION_TYPE_BOOL},
     {.key = {SSL_OWN_CERT_OPT}, .type = GF_OPTION_TYPE_STR},
@@ -4753,6 +5361,14 @@ struct volume_options options[] = {
     {.key = {SSL_EC_CURVE_OPT}, .type = GF_OPTION_TYPE_STR},
     {.key = {SSL_CRL_PATH_OPT}, .type = GF_OPTION_TYPE_STR},
     {.key = {OWN_THREAD_OPT}, .type = GF_OPTION_TYPE_BOOL},
+    {.key = {SSL_KTLS_OPT},
+     .type = GF_OPTION_TYPE_BOOL,
+     .op_version = {GD_OP_VERSION_10_0},
+     .flags = OPT_FLAG_SETTABLE,
+     .default_value = "off",
+     .description = "Let the kernel encrypt and decrypt TLS records (kTLS) "
+                    "once the handshake is done, where the kernel and "
+                    "OpenSSL support it. Ignored if SSL is not enabled."},
     {.key = {"ssl-own-cert"},
      .op_version = {GD_OP_VERSION_3_7_4},
      .flags = OPT_FLAG_SETTABLE,
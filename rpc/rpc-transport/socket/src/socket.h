@@ -49,6 +49,14 @@
 #define GF_KEEPALIVE_INTERVAL (2)
 #define GF_KEEPALIVE_COUNT (9)
 
+/* Queued messages are gathered into a single sendmsg() of at most this
+ * many iovecs (further capped by IOV_MAX). */
+#define GF_SOCKET_BATCH_IOVEC 256
+
+/* Payload iovecs at least this large are sent with MSG_ZEROCOPY, when
+ * enabled. Below ~10KB page pinning costs more than the copy it saves. */
+#define GF_SOCKET_ZEROCOPY_THRESHOLD (64 * GF_UNIT_KB)
+
 typedef enum {
     SP_STATE_NADA = 0,
     SP_STATE_COMPLETE,
@@ -109,7 +117,9 @@ struct ioq {
     int pending_count;
     struct iobref *iobref;
     uint32_t fraghdr;
-    char _pad[4];
+    uint32_t zc_seq; /* MSG_ZEROCOPY send the entry last went out in */
+    char zerocopy;
+    char _pad[7];
 };
 
 typedef struct {
@@ -162,7 +172,14 @@ struct gf_sock_incoming_frag {
     sp_rpcfrag_state_t state;
 };
 
-#define GF_SOCKET_RA_MAX 1024
+/* Bytes are read off the socket into a per-connection receive buffer, with
+ * one recv() for as many records as have arrived. Complete records up to
+ * GF_SOCKET_RX_INLINE_MAX are handed up in place, the buffer is shared by
+ * reference with the pollin. Reads of at least GF_SOCKET_RX_BUF_SIZE go
+ * straight into their destination once the buffer is drained. */
+#define GF_SOCKET_RX_BUF_SIZE (64 * GF_UNIT_KB)
+#define GF_SOCKET_RX_INLINE_MAX (16 * GF_UNIT_KB)
+#define GF_SOCKET_RX_MIN_FREE (4 * GF_UNIT_KB)
 
 struct gf_sock_incoming {
     char *proghdr_base_addr;
@@ -178,14 +195,14 @@ struct gf_sock_incoming {
     int pending_count;
     size_t total_bytes_read;
 
-    size_t ra_read;
-    size_t ra_max;
-    size_t ra_served;
-    char *ra_buf;
+    struct iobuf *rx_iobuf;
+    size_t rx_start; /* first unconsumed byte in rx_iobuf */
+    size_t rx_end;   /* end of the data received into rx_iobuf */
     uint32_t fraghdr;
     msg_type_t msg_type;
     sp_rpcrecord_state_t record_state;
-    char _pad[4];
+    char rx_shared; /* records in rx_iobuf were handed up in place */
+    char _pad[3];
 };
 
 typedef struct {
@@ -196,6 +213,9 @@ typedef struct {
             struct ioq *ioq_prev;
         };
     };
+    /* entries written out with MSG_ZEROCOPY, kept (with their iobrefs)
+     * until the kernel reports it is done with their pages */
+    struct list_head zc_pending;
     pthread_mutex_t out_lock;
     pthread_mutex_t cond_lock;
     pthread_cond_t cond;
@@ -226,6 +246,9 @@ typedef struct {
     int32_t idx;
     int32_t gen;
     uint32_t backlog;
+    uint32_t zc_sent; /* MSG_ZEROCOPY sends so far, as counted by kernel */
+    uint32_t zc_done; /* sends below this have been completed */
+    uint64_t zerocopy_threshold;
     SSL_METHOD *ssl_meth;
     SSL_CTX *ssl_ctx;
     BIO *ssl_sbio;
@@ -245,6 +268,11 @@ typedef struct {
     char connect_finish_log;
     char submit_log;
     char nodelay;
+    char zerocopy;    /* configured */
+    char zc_active;   /* SO_ZEROCOPY accepted on this socket */
+    char ktls;        /* configured */
+    char ktls_tx;     /* kernel does TLS records on send ... */
+    char ktls_rx;     /* ... and on receive */
     gf_boolean_t read_fail_log;
     gf_boolean_t ssl_enabled; /* outbound I/O */
     gf_boolean_t mgmt_ssl;    /* outbound mgmt */
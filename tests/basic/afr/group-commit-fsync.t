@@ -0,0 +1,35 @@
+#!/bin/bash
+# Changelog fsyncs sent by AFR with ensure-durability go through the
+# group-commit engine of posix when batch-fsync-mode is group-commit.
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+cleanup;
+TEST glusterd
+TEST pidof glusterd
+
+TEST $CLI volume create $V0 replica 2 $H0:$B0/${V0}{0,1}
+TEST $CLI volume set $V0 ensure-durability on
+TEST $CLI volume set $V0 storage.batch-fsync-mode group-commit
+TEST $CLI volume set $V0 performance.write-behind off
+TEST $CLI volume start $V0
+TEST glusterfs --entry-timeout=0 --attribute-timeout=0 -s $H0 --volfile-id=$V0 $M0
+
+# Parallel writers, several of them on the same file, so that batches
+# hold both distinct and repeated inodes.
+for i in {1..8}; do
+        dd if=/dev/urandom of=$M0/file$((i % 4)) bs=4k count=64 \
+           seek=$((i * 64)) conv=notrunc,fsync 2>/dev/null &
+done
+wait
+
+for i in {0..3}; do
+        EXPECT "$(md5sum < $B0/${V0}0/file$i)" echo "$(md5sum < $B0/${V0}1/file$i)"
+done
+
+TEST $CLI volume set $V0 storage.batch-fsync-mode reverse-fsync
+TEST dd if=/dev/zero of=$M0/file4 bs=4k count=16 conv=fsync
+EXPECT "65536" stat -c %s $M0/file4
+
+cleanup;
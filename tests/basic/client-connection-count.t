@@ -0,0 +1,39 @@
+#!/bin/bash
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+function lanes_ready {
+        local fpath=$(generate_mount_statedump $V0 $M0)
+        grep -a "^lane\..*\.ready=1" $fpath | wc -l
+        rm -f $fpath
+}
+
+cleanup;
+
+TEST glusterd;
+
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 client.connection-count 3
+TEST $CLI volume set $V0 performance.write-behind off
+TEST $CLI volume set $V0 performance.io-cache off
+TEST $CLI volume set $V0 performance.quick-read off
+TEST $CLI volume start $V0
+
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0
+EXPECT_WITHIN $PROCESS_UP_TIMEOUT "2" lanes_ready
+
+TEST dd if=/dev/urandom of=$M0/file bs=128k count=64
+EXPECT "$(md5sum < $B0/${V0}0/file)" echo "$(md5sum < $M0/file)"
+
+## fds and locks are shared between the connections
+TEST flock -x $M0/file true
+
+## The lanes follow the main connection over a brick restart
+TEST kill_brick $V0 $H0 $B0/${V0}0
+TEST $CLI volume start $V0 force
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "1" brick_up_status $V0 $H0 $B0/${V0}0
+EXPECT_WITHIN $PROCESS_UP_TIMEOUT "2" lanes_ready
+TEST stat $M0/file
+
+cleanup;
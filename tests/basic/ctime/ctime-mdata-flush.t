@@ -0,0 +1,37 @@
+#!/bin/bash
+# Time attributes kept in memory by storage.mdata-flush-interval must reach
+# the mdata xattr on the brick within the interval, and at once on fsync.
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+cleanup;
+
+function mdata_changed {
+        [ "$(get_mdata $1)" != "$2" ] && echo "Y" || echo "N"
+}
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 storage.mdata-flush-interval 5
+TEST $CLI volume set $V0 performance.stat-prefetch off
+TEST $CLI volume set $V0 performance.write-behind off
+TEST $CLI volume start $V0
+
+TEST glusterfs --volfile-id=$V0 --volfile-server=$H0 --entry-timeout=0 $M0;
+
+TEST touch $M0/FILE
+EXPECT_WITHIN 10 "Y" mdata_changed $B0/${V0}0/FILE ""
+
+mdata=$(get_mdata $B0/${V0}0/FILE)
+TEST touch -m -d @1000000 $M0/FILE
+EXPECT "1000000" stat -c "%Y" $M0/FILE
+EXPECT_WITHIN 10 "Y" mdata_changed $B0/${V0}0/FILE $mdata
+
+TEST $CLI volume set $V0 storage.mdata-flush-interval 60
+mdata=$(get_mdata $B0/${V0}0/FILE)
+TEST touch -m -d @2000000 $M0/FILE
+TEST dd if=/dev/zero of=$M0/FILE bs=1 count=0 conv=notrunc,fsync
+EXPECT "Y" mdata_changed $B0/${V0}0/FILE $mdata
+EXPECT "2000000" stat -c "%Y" $M0/FILE
+
+cleanup;
@@ -0,0 +1,38 @@
+#!/bin/bash
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 $H0:$B0/${V0}{0,1}
+TEST $CLI volume set $V0 performance.write-behind off
+TEST $CLI volume start $V0
+
+## Out of range sizes are refused at the command line
+TEST ! $GFS --volfile-id=/$V0 --volfile-server=$H0 --fuse-max-write=64KB $M0
+TEST ! $GFS --volfile-id=/$V0 --volfile-server=$H0 --fuse-max-write=32MB $M0
+
+## Several readers, each on its own /dev/fuse clone where supported
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 --fuse-max-write=1MB \
+          --reader-thread-count=4 $M0
+
+TEST dd if=/dev/urandom of=$B0/data bs=1M count=16
+TEST dd if=$B0/data of=$M0/file bs=4M oflag=direct
+TEST cmp $B0/data $M0/file
+
+TEST mkdir $M0/dir
+for i in {1..50}; do touch $M0/dir/f$i & done
+wait
+EXPECT "50" echo $(ls $M0/dir | wc -l)
+
+TEST ln -s file $M0/link
+EXPECT "file" readlink $M0/link
+TEST cmp $B0/data $M0/link
+
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+TEST rm -f $B0/data
+
+cleanup;
@@ -0,0 +1,136 @@
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <glusterfs/api/glfs.h>
+
+#define VALIDATE_AND_GOTO_LABEL_ON_ERROR(func, ret, label)                     \
+    do {                                                                       \
+        if (ret < 0) {                                                         \
+            fprintf(stderr, "%s : returned error %d (%s)\n", func, ret,        \
+                    strerror(errno));                                          \
+            goto label;                                                        \
+        }                                                                      \
+    } while (0)
+
+#define IO_SIZE (1024 * 1024)
+
+int
+main(int argc, char *argv[])
+{
+    int ret = -1;
+    glfs_t *fs = NULL;
+    glfs_fd_t *fd1 = NULL;
+    glfs_fd_t *fd2 = NULL;
+    glfs_buf_t *wbuf = NULL;
+    glfs_buf_t *rbuf = NULL;
+    const struct iovec *iov = NULL;
+    char *expect = NULL;
+    size_t done = 0;
+    int cnt = 0;
+    int i = 0;
+
+    if (argc != 3) {
+        fprintf(stderr, "Invalid argument\n");
+        return 1;
+    }
+
+    fs = glfs_new(argv[1]);
+    if (!fs)
+        VALIDATE_AND_GOTO_LABEL_ON_ERROR("glfs_new", ret, out);
+
+    ret = glfs_set_volfile_server(fs, "tcp", "localhost", 24007);
+    VALIDATE_AND_GOTO_LABEL_ON_ERROR("glfs_set_volfile_server", ret, out);
+
+    ret = glfs_set_logging(fs, argv[2], 7);
+    VALIDATE_AND_GOTO_LABEL_ON_ERROR("glfs_set_logging", ret, out);
+
+    ret = glfs_init(fs);
+    VALIDATE_AND_GOTO_LABEL_ON_ERROR("glfs_init", ret, out);
+
+    fd1 = glfs_creat(fs, "buf-src", O_RDWR, 0644);
+    fd2 = glfs_creat(fs, "buf-dst", O_RDWR, 0644);
+    if (!fd1 || !fd2) {
+        ret = -1;
+        VALIDATE_AND_GOTO_LABEL_ON_ERROR("glfs_creat", ret, out);
+    }
+
+    /* fill a library buffer and write it out */
+    wbuf = glfs_buf_get(fs, IO_SIZE);
+    if (!wbuf) {
+        ret = -1;
+        VALIDATE_AND_GOTO_LABEL_ON_ERROR("glfs_buf_get", ret, out);
+    }
+
+    cnt = glfs_buf_iov(wbuf, &iov);
+    if (cnt != 1 || iov[0].iov_len < IO_SIZE) {
+        fprintf(stderr, "bad write buffer: %d segments\n", cnt);
+        ret = -1;
+        goto out;
+    }
+    for (i = 0; i < IO_SIZE; i++)
+        ((char *)iov[0].iov_base)[i] = i % 251;
+
+    expect = malloc(IO_SIZE);
+    if (!expect) {
+        ret = -1;
+        goto out;
+    }
+    memcpy(expect, iov[0].iov_base, IO_SIZE);
+
+    ret = glfs_pwrite_buf(fd1, wbuf, IO_SIZE, 0, 0, NULL, NULL);
+    VALIDATE_AND_GOTO_LABEL_ON_ERROR("glfs_pwrite_buf", ret, out);
+
+    /* read it back without copying, and pass it on to another file */
+    ret = glfs_pread_buf(fd1, IO_SIZE, 0, 0, &rbuf, NULL);
+    VALIDATE_AND_GOTO_LABEL_ON_ERROR("glfs_pread_buf", ret, out);
+    if (ret != IO_SIZE) {
+        fprintf(stderr, "short read %d\n", ret);
+        ret = -1;
+        goto out;
+    }
+
+    cnt = glfs_buf_iov(rbuf, &iov);
+    for (i = 0; i < cnt; i++) {
+        if (memcmp(expect + done, iov[i].iov_base, iov[i].iov_len)) {
+            fprintf(stderr, "data mismatch in segment %d\n", i);
+            ret = -1;
+            goto out;
+        }
+        done += iov[i].iov_len;
+    }
+
+    ret = glfs_pwrite_buf(fd2, rbuf, IO_SIZE / 2, 0, 0, NULL, NULL);
+    VALIDATE_AND_GOTO_LABEL_ON_ERROR("glfs_pwrite_buf", ret, out);
+    if (ret != IO_SIZE / 2) {
+        fprintf(stderr, "short write %d\n", ret);
+        ret = -1;
+        goto out;
+    }
+
+    /* nothing to lend past the end of the file */
+    glfs_buf_release(rbuf);
+    rbuf = NULL;
+    ret = glfs_pread_buf(fd2, IO_SIZE, IO_SIZE, 0, &rbuf, NULL);
+    VALIDATE_AND_GOTO_LABEL_ON_ERROR("glfs_pread_buf", ret, out);
+    if (ret != 0 || rbuf) {
+        fprintf(stderr, "read past eof returned %d\n", ret);
+        ret = -1;
+        goto out;
+    }
+
+    ret = 0;
+out:
+    glfs_buf_release(rbuf);
+    glfs_buf_release(wbuf);
+    free(expect);
+    if (fd1 != NULL)
+        glfs_close(fd1);
+    if (fd2 != NULL)
+        glfs_close(fd2);
+    if (fs)
+        (void)glfs_fini(fs);
+
+    return ret;
+}
@@ -0,0 +1,27 @@
+#!/bin/bash
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+cleanup;
+
+TEST glusterd
+
+TEST $CLI volume create $V0 ${H0}:$B0/brick1;
+EXPECT 'Created' volinfo_field $V0 'Status';
+
+TEST $CLI volume start $V0;
+EXPECT 'Started' volinfo_field $V0 'Status';
+
+logdir=`gluster --print-logdir`
+
+build_tester $(dirname $0)/gfapi-buf-io.c -lgfapi
+
+TEST ./$(dirname $0)/gfapi-buf-io $V0 $logdir/gfapi-buf-io.log
+
+TEST cmp -n 524288 $B0/brick1/buf-src $B0/brick1/buf-dst
+EXPECT "524288" stat -c %s $B0/brick1/buf-dst
+
+cleanup_tester $(dirname $0)/gfapi-buf-io
+
+cleanup;
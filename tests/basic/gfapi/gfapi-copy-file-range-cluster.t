@@ -0,0 +1,88 @@
+#!/bin/bash
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+cleanup;
+
+mkfs.xfs 2>&1 | grep reflink
+if [ $? -ne 0 ]; then
+    SKIP_TESTS
+    exit
+fi
+
+function copy_and_compare {
+        local src=$1
+        local dst=$2
+
+        ./$(dirname $0)/glfs-copy-file-range $H0 $V0 \
+                $logdir/gfapi-copy-file-range.log $src $dst || return 1
+        cmp $M0$src $M0$dst
+}
+
+function copy_error {
+        timeout 60 ./$(dirname $0)/glfs-copy-file-range $H0 $V0 \
+                $logdir/gfapi-copy-file-range.log $1 $2 2>&1 >/dev/null |
+                sed -n 's/^copy_file_range failed with //p'
+}
+
+TEST glusterd
+
+TEST truncate -s 2G $B0/xfs_image
+TEST mkfs.xfs -f -i size=512 -m reflink=1 $B0/xfs_image;
+
+TEST mkdir $B0/bricks
+TEST mount -t xfs -o loop $B0/xfs_image $B0/bricks
+
+logdir=`gluster --print-logdir`
+TEST build_tester $(dirname $0)/glfs-copy-file-range.c -lgfapi
+
+# Replicate: every brick copies from its own replica of the source.
+TEST $CLI volume create $V0 replica 3 $H0:$B0/bricks/brick{0,1,2};
+TEST $CLI volume start $V0;
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0
+
+TEST dd if=/dev/urandom of=$M0/file bs=1M count=64;
+TEST copy_and_compare /file /new
+TEST cmp $B0/bricks/brick0/new $B0/bricks/brick1/new
+TEST cmp $B0/bricks/brick0/new $B0/bricks/brick2/new
+EXPECT "^0$" get_pending_heal_count $V0
+
+# Sharded: the copy is cut at block boundaries and each block is copied
+# on the bricks holding it.
+TEST $CLI volume set $V0 features.shard on
+TEST $CLI volume set $V0 features.shard-block-size 4MB
+TEST dd if=/dev/urandom of=$M0/sharded bs=1M count=21;
+TEST copy_and_compare /sharded /sharded-new
+EXPECT "^22020096$" stat -c %s $M0/sharded-new
+
+# Sparse sharded source: the base file and the second block are shorter
+# than the logical range. The copy must not stop early as if at EOF, it
+# has to tell the caller to fall back to read/write instead.
+TEST truncate -s 21M $M0/sparse
+TEST dd if=/dev/urandom of=$M0/sparse bs=1M count=1 seek=5 conv=notrunc
+EXPECT "Invalid cross-device link" copy_error /sparse /sparse-new
+
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+TEST $CLI volume stop $V0
+TEST $CLI volume delete $V0
+
+# Disperse: whole stripes are copied fragment by fragment.
+TEST $CLI volume create $V0 disperse 3 redundancy 1 \
+        $H0:$B0/bricks/ec{0,1,2} force;
+TEST $CLI volume start $V0;
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0
+
+TEST dd if=/dev/urandom of=$M0/file bs=1M count=16;
+TEST copy_and_compare /file /new
+EXPECT "^0$" get_pending_heal_count $V0
+
+cleanup_tester $(dirname $0)/glfs-copy-file-range
+
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+TEST $CLI volume stop $V0
+TEST $CLI volume delete $V0
+
+UMOUNT_LOOP $B0/bricks;
+
+cleanup;
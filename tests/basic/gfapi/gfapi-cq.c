@@ -0,0 +1,197 @@
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <glusterfs/api/glfs.h>
+#include <glusterfs/api/glfs-handles.h>
+
+#define VALIDATE_AND_GOTO_LABEL_ON_ERROR(func, ret, label)                     \
+    do {                                                                       \
+        if (ret < 0) {                                                         \
+            fprintf(stderr, "%s : returned error %d (%s)\n", func, ret,        \
+                    strerror(errno));                                          \
+            goto label;                                                        \
+        }                                                                      \
+    } while (0)
+
+#define NR_OPS 16
+#define IO_SIZE (64 * 1024)
+
+static char wbuf[NR_OPS][IO_SIZE];
+static char rbuf[NR_OPS][IO_SIZE];
+
+/* reap exactly @nr completions, checking each */
+static int
+reap(glfs_cq_t *cq, int nr, ssize_t expect, struct glfs_cqe *out)
+{
+    struct glfs_cqe cqes[NR_OPS];
+    int done = 0;
+    int ret = 0;
+    int i = 0;
+
+    while (done < nr) {
+        ret = glfs_cq_wait(cq, cqes, NR_OPS, 1, NULL);
+        if (ret < 0)
+            return ret;
+        for (i = 0; i < ret; i++) {
+            if (cqes[i].res != expect) {
+                fprintf(stderr, "op %ld: res %zd, expected %zd\n",
+                        (long)(intptr_t)cqes[i].data, cqes[i].res, expect);
+                return -1;
+            }
+            if (out)
+                out[(intptr_t)cqes[i].data] = cqes[i];
+        }
+        done += ret;
+    }
+
+    return 0;
+}
+
+int
+main(int argc, char *argv[])
+{
+    int ret = -1;
+    glfs_t *fs = NULL;
+    glfs_cq_t *cq = NULL;
+    glfs_fd_t *fd = NULL;
+    glfs_object_t *root = NULL;
+    struct glfs_cqe cqes[NR_OPS];
+    struct iovec iov[NR_OPS];
+    struct stat st;
+    struct pollfd pfd;
+    int i = 0;
+
+    if (argc != 3) {
+        fprintf(stderr, "Invalid argument\n");
+        return 1;
+    }
+
+    fs = glfs_new(argv[1]);
+    if (!fs)
+        VALIDATE_AND_GOTO_LABEL_ON_ERROR("glfs_new", ret, out);
+
+    ret = glfs_set_volfile_server(fs, "tcp", "localhost", 24007);
+    VALIDATE_AND_GOTO_LABEL_ON_ERROR("glfs_set_volfile_server", ret, out);
+
+    ret = glfs_set_logging(fs, argv[2], 7);
+    VALIDATE_AND_GOTO_LABEL_ON_ERROR("glfs_set_logging", ret, out);
+
+    ret = glfs_init(fs);
+    VALIDATE_AND_GOTO_LABEL_ON_ERROR("glfs_init", ret, out);
+
+    cq = glfs_cq_new(fs, NR_OPS);
+    if (!cq) {
+        ret = -1;
+        VALIDATE_AND_GOTO_LABEL_ON_ERROR("glfs_cq_new", ret, out);
+    }
+
+    root = glfs_h_lookupat(fs, NULL, "/", &st, 0);
+    if (!root) {
+        ret = -1;
+        VALIDATE_AND_GOTO_LABEL_ON_ERROR("glfs_h_lookupat", ret, out);
+    }
+
+    /* create through the queue, then open what it returned */
+    ret = glfs_cq_h_creat(cq, root, "cq-file", O_RDWR, 0644, (void *)0);
+    VALIDATE_AND_GOTO_LABEL_ON_ERROR("glfs_cq_h_creat", ret, out);
+    ret = reap(cq, 1, 0, cqes);
+    VALIDATE_AND_GOTO_LABEL_ON_ERROR("reap creat", ret, out);
+
+    fd = glfs_h_open(fs, cqes[0].object, O_RDWR);
+    glfs_h_close(cqes[0].object);
+    if (!fd) {
+        ret = -1;
+        VALIDATE_AND_GOTO_LABEL_ON_ERROR("glfs_h_open", ret, out);
+    }
+
+    /* a full queue of writes, and one more which must be refused */
+    for (i = 0; i < NR_OPS; i++) {
+        memset(wbuf[i], 'a' + i, IO_SIZE);
+        iov[i].iov_base = wbuf[i];
+        iov[i].iov_len = IO_SIZE;
+        ret = glfs_cq_pwritev(cq, fd, &iov[i], 1, (off_t)i * IO_SIZE, 0,
+                              (void *)(intptr_t)i);
+        VALIDATE_AND_GOTO_LABEL_ON_ERROR("glfs_cq_pwritev", ret, out);
+    }
+
+    ret = glfs_cq_fsync(cq, fd, NULL);
+    if (ret != -1 || errno != EAGAIN) {
+        fprintf(stderr, "submission past the queue depth: %d\n", ret);
+        ret = -1;
+        goto out;
+    }
+
+    /* the notification fd polls readable once something completed */
+    pfd.fd = glfs_cq_fd(cq);
+    pfd.events = POLLIN;
+    ret = poll(&pfd, 1, 60000);
+    if (ret != 1) {
+        fprintf(stderr, "notification fd not readable: %d\n", ret);
+        ret = -1;
+        goto out;
+    }
+
+    ret = reap(cq, NR_OPS, IO_SIZE, NULL);
+    VALIDATE_AND_GOTO_LABEL_ON_ERROR("reap writes", ret, out);
+
+    ret = glfs_cq_fsync(cq, fd, NULL);
+    VALIDATE_AND_GOTO_LABEL_ON_ERROR("glfs_cq_fsync", ret, out);
+    ret = reap(cq, 1, 0, NULL);
+    VALIDATE_AND_GOTO_LABEL_ON_ERROR("reap fsync", ret, out);
+
+    /* nothing outstanding, nothing to wait for */
+    ret = glfs_cq_wait(cq, cqes, NR_OPS, 0, NULL);
+    if (ret != 0) {
+        fprintf(stderr, "spurious completions: %d\n", ret);
+        ret = -1;
+        goto out;
+    }
+
+    for (i = 0; i < NR_OPS; i++) {
+        iov[i].iov_base = rbuf[i];
+        ret = glfs_cq_preadv(cq, fd, &iov[i], 1, (off_t)i * IO_SIZE, 0,
+                             (void *)(intptr_t)i);
+        VALIDATE_AND_GOTO_LABEL_ON_ERROR("glfs_cq_preadv", ret, out);
+    }
+    ret = reap(cq, NR_OPS, IO_SIZE, NULL);
+    VALIDATE_AND_GOTO_LABEL_ON_ERROR("reap reads", ret, out);
+
+    if (memcmp(wbuf, rbuf, sizeof(wbuf))) {
+        fprintf(stderr, "data mismatch\n");
+        ret = -1;
+        goto out;
+    }
+
+    ret = glfs_cq_h_lookupat(cq, root, "cq-file", 0, (void *)0);
+    VALIDATE_AND_GOTO_LABEL_ON_ERROR("glfs_cq_h_lookupat", ret, out);
+    ret = reap(cq, 1, 0, cqes);
+    VALIDATE_AND_GOTO_LABEL_ON_ERROR("reap lookup", ret, out);
+    glfs_h_close(cqes[0].object);
+    if (cqes[0].st.st_size != NR_OPS * IO_SIZE) {
+        fprintf(stderr, "lookup size %jd\n", (intmax_t)cqes[0].st.st_size);
+        ret = -1;
+        goto out;
+    }
+
+    /* leave some completions for glfs_cq_destroy() to clean up */
+    ret = glfs_cq_pread_buf(cq, fd, IO_SIZE, 0, 0, NULL);
+    VALIDATE_AND_GOTO_LABEL_ON_ERROR("glfs_cq_pread_buf", ret, out);
+    ret = glfs_cq_h_lookupat(cq, root, "cq-file", 0, NULL);
+    VALIDATE_AND_GOTO_LABEL_ON_ERROR("glfs_cq_h_lookupat", ret, out);
+
+    ret = 0;
+out:
+    if (cq)
+        glfs_cq_destroy(cq);
+    if (root)
+        glfs_h_close(root);
+    if (fd != NULL)
+        glfs_close(fd);
+    if (fs)
+        (void)glfs_fini(fs);
+
+    return ret;
+}
@@ -0,0 +1,26 @@
+#!/bin/bash
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+cleanup;
+
+TEST glusterd
+
+TEST $CLI volume create $V0 ${H0}:$B0/brick1;
+EXPECT 'Created' volinfo_field $V0 'Status';
+
+TEST $CLI volume start $V0;
+EXPECT 'Started' volinfo_field $V0 'Status';
+
+logdir=`gluster --print-logdir`
+
+build_tester $(dirname $0)/gfapi-cq.c -lgfapi
+
+TEST ./$(dirname $0)/gfapi-cq $V0 $logdir/gfapi-cq.log
+
+EXPECT "1048576" stat -c %s $B0/brick1/cq-file
+
+cleanup_tester $(dirname $0)/gfapi-cq
+
+cleanup;
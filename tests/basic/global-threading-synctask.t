@@ -0,0 +1,81 @@
+#!/bin/bash
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+function thread_count {
+        ps hH -o comm $1 | grep -c "$2"
+}
+
+function create_files {
+        local i
+        mkdir -p $1/deep/$(seq -s/ 1 32) || return 1
+        for i in $(seq 1 50); do
+                mkdir $1/d$i && echo "data $i" > $1/d$i/f || return 1
+        done
+        dd if=/dev/urandom of=$1/big bs=1M count=8 status=none && echo Y
+}
+
+function bricks_match {
+        local f
+        for f in d1/f d25/f d50/f big; do
+                cmp -s $B0/${V0}0/$1/$f $B0/${V0}2/$1/$f || return 1
+        done
+        [ -d $B0/${V0}2/$1/deep/$(seq -s/ 1 32) ] && echo Y
+}
+
+function stat_all {
+        find $1 -exec stat {} + > /dev/null && echo Y
+}
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+
+TEST $CLI volume create $V0 replica 3 $H0:$B0/${V0}{0,1,2}
+TEST $CLI volume set $V0 cluster.heal-timeout 5
+TEST $CLI volume start $V0
+EXPECT_WITHIN $PROCESS_UP_TIMEOUT "Y" glustershd_up_status
+
+# The self-heal daemon runs on the global thread pool: its heals are run
+# by the pool's workers, there are no synctask threads.
+shd=$(get_shd_process_pid)
+TEST [ $(thread_count $shd glfs_tpw) -ge 1 ]
+EXPECT "0" thread_count $shd glfs_sproc
+
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0
+TEST mkdir $M0/shd
+TEST kill_brick $V0 $H0 $B0/${V0}2
+EXPECT "Y" create_files $M0/shd
+TEST $CLI volume start $V0 force
+EXPECT_WITHIN $PROCESS_UP_TIMEOUT "1" afr_child_up_status_in_shd $V0 2
+TEST $CLI volume heal $V0
+EXPECT_WITHIN $HEAL_TIMEOUT "^0$" get_pending_heal_count $V0
+EXPECT "Y" bricks_match shd
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+
+# The same for heals done by a client using the pool.
+TEST $CLI volume set $V0 cluster.self-heal-daemon off
+TEST $CLI volume set $V0 cluster.data-self-heal on
+TEST $CLI volume set $V0 cluster.metadata-self-heal on
+TEST $CLI volume set $V0 cluster.entry-self-heal on
+TEST $CLI volume set $V0 performance.client-io-threads off
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 --global-threading $M0
+mnt=$(get_mount_process_pid $V0 $M0)
+TEST [ $(thread_count $mnt glfs_tpw) -ge 1 ]
+EXPECT "0" thread_count $mnt glfs_sproc
+
+TEST mkdir $M0/client
+TEST kill_brick $V0 $H0 $B0/${V0}2
+EXPECT "Y" create_files $M0/client
+TEST $CLI volume start $V0 force
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "1" afr_child_up_status $V0 2
+EXPECT "Y" stat_all $M0/client
+TEST "cat $M0/client/big $M0/client/d{1,25,50}/f > /dev/null"
+EXPECT_WITHIN $HEAL_TIMEOUT "^0$" get_pending_heal_count $V0
+EXPECT "Y" bricks_match client
+
+TEST rm -rf $M0/shd $M0/client
+TEST force_umount $M0
+cleanup;
@@ -0,0 +1,41 @@
+#!/bin/bash
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 storage.handle-cache-size 1024
+TEST $CLI volume set $V0 performance.stat-prefetch off
+TEST $CLI volume start $V0
+
+TEST $GFS -s $H0 --volfile-id=$V0 $M0
+
+TEST mkdir -p $M0/a/b/c/d/e/f
+TEST touch $M0/a/b/c/d/e/f/file1
+TEST -f $B0/${V0}0/a/b/c/d/e/f/file1
+
+# Renaming an ancestor must retire the cached paths of its subtree.
+TEST mv $M0/a/b $M0/a/B
+TEST touch $M0/a/B/c/d/e/f/file2
+TEST -f $B0/${V0}0/a/B/c/d/e/f/file2
+TEST ! -d $B0/${V0}0/a/b
+
+# A directory re-created under the same name gets a new gfid.
+TEST rm -rf $M0/a/B/c/d/e/f
+TEST mkdir $M0/a/B/c/d/e/f
+TEST touch $M0/a/B/c/d/e/f/file3
+TEST -f $B0/${V0}0/a/B/c/d/e/f/file3
+EXPECT "1" echo $(ls $M0/a/B/c/d/e/f | wc -l)
+
+# Turning the cache off must keep resolving through the handles.
+TEST $CLI volume set $V0 storage.handle-cache-size 0
+TEST touch $M0/a/B/c/d/e/f/file4
+TEST -f $B0/${V0}0/a/B/c/d/e/f/file4
+
+TEST force_umount $M0
+cleanup;
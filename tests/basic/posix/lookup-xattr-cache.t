@@ -0,0 +1,47 @@
+#!/bin/bash
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+function get_xattr {
+        getfattr --only-values -n $1 $2 2>/dev/null
+}
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+
+TEST $CLI volume create $V0 replica 3 $H0:$B0/${V0}{0,1,2}
+TEST $CLI volume set $V0 storage.lookup-xattr-cache on
+TEST $CLI volume set $V0 performance.xattr-cache-list "user.*"
+TEST $CLI volume set $V0 performance.md-cache-timeout 1
+TEST $CLI volume start $V0
+
+TEST $GFS -s $H0 --volfile-id=$V0 $M0
+
+TEST touch $M0/file1
+TEST setfattr -n user.foo -v one $M0/file1
+
+# Let the brick snapshot the xattrs on the next lookups.
+sleep 2
+TEST stat $M0/file1
+EXPECT "one" get_xattr user.foo $M0/file1
+
+# Updates through the volume drop the snapshot.
+TEST setfattr -n user.foo -v two $M0/file1
+EXPECT_WITHIN 3 "two" get_xattr user.foo $M0/file1
+
+# So do changes that never reach posix: the ctime moves.
+sleep 2
+TEST stat $M0/file1
+for i in 0 1 2; do
+        TEST setfattr -n user.foo -v three $B0/${V0}$i/file1
+done
+EXPECT_WITHIN 3 "three" get_xattr user.foo $M0/file1
+
+TEST setfattr -x user.foo $M0/file1
+EXPECT_WITHIN 3 "" get_xattr user.foo $M0/file1
+
+TEST force_umount $M0
+cleanup;
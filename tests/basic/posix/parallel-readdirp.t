@@ -0,0 +1,33 @@
+#!/bin/bash
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 performance.stat-prefetch off
+TEST $CLI volume set $V0 performance.md-cache-timeout 0
+TEST $CLI volume start $V0
+
+TEST $GFS -s $H0 --volfile-id=$V0 $M0
+
+TEST mkdir $M0/dir
+TEST touch $M0/dir/file{1..1000}
+TEST mkdir $M0/dir/subdir{1..100}
+TEST ln -s file1 $M0/dir/link
+
+# Listings must be the same whether entries are filled serially or by
+# parallel tasks.
+serial=$(ls -ln --time-style=+%s $M0/dir | md5sum)
+TEST $CLI volume set $V0 storage.parallel-readdirp on
+
+EXPECT "1101" echo $(ls $M0/dir | wc -l)
+EXPECT "$serial" echo "$(ls -ln --time-style=+%s $M0/dir | md5sum)"
+EXPECT "link -> file1" echo "$(ls -l $M0/dir/link | sed 's/.* link/link/')"
+
+TEST force_umount $M0
+cleanup;
@@ -0,0 +1,58 @@
+#!/bin/bash
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+function stream_stat {
+        local fpath=$(generate_brick_statedump $V0 $H0 $B0/${V0}0)
+        grep -a "^$1=" $fpath | head -1 | cut -f2 -d'='
+        rm -f $fpath
+}
+
+# MB of the brick file in the page cache
+function resident_mb {
+        echo $(( $(fincore --bytes --noheadings --output RES $1) / 1048576 ))
+}
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 storage.stream-drop-behind 4MB
+TEST $CLI volume set $V0 performance.write-behind off
+TEST $CLI volume set $V0 performance.io-cache off
+TEST $CLI volume set $V0 performance.read-ahead off
+TEST $CLI volume start $V0
+
+TEST $GFS -s $H0 --volfile-id=$V0 $M0
+
+# A stream long enough to be written back and dropped behind itself.
+TEST dd if=/dev/urandom of=$B0/stream.src bs=1M count=64
+TEST dd if=$B0/stream.src of=$M0/stream bs=128k
+EXPECT "1" stream_stat streams_detected
+EXPECT "$(md5sum < $B0/stream.src)" echo "$(md5sum < $M0/stream)"
+EXPECT "$(md5sum < $B0/stream.src)" echo "$(md5sum < $B0/${V0}0/stream)"
+
+# Read back from a cold cache, no more than a few windows of the brick
+# file stay behind the stream.
+detected=$(stream_stat streams_detected)
+drop_cache $M0
+TEST cat $M0/stream > /dev/null
+EXPECT "$((detected + 1))" stream_stat streams_detected
+if which fincore > /dev/null; then
+        TEST [ $(resident_mb $B0/${V0}0/stream) -lt 32 ]
+fi
+
+# Random access in between must not lose or reorder data.
+TEST dd if=/dev/zero of=$M0/stream bs=1M seek=20 count=1 conv=notrunc
+TEST dd if=/dev/zero of=$B0/stream.src bs=1M seek=20 count=1 conv=notrunc
+EXPECT "$(md5sum < $B0/stream.src)" echo "$(md5sum < $M0/stream)"
+
+TEST $CLI volume set $V0 storage.stream-drop-behind 0
+EXPECT "$(md5sum < $B0/stream.src)" echo "$(md5sum < $M0/stream)"
+
+TEST rm -f $B0/stream.src
+TEST force_umount $M0
+cleanup;
@@ -0,0 +1,45 @@
+#!/bin/bash
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+function reclaim_stat {
+        local fpath=$(generate_brick_statedump $V0 $H0 $B0/${V0}0)
+        grep -a "^$1=" $fpath | cut -f2 -d'='
+        rm -f $fpath
+}
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 storage.reclaim-threshold 64MB
+TEST $CLI volume set $V0 storage.reclaim-rate 32MB
+TEST $CLI volume start $V0
+
+TEST $GFS -s $H0 --volfile-id=$V0 $M0
+
+TEST dd if=/dev/zero of=$M0/big bs=1M count=256 conv=fsync
+TEST dd if=/dev/zero of=$M0/small bs=1M count=8 conv=fsync
+gfid=$(gf_get_gfid_backend_file_path $B0/${V0}0 big)
+
+# The unlink returns at once, the blocks are freed at the set rate.
+TEST rm -f $M0/big $M0/small
+TEST ! -e $B0/${V0}0/big
+TEST ! -e $gfid
+EXPECT "1" reclaim_stat reclaim_queued
+EXPECT_WITHIN 30 "0" reclaim_stat reclaim_queued
+EXPECT "268435456" reclaim_stat reclaim_freed_bytes
+
+# Open fds keep the data: such files are left to their last close.
+TEST dd if=/dev/zero of=$M0/held bs=1M count=128 conv=fsync
+exec 5<$M0/held
+TEST rm -f $M0/held
+EXPECT "0" reclaim_stat reclaim_queued
+TEST cat <&5 >/dev/null
+exec 5<&-
+
+TEST force_umount $M0
+cleanup;
@@ -0,0 +1,38 @@
+#!/bin/bash
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+function fair_share_clients {
+        local fpath=$(generate_brick_statedump $V0 $H0 $B0/${V0}0)
+        grep -a "^fair-share\." $fpath | wc -l
+        rm -f $fpath
+}
+
+cleanup;
+
+TEST glusterd;
+
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 server.fair-share on
+TEST $CLI volume set $V0 server.fair-share-internal-weight 1
+TEST $CLI volume start $V0
+
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M1
+
+TEST mkdir $M0/dir
+for i in {1..50}; do echo $i > $M0/dir/file$i; done
+TEST dd if=/dev/zero of=$M1/big bs=128k count=64 conv=fsync
+EXPECT "50" echo $(ls $M1/dir | wc -l)
+EXPECT "8388608" stat -c %s $M0/big
+
+## Both mounts show up with their queueing stats
+EXPECT_WITHIN $PROCESS_UP_TIMEOUT "2" fair_share_clients
+
+## Switching it off on the fly keeps the queues draining
+TEST $CLI volume set $V0 server.fair-share off
+TEST touch $M0/dir/file51
+EXPECT "51" echo $(ls $M1/dir | wc -l)
+
+cleanup;
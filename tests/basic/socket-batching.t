@@ -0,0 +1,67 @@
+#!/bin/bash
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+# Many small requests in flight at once, so that several of them are
+# queued on the socket and go out in one sendmsg.
+function small_writers {
+        local i
+        for i in $(seq 1 16); do
+                dd if=$1 of=$2/small$i bs=4k oflag=direct status=none &
+        done
+        wait
+        for i in $(seq 1 16); do
+                cmp -s $1 $2/small$i || return 1
+        done
+        echo Y
+}
+
+function big_copy {
+        dd if=$1 of=$2 bs=1M oflag=direct status=none && \
+                cmp -s $1 $2 && echo Y
+}
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+
+TEST dd if=/dev/urandom of=$B0/small bs=4k count=64 status=none
+TEST dd if=/dev/urandom of=$B0/big bs=1M count=32 status=none
+
+TEST $CLI volume create $V0 $H0:$B0/${V0}{0,1}
+TEST $CLI volume set $V0 performance.write-behind off
+TEST $CLI volume set $V0 performance.io-cache off
+TEST $CLI volume set $V0 performance.read-ahead off
+TEST $CLI volume set $V0 performance.quick-read off
+TEST $CLI volume start $V0
+
+TEST $GFS -s $H0 --volfile-id=$V0 --direct-io-mode=yes $M0
+TEST mkdir $M0/dir
+
+# Batched sends keep every message whole and in order.
+EXPECT "Y" small_writers $B0/small $M0/dir
+EXPECT "Y" big_copy $B0/big $M0/dir/big
+TEST rm -f $M0/dir/*
+
+# The same with the large payloads sent with MSG_ZEROCOPY, both ways. On
+# loopback the kernel copies them anyway and the connection falls back to
+# plain sends after the first completions.
+TEST $CLI volume set $V0 client.zerocopy on
+TEST $CLI volume set $V0 server.zerocopy on
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+TEST $CLI volume stop $V0
+TEST $CLI volume start $V0
+TEST $GFS -s $H0 --volfile-id=$V0 --direct-io-mode=yes $M0
+
+EXPECT "Y" small_writers $B0/small $M0/dir
+EXPECT "Y" big_copy $B0/big $M0/dir/big
+TEST drop_cache $M0
+EXPECT "Y" big_copy $M0/dir/big $M0/dir/big2
+EXPECT "Y" big_copy $M0/dir/big $M0/dir/big3
+
+TEST rm -rf $M0/dir
+TEST force_umount $M0
+TEST rm -f $B0/small $B0/big
+cleanup;
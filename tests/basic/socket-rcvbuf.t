@@ -0,0 +1,78 @@
+#!/bin/bash
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+# Reads and writes whose records land on either side of the in-place limit
+# and of the size of the receive buffer.
+function sizes_check {
+        local s
+        for s in 1 4095 16383 16384 16385 65535 65536 65537 200000; do
+                head -c $s $1 > $2/f$s || return 1
+        done
+        drop_cache
+        for s in 1 4095 16383 16384 16385 65535 65536 65537 200000; do
+                cmp -s <(head -c $s $1) $2/f$s || return 1
+        done
+        echo Y
+}
+
+# Many small replies queued on the connection at once.
+function lookup_storm {
+        local i
+        for i in $(seq 1 8); do
+                (for f in $1/m*; do stat -c %s $f; done > $2.$i) &
+        done
+        wait
+        for i in $(seq 1 8); do
+                [ $(grep -c '^5$' $2.$i) -eq 100 ] || return 1
+        done
+        rm -f $2.*
+        echo Y
+}
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+
+TEST dd if=/dev/urandom of=$B0/data bs=200000 count=1 status=none
+
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 performance.stat-prefetch off
+TEST $CLI volume set $V0 performance.quick-read off
+TEST $CLI volume set $V0 performance.io-cache off
+TEST $CLI volume set $V0 performance.read-ahead off
+TEST $CLI volume set $V0 performance.write-behind off
+TEST $CLI volume start $V0
+
+TEST $GFS -s $H0 --volfile-id=$V0 --direct-io-mode=yes $M0
+TEST $GFS -s $H0 --volfile-id=$V0 --direct-io-mode=yes $M1
+
+TEST mkdir $M0/dir
+for i in $(seq 1 100); do
+        echo "meta" > $M0/dir/m$i
+done
+
+EXPECT "Y" sizes_check $B0/data $M0/dir
+EXPECT "Y" lookup_storm $M0/dir $B0/stat
+
+# A lock request that waits on the brick keeps its record around, the
+# connection goes on serving the others meanwhile.
+TEST touch $M0/dir/lock
+exec 5>$M1/dir/lock
+TEST flock -x 5
+flock -x $M0/dir/lock -c "echo taken > $B0/waiter" &
+waiter=$!
+EXPECT "Y" lookup_storm $M0/dir $B0/stat
+TEST [ ! -e $B0/waiter ]
+TEST flock -u 5
+exec 5>&-
+EXPECT_WITHIN 10 "taken" cat $B0/waiter
+wait $waiter
+
+TEST rm -rf $M0/dir
+TEST force_umount $M0
+TEST force_umount $M1
+TEST rm -f $B0/data $B0/waiter
+cleanup;
@@ -0,0 +1,73 @@
+#!/bin/bash
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+function mdc_stat {
+        local fpath=$(generate_mount_statedump $V0 $1)
+        grep -a "^$2=" $fpath | head -1 | cut -f2 -d'='
+        rm -f $fpath
+}
+
+## Looks the directory up until md-cache asks the brick for it again, so that
+## its attributes are cached under the lease
+function lookup_anew {
+        local misses=$(mdc_stat $1 stat_miss_count)
+        stat $1/$2 > /dev/null
+        [ $(mdc_stat $1 stat_miss_count) -gt $misses ] && echo Y
+}
+
+## The mode stays the same across a few md-cache-timeouts
+function mode_kept {
+        local i
+        for i in 1 2 3; do
+                [ "$(stat -c '%a' $1)" == "$2" ] || return 1
+                sleep 1
+        done
+        echo Y
+}
+
+cleanup;
+
+TEST glusterd;
+
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 leases on
+TEST $CLI volume set $V0 performance.md-cache-timeout 1
+TEST $CLI volume set $V0 performance.md-cache-dir-leases on
+TEST $CLI volume start $V0
+
+TEST glusterfs --volfile-id=/$V0 --volfile-server=$H0 $M0 --attribute-timeout=0 --entry-timeout=0
+TEST glusterfs --volfile-id=/$V0 --volfile-server=$H0 $M1 --attribute-timeout=0 --entry-timeout=0
+
+TEST mkdir $M0/dir
+TEST chmod 755 $M0/dir
+TEST touch $M0/dir/file
+
+## Looking the directory up from mount-1 takes a lease on it
+TEST stat $M1/dir
+EXPECT_WITHIN 5 "1" mdc_stat $M1 dir_lease_grants_received
+EXPECT_WITHIN 5 "Y" lookup_anew $M1 dir
+
+## A change behind gluster's back is not seen while the lease is held, even
+## past md-cache-timeout
+TEST chmod 700 $B0/${V0}0/dir
+EXPECT "Y" mode_kept $M1/dir 755
+
+## Writing a file in the directory does not recall the lease
+TEST "echo data > $M0/dir/file"
+EXPECT "0" mdc_stat $M1 dir_lease_recalls_received
+
+## Setting the attributes of the directory from the other mount does
+TEST chmod 750 $M0/dir
+EXPECT_WITHIN 5 "1" mdc_stat $M1 dir_lease_recalls_received
+EXPECT_WITHIN 5 "750" stat -c '%a' $M1/dir
+
+## So does creating an entry in the directory
+TEST stat $M1/dir
+EXPECT_WITHIN 5 "2" mdc_stat $M1 dir_lease_grants_received
+TEST touch $M0/dir/file2
+EXPECT_WITHIN 5 "2" mdc_stat $M1 dir_lease_recalls_received
+EXPECT_WITHIN 5 "file2" ls $M1/dir
+
+cleanup;
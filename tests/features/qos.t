@@ -0,0 +1,60 @@
+#!/bin/bash
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+function qos_stat {
+        local fpath=$(generate_brick_statedump $V0 $H0 $B0/${V0}0)
+        grep -a "^$1=" $fpath | head -1 | cut -f2 -d'='
+        rm -f $fpath
+}
+
+function qos_tenants {
+        local fpath=$(generate_brick_statedump $V0 $H0 $B0/${V0}0)
+        grep -a "^tenant=$1$" $fpath | wc -l
+        rm -f $fpath
+}
+
+function timed_write {
+        local start=$SECONDS
+        dd if=/dev/zero of=$1 bs=128k count=32 conv=fsync 2>/dev/null
+        echo $((SECONDS - start))
+}
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 features.qos on
+TEST $CLI volume set $V0 features.qos-write-bandwidth 1MB
+TEST $CLI volume set $V0 features.qos-burst-time 1
+TEST $CLI volume start $V0
+
+TEST $GFS -s $H0 --volfile-id=$V0 $M0
+TEST $GFS -s $H0 --volfile-id=$V0 $M1
+
+# 4MB at 1MB/s with one second of burst takes about three seconds.
+TEST [ $(timed_write $M0/slow) -ge 2 ]
+EXPECT "4194304" stat -c %s $M0/slow
+TEST [ $(qos_stat write.throttled) -gt 0 ]
+
+# Every mount is a tenant of its own.
+TEST touch $M1/other
+EXPECT "2" qos_stat tenants
+
+# Dropping the limit lets writes through at once.
+TEST $CLI volume set $V0 features.qos-write-bandwidth 0
+TEST [ $(timed_write $M0/fast) -le 1 ]
+EXPECT "0" qos_stat queued
+
+# Accounting by uid puts both mounts in the same bucket.
+TEST $CLI volume set $V0 features.qos-key uid
+TEST $CLI volume set $V0 features.qos-metadata-iops 100
+TEST touch $M0/a $M1/b
+EXPECT "1" qos_tenants uid:0
+
+TEST force_umount $M0
+TEST force_umount $M1
+cleanup;
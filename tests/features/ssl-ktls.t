@@ -0,0 +1,70 @@
+#!/bin/bash
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+for d in /etc/ssl /etc/openssl /usr/local/etc/openssl ; do
+        if test -d $d ; then
+                SSL_BASE=$d
+                break
+        fi
+done
+SSL_KEY=$SSL_BASE/glusterfs.key
+SSL_CERT=$SSL_BASE/glusterfs.pem
+SSL_CA=$SSL_BASE/glusterfs.ca
+
+function copy_check {
+        dd if=$1 of=$2 bs=1M oflag=direct status=none && \
+                cmp -s $1 $2 && echo Y
+}
+
+function remount {
+        force_umount $M0 > /dev/null
+        $GFS -s $H0 --volfile-id=$V0 --direct-io-mode=yes $M0 && echo Y
+}
+
+cleanup;
+rm -f $SSL_BASE/glusterfs.*
+
+TEST openssl genrsa -out $SSL_KEY 2048
+TEST openssl req -new -x509 -key $SSL_KEY -subj /CN=Anyone -out $SSL_CERT
+ln $SSL_CERT $SSL_CA
+
+TEST glusterd
+TEST pidof glusterd
+
+TEST dd if=/dev/urandom of=$B0/data bs=1M count=16 status=none
+
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 server.ssl on
+TEST $CLI volume set $V0 client.ssl on
+TEST $CLI volume set $V0 server.ssl-ktls on
+TEST $CLI volume set $V0 client.ssl-ktls on
+TEST $CLI volume start $V0
+
+# Records are the same whether the kernel or OpenSSL handles them, where
+# kTLS is not available the connections stay with OpenSSL.
+EXPECT "Y" remount
+EXPECT "Y" copy_check $B0/data $M0/data
+TEST drop_cache $M0
+EXPECT "Y" copy_check $M0/data $M0/data2
+
+# Either end may use it alone.
+TEST $CLI volume set $V0 client.ssl-ktls off
+EXPECT "Y" remount
+EXPECT "Y" copy_check $B0/data $M0/data3
+EXPECT "Y" copy_check $M0/data3 $M0/data4
+
+TEST $CLI volume set $V0 client.ssl-ktls on
+TEST $CLI volume set $V0 server.ssl-ktls off
+TEST $CLI volume stop $V0
+TEST $CLI volume start $V0
+EXPECT "Y" remount
+EXPECT "Y" copy_check $B0/data $M0/data5
+EXPECT "Y" copy_check $M0/data5 $M0/data6
+
+TEST rm -f $M0/data*
+TEST force_umount $M0
+TEST rm -f $B0/data
+cleanup;
+rm -f $SSL_BASE/glusterfs.*
@@ -0,0 +1,74 @@
+#!/bin/bash
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+function nlc_stat {
+        local fpath=$(generate_mount_statedump $V0 $M0)
+        grep -a "^$1=" $fpath | head -1 | cut -f2 -d'='
+        rm -f $fpath
+}
+
+function nlc_dir_index {
+        local fpath=$(generate_mount_statedump $V0 $M0)
+        grep -a -A12 "^path=$1$" $fpath | grep -a "^$2=" | head -1 | \
+                cut -f2 -d'='
+        rm -f $fpath
+}
+
+function lookup_missing {
+        local i
+        for i in $(seq $2 $3); do
+                stat $1$i > /dev/null 2>&1
+        done
+        echo done
+}
+
+function present {
+        stat $1 > /dev/null 2>&1 && echo Y
+}
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 group nl-cache
+TEST $CLI volume set $V0 nl-cache-positive-entry on
+TEST $CLI volume start $V0
+
+TEST $GFS -s $H0 --volfile-id=$V0 $M0
+TEST $GFS -s $H0 --volfile-id=$V0 $M1
+
+TEST mkdir $M0/dir
+
+# The negative entries are indexed, the index grows with them: 8 buckets
+# to start with, doubled once there are 4 names a bucket.
+EXPECT "done" lookup_missing $M0/dir/missing 1 200
+EXPECT "200 names, 64 buckets" nlc_dir_index /dir ne-index
+
+# Another pass is served from the cache.
+hits=$(nlc_stat negative_lookup_hit_count)
+EXPECT "done" lookup_missing $M0/dir/missing 1 200
+TEST [ $(nlc_stat negative_lookup_hit_count) -ge $((hits + 200)) ]
+
+# A name created here leaves the negative index at once...
+TEST touch $M0/dir/missing7
+TEST stat $M0/dir/missing7
+EXPECT "199 names, 64 buckets" nlc_dir_index /dir ne-index
+
+# ...and names that were never cached are still misses.
+TEST ! stat $M0/dir/other1
+TEST touch $M0/dir/other2
+TEST stat $M0/dir/other2
+
+# A name created by another client invalidates the cache.
+TEST touch $M1/dir/missing9
+EXPECT_WITHIN 20 "Y" present $M0/dir/missing9
+TEST ! stat $M0/dir/missing10
+
+TEST rm -rf $M0/dir
+TEST force_umount $M0
+TEST force_umount $M1
+cleanup;
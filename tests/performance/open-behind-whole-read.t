@@ -0,0 +1,68 @@
+#!/bin/bash
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+# The cached content expires on a one second boundary, start right after
+# one so that the next steps run within the same second.
+function at_second_start {
+        sleep $(printf '0.%03d' $((1000 - 10#$(date +%3N))))
+}
+
+function read_at {
+        dd bs=1 skip=$2 count=4 status=none <&$1
+}
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 performance.read-after-open no
+TEST $CLI volume set $V0 performance.whole-file-read-size 64KB
+TEST $CLI volume set $V0 performance.quick-read off
+TEST $CLI volume set $V0 performance.io-cache off
+TEST $CLI volume set $V0 performance.read-ahead off
+TEST $CLI volume start $V0
+
+TEST $GFS -s $H0 --volfile-id=$V0 --direct-io-mode=yes $M0
+TEST $GFS -s $H0 --volfile-id=$V0 --direct-io-mode=yes $M1
+
+TEST "printf 'aaaa%.0s' {1..2048} > $M1/file"
+
+# The first read takes the whole file, the next ones on the fd are served
+# from it while the open is pending, even if another client changed it.
+at_second_start
+exec 5<$M0/file
+TEST dd bs=4k count=1 status=none of=/dev/null <&5
+TEST "printf 'bbbb' | dd of=$M1/file bs=1 seek=4096 conv=notrunc status=none"
+EXPECT "aaaa" read_at 5 4096
+
+# It's dropped after a second.
+sleep 2
+EXPECT "bbbb" read_at 5 4096
+exec 5<&-
+
+# A write from this client drops it at once.
+at_second_start
+exec 5<$M0/file
+TEST dd bs=4k count=1 status=none of=/dev/null <&5
+exec 6<>$M0/file
+TEST "printf 'cccc' | dd bs=1 seek=4096 conv=notrunc status=none >&6"
+EXPECT "cccc" read_at 5 4096
+exec 6<&-
+exec 5<&-
+
+# Not used when reads wait for the open.
+TEST $CLI volume set $V0 performance.read-after-open yes
+at_second_start
+exec 5<$M0/file
+TEST dd bs=4k count=1 status=none of=/dev/null <&5
+TEST "printf 'dddd' | dd of=$M1/file bs=1 seek=4096 conv=notrunc status=none"
+EXPECT "dddd" read_at 5 4096
+exec 5<&-
+
+TEST force_umount $M0
+TEST force_umount $M1
+cleanup;
@@ -0,0 +1,64 @@
+#!/bin/bash
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+function qr_stat {
+        local fpath=$(generate_mount_statedump $V0 $M0)
+        grep -a "^$1=" $fpath | head -1 | cut -f2 -d'='
+        rm -f $fpath
+}
+
+function list_dir {
+        ls -l $1 | grep -c '^-'
+}
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 performance.readdir-ahead on
+TEST $CLI volume set $V0 performance.quick-read on
+TEST $CLI volume set $V0 performance.open-behind off
+TEST $CLI volume start $V0
+
+TEST $GFS -s $H0 --volfile-id=$V0 $M0
+TEST $GFS -s $H0 --volfile-id=$V0 $M1
+
+TEST mkdir $M1/dir
+for i in $(seq 1 20); do
+        echo "content of $i" > $M1/dir/f$i
+done
+TEST dd if=/dev/urandom of=$M1/dir/big bs=64k count=1
+
+# Off by default: listing caches no content.
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+TEST $GFS -s $H0 --volfile-id=$V0 $M0
+EXPECT "21" list_dir $M0/dir
+EXPECT "0" qr_stat total_files_cached
+
+# With it on, the content of the files up to the size comes along with the
+# entries, the bigger ones are left out.
+TEST $CLI volume set $V0 performance.rda-content-prefetch-size 4KB
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+TEST $GFS -s $H0 --volfile-id=$V0 $M0
+EXPECT "21" list_dir $M0/dir
+EXPECT "20" qr_stat total_files_cached
+
+# Reading them is served from the cache.
+misses=$(qr_stat cache-miss)
+for i in $(seq 1 20); do
+        EXPECT "content of $i" cat $M0/dir/f$i
+done
+EXPECT "$misses" qr_stat cache-miss
+
+# A file changed since is read anew.
+TEST "echo changed > $M1/dir/f3"
+EXPECT_WITHIN 5 "changed" cat $M0/dir/f3
+
+TEST rm -rf $M1/dir
+TEST force_umount $M0
+TEST force_umount $M1
+cleanup;
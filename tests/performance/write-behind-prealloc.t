@@ -0,0 +1,45 @@
+#!/bin/bash
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+function brick_kb {
+        echo $(( $(stat -c '%b * %B' $B0/${V0}0/$1) / 1024 ))
+}
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 performance.write-behind-append-prealloc-size 16MB
+TEST $CLI volume set $V0 performance.flush-behind off
+TEST $CLI volume start $V0
+
+TEST $GFS -s $H0 --volfile-id=$V0 $M0
+
+# An append stream gets blocks preallocated ahead of it...
+exec 5>$M0/log
+TEST dd if=/dev/zero bs=64k count=16 conv=fsync status=none >&5
+EXPECT "1048576" stat -c %s $M0/log
+TEST [ $(brick_kb log) -gt 8192 ]
+
+# ...which are given back when the last fd is closed.
+exec 5>&-
+EXPECT_WITHIN 10 "Y" eval '[ $(brick_kb log) -le 1280 ] && echo Y'
+EXPECT "1048576" stat -c %s $M0/log
+
+# A truncate frees them too, and the next stream preallocates again.
+exec 5>>$M0/log
+TEST dd if=/dev/zero bs=64k count=16 conv=fsync status=none >&5
+TEST [ $(brick_kb log) -gt 8192 ]
+TEST truncate -s 512k $M0/log
+TEST dd if=/dev/zero bs=64k count=16 conv=fsync status=none >&5
+TEST [ $(brick_kb log) -gt 8192 ]
+exec 5>&-
+EXPECT_WITHIN 10 "Y" eval '[ $(brick_kb log) -le 1792 ] && echo Y'
+EXPECT "1572864" stat -c %s $M0/log
+
+TEST force_umount $M0
+cleanup;
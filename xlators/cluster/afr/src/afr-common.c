@@ -2692,6 +2692,12 @@ afr_local_cleanup(afr_local_t *local, xlator_t *this)
             iobref_unref(local->cont.writev.iobref);
     }
 
+    { /* copy_file_range */
+        if (local->cont.copy_file_range.fd_in)
+            fd_unref(local->cont.copy_file_range.fd_in);
+        GF_FREE(local->cont.copy_file_range.locked_nodes);
+    }
+
     { /* setxattr */
         if (local->cont.setxattr.dict)
             dict_unref(local->cont.setxattr.dict);
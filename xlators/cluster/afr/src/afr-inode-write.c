@@ -2049,6 +2049,353 @@ out:
 
 /* }}} */
 
+/* {{{ copy_file_range */
+
+static int
+afr_copy_file_range_src_unlock_cbk(call_frame_t *frame, void *cookie,
+                                   xlator_t *this, int32_t op_ret,
+                                   int32_t op_errno, dict_t *xdata)
+{
+    if (afr_frame_return(frame) == 0)
+        AFR_STACK_DESTROY(frame);
+
+    return 0;
+}
+
+/* Drops the read lock on the source and destroys the lock frame. */
+static void
+afr_copy_file_range_src_unlock(call_frame_t *lk_frame, xlator_t *this)
+{
+    afr_local_t *local = lk_frame->local;
+    afr_private_t *priv = this->private;
+    int call_count = 0;
+    int i = 0;
+
+    call_count = AFR_COUNT(local->cont.copy_file_range.locked_nodes,
+                           priv->child_count);
+    if (!call_count) {
+        AFR_STACK_DESTROY(lk_frame);
+        return;
+    }
+
+    local->call_count = call_count;
+    local->cont.copy_file_range.flock.l_type = F_UNLCK;
+
+    for (i = 0; i < priv->child_count; i++) {
+        if (!local->cont.copy_file_range.locked_nodes[i])
+            continue;
+
+        STACK_WIND_COOKIE(lk_frame, afr_copy_file_range_src_unlock_cbk,
+                          (void *)(long)i, priv->children[i],
+                          priv->children[i]->fops->finodelk, this->name,
+                          local->fd, F_SETLK,
+                          &local->cont.copy_file_range.flock, NULL);
+        if (!--call_count)
+            break;
+    }
+}
+
+int
+afr_copy_file_range_unwind(call_frame_t *frame, xlator_t *this)
+{
+    afr_local_t *local = NULL;
+    call_frame_t *main_frame = NULL;
+
+    local = frame->local;
+
+    main_frame = afr_transaction_detach_fop_frame(frame);
+    if (!main_frame)
+        return 0;
+
+    /* Every child is done copying, the source may change again. */
+    if (local->cont.copy_file_range.lk_frame) {
+        afr_copy_file_range_src_unlock(local->cont.copy_file_range.lk_frame,
+                                       this);
+        local->cont.copy_file_range.lk_frame = NULL;
+    }
+
+    AFR_STACK_UNWIND(copy_file_range, main_frame, local->op_ret,
+                     local->op_errno, &local->cont.copy_file_range.stbuf,
+                     &local->cont.inode_wfop.prebuf,
+                     &local->cont.inode_wfop.postbuf, local->xdata_rsp);
+    return 0;
+}
+
+int
+afr_copy_file_range_wind_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                             int32_t op_ret, int32_t op_errno,
+                             struct iatt *stbuf, struct iatt *prebuf_dst,
+                             struct iatt *postbuf_dst, dict_t *xdata)
+{
+    afr_local_t *local = frame->local;
+
+    if (op_ret >= 0 && stbuf) {
+        LOCK(&frame->lock);
+        {
+            local->cont.copy_file_range.stbuf = *stbuf;
+        }
+        UNLOCK(&frame->lock);
+    }
+
+    return __afr_inode_write_cbk(frame, cookie, this, op_ret, op_errno,
+                                 prebuf_dst, postbuf_dst, NULL, xdata);
+}
+
+int
+afr_copy_file_range_wind(call_frame_t *frame, xlator_t *this, int subvol)
+{
+    afr_local_t *local = NULL;
+    afr_private_t *priv = NULL;
+
+    local = frame->local;
+    priv = this->private;
+
+    STACK_WIND_COOKIE(frame, afr_copy_file_range_wind_cbk,
+                      (void *)(long)subvol, priv->children[subvol],
+                      priv->children[subvol]->fops->copy_file_range,
+                      local->cont.copy_file_range.fd_in,
+                      local->cont.copy_file_range.off_in, local->fd,
+                      local->cont.copy_file_range.off_out,
+                      local->cont.copy_file_range.len,
+                      local->cont.copy_file_range.flags, local->xdata_req);
+    return 0;
+}
+
+/* Every child copies from its own replica of the source, so the copy can
+ * only be offloaded when the source is good on all of them. Otherwise
+ * EXDEV makes the caller fall back to a read/write copy through the
+ * client, which reads from a good copy. */
+static gf_boolean_t
+afr_copy_file_range_source_ok(xlator_t *this, fd_t *fd_in)
+{
+    afr_private_t *priv = this->private;
+    unsigned char *data = alloca0(priv->child_count);
+    int ret = 0;
+
+    if (fd_in->inode->ia_type != IA_IFREG)
+        return _gf_false;
+
+    ret = afr_inode_read_subvol_get(fd_in->inode, this, data, NULL, NULL);
+    if (ret < 0)
+        return _gf_false;
+
+    return (AFR_COUNT(data, priv->child_count) == priv->child_count);
+}
+
+static void
+afr_copy_file_range_src_locked(call_frame_t *lk_frame, xlator_t *this)
+{
+    afr_local_t *lk_local = lk_frame->local;
+    afr_private_t *priv = this->private;
+    call_frame_t *txn_frame = lk_local->cont.copy_file_range.txn_frame;
+    afr_local_t *local = txn_frame->local;
+    call_frame_t *main_frame = NULL;
+    int op_errno = EXDEV;
+    int ret = 0;
+
+    if (AFR_COUNT(lk_local->cont.copy_file_range.locked_nodes,
+                  priv->child_count) !=
+        AFR_COUNT(lk_local->child_up, priv->child_count))
+        goto fail;
+
+    local->cont.copy_file_range.lk_frame = lk_frame;
+    ret = afr_transaction(txn_frame, this, AFR_DATA_TRANSACTION);
+    if (ret < 0) {
+        op_errno = -ret;
+        local->cont.copy_file_range.lk_frame = NULL;
+        goto fail;
+    }
+
+    return;
+fail:
+    main_frame = local->transaction.main_frame;
+    afr_copy_file_range_src_unlock(lk_frame, this);
+    AFR_STACK_DESTROY(txn_frame);
+    AFR_STACK_UNWIND(copy_file_range, main_frame, -1, op_errno, NULL, NULL,
+                     NULL, NULL);
+}
+
+static int
+afr_copy_file_range_src_lock_cbk(call_frame_t *frame, void *cookie,
+                                 xlator_t *this, int32_t op_ret,
+                                 int32_t op_errno, dict_t *xdata)
+{
+    afr_local_t *local = frame->local;
+    int child_index = (long)cookie;
+
+    if (op_ret == 0) {
+        LOCK(&frame->lock);
+        {
+            local->cont.copy_file_range.locked_nodes[child_index] = 1;
+        }
+        UNLOCK(&frame->lock);
+    }
+
+    if (afr_frame_return(frame) == 0)
+        afr_copy_file_range_src_locked(frame, this);
+
+    return 0;
+}
+
+/* Each child reads its own replica of the source. A write racing with the
+ * copy could land on some replicas before their copy and on others after
+ * it, and nothing would ever tell them apart again. So the source range is
+ * read locked on every child for the whole transaction. The lock does not
+ * wait: it is taken before the one on the destination, and waiting could
+ * deadlock against a copy going the other way. A source that is busy gets
+ * EXDEV, and the caller copies through the client instead. */
+static int
+afr_copy_file_range_src_lock(call_frame_t *txn_frame, xlator_t *this,
+                             int *op_errno)
+{
+    afr_local_t *txn_local = txn_frame->local;
+    afr_private_t *priv = this->private;
+    call_frame_t *lk_frame = NULL;
+    afr_local_t *local = NULL;
+    int call_count = 0;
+    int i = 0;
+
+    lk_frame = copy_frame(txn_frame);
+    if (!lk_frame) {
+        *op_errno = ENOMEM;
+        return -1;
+    }
+
+    local = AFR_FRAME_INIT(lk_frame, *op_errno);
+    if (!local)
+        goto err;
+
+    local->cont.copy_file_range.locked_nodes = GF_CALLOC(
+        priv->child_count, sizeof(*local->cont.copy_file_range.locked_nodes),
+        gf_afr_mt_char);
+    if (!local->cont.copy_file_range.locked_nodes) {
+        *op_errno = ENOMEM;
+        goto err;
+    }
+
+    call_count = AFR_COUNT(local->child_up, priv->child_count);
+    if (!call_count) {
+        *op_errno = ENOTCONN;
+        goto err;
+    }
+
+    set_lk_owner_from_ptr(&lk_frame->root->lk_owner, lk_frame->root);
+    local->op = GF_FOP_COPY_FILE_RANGE;
+    local->fd = fd_ref(txn_local->cont.copy_file_range.fd_in);
+    local->cont.copy_file_range.txn_frame = txn_frame;
+    local->cont.copy_file_range.flock.l_type = F_RDLCK;
+    local->cont.copy_file_range.flock.l_whence = SEEK_SET;
+    local->cont.copy_file_range.flock.l_start =
+        txn_local->cont.copy_file_range.off_in;
+    local->cont.copy_file_range.flock.l_len =
+        txn_local->cont.copy_file_range.len;
+    local->call_count = call_count;
+
+    for (i = 0; i < priv->child_count; i++) {
+        if (!local->child_up[i])
+            continue;
+
+        STACK_WIND_COOKIE(lk_frame, afr_copy_file_range_src_lock_cbk,
+                          (void *)(long)i, priv->children[i],
+                          priv->children[i]->fops->finodelk, this->name,
+                          local->fd, F_SETLK,
+                          &local->cont.copy_file_range.flock, NULL);
+        if (!--call_count)
+            break;
+    }
+
+    return 0;
+err:
+    AFR_STACK_DESTROY(lk_frame);
+    return -1;
+}
+
+int
+afr_copy_file_range(call_frame_t *frame, xlator_t *this, fd_t *fd_in,
+                    off64_t off_in, fd_t *fd_out, off64_t off_out, size_t len,
+                    uint32_t flags, dict_t *xdata)
+{
+    call_frame_t *transaction_frame = NULL;
+    afr_local_t *local = NULL;
+    int ret = -1;
+    int op_errno = ENOMEM;
+
+    AFR_ERROR_OUT_IF_FDCTX_INVALID(fd_in, this, op_errno, out);
+    AFR_ERROR_OUT_IF_FDCTX_INVALID(fd_out, this, op_errno, out);
+
+    if (!afr_copy_file_range_source_ok(this, fd_in)) {
+        op_errno = EXDEV;
+        goto out;
+    }
+
+    transaction_frame = copy_frame(frame);
+    if (!transaction_frame)
+        goto out;
+
+    local = AFR_FRAME_INIT(transaction_frame, op_errno);
+    if (!local)
+        goto out;
+
+    local->cont.copy_file_range.fd_in = fd_ref(fd_in);
+    local->cont.copy_file_range.off_in = off_in;
+    local->cont.copy_file_range.off_out = off_out;
+    local->cont.copy_file_range.len = len;
+    local->cont.copy_file_range.flags = flags;
+
+    local->fd = fd_ref(fd_out);
+    ret = afr_set_inode_local(this, local, fd_out->inode);
+    if (ret)
+        goto out;
+
+    if (xdata)
+        local->xdata_req = dict_copy_with_ref(xdata, NULL);
+    else
+        local->xdata_req = dict_new();
+
+    if (!local->xdata_req)
+        goto out;
+
+    local->op = GF_FOP_COPY_FILE_RANGE;
+
+    local->transaction.wind = afr_copy_file_range_wind;
+    local->transaction.unwind = afr_copy_file_range_unwind;
+
+    local->transaction.main_frame = frame;
+
+    local->transaction.start = off_out;
+    local->transaction.len = 0;
+
+    afr_fix_open(fd_in, this);
+    afr_fix_open(fd_out, this);
+
+    /* Within one file the write lock of the transaction has to cover the
+     * source as well, a read lock of our own would block it. */
+    if (fd_in->inode == fd_out->inode) {
+        local->transaction.start = min(off_in, off_out);
+        ret = afr_transaction(transaction_frame, this, AFR_DATA_TRANSACTION);
+        if (ret < 0) {
+            op_errno = -ret;
+            goto out;
+        }
+        return 0;
+    }
+
+    ret = afr_copy_file_range_src_lock(transaction_frame, this, &op_errno);
+    if (ret < 0)
+        goto out;
+
+    return 0;
+out:
+    if (transaction_frame)
+        AFR_STACK_DESTROY(transaction_frame);
+
+    AFR_STACK_UNWIND(copy_file_range, frame, -1, op_errno, NULL, NULL, NULL,
+                     NULL);
+    return 0;
+}
+
+/* }}} */
+
 /* {{{ discard */
 
 int
@@ -791,6 +791,7 @@ struct xlator_fops fops = {
     .fallocate = afr_fallocate,
     .discard = afr_discard,
     .zerofill = afr_zerofill,
+    .copy_file_range = afr_copy_file_range,
     .xattrop = afr_xattrop,
     .fxattrop = afr_fxattrop,
     .fsync = afr_fsync,
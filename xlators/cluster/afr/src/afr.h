@@ -764,6 +764,20 @@ typedef struct _afr_local {
             int32_t mode;
         } fallocate;
 
+        struct {
+            fd_t *fd_in;
+            off64_t off_in;
+            off64_t off_out;
+            size_t len;
+            uint32_t flags;
+            struct iatt stbuf;
+            /* read lock on the source range, held on its own frame */
+            struct gf_flock flock;
+            unsigned char *locked_nodes;
+            call_frame_t *lk_frame;
+            call_frame_t *txn_frame;
+        } copy_file_range;
+
         struct {
             off_t offset;
             size_t len;
@@ -149,6 +149,7 @@ struct dht_rebalance_ {
     dict_t *xattr;
     dict_t *dict;
     struct gf_flock flock;
+    struct gf_lease lease;
     int32_t set;
     int lock_cmd;
 };
@@ -1081,6 +1082,10 @@ int32_t
 dht_zerofill(call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
              off_t len, dict_t *xdata);
 int32_t
+dht_copy_file_range(call_frame_t *frame, xlator_t *this, fd_t *fd_in,
+                    off64_t off_in, fd_t *fd_out, off64_t off_out, size_t len,
+                    uint32_t flags, dict_t *xdata);
+int32_t
 dht_ipc(call_frame_t *frame, xlator_t *this, int32_t op, dict_t *xdata);
 
 int
@@ -988,6 +988,96 @@ err:
     return 0;
 }
 
+/* copy_file_range is done by the subvolume holding both files. Copies
+ * between subvolumes, and copies touching a file that is being migrated,
+ * fail with EXDEV: callers then copy through readv and writev, which
+ * follow the data to wherever it is.
+ */
+static int
+dht_copy_file_range_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                        int op_ret, int op_errno, struct iatt *stbuf,
+                        struct iatt *prebuf_dst, struct iatt *postbuf_dst,
+                        dict_t *xdata)
+{
+    xlator_t *prev = cookie;
+
+    if (op_ret == -1) {
+        gf_msg_debug(this->name, op_errno, "subvolume %s returned -1",
+                     prev->name);
+        if (dht_inode_missing(op_errno) || (op_errno == EBADF) ||
+            (op_errno == EBADFD))
+            op_errno = EXDEV;
+    } else if (IS_DHT_MIGRATION_PHASE1(postbuf_dst) ||
+               IS_DHT_MIGRATION_PHASE2(postbuf_dst) ||
+               IS_DHT_MIGRATION_PHASE2(stbuf)) {
+        /* the copy may have missed the new location of the data */
+        op_ret = -1;
+        op_errno = EXDEV;
+    }
+
+    DHT_STRIP_PHASE1_FLAGS(stbuf);
+    DHT_STRIP_PHASE1_FLAGS(prebuf_dst);
+    DHT_STRIP_PHASE1_FLAGS(postbuf_dst);
+
+    DHT_STACK_UNWIND(copy_file_range, frame, op_ret, op_errno, stbuf,
+                     prebuf_dst, postbuf_dst, xdata);
+    return 0;
+}
+
+int
+dht_copy_file_range(call_frame_t *frame, xlator_t *this, fd_t *fd_in,
+                    off64_t off_in, fd_t *fd_out, off64_t off_out, size_t len,
+                    uint32_t flags, dict_t *xdata)
+{
+    xlator_t *subvol = NULL;
+    xlator_t *src_subvol = NULL;
+    int op_errno = -1;
+    dht_local_t *local = NULL;
+
+    VALIDATE_OR_GOTO(frame, err);
+    VALIDATE_OR_GOTO(this, err);
+    VALIDATE_OR_GOTO(fd_in, err);
+    VALIDATE_OR_GOTO(fd_out, err);
+
+    local = dht_local_init(frame, NULL, fd_out, GF_FOP_COPY_FILE_RANGE);
+    if (!local) {
+        op_errno = ENOMEM;
+        goto err;
+    }
+
+    subvol = local->cached_subvol;
+    src_subvol = dht_subvol_get_cached(this, fd_in->inode);
+    if (!subvol || !src_subvol) {
+        gf_msg_debug(this->name, 0, "no cached subvolume for fd=%p",
+                     subvol ? fd_in : fd_out);
+        op_errno = EINVAL;
+        goto err;
+    }
+
+    if (subvol != src_subvol) {
+        gf_msg_debug(this->name, 0,
+                     "%s and %s are on different subvolumes (%s, %s)",
+                     uuid_utoa(fd_in->inode->gfid),
+                     uuid_utoa(fd_out->inode->gfid), src_subvol->name,
+                     subvol->name);
+        op_errno = EXDEV;
+        goto err;
+    }
+
+    STACK_WIND_COOKIE(frame, dht_copy_file_range_cbk, subvol, subvol,
+                      subvol->fops->copy_file_range, fd_in, off_in, fd_out,
+                      off_out, len, flags, xdata);
+
+    return 0;
+
+err:
+    op_errno = (op_errno == -1) ? errno : op_errno;
+    DHT_STACK_UNWIND(copy_file_range, frame, -1, op_errno, NULL, NULL, NULL,
+                     NULL);
+
+    return 0;
+}
+
 /* handle cases of migration here for 'setattr()' calls */
 int
 dht_file_setattr_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
@@ -88,6 +88,7 @@ struct xlator_fops fops = {
     .fallocate = dht_fallocate,
     .discard = dht_discard,
     .zerofill = dht_zerofill,
+    .copy_file_range = dht_copy_file_range,
 };
 
 struct xlator_dumpops dumpops = {
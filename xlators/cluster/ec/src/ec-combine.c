@@ -74,6 +74,9 @@ ec_combine_write(ec_fop_data_t *fop, ec_cbk_data_t *dst, ec_cbk_data_t *src)
         case GF_FOP_ZEROFILL:
             valid = 2;
             break;
+        case GF_FOP_COPY_FILE_RANGE:
+            valid = 3;
+            break;
         case GF_FOP_RENAME:
             valid = 5;
             break;
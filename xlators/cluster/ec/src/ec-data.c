@@ -263,6 +263,9 @@ ec_fop_data_release(ec_fop_data_t *fop)
         if (fop->fd != NULL) {
             fd_unref(fop->fd);
         }
+        if (fop->fd_in != NULL) {
+            fd_unref(fop->fd_in);
+        }
         if (fop->buffers != NULL) {
             iobref_unref(fop->buffers);
         }
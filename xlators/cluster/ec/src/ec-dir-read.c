@@ -409,6 +409,9 @@ ec_manager_readdir(ec_fop_data_t *fop, int32_t state)
 
                         return EC_STATE_REPORT;
                     }
+                } else {
+                    /* A brick only has a fragment of the content */
+                    dict_del(fop->xdata, GF_CONTENT_KEY);
                 }
 
                 err = dict_set_uint64(fop->xdata, EC_XATTR_SIZE, 0);
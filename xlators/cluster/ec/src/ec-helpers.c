@@ -838,6 +838,7 @@ ec_is_data_fop(glusterfs_fop_t fop)
         case GF_FOP_FALLOCATE:
         case GF_FOP_DISCARD:
         case GF_FOP_ZEROFILL:
+        case GF_FOP_COPY_FILE_RANGE:
             return _gf_true;
         default:
             return _gf_false;
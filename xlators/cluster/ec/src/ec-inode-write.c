@@ -1087,6 +1087,335 @@ out:
     }
 }
 
+/*********************************************************************
+ *
+ * File Operation : copy_file_range
+ *
+ *********************************************************************/
+
+/* A copy can be offloaded to the bricks only when it moves whole stripes:
+ * each brick then copies its own fragments and the result is a valid
+ * encoding of the destination. A partial stripe is only allowed at the end
+ * of the source when it also becomes the end of the destination, since the
+ * padding copied along with it lands beyond the destination size. Anything
+ * else gets EXDEV and the caller falls back to a regular read/write copy. */
+static int32_t
+ec_copy_file_range_adjust(ec_fop_data_t *fop)
+{
+    ec_t *ec = fop->xl->private;
+    ec_lock_link_t *src = NULL;
+    uint64_t src_size = 0;
+    uint64_t dst_size = 0;
+    gf_boolean_t found;
+    int32_t i;
+
+    for (i = 0; i < fop->lock_count; i++) {
+        if (fop->locks[i].lock->loc.inode == fop->fd_in->inode) {
+            src = &fop->locks[i];
+        }
+    }
+    if ((src == NULL) || ((src->lock->healing & fop->mask) != 0)) {
+        return EXDEV;
+    }
+
+    LOCK(&fop->fd_in->inode->lock);
+    {
+        found = __ec_get_inode_size(fop, fop->fd_in->inode, &src_size);
+    }
+    UNLOCK(&fop->fd_in->inode->lock);
+
+    if (!found) {
+        return EXDEV;
+    }
+
+    LOCK(&fop->fd->inode->lock);
+    {
+        GF_ASSERT(__ec_get_inode_size(fop, fop->fd->inode, &dst_size));
+    }
+    UNLOCK(&fop->fd->inode->lock);
+
+    if (fop->offset_in >= src_size) {
+        fop->user_size = 0;
+    } else if (fop->offset_in + fop->user_size > src_size) {
+        fop->user_size = src_size - fop->offset_in;
+    }
+
+    if (((fop->user_size % ec->stripe_size) != 0) &&
+        (fop->offset + fop->user_size < dst_size)) {
+        ec_adjust_size_down(ec, &fop->user_size, _gf_false);
+        if (fop->user_size == 0) {
+            return EXDEV;
+        }
+    }
+
+    fop->size = fop->user_size;
+    ec_adjust_size_up(ec, &fop->size, _gf_false);
+    fop->frag_range.last = fop->frag_range.first + fop->size / ec->fragments;
+
+    return 0;
+}
+
+int32_t
+ec_copy_file_range_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                       int32_t op_ret, int32_t op_errno, struct iatt *stbuf,
+                       struct iatt *prebuf_dst, struct iatt *postbuf_dst,
+                       dict_t *xdata)
+{
+    ec_fop_data_t *fop = NULL;
+    ec_cbk_data_t *cbk = NULL;
+    int32_t idx = (int32_t)(uintptr_t)cookie;
+
+    VALIDATE_OR_GOTO(this, out);
+    GF_VALIDATE_OR_GOTO(this->name, frame, out);
+    GF_VALIDATE_OR_GOTO(this->name, frame->local, out);
+    GF_VALIDATE_OR_GOTO(this->name, this->private, out);
+
+    fop = frame->local;
+
+    ec_trace("CBK", fop, "idx=%d, frame=%p, op_ret=%d, op_errno=%d", idx, frame,
+             op_ret, op_errno);
+
+    cbk = ec_cbk_data_allocate(frame, this, fop, fop->id, idx, op_ret,
+                               op_errno);
+    if (!cbk)
+        goto out;
+
+    if (op_ret < 0)
+        goto out;
+
+    if (xdata)
+        cbk->xdata = dict_ref(xdata);
+
+    if (stbuf)
+        cbk->iatt[0] = *stbuf;
+    if (prebuf_dst)
+        cbk->iatt[1] = *prebuf_dst;
+    if (postbuf_dst)
+        cbk->iatt[2] = *postbuf_dst;
+
+out:
+    if (cbk)
+        ec_combine(cbk, ec_combine_write);
+
+    if (fop)
+        ec_complete(fop);
+    return 0;
+}
+
+void
+ec_wind_copy_file_range(ec_t *ec, ec_fop_data_t *fop, int32_t idx)
+{
+    ec_trace("WIND", fop, "idx=%d", idx);
+
+    STACK_WIND_COOKIE(fop->frame, ec_copy_file_range_cbk,
+                      (void *)(uintptr_t)idx, ec->xl_list[idx],
+                      ec->xl_list[idx]->fops->copy_file_range, fop->fd_in,
+                      fop->offset_in / ec->fragments, fop->fd,
+                      fop->offset / ec->fragments, fop->size / ec->fragments,
+                      fop->uint32, fop->xdata);
+}
+
+int32_t
+ec_manager_copy_file_range(ec_fop_data_t *fop, int32_t state)
+{
+    ec_cbk_data_t *cbk = NULL;
+    ec_t *ec = fop->xl->private;
+    uint64_t size;
+    int32_t err;
+
+    switch (state) {
+        case EC_STATE_INIT:
+            if ((fop->size == 0) || ((fop->offset % ec->stripe_size) != 0) ||
+                ((fop->offset_in % ec->stripe_size) != 0)) {
+                ec_fop_set_error(fop, EXDEV);
+                return EC_STATE_REPORT;
+            }
+            fop->user_size = fop->size;
+            ec_adjust_size_up(ec, &fop->size, _gf_false);
+            fop->frag_range.first = fop->offset / ec->fragments;
+            fop->frag_range.last = fop->frag_range.first +
+                                   fop->size / ec->fragments;
+
+            /* Fall through */
+
+        case EC_STATE_LOCK:
+            /* The destination lock must be the first one, since it's the
+             * one whose size and version are updated. */
+            ec_lock_prepare_fd(fop, fop->fd,
+                               EC_UPDATE_DATA | EC_UPDATE_META | EC_QUERY_INFO,
+                               fop->frag_range.first,
+                               fop->size / ec->fragments);
+            ec_lock_prepare_fd(fop, fop->fd_in, EC_QUERY_INFO,
+                               fop->offset_in / ec->fragments,
+                               fop->size / ec->fragments);
+            ec_lock(fop);
+
+            return EC_STATE_DISPATCH;
+
+        case EC_STATE_DISPATCH:
+            err = ec_copy_file_range_adjust(fop);
+            if (err != 0) {
+                ec_fop_set_error(fop, err);
+                return EC_STATE_REPORT;
+            }
+
+            ec_dispatch_all(fop);
+
+            return EC_STATE_PREPARE_ANSWER;
+
+        case EC_STATE_PREPARE_ANSWER:
+            cbk = ec_fop_prepare_answer(fop, _gf_false);
+            if (cbk != NULL) {
+                ec_iatt_rebuild(ec, cbk->iatt, 3, cbk->count);
+
+                if (fop->error == 0) {
+                    cbk->op_ret *= ec->fragments;
+                    if (cbk->op_ret > fop->user_size) {
+                        cbk->op_ret = fop->user_size;
+                    }
+                }
+
+                /* These shouldn't fail because we have the inodes locked. */
+                LOCK(&fop->fd_in->inode->lock);
+                {
+                    __ec_get_inode_size(fop, fop->fd_in->inode,
+                                        &cbk->iatt[0].ia_size);
+                }
+                UNLOCK(&fop->fd_in->inode->lock);
+
+                LOCK(&fop->fd->inode->lock);
+                {
+                    GF_ASSERT(__ec_get_inode_size(fop, fop->fd->inode,
+                                                  &cbk->iatt[1].ia_size));
+                    cbk->iatt[2].ia_size = cbk->iatt[1].ia_size;
+                    size = fop->offset + cbk->op_ret;
+                    if ((cbk->op_ret > 0) && (size > cbk->iatt[1].ia_size)) {
+                        GF_ASSERT(
+                            __ec_set_inode_size(fop, fop->fd->inode, size));
+                        cbk->iatt[2].ia_size = size;
+                    }
+                }
+                UNLOCK(&fop->fd->inode->lock);
+            }
+
+            return EC_STATE_REPORT;
+
+        case EC_STATE_REPORT:
+            cbk = fop->answer;
+
+            GF_ASSERT(cbk != NULL);
+
+            if (fop->cbks.copy_file_range != NULL) {
+                QUORUM_CBK(fop->cbks.copy_file_range, fop, fop->req_frame, fop,
+                           fop->xl, cbk->op_ret, cbk->op_errno, &cbk->iatt[0],
+                           &cbk->iatt[1], &cbk->iatt[2], cbk->xdata);
+            }
+
+            return EC_STATE_LOCK_REUSE;
+
+        case -EC_STATE_INIT:
+        case -EC_STATE_LOCK:
+        case -EC_STATE_DISPATCH:
+        case -EC_STATE_PREPARE_ANSWER:
+        case -EC_STATE_REPORT:
+            GF_ASSERT(fop->error != 0);
+
+            if (fop->cbks.copy_file_range != NULL) {
+                fop->cbks.copy_file_range(fop->req_frame, fop, fop->xl, -1,
+                                          fop->error, NULL, NULL, NULL, NULL);
+            }
+
+            return EC_STATE_LOCK_REUSE;
+
+        case -EC_STATE_LOCK_REUSE:
+        case EC_STATE_LOCK_REUSE:
+            ec_lock_reuse(fop);
+
+            return EC_STATE_UNLOCK;
+
+        case -EC_STATE_UNLOCK:
+        case EC_STATE_UNLOCK:
+            ec_unlock(fop);
+
+            return EC_STATE_END;
+
+        default:
+            gf_msg(fop->xl->name, GF_LOG_ERROR, EINVAL, EC_MSG_UNHANDLED_STATE,
+                   "Unhandled state %d for %s", state, ec_fop_name(fop->id));
+
+            return EC_STATE_END;
+    }
+}
+
+void
+ec_copy_file_range(call_frame_t *frame, xlator_t *this, uintptr_t target,
+                   uint32_t fop_flags, fop_copy_file_range_cbk_t func,
+                   void *data, fd_t *fd_in, off64_t off_in, fd_t *fd_out,
+                   off64_t off_out, size_t len, uint32_t flags, dict_t *xdata)
+{
+    ec_cbk_t callback = {.copy_file_range = func};
+    ec_fop_data_t *fop = NULL;
+    int32_t error = ENOMEM;
+
+    gf_msg_trace("ec", 0, "EC(COPY_FILE_RANGE) %p", frame);
+
+    VALIDATE_OR_GOTO(this, out);
+    GF_VALIDATE_OR_GOTO(this->name, frame, out);
+    GF_VALIDATE_OR_GOTO(this->name, this->private, out);
+
+    fop = ec_fop_data_allocate(frame, this, GF_FOP_COPY_FILE_RANGE, 0, target,
+                               fop_flags, ec_wind_copy_file_range,
+                               ec_manager_copy_file_range, callback, data);
+    if (fop == NULL) {
+        goto out;
+    }
+
+    fop->use_fd = 1;
+    fop->uint32 = flags;
+    fop->offset_in = off_in;
+    fop->offset = off_out;
+    fop->size = len;
+
+    if (fd_in != NULL) {
+        fop->fd_in = fd_ref(fd_in);
+        if (fop->fd_in == NULL) {
+            gf_msg(this->name, GF_LOG_ERROR, 0, EC_MSG_FILE_DESC_REF_FAIL,
+                   "Failed to reference a "
+                   "file descriptor.");
+            goto out;
+        }
+    }
+
+    if (fd_out != NULL) {
+        fop->fd = fd_ref(fd_out);
+        if (fop->fd == NULL) {
+            gf_msg(this->name, GF_LOG_ERROR, 0, EC_MSG_FILE_DESC_REF_FAIL,
+                   "Failed to reference a "
+                   "file descriptor.");
+            goto out;
+        }
+    }
+
+    if (xdata != NULL) {
+        fop->xdata = dict_ref(xdata);
+        if (fop->xdata == NULL) {
+            gf_msg(this->name, GF_LOG_ERROR, 0, EC_MSG_DICT_REF_FAIL,
+                   "Failed to reference a "
+                   "dictionary.");
+            goto out;
+        }
+    }
+
+    error = 0;
+
+out:
+    if (fop != NULL) {
+        ec_manager(fop, error);
+    } else {
+        func(frame, NULL, this, -1, error, NULL, NULL, NULL, NULL);
+    }
+}
+
 /*********************************************************************
  *
  * File Operation : Discard
@@ -1403,6 +1732,7 @@ ec_manager_truncate(ec_fop_data_t *fop, int32_t state)
 {
     ec_cbk_data_t *cbk;
     off_t offset_down;
+    uint64_t size;
 
     switch (state) {
         case EC_STATE_INIT:
@@ -1433,6 +1763,18 @@ ec_manager_truncate(ec_fop_data_t *fop, int32_t state)
             return EC_STATE_DISPATCH;
 
         case EC_STATE_DISPATCH:
+            /* Trimming the preallocated blocks must not cut off what has
+             * been written since the size was taken. */
+            if ((fop->xdata != NULL) &&
+                (dict_get(fop->xdata, GLUSTERFS_TRIM_PREALLOC) != NULL) &&
+                (!ec_get_inode_size(fop, fop->locks[0].lock->loc.inode,
+                                    &size) ||
+                 (size != fop->user_size))) {
+                ec_fop_set_error(fop, EAGAIN);
+
+                return EC_STATE_REPORT;
+            }
+
             ec_dispatch_all(fop);
 
             return EC_STATE_PREPARE_ANSWER;
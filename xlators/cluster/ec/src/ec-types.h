@@ -242,6 +242,7 @@ union _ec_cbk {
     fop_xattrop_cbk_t xattrop;
     fop_fxattrop_cbk_t fxattrop;
     fop_zerofill_cbk_t zerofill;
+    fop_copy_file_range_cbk_t copy_file_range;
     fop_seek_cbk_t seek;
     fop_ipc_cbk_t ipc;
 };
@@ -379,6 +380,8 @@ struct _ec_fop_data {
     inode_t *inode;
     fd_t *fd; /* FD of the file on which FOP is
                  being carried upon */
+    fd_t *fd_in;     /* Source FD of copy_file_range */
+    off_t offset_in; /* Source offset of copy_file_range */
     struct iatt iatt;
     char *str[2];
     loc_t loc[2]; /* Holds the location details for
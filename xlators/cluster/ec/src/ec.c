@@ -937,6 +937,18 @@ ec_gf_create(call_frame_t *frame, xlator_t *this, loc_t *loc, int32_t flags,
     return 0;
 }
 
+int32_t
+ec_gf_copy_file_range(call_frame_t *frame, xlator_t *this, fd_t *fd_in,
+                      off64_t off_in, fd_t *fd_out, off64_t off_out, size_t len,
+                      uint32_t flags, dict_t *xdata)
+{
+    ec_copy_file_range(frame, this, -1, EC_MINIMUM_MIN,
+                       default_copy_file_range_cbk, NULL, fd_in, off_in, fd_out,
+                       off_out, len, flags, xdata);
+
+    return 0;
+}
+
 int32_t
 ec_gf_discard(call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
               size_t len, dict_t *xdata)
@@ -1632,6 +1644,7 @@ struct xlator_fops fops = {.lookup = ec_gf_lookup,
                            .fallocate = ec_gf_fallocate,
                            .discard = ec_gf_discard,
                            .zerofill = ec_gf_zerofill,
+                           .copy_file_range = ec_gf_copy_file_range,
                            .seek = ec_gf_seek,
                            .ipc = ec_gf_ipc};
 
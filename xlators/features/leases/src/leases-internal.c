@@ -101,11 +101,13 @@ __dump_leases_info(xlator_t *this, lease_inode_ctx_t *lease_ctx)
     gf_msg_debug(this->name, 0,
                  "Lease held on this inode, lease_type: %d,"
                  " lease_cnt:%" PRIu64
-                 ", RD lease:%d, RW lease:%d, "
+                 ", RD lease:%d, RW lease:%d, DIR lease:%d, "
                  "openfd cnt:%" PRIu64,
                  lease_ctx->lease_type, lease_ctx->lease_cnt,
                  lease_ctx->lease_type_cnt[GF_RD_LEASE],
-                 lease_ctx->lease_type_cnt[GF_RW_LEASE], lease_ctx->openfd_cnt);
+                 lease_ctx->lease_type_cnt[GF_RW_LEASE],
+                 lease_ctx->lease_type_cnt[GF_DIR_LEASE],
+                 lease_ctx->openfd_cnt);
 
     list_for_each_entry_safe(lease_entry, tmp, &lease_ctx->lease_id_list,
                              lease_id_list)
@@ -515,6 +517,10 @@ __add_lease(call_frame_t *frame, inode_t *inode, lease_inode_ctx_t *lease_ctx,
     lease_ctx->lease_type_cnt[lease->lease_type]++;
     lease_ctx->lease_type |= lease->lease_type;
 
+    if (lease->lease_type == GF_DIR_LEASE)
+        GF_ATOMIC_INC(((leases_private_t *)frame->this->private)
+                          ->dir_lease_cnt);
+
     /* Take a ref for the first lock taken on this inode. Corresponding
      * unref when all the leases are unlocked or during DISCONNECT
      * Ref is required because the inode on which lease is acquired should
@@ -654,6 +660,9 @@ __remove_lease(xlator_t *this, inode_t *inode, lease_inode_ctx_t *lease_ctx,
     lease_ctx->lease_type_cnt[lease_type]--;
     lease_ctx->lease_cnt--;
 
+    if (lease_type == GF_DIR_LEASE)
+        GF_ATOMIC_DEC(priv->dir_lease_cnt);
+
     if (lease_entry->lease_type_cnt[lease_type] == 0)
         lease_entry->lease_type = lease_entry->lease_type & (~lease_type);
 
@@ -714,6 +723,15 @@ __is_lease_grantable(xlator_t *this, lease_inode_ctx_t *lease_ctx,
         goto out;
     }
 
+    /* Directory leases are shared by any number of clients. They only
+     * let the holder cache the directory's entries and attributes, and
+     * are recalled by entry fops and setattr from other clients instead
+     * of by open fds. */
+    if (lease->lease_type == GF_DIR_LEASE) {
+        grant = _gf_true;
+        goto out;
+    }
+
     LOCK(&inode->lock);
     {
         list_for_each_entry(iter_fd, &inode->fd_list, inode_list)
@@ -962,6 +980,7 @@ process_lease_req(call_frame_t *frame, xlator_t *this, inode_t *inode,
     int ret = 0;
     char *client_uid = NULL;
     lease_inode_ctx_t *lease_ctx = NULL;
+    lease_id_entry_t *lease_entry = NULL;
 
     GF_VALIDATE_OR_GOTO("leases", frame, out);
     GF_VALIDATE_OR_GOTO("leases", this, out);
@@ -980,6 +999,17 @@ process_lease_req(call_frame_t *frame, xlator_t *this, inode_t *inode,
         goto out;
     }
 
+    if ((lease->cmd == GF_SET_LEASE) && (lease->lease_type == GF_DIR_LEASE) &&
+        (inode->ia_type != IA_IFDIR)) {
+        gf_msg(this->name, GF_LOG_ERROR, EINVAL, LEASE_MSG_INVAL_LEASE_TYPE,
+               "Directory lease requested on a non-directory, from "
+               "client:%s",
+               client_uid);
+        ret = -EINVAL;
+        errno = EINVAL;
+        goto out;
+    }
+
     lease_ctx = lease_ctx_get(inode, this);
     if (!lease_ctx) {
         gf_msg(this->name, GF_LOG_WARNING, ENOMEM, LEASE_MSG_NO_MEM,
@@ -1010,6 +1040,17 @@ process_lease_req(call_frame_t *frame, xlator_t *this, inode_t *inode,
                 break;
 
             case GF_SET_LEASE:
+                /* A directory lease is taken once per lease id, however
+                 * many times the client asks for it. */
+                if (lease->lease_type == GF_DIR_LEASE) {
+                    lease_entry = __get_lease_id_entry(lease_ctx,
+                                                       lease->lease_id);
+                    if (lease_entry &&
+                        (lease_entry->lease_type & GF_DIR_LEASE)) {
+                        ret = 0;
+                        break;
+                    }
+                }
                 if (__is_lease_grantable(this, lease_ctx, lease, inode)) {
                     __add_lease(frame, inode, lease_ctx, client_uid, lease);
                     ret = 0;
@@ -1051,16 +1092,16 @@ gf_boolean_t
 __check_lease_conflict(call_frame_t *frame, lease_inode_ctx_t *lease_ctx,
                        const char *lease_id, gf_boolean_t is_write)
 {
-    gf_lease_types_t lease_type = {
-        0,
-    };
+    int lease_type = NONE;
     gf_boolean_t conflicts = _gf_false;
     lease_id_entry_t *lease_entry = NULL;
 
     GF_VALIDATE_OR_GOTO("leases", frame, out);
     GF_VALIDATE_OR_GOTO("leases", lease_ctx, out);
 
-    lease_type = lease_ctx->lease_type;
+    /* Directory leases are checked separately, by
+     * check_dir_lease_conflict */
+    lease_type = lease_ctx->lease_type & ~GF_DIR_LEASE;
 
     /* If the fop is rename or unlink conflict the lease even if its
      * from the same client??
@@ -1084,7 +1125,8 @@ __check_lease_conflict(call_frame_t *frame, lease_inode_ctx_t *lease_ctx,
 
     /* If lease_id is not sent, set conflicts = true if there is
      * an existing lease */
-    if (!lease_id && (lease_ctx->lease_cnt > 0)) {
+    if (!lease_id &&
+        (lease_ctx->lease_cnt > lease_ctx->lease_type_cnt[GF_DIR_LEASE])) {
         conflicts = _gf_true;
         goto recall;
     }
@@ -1147,7 +1189,7 @@ check_lease_conflict(call_frame_t *frame, inode_t *inode, const char *lease_id,
 
     pthread_mutex_lock(&lease_ctx->lock);
     {
-        if (lease_ctx->lease_type == NONE) {
+        if ((lease_ctx->lease_type & ~GF_DIR_LEASE) == NONE) {
             pthread_mutex_unlock(&lease_ctx->lock);
             gf_msg_debug(frame->this->name, 0,
                          "No leases found continuing with the"
@@ -1186,9 +1228,144 @@ out:
     return ret;
 }
 
+/* Checks if a directory lease on this inode is held by a client other than
+ * the one the fop came from. The holder's own modifications are seen by its
+ * cache on the way back, hence do not need a recall.
+ */
+static gf_boolean_t
+__dir_lease_conflicts(call_frame_t *frame, lease_inode_ctx_t *lease_ctx)
+{
+    lease_id_entry_t *lease_entry = NULL;
+    const char *client_uid = NULL;
+
+    if (lease_ctx->lease_type_cnt[GF_DIR_LEASE] == 0)
+        return _gf_false;
+
+    if (frame->root->client)
+        client_uid = frame->root->client->client_uid;
+
+    list_for_each_entry(lease_entry, &lease_ctx->lease_id_list, lease_id_list)
+    {
+        if (!(lease_entry->lease_type & GF_DIR_LEASE))
+            continue;
+        if (!client_uid || strcmp(client_uid, lease_entry->client_uid) != 0)
+            return _gf_true;
+    }
+
+    return _gf_false;
+}
+
+static int
+dir_lease_conflict(call_frame_t *frame, inode_t *inode, uint32_t fop_flags,
+                   lease_inode_ctx_t **dir_ctx)
+{
+    lease_inode_ctx_t *lease_ctx = NULL;
+    uint64_t ctx = 0;
+    int ret = WIND_FOP;
+
+    /* Only look at an existing ctx, there is no point in creating one on
+     * every directory a fop touches. */
+    if (inode_ctx_get(inode, frame->this, &ctx) < 0 || !ctx)
+        goto out;
+
+    lease_ctx = (lease_inode_ctx_t *)(long)ctx;
+
+    pthread_mutex_lock(&lease_ctx->lock);
+    {
+        if (__dir_lease_conflicts(frame, lease_ctx)) {
+            __recall_lease(frame->this, lease_ctx);
+            if (fop_flags & BLOCKING_FOP) {
+                gf_msg_debug(frame->this->name, 0,
+                             "Fop: %s conflicting directory lease on "
+                             "gfid(%s), blocking the fop",
+                             gf_fop_list[frame->root->op],
+                             uuid_utoa(inode->gfid));
+                *dir_ctx = lease_ctx;
+                ret = BLOCK_FOP;
+            } else {
+                errno = EAGAIN;
+                ret = -1;
+            }
+        }
+    }
+    pthread_mutex_unlock(&lease_ctx->lock);
+out:
+    return ret;
+}
+
+/* A directory lease covers the entries of the directory and its own
+ * attributes. Hence an entry fop has to be checked against the lease on
+ * @parent, and a fop changing the attributes of a directory against the
+ * lease on @inode itself. Either may be NULL.
+ *
+ * Return values:
+ * -1 : error, unwind the fop
+ * WIND_FOP: No conflict, wind the fop
+ * BLOCK_FOP: Found a conflicting lease, block the fop on @dir_ctx
+ */
+int
+check_dir_lease_conflict(call_frame_t *frame, inode_t *inode, inode_t *parent,
+                         uint32_t fop_flags, lease_inode_ctx_t **dir_ctx)
+{
+    leases_private_t *priv = frame->this->private;
+    int ret = WIND_FOP;
+
+    if (GF_ATOMIC_GET(priv->dir_lease_cnt) == 0)
+        goto out;
+
+    if (inode && (inode->ia_type == IA_IFDIR)) {
+        ret = dir_lease_conflict(frame, inode, fop_flags, dir_ctx);
+        if (ret != WIND_FOP)
+            goto out;
+    }
+
+    if (parent)
+        ret = dir_lease_conflict(frame, parent, fop_flags, dir_ctx);
+out:
+    return ret;
+}
+
+/* Queues @stub until the directory leases on @lease_ctx are released. If
+ * that already happened after the conflict was found, the stub is resumed
+ * right away and redoes the checks.
+ */
+int
+block_dir_lease_fop(xlator_t *this, lease_inode_ctx_t *lease_ctx,
+                    call_stub_t *stub)
+{
+    fop_stub_t *blk_fop = NULL;
+    gf_boolean_t resume = _gf_false;
+
+    blk_fop = GF_CALLOC(1, sizeof(*blk_fop), gf_leases_mt_fop_stub_t);
+    if (!blk_fop) {
+        gf_msg(this->name, GF_LOG_WARNING, ENOMEM, LEASE_MSG_NO_MEM,
+               "Unable to create lease fop stub");
+        return -ENOMEM;
+    }
+    blk_fop->stub = stub;
+
+    pthread_mutex_lock(&lease_ctx->lock);
+    {
+        if ((lease_ctx->lease_cnt == 0) ||
+            (lease_ctx->lease_type_cnt[GF_DIR_LEASE] == 0))
+            resume = _gf_true;
+        else
+            list_add_tail(&blk_fop->list, &lease_ctx->blocked_list);
+    }
+    pthread_mutex_unlock(&lease_ctx->lock);
+
+    if (resume) {
+        GF_FREE(blk_fop);
+        call_resume(stub);
+    }
+
+    return 0;
+}
+
 static int
 remove_clnt_leases(const char *client_uid, inode_t *inode, xlator_t *this)
 {
+    leases_private_t *priv = this->private;
     lease_inode_ctx_t *lease_ctx = NULL;
     lease_id_entry_t *lease_entry = NULL;
     lease_id_entry_t *tmp = NULL;
@@ -1210,6 +1387,8 @@ remove_clnt_leases(const char *client_uid, inode_t *inode, xlator_t *this)
                                  lease_id_list)
         {
             if (strcmp(client_uid, lease_entry->client_uid) == 0) {
+                GF_ATOMIC_SUB(priv->dir_lease_cnt,
+                              lease_entry->lease_type_cnt[GF_DIR_LEASE]);
                 for (i = 0; i < GF_LEASE_MAX_TYPE; i++) {
                     lease_ctx->lease_type_cnt[i] -= lease_entry
                                                         ->lease_type_cnt[i];
@@ -1284,6 +1463,7 @@ out:
 static void
 __remove_all_leases(xlator_t *this, lease_inode_ctx_t *lease_ctx)
 {
+    leases_private_t *priv = this->private;
     int i = 0;
     lease_id_entry_t *lease_entry = NULL;
     lease_id_entry_t *tmp = NULL;
@@ -1302,6 +1482,8 @@ __remove_all_leases(xlator_t *this, lease_inode_ctx_t *lease_ctx)
         __destroy_lease_id_entry(lease_entry);
     }
     INIT_LIST_HEAD(&lease_ctx->lease_id_list);
+    GF_ATOMIC_SUB(priv->dir_lease_cnt,
+                  lease_ctx->lease_type_cnt[GF_DIR_LEASE]);
     for (i = 0; i <= GF_LEASE_MAX_TYPE; i++)
         lease_ctx->lease_type_cnt[i] = 0;
     lease_ctx->lease_type = 0;
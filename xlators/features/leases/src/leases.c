@@ -331,6 +331,7 @@ leases_setattr(call_frame_t *frame, xlator_t *this, loc_t *loc,
 {
     uint32_t fop_flags = 0;
     char *lease_id = NULL;
+    lease_inode_ctx_t *dir_ctx = NULL;
     int ret = 0;
 
     EXIT_IF_LEASES_OFF(this, out);
@@ -339,6 +340,13 @@ leases_setattr(call_frame_t *frame, xlator_t *this, loc_t *loc,
     GET_LEASE_ID(xdata, lease_id, frame->root->client->client_uid);
     GET_FLAGS(frame->root->op, 0);
 
+    ret = check_dir_lease_conflict(frame, loc->inode, NULL, fop_flags,
+                                   &dir_ctx);
+    if (ret < 0)
+        goto err;
+    else if (ret == BLOCK_FOP)
+        goto block_dir;
+
     ret = check_lease_conflict(frame, loc->inode, lease_id, fop_flags);
     if (ret < 0)
         goto err;
@@ -351,6 +359,11 @@ block:
     LEASE_BLOCK_FOP(loc->inode, setattr, frame, this, loc, stbuf, valid, xdata);
     return 0;
 
+block_dir:
+    LEASE_BLOCK_DIR_FOP(dir_ctx, setattr, frame, this, loc, stbuf, valid,
+                        xdata);
+    return 0;
+
 out:
     STACK_WIND(frame, leases_setattr_cbk, FIRST_CHILD(this),
                FIRST_CHILD(this)->fops->setattr, loc, stbuf, valid, xdata);
@@ -380,6 +393,7 @@ leases_rename(call_frame_t *frame, xlator_t *this, loc_t *oldloc, loc_t *newloc,
 {
     uint32_t fop_flags = 0;
     char *lease_id = NULL;
+    lease_inode_ctx_t *dir_ctx = NULL;
     int ret = 0;
 
     EXIT_IF_LEASES_OFF(this, out);
@@ -389,6 +403,16 @@ leases_rename(call_frame_t *frame, xlator_t *this, loc_t *oldloc, loc_t *newloc,
     GET_LEASE_ID(xdata, lease_id, frame->root->client->client_uid);
     GET_FLAGS(frame->root->op, 0);
 
+    ret = check_dir_lease_conflict(frame, oldloc->inode, oldloc->parent,
+                                   fop_flags, &dir_ctx);
+    if ((ret == WIND_FOP) && (newloc->parent != oldloc->parent))
+        ret = check_dir_lease_conflict(frame, NULL, newloc->parent, fop_flags,
+                                       &dir_ctx);
+    if (ret < 0)
+        goto err;
+    else if (ret == BLOCK_FOP)
+        goto block_dir;
+
     ret = check_lease_conflict(frame, oldloc->inode, lease_id, fop_flags);
     if (ret < 0)
         goto err;
@@ -401,6 +425,10 @@ block:
     LEASE_BLOCK_FOP(oldloc->inode, rename, frame, this, oldloc, newloc, xdata);
     return 0;
 
+block_dir:
+    LEASE_BLOCK_DIR_FOP(dir_ctx, rename, frame, this, oldloc, newloc, xdata);
+    return 0;
+
 out:
     STACK_WIND(frame, leases_rename_cbk, FIRST_CHILD(this),
                FIRST_CHILD(this)->fops->rename, oldloc, newloc, xdata);
@@ -429,6 +457,7 @@ leases_unlink(call_frame_t *frame, xlator_t *this, loc_t *loc, int xflag,
 {
     uint32_t fop_flags = 0;
     char *lease_id = NULL;
+    lease_inode_ctx_t *dir_ctx = NULL;
     int ret = 0;
 
     EXIT_IF_LEASES_OFF(this, out);
@@ -437,6 +466,13 @@ leases_unlink(call_frame_t *frame, xlator_t *this, loc_t *loc, int xflag,
     GET_LEASE_ID(xdata, lease_id, frame->root->client->client_uid);
     GET_FLAGS(frame->root->op, 0);
 
+    ret = check_dir_lease_conflict(frame, NULL, loc->parent, fop_flags,
+                                   &dir_ctx);
+    if (ret < 0)
+        goto err;
+    else if (ret == BLOCK_FOP)
+        goto block_dir;
+
     ret = check_lease_conflict(frame, loc->inode, lease_id, fop_flags);
     if (ret < 0)
         goto err;
@@ -449,6 +485,10 @@ block:
     LEASE_BLOCK_FOP(loc->inode, unlink, frame, this, loc, xflag, xdata);
     return 0;
 
+block_dir:
+    LEASE_BLOCK_DIR_FOP(dir_ctx, unlink, frame, this, loc, xflag, xdata);
+    return 0;
+
 out:
     STACK_WIND(frame, leases_unlink_cbk, FIRST_CHILD(this),
                FIRST_CHILD(this)->fops->unlink, loc, xflag, xdata);
@@ -476,6 +516,7 @@ leases_link(call_frame_t *frame, xlator_t *this, loc_t *oldloc, loc_t *newloc,
 {
     uint32_t fop_flags = 0;
     char *lease_id = NULL;
+    lease_inode_ctx_t *dir_ctx = NULL;
     int ret = 0;
 
     EXIT_IF_LEASES_OFF(this, out);
@@ -484,6 +525,13 @@ leases_link(call_frame_t *frame, xlator_t *this, loc_t *oldloc, loc_t *newloc,
     GET_LEASE_ID(xdata, lease_id, frame->root->client->client_uid);
     GET_FLAGS(frame->root->op, 0);
 
+    ret = check_dir_lease_conflict(frame, NULL, newloc->parent, fop_flags,
+                                   &dir_ctx);
+    if (ret < 0)
+        goto err;
+    else if (ret == BLOCK_FOP)
+        goto block_dir;
+
     ret = check_lease_conflict(frame, oldloc->inode, lease_id, fop_flags);
     if (ret < 0)
         goto err;
@@ -495,6 +543,10 @@ leases_link(call_frame_t *frame, xlator_t *this, loc_t *oldloc, loc_t *newloc,
 block:
     LEASE_BLOCK_FOP(oldloc->inode, link, frame, this, oldloc, newloc, xdata);
     return 0;
+
+block_dir:
+    LEASE_BLOCK_DIR_FOP(dir_ctx, link, frame, this, oldloc, newloc, xdata);
+    return 0;
 out:
     STACK_WIND(frame, leases_link_cbk, FIRST_CHILD(this),
                FIRST_CHILD(this)->fops->link, oldloc, newloc, xdata);
@@ -523,6 +575,7 @@ leases_create(call_frame_t *frame, xlator_t *this, loc_t *loc, int32_t flags,
 {
     uint32_t fop_flags = 0;
     char *lease_id = NULL;
+    lease_inode_ctx_t *dir_ctx = NULL;
     int ret = 0;
 
     EXIT_IF_LEASES_OFF(this, out);
@@ -531,6 +584,13 @@ leases_create(call_frame_t *frame, xlator_t *this, loc_t *loc, int32_t flags,
     GET_LEASE_ID(xdata, lease_id, frame->root->client->client_uid);
     GET_FLAGS(frame->root->op, flags);
 
+    ret = check_dir_lease_conflict(frame, NULL, loc->parent, fop_flags,
+                                   &dir_ctx);
+    if (ret < 0)
+        goto err;
+    else if (ret == BLOCK_FOP)
+        goto block_dir;
+
     ret = check_lease_conflict(frame, fd->inode, lease_id, fop_flags);
     if (ret < 0)
         goto err;
@@ -544,6 +604,11 @@ block:
                     xdata);
     return 0;
 
+block_dir:
+    LEASE_BLOCK_DIR_FOP(dir_ctx, create, frame, this, loc, flags, mode, umask,
+                        fd, xdata);
+    return 0;
+
 out:
     STACK_WIND(frame, leases_create_cbk, FIRST_CHILD(this),
                FIRST_CHILD(this)->fops->create, loc, flags, mode, umask, fd,
@@ -662,6 +727,7 @@ leases_fsetattr(call_frame_t *frame, xlator_t *this, fd_t *fd,
 {
     uint32_t fop_flags = 0;
     char *lease_id = NULL;
+    lease_inode_ctx_t *dir_ctx = NULL;
     int ret = 0;
 
     EXIT_IF_LEASES_OFF(this, out);
@@ -670,6 +736,12 @@ leases_fsetattr(call_frame_t *frame, xlator_t *this, fd_t *fd,
     GET_LEASE_ID(xdata, lease_id, frame->root->client->client_uid);
     GET_FLAGS(frame->root->op, fd->flags);
 
+    ret = check_dir_lease_conflict(frame, fd->inode, NULL, fop_flags, &dir_ctx);
+    if (ret < 0)
+        goto err;
+    else if (ret == BLOCK_FOP)
+        goto block_dir;
+
     ret = check_lease_conflict(frame, fd->inode, lease_id, fop_flags);
     if (ret < 0)
         goto err;
@@ -682,6 +754,11 @@ block:
     LEASE_BLOCK_FOP(fd->inode, fsetattr, frame, this, fd, stbuf, valid, xdata);
     return 0;
 
+block_dir:
+    LEASE_BLOCK_DIR_FOP(dir_ctx, fsetattr, frame, this, fd, stbuf, valid,
+                        xdata);
+    return 0;
+
 out:
     STACK_WIND(frame, leases_fsetattr_cbk, FIRST_CHILD(this),
                FIRST_CHILD(this)->fops->fsetattr, fd, stbuf, valid, xdata);
@@ -899,6 +976,188 @@ err:
     return 0;
 }
 
+int32_t
+leases_mkdir_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                 int32_t op_ret, int32_t op_errno, inode_t *inode,
+                 struct iatt *buf, struct iatt *preparent,
+                 struct iatt *postparent, dict_t *xdata)
+{
+    STACK_UNWIND_STRICT(mkdir, frame, op_ret, op_errno, inode, buf, preparent,
+                        postparent, xdata);
+
+    return 0;
+}
+
+int32_t
+leases_mkdir(call_frame_t *frame, xlator_t *this, loc_t *loc, mode_t mode,
+             mode_t umask, dict_t *xdata)
+{
+    uint32_t fop_flags = 0;
+    lease_inode_ctx_t *dir_ctx = NULL;
+    int ret = 0;
+
+    EXIT_IF_LEASES_OFF(this, out);
+    EXIT_IF_INTERNAL_FOP(frame, xdata, out);
+
+    GET_FLAGS(frame->root->op, 0);
+
+    ret = check_dir_lease_conflict(frame, NULL, loc->parent, fop_flags,
+                                   &dir_ctx);
+    if (ret < 0)
+        goto err;
+    else if (ret == WIND_FOP)
+        goto out;
+
+    LEASE_BLOCK_DIR_FOP(dir_ctx, mkdir, frame, this, loc, mode, umask, xdata);
+    return 0;
+
+out:
+    STACK_WIND(frame, leases_mkdir_cbk, FIRST_CHILD(this),
+               FIRST_CHILD(this)->fops->mkdir, loc, mode, umask, xdata);
+    return 0;
+
+err:
+    STACK_UNWIND_STRICT(mkdir, frame, -1, errno, NULL, NULL, NULL, NULL, NULL);
+    return 0;
+}
+
+int32_t
+leases_mknod_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                 int32_t op_ret, int32_t op_errno, inode_t *inode,
+                 struct iatt *buf, struct iatt *preparent,
+                 struct iatt *postparent, dict_t *xdata)
+{
+    STACK_UNWIND_STRICT(mknod, frame, op_ret, op_errno, inode, buf, preparent,
+                        postparent, xdata);
+
+    return 0;
+}
+
+int32_t
+leases_mknod(call_frame_t *frame, xlator_t *this, loc_t *loc, mode_t mode,
+             dev_t rdev, mode_t umask, dict_t *xdata)
+{
+    uint32_t fop_flags = 0;
+    lease_inode_ctx_t *dir_ctx = NULL;
+    int ret = 0;
+
+    EXIT_IF_LEASES_OFF(this, out);
+    EXIT_IF_INTERNAL_FOP(frame, xdata, out);
+
+    GET_FLAGS(frame->root->op, 0);
+
+    ret = check_dir_lease_conflict(frame, NULL, loc->parent, fop_flags,
+                                   &dir_ctx);
+    if (ret < 0)
+        goto err;
+    else if (ret == WIND_FOP)
+        goto out;
+
+    LEASE_BLOCK_DIR_FOP(dir_ctx, mknod, frame, this, loc, mode, rdev, umask,
+                        xdata);
+    return 0;
+
+out:
+    STACK_WIND(frame, leases_mknod_cbk, FIRST_CHILD(this),
+               FIRST_CHILD(this)->fops->mknod, loc, mode, rdev, umask, xdata);
+    return 0;
+
+err:
+    STACK_UNWIND_STRICT(mknod, frame, -1, errno, NULL, NULL, NULL, NULL, NULL);
+    return 0;
+}
+
+int32_t
+leases_symlink_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                   int32_t op_ret, int32_t op_errno, inode_t *inode,
+                   struct iatt *buf, struct iatt *preparent,
+                   struct iatt *postparent, dict_t *xdata)
+{
+    STACK_UNWIND_STRICT(symlink, frame, op_ret, op_errno, inode, buf,
+                        preparent, postparent, xdata);
+
+    return 0;
+}
+
+int32_t
+leases_symlink(call_frame_t *frame, xlator_t *this, const char *linkpath,
+               loc_t *loc, mode_t umask, dict_t *xdata)
+{
+    uint32_t fop_flags = 0;
+    lease_inode_ctx_t *dir_ctx = NULL;
+    int ret = 0;
+
+    EXIT_IF_LEASES_OFF(this, out);
+    EXIT_IF_INTERNAL_FOP(frame, xdata, out);
+
+    GET_FLAGS(frame->root->op, 0);
+
+    ret = check_dir_lease_conflict(frame, NULL, loc->parent, fop_flags,
+                                   &dir_ctx);
+    if (ret < 0)
+        goto err;
+    else if (ret == WIND_FOP)
+        goto out;
+
+    LEASE_BLOCK_DIR_FOP(dir_ctx, symlink, frame, this, linkpath, loc, umask,
+                        xdata);
+    return 0;
+
+out:
+    STACK_WIND(frame, leases_symlink_cbk, FIRST_CHILD(this),
+               FIRST_CHILD(this)->fops->symlink, linkpath, loc, umask, xdata);
+    return 0;
+
+err:
+    STACK_UNWIND_STRICT(symlink, frame, -1, errno, NULL, NULL, NULL, NULL,
+                        NULL);
+    return 0;
+}
+
+int32_t
+leases_rmdir_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                 int32_t op_ret, int32_t op_errno, struct iatt *preparent,
+                 struct iatt *postparent, dict_t *xdata)
+{
+    STACK_UNWIND_STRICT(rmdir, frame, op_ret, op_errno, preparent, postparent,
+                        xdata);
+
+    return 0;
+}
+
+int32_t
+leases_rmdir(call_frame_t *frame, xlator_t *this, loc_t *loc, int xflag,
+             dict_t *xdata)
+{
+    uint32_t fop_flags = 0;
+    lease_inode_ctx_t *dir_ctx = NULL;
+    int ret = 0;
+
+    EXIT_IF_LEASES_OFF(this, out);
+    EXIT_IF_INTERNAL_FOP(frame, xdata, out);
+
+    GET_FLAGS(frame->root->op, 0);
+
+    ret = check_dir_lease_conflict(frame, loc->inode, loc->parent, fop_flags,
+                                   &dir_ctx);
+    if (ret < 0)
+        goto err;
+    else if (ret == WIND_FOP)
+        goto out;
+
+    LEASE_BLOCK_DIR_FOP(dir_ctx, rmdir, frame, this, loc, xflag, xdata);
+    return 0;
+
+out:
+    STACK_WIND(frame, leases_rmdir_cbk, FIRST_CHILD(this),
+               FIRST_CHILD(this)->fops->rmdir, loc, xflag, xdata);
+    return 0;
+
+err:
+    STACK_UNWIND_STRICT(rmdir, frame, -1, errno, NULL, NULL, NULL);
+    return 0;
+}
+
 int32_t
 mem_acct_init(xlator_t *this)
 {
@@ -996,6 +1255,7 @@ init(xlator_t *this)
     GF_OPTION_INIT("lease-lock-recall-timeout", priv->recall_lease_timeout,
                    int32, out);
     pthread_mutex_init(&priv->mutex, NULL);
+    GF_ATOMIC_INIT(priv->dir_lease_cnt, 0);
     INIT_LIST_HEAD(&priv->client_list);
     INIT_LIST_HEAD(&priv->recall_list);
 
@@ -1116,6 +1376,10 @@ struct xlator_fops fops = {
     .rename = leases_rename,
     .unlink = leases_unlink,
     .link = leases_link,
+    .mkdir = leases_mkdir,
+    .mknod = leases_mknod,
+    .symlink = leases_symlink,
+    .rmdir = leases_rmdir,
 
 #ifdef NOT_SUPPORTED
     /* internal lk fops */
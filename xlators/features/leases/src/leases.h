@@ -151,6 +151,30 @@
         }                                                                      \
     } while (0)
 
+/* Blocks a fop that conflicts with a directory lease held by another
+ * client. Unlike LEASE_BLOCK_FOP, the stub resumes into the leases fop
+ * itself, so the directory and file lease checks are redone once the
+ * directory lease is released. */
+#define LEASE_BLOCK_DIR_FOP(lease_ctx, fop_name, frame, this, params...)       \
+    do {                                                                       \
+        call_stub_t *__stub = NULL;                                            \
+                                                                               \
+        __stub = fop_##fop_name##_stub(frame, leases_##fop_name, params);      \
+        if (!__stub) {                                                         \
+            gf_msg(this->name, GF_LOG_WARNING, ENOMEM, LEASE_MSG_NO_MEM,       \
+                   "Unable to create stub for blocking the fop:%s",            \
+                   gf_fop_list[frame->root->op]);                              \
+            errno = ENOMEM;                                                    \
+            goto err;                                                          \
+        }                                                                      \
+                                                                               \
+        if (block_dir_lease_fop(this, lease_ctx, __stub) < 0) {                \
+            call_stub_destroy(__stub);                                         \
+            errno = ENOMEM;                                                    \
+            goto err;                                                          \
+        }                                                                      \
+    } while (0)
+
 struct _leases_private {
     struct list_head client_list;
     struct list_head recall_list;
@@ -159,6 +183,8 @@ struct _leases_private {
     pthread_t recall_thr;
     pthread_mutex_t mutex;
     pthread_cond_t cond;
+    gf_atomic_t dir_lease_cnt; /* directory leases held on this brick, lets
+                                  fops skip the parent lookup when zero */
     int32_t recall_lease_timeout;
     gf_boolean_t inited_recall_thr;
     gf_boolean_t fini;
@@ -250,6 +276,14 @@ int
 check_lease_conflict(call_frame_t *frame, inode_t *inode, const char *lease_id,
                      uint32_t fop_flags);
 
+int
+check_dir_lease_conflict(call_frame_t *frame, inode_t *inode, inode_t *parent,
+                         uint32_t fop_flags, lease_inode_ctx_t **dir_ctx);
+
+int
+block_dir_lease_fop(xlator_t *this, lease_inode_ctx_t *lease_ctx,
+                    call_stub_t *stub);
+
 int
 cleanup_client_leases(xlator_t *this, const char *client_uid);
 
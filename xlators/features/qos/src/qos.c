@@ -0,0 +1,1193 @@
+/*
+   Copyright (c) 2021 Red Hat, Inc. <http://www.redhat.com>
+   This file is part of GlusterFS.
+
+   This file is licensed to you under your choice of the GNU Lesser
+   General Public License, version 3 or any later version (LGPLv3 or
+   later), or the GNU General Public License, version 2 (GPLv2), in all
+   cases as published by the Free Software Foundation.
+*/
+
+/*
+ * Brick side QoS.
+ *
+ * Requests are accounted to a tenant, which is the client, the uid of the
+ * caller or the top level directory the request works in, depending on the
+ * "key" option. Every tenant has an IOPS and a bandwidth bucket for each
+ * class of fops (read, write and metadata). A request that finds credit in
+ * both buckets of its class goes down right away; otherwise it is queued as
+ * a stub on the tenant and the dispatcher thread resumes it once the credit
+ * is there. Requests of one tenant and class are never reordered.
+ *
+ * The xlator sits right above io-threads, so resuming a stub only hands it
+ * over to the io-threads queues and the dispatcher never does any I/O. A
+ * throttled tenant holds no worker thread while it waits.
+ *
+ * Internal clients (self-heal, rebalance, ...) and fops that only take or
+ * release state (locks, flush, xattrop, ...) are not throttled.
+ */
+
+#include <glusterfs/hashfn.h>
+#include <glusterfs/statedump.h>
+#include <glusterfs/timespec.h>
+#include <glusterfs/client_t.h>
+#include "qos.h"
+
+static const char *qos_class_names[QOS_CLASS_MAX] = {
+    [QOS_CLASS_READ] = "read",
+    [QOS_CLASS_WRITE] = "write",
+    [QOS_CLASS_META] = "metadata",
+};
+
+static const char *qos_key_names[] = {
+    [QOS_KEY_CLIENT] = "client",
+    [QOS_KEY_UID] = "uid",
+    [QOS_KEY_DIRECTORY] = "directory",
+};
+
+static uint64_t
+qos_now(void)
+{
+    struct timespec ts;
+
+    timespec_now(&ts);
+    return TS(ts);
+}
+
+static uint64_t
+qos_cost(uint64_t units, uint64_t rate)
+{
+    return (uint64_t)((double)units * GF_SEC_IN_NS / rate);
+}
+
+static gf_boolean_t
+qos_bucket_ready(qos_bucket_t *bucket, uint64_t rate, uint64_t now,
+                 uint64_t burst)
+{
+    return (rate == 0) || (bucket->tat <= now + burst);
+}
+
+static void
+qos_bucket_charge(qos_bucket_t *bucket, uint64_t rate, uint64_t now,
+                  uint64_t units)
+{
+    if (rate == 0)
+        return;
+
+    if (bucket->tat < now)
+        bucket->tat = now;
+    bucket->tat += qos_cost(units, rate);
+}
+
+static uint64_t
+qos_bucket_wait(qos_bucket_t *bucket, uint64_t rate, uint64_t now,
+                uint64_t burst)
+{
+    if (qos_bucket_ready(bucket, rate, now, burst))
+        return 0;
+
+    return bucket->tat - burst - now;
+}
+
+static uint64_t
+qos_stub_bytes(call_stub_t *stub)
+{
+    switch (stub->fop) {
+        case GF_FOP_READ:
+        case GF_FOP_COPY_FILE_RANGE:
+            return stub->args.size;
+        case GF_FOP_WRITE:
+            return iov_length(stub->args.vector, stub->args.count);
+        default:
+            return 0;
+    }
+}
+
+static gf_boolean_t
+__qos_admit(qos_priv_t *priv, qos_tenant_t *tenant, qos_class_t class,
+            uint64_t bytes, uint64_t now)
+{
+    uint64_t iops = priv->iops_limit[class];
+    uint64_t bw = priv->bw_limit[class];
+
+    if (!qos_bucket_ready(&tenant->iops[class], iops, now, priv->burst_ns) ||
+        !qos_bucket_ready(&tenant->bw[class], bw, now, priv->burst_ns))
+        return _gf_false;
+
+    qos_bucket_charge(&tenant->iops[class], iops, now, 1);
+    qos_bucket_charge(&tenant->bw[class], bw, now, bytes);
+
+    return _gf_true;
+}
+
+static uint64_t
+__qos_wait(qos_priv_t *priv, qos_tenant_t *tenant, qos_class_t class,
+           uint64_t now)
+{
+    uint64_t iops = 0;
+    uint64_t bw = 0;
+
+    iops = qos_bucket_wait(&tenant->iops[class], priv->iops_limit[class], now,
+                           priv->burst_ns);
+    bw = qos_bucket_wait(&tenant->bw[class], priv->bw_limit[class], now,
+                         priv->burst_ns);
+
+    return max(iops, bw);
+}
+
+static int32_t
+qos_forget(xlator_t *this, inode_t *inode)
+{
+    uint64_t value = 0;
+
+    inode_ctx_del(inode, this, &value);
+    GF_FREE((char *)(uintptr_t)value);
+
+    return 0;
+}
+
+/* The name of the top level directory is cached in the inode context the
+ * first time an inode is seen. An inode renamed to another top level
+ * directory keeps being accounted to the old one until it is forgotten. */
+static void
+qos_directory_key(xlator_t *this, call_stub_t *stub, char *key, size_t size)
+{
+    inode_t *inode = NULL;
+    fd_t *fd = NULL;
+    char *path = NULL;
+    char *name = NULL;
+    uint64_t value = 0;
+    size_t len = 0;
+    int ret = -1;
+
+    fd = stub->args.fd_dst ? stub->args.fd_dst : stub->args.fd;
+    if (fd) {
+        inode = fd->inode;
+    } else if (stub->args.loc.parent && stub->args.loc.name) {
+        if (__is_root_gfid(stub->args.loc.parent->gfid)) {
+            snprintf(key, size, "dir:/%s", stub->args.loc.name);
+            return;
+        }
+        inode = stub->args.loc.parent;
+    } else {
+        inode = stub->args.loc.inode;
+    }
+
+    if (!inode || __is_root_gfid(inode->gfid)) {
+        snprintf(key, size, "dir:/");
+        return;
+    }
+
+    LOCK(&inode->lock);
+    {
+        ret = __inode_ctx_get(inode, this, &value);
+        if (ret == 0)
+            snprintf(key, size, "dir:/%s", (char *)(uintptr_t)value);
+    }
+    UNLOCK(&inode->lock);
+
+    if (ret == 0)
+        return;
+
+    /* Inodes not linked up to the root resolve to "<gfid:...>/..." and
+     * are accounted to an anonymous tenant until they are. */
+    ret = inode_path(inode, NULL, &path);
+    if (ret < 0 || path[0] != '/') {
+        snprintf(key, size, "dir:-");
+        goto out;
+    }
+
+    len = strcspn(path + 1, "/");
+    snprintf(key, size, "dir:/%.*s", (int)len, path + 1);
+
+    name = GF_MALLOC(len + 1, gf_qos_mt_char);
+    if (!name)
+        goto out;
+    memcpy(name, path + 1, len);
+    name[len] = '\0';
+
+    LOCK(&inode->lock);
+    {
+        if (__inode_ctx_get(inode, this, &value) != 0) {
+            value = (uint64_t)(uintptr_t)name;
+            if (__inode_ctx_set(inode, this, &value) == 0)
+                name = NULL;
+        }
+    }
+    UNLOCK(&inode->lock);
+
+out:
+    GF_FREE(name);
+    GF_FREE(path);
+}
+
+static void
+qos_tenant_key(xlator_t *this, qos_priv_t *priv, call_frame_t *frame,
+               call_stub_t *stub, char *key, size_t size)
+{
+    client_t *client = frame->root->client;
+
+    switch (priv->key) {
+        case QOS_KEY_UID:
+            snprintf(key, size, "uid:%u", frame->root->uid);
+            break;
+        case QOS_KEY_DIRECTORY:
+            qos_directory_key(this, stub, key, size);
+            break;
+        case QOS_KEY_CLIENT:
+        default:
+            snprintf(key, size, "client:%s",
+                     (client && client->client_uid) ? client->client_uid
+                                                    : "-");
+            break;
+    }
+}
+
+static qos_tenant_t *
+__qos_tenant_get(qos_priv_t *priv, const char *key)
+{
+    qos_tenant_t *tenant = NULL;
+    size_t len = strlen(key);
+    uint32_t hash = 0;
+    int i = 0;
+
+    hash = SuperFastHash(key, len) % QOS_TENANT_BUCKETS;
+    list_for_each_entry(tenant, &priv->tenants[hash], hash)
+    {
+        if (strcmp(tenant->key, key) == 0)
+            goto out;
+    }
+
+    tenant = GF_CALLOC(1, sizeof(*tenant) + len + 1, gf_qos_mt_tenant_t);
+    if (!tenant)
+        return NULL;
+
+    INIT_LIST_HEAD(&tenant->hash);
+    INIT_LIST_HEAD(&tenant->pending);
+    for (i = 0; i < QOS_CLASS_MAX; i++)
+        INIT_LIST_HEAD(&tenant->queue[i]);
+    memcpy(tenant->key, key, len + 1);
+
+    list_add_tail(&tenant->hash, &priv->tenants[hash]);
+    priv->tenant_count++;
+out:
+    tenant->last_active = gf_time();
+    return tenant;
+}
+
+static void
+__qos_tenant_prune(qos_priv_t *priv, time_t now)
+{
+    qos_tenant_t *tenant = NULL;
+    qos_tenant_t *tmp = NULL;
+    int i = 0;
+
+    for (i = 0; i < QOS_TENANT_BUCKETS; i++) {
+        list_for_each_entry_safe(tenant, tmp, &priv->tenants[i], hash)
+        {
+            if (tenant->queued ||
+                (tenant->last_active + QOS_TENANT_IDLE_SECS > now))
+                continue;
+
+            list_del_init(&tenant->hash);
+            priv->tenant_count--;
+            GF_FREE(tenant);
+        }
+    }
+}
+
+static void
+__qos_enqueue(qos_priv_t *priv, qos_tenant_t *tenant, qos_class_t class,
+              call_stub_t *stub)
+{
+    list_add_tail(&stub->list, &tenant->queue[class]);
+    if (tenant->queued++ == 0)
+        list_add_tail(&tenant->pending, &priv->pending);
+    priv->queued++;
+}
+
+/* Moves every queued stub that has credit now to @ready and returns the
+ * time, in nanoseconds, until the next queued stub can go. */
+static uint64_t
+__qos_dispatch(qos_priv_t *priv, uint64_t now, struct list_head *ready)
+{
+    qos_tenant_t *tenant = NULL;
+    qos_tenant_t *tmp = NULL;
+    call_stub_t *stub = NULL;
+    uint64_t wait = (uint64_t)QOS_DISPATCH_IDLE_SECS * GF_SEC_IN_NS;
+    int i = 0;
+
+    list_for_each_entry_safe(tenant, tmp, &priv->pending, pending)
+    {
+        for (i = 0; i < QOS_CLASS_MAX; i++) {
+            while (!list_empty(&tenant->queue[i])) {
+                stub = list_first_entry(&tenant->queue[i], call_stub_t, list);
+                if (!__qos_admit(priv, tenant, i, qos_stub_bytes(stub), now)) {
+                    wait = min(wait, __qos_wait(priv, tenant, i, now));
+                    break;
+                }
+
+                list_move_tail(&stub->list, ready);
+                tenant->queued--;
+                priv->queued--;
+            }
+        }
+
+        if (!tenant->queued)
+            list_del_init(&tenant->pending);
+    }
+
+    return wait;
+}
+
+static void
+qos_resume_all(struct list_head *ready)
+{
+    call_stub_t *stub = NULL;
+    call_stub_t *tmp = NULL;
+
+    list_for_each_entry_safe(stub, tmp, ready, list)
+    {
+        list_del_init(&stub->list);
+        call_resume(stub);
+    }
+}
+
+static void *
+qos_dispatcher(void *data)
+{
+    xlator_t *this = data;
+    qos_priv_t *priv = this->private;
+    struct timespec deadline = {
+        0,
+    };
+    struct list_head ready;
+    time_t last_prune = 0;
+    uint64_t wait = 0;
+
+    THIS = this;
+    INIT_LIST_HEAD(&ready);
+
+    pthread_mutex_lock(&priv->lock);
+    while (!priv->fini) {
+        wait = __qos_dispatch(priv, qos_now(), &ready);
+        if (!list_empty(&ready)) {
+            pthread_mutex_unlock(&priv->lock);
+            qos_resume_all(&ready);
+            pthread_mutex_lock(&priv->lock);
+            continue;
+        }
+
+        if (gf_time() - last_prune >= QOS_DISPATCH_IDLE_SECS) {
+            last_prune = gf_time();
+            __qos_tenant_prune(priv, last_prune);
+        }
+
+        timespec_now(&deadline);
+        deadline.tv_sec += wait / GF_SEC_IN_NS;
+        deadline.tv_nsec += wait % GF_SEC_IN_NS;
+        if (deadline.tv_nsec >= GF_SEC_IN_NS) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= GF_SEC_IN_NS;
+        }
+        pthread_cond_timedwait(&priv->cond, &priv->lock, &deadline);
+    }
+    pthread_mutex_unlock(&priv->lock);
+
+    return NULL;
+}
+
+int
+qos_schedule(xlator_t *this, call_frame_t *frame, call_stub_t *stub,
+             qos_class_t class)
+{
+    qos_priv_t *priv = this->private;
+    qos_tenant_t *tenant = NULL;
+    char key[QOS_TENANT_KEY_MAX];
+    uint64_t bytes = qos_stub_bytes(stub);
+    gf_boolean_t resume = _gf_false;
+    int ret = 0;
+
+    qos_tenant_key(this, priv, frame, stub, key, sizeof(key));
+
+    pthread_mutex_lock(&priv->lock);
+    {
+        /* Go after what was queued before, see reconfigure() */
+        if (priv->draining) {
+            list_add_tail(&stub->list, &priv->held);
+            goto unlock;
+        }
+
+        tenant = __qos_tenant_get(priv, key);
+        if (!tenant) {
+            ret = -ENOMEM;
+            goto unlock;
+        }
+
+        tenant->ops[class]++;
+        tenant->bytes[class] += bytes;
+        priv->ops[class]++;
+
+        if (list_empty(&tenant->queue[class]) &&
+            __qos_admit(priv, tenant, class, bytes, qos_now())) {
+            resume = _gf_true;
+            goto unlock;
+        }
+
+        tenant->throttled[class]++;
+        priv->throttled[class]++;
+        __qos_enqueue(priv, tenant, class, stub);
+        pthread_cond_signal(&priv->cond);
+    }
+unlock:
+    pthread_mutex_unlock(&priv->lock);
+
+    if (resume)
+        call_resume(stub);
+
+    return ret;
+}
+
+int
+qos_lookup(call_frame_t *frame, xlator_t *this, loc_t *loc, dict_t *xdata)
+{
+    QOS_FOP(lookup, QOS_CLASS_META, frame, this, loc, xdata);
+    return 0;
+}
+
+int
+qos_stat(call_frame_t *frame, xlator_t *this, loc_t *loc, dict_t *xdata)
+{
+    QOS_FOP(stat, QOS_CLASS_META, frame, this, loc, xdata);
+    return 0;
+}
+
+int
+qos_fstat(call_frame_t *frame, xlator_t *this, fd_t *fd, dict_t *xdata)
+{
+    QOS_FOP(fstat, QOS_CLASS_META, frame, this, fd, xdata);
+    return 0;
+}
+
+int
+qos_setattr(call_frame_t *frame, xlator_t *this, loc_t *loc, struct iatt *stbuf,
+            int32_t valid, dict_t *xdata)
+{
+    QOS_FOP(setattr, QOS_CLASS_META, frame, this, loc, stbuf, valid, xdata);
+    return 0;
+}
+
+int
+qos_fsetattr(call_frame_t *frame, xlator_t *this, fd_t *fd, struct iatt *stbuf,
+             int32_t valid, dict_t *xdata)
+{
+    QOS_FOP(fsetattr, QOS_CLASS_META, frame, this, fd, stbuf, valid, xdata);
+    return 0;
+}
+
+int
+qos_access(call_frame_t *frame, xlator_t *this, loc_t *loc, int32_t mask,
+           dict_t *xdata)
+{
+    QOS_FOP(access, QOS_CLASS_META, frame, this, loc, mask, xdata);
+    return 0;
+}
+
+int
+qos_readlink(call_frame_t *frame, xlator_t *this, loc_t *loc, size_t size,
+             dict_t *xdata)
+{
+    QOS_FOP(readlink, QOS_CLASS_META, frame, this, loc, size, xdata);
+    return 0;
+}
+
+int
+qos_mknod(call_frame_t *frame, xlator_t *this, loc_t *loc, mode_t mode,
+          dev_t rdev, mode_t umask, dict_t *xdata)
+{
+    QOS_FOP(mknod, QOS_CLASS_META, frame, this, loc, mode, rdev, umask, xdata);
+    return 0;
+}
+
+int
+qos_mkdir(call_frame_t *frame, xlator_t *this, loc_t *loc, mode_t mode,
+          mode_t umask, dict_t *xdata)
+{
+    QOS_FOP(mkdir, QOS_CLASS_META, frame, this, loc, mode, umask, xdata);
+    return 0;
+}
+
+int
+qos_unlink(call_frame_t *frame, xlator_t *this, loc_t *loc, int32_t xflag,
+           dict_t *xdata)
+{
+    QOS_FOP(unlink, QOS_CLASS_META, frame, this, loc, xflag, xdata);
+    return 0;
+}
+
+int
+qos_rmdir(call_frame_t *frame, xlator_t *this, loc_t *loc, int flags,
+          dict_t *xdata)
+{
+    QOS_FOP(rmdir, QOS_CLASS_META, frame, this, loc, flags, xdata);
+    return 0;
+}
+
+int
+qos_symlink(call_frame_t *frame, xlator_t *this, const char *linkname,
+            loc_t *loc, mode_t umask, dict_t *xdata)
+{
+    QOS_FOP(symlink, QOS_CLASS_META, frame, this, linkname, loc, umask, xdata);
+    return 0;
+}
+
+int
+qos_rename(call_frame_t *frame, xlator_t *this, loc_t *oldloc, loc_t *newloc,
+           dict_t *xdata)
+{
+    QOS_FOP(rename, QOS_CLASS_META, frame, this, oldloc, newloc, xdata);
+    return 0;
+}
+
+int
+qos_link(call_frame_t *frame, xlator_t *this, loc_t *oldloc, loc_t *newloc,
+         dict_t *xdata)
+{
+    QOS_FOP(link, QOS_CLASS_META, frame, this, oldloc, newloc, xdata);
+    return 0;
+}
+
+int
+qos_open(call_frame_t *frame, xlator_t *this, loc_t *loc, int32_t flags,
+         fd_t *fd, dict_t *xdata)
+{
+    QOS_FOP(open, QOS_CLASS_META, frame, this, loc, flags, fd, xdata);
+    return 0;
+}
+
+int
+qos_create(call_frame_t *frame, xlator_t *this, loc_t *loc, int32_t flags,
+           mode_t mode, mode_t umask, fd_t *fd, dict_t *xdata)
+{
+    QOS_FOP(create, QOS_CLASS_META, frame, this, loc, flags, mode, umask, fd,
+            xdata);
+    return 0;
+}
+
+int
+qos_opendir(call_frame_t *frame, xlator_t *this, loc_t *loc, fd_t *fd,
+            dict_t *xdata)
+{
+    QOS_FOP(opendir, QOS_CLASS_META, frame, this, loc, fd, xdata);
+    return 0;
+}
+
+int
+qos_readdir(call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
+            off_t offset, dict_t *xdata)
+{
+    QOS_FOP(readdir, QOS_CLASS_META, frame, this, fd, size, offset, xdata);
+    return 0;
+}
+
+int
+qos_readdirp(call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
+             off_t offset, dict_t *xdata)
+{
+    QOS_FOP(readdirp, QOS_CLASS_META, frame, this, fd, size, offset, xdata);
+    return 0;
+}
+
+int
+qos_statfs(call_frame_t *frame, xlator_t *this, loc_t *loc, dict_t *xdata)
+{
+    QOS_FOP(statfs, QOS_CLASS_META, frame, this, loc, xdata);
+    return 0;
+}
+
+int
+qos_getxattr(call_frame_t *frame, xlator_t *this, loc_t *loc, const char *name,
+             dict_t *xdata)
+{
+    QOS_FOP(getxattr, QOS_CLASS_META, frame, this, loc, name, xdata);
+    return 0;
+}
+
+int
+qos_fgetxattr(call_frame_t *frame, xlator_t *this, fd_t *fd, const char *name,
+              dict_t *xdata)
+{
+    QOS_FOP(fgetxattr, QOS_CLASS_META, frame, this, fd, name, xdata);
+    return 0;
+}
+
+int
+qos_setxattr(call_frame_t *frame, xlator_t *this, loc_t *loc, dict_t *dict,
+             int32_t flags, dict_t *xdata)
+{
+    QOS_FOP(setxattr, QOS_CLASS_META, frame, this, loc, dict, flags, xdata);
+    return 0;
+}
+
+int
+qos_fsetxattr(call_frame_t *frame, xlator_t *this, fd_t *fd, dict_t *dict,
+              int32_t flags, dict_t *xdata)
+{
+    QOS_FOP(fsetxattr, QOS_CLASS_META, frame, this, fd, dict, flags, xdata);
+    return 0;
+}
+
+int
+qos_removexattr(call_frame_t *frame, xlator_t *this, loc_t *loc,
+                const char *name, dict_t *xdata)
+{
+    QOS_FOP(removexattr, QOS_CLASS_META, frame, this, loc, name, xdata);
+    return 0;
+}
+
+int
+qos_fremovexattr(call_frame_t *frame, xlator_t *this, fd_t *fd,
+                 const char *name, dict_t *xdata)
+{
+    QOS_FOP(fremovexattr, QOS_CLASS_META, frame, this, fd, name, xdata);
+    return 0;
+}
+
+int
+qos_readv(call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
+          off_t offset, uint32_t flags, dict_t *xdata)
+{
+    QOS_FOP(readv, QOS_CLASS_READ, frame, this, fd, size, offset, flags, xdata);
+    return 0;
+}
+
+int
+qos_writev(call_frame_t *frame, xlator_t *this, fd_t *fd, struct iovec *vector,
+           int32_t count, off_t offset, uint32_t flags, struct iobref *iobref,
+           dict_t *xdata)
+{
+    QOS_FOP(writev, QOS_CLASS_WRITE, frame, this, fd, vector, count, offset,
+            flags, iobref, xdata);
+    return 0;
+}
+
+int
+qos_truncate(call_frame_t *frame, xlator_t *this, loc_t *loc, off_t offset,
+             dict_t *xdata)
+{
+    QOS_FOP(truncate, QOS_CLASS_WRITE, frame, this, loc, offset, xdata);
+    return 0;
+}
+
+int
+qos_ftruncate(call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
+              dict_t *xdata)
+{
+    QOS_FOP(ftruncate, QOS_CLASS_WRITE, frame, this, fd, offset, xdata);
+    return 0;
+}
+
+int
+qos_fsync(call_frame_t *frame, xlator_t *this, fd_t *fd, int32_t datasync,
+          dict_t *xdata)
+{
+    QOS_FOP(fsync, QOS_CLASS_WRITE, frame, this, fd, datasync, xdata);
+    return 0;
+}
+
+int
+qos_fallocate(call_frame_t *frame, xlator_t *this, fd_t *fd, int32_t mode,
+              off_t offset, size_t len, dict_t *xdata)
+{
+    QOS_FOP(fallocate, QOS_CLASS_WRITE, frame, this, fd, mode, offset, len,
+            xdata);
+    return 0;
+}
+
+int
+qos_discard(call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
+            size_t len, dict_t *xdata)
+{
+    QOS_FOP(discard, QOS_CLASS_WRITE, frame, this, fd, offset, len, xdata);
+    return 0;
+}
+
+int
+qos_zerofill(call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
+             off_t len, dict_t *xdata)
+{
+    QOS_FOP(zerofill, QOS_CLASS_WRITE, frame, this, fd, offset, len, xdata);
+    return 0;
+}
+
+int
+qos_copy_file_range(call_frame_t *frame, xlator_t *this, fd_t *fd_in,
+                    off64_t off_in, fd_t *fd_out, off64_t off_out, size_t len,
+                    uint32_t flags, dict_t *xdata)
+{
+    QOS_FOP(copy_file_range, QOS_CLASS_WRITE, frame, this, fd_in, off_in,
+            fd_out, off_out, len, flags, xdata);
+    return 0;
+}
+
+static int
+qos_parse_key(const char *str, qos_key_t *key)
+{
+    int i = 0;
+
+    for (i = 0; i < sizeof(qos_key_names) / sizeof(qos_key_names[0]); i++) {
+        if (strcmp(str, qos_key_names[i]) == 0) {
+            *key = i;
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
+static void
+__qos_configure(qos_priv_t *priv, qos_key_t key, uint64_t *iops, uint64_t *bw,
+                uint32_t burst)
+{
+    int i = 0;
+
+    priv->key = key;
+    priv->burst_ns = (uint64_t)burst * GF_SEC_IN_NS;
+    priv->active = _gf_false;
+    for (i = 0; i < QOS_CLASS_MAX; i++) {
+        priv->iops_limit[i] = iops[i];
+        priv->bw_limit[i] = bw[i];
+        if (iops[i] || bw[i])
+            priv->active = _gf_true;
+    }
+}
+
+/* Takes every queued request off its tenant to @ready, each queue in its
+ * order. */
+static void
+__qos_drain(qos_priv_t *priv, struct list_head *ready)
+{
+    qos_tenant_t *tenant = NULL;
+    qos_tenant_t *tmp = NULL;
+    int i = 0;
+
+    list_for_each_entry_safe(tenant, tmp, &priv->pending, pending)
+    {
+        for (i = 0; i < QOS_CLASS_MAX; i++)
+            list_splice_init(&tenant->queue[i], ready);
+        tenant->queued = 0;
+        list_del_init(&tenant->pending);
+    }
+    priv->queued = 0;
+}
+
+/* Resumes what was drained and then what came in meanwhile, until nothing
+ * is held any more, and only then lets the new configuration take over. */
+static void
+qos_resume_drained(qos_priv_t *priv, struct list_head *ready,
+                   gf_boolean_t active)
+{
+    while (!list_empty(ready)) {
+        qos_resume_all(ready);
+
+        pthread_mutex_lock(&priv->lock);
+        {
+            list_splice_init(&priv->held, ready);
+            if (list_empty(ready)) {
+                priv->active = active;
+                priv->draining = _gf_false;
+            }
+        }
+        pthread_mutex_unlock(&priv->lock);
+    }
+}
+
+int
+reconfigure(xlator_t *this, dict_t *options)
+{
+    qos_priv_t *priv = this->private;
+    uint64_t iops[QOS_CLASS_MAX] = {
+        0,
+    };
+    uint64_t bw[QOS_CLASS_MAX] = {
+        0,
+    };
+    uint32_t burst = 0;
+    char *key_str = NULL;
+    qos_key_t key = QOS_KEY_CLIENT;
+    struct list_head ready;
+    gf_boolean_t active = _gf_false;
+    gf_boolean_t rekey = _gf_false;
+    int ret = -1;
+
+    INIT_LIST_HEAD(&ready);
+
+    GF_OPTION_RECONF("key", key_str, options, str, out);
+    GF_OPTION_RECONF("read-iops", iops[QOS_CLASS_READ], options, uint64, out);
+    GF_OPTION_RECONF("write-iops", iops[QOS_CLASS_WRITE], options, uint64,
+                     out);
+    GF_OPTION_RECONF("metadata-iops", iops[QOS_CLASS_META], options, uint64,
+                     out);
+    GF_OPTION_RECONF("read-bandwidth", bw[QOS_CLASS_READ], options,
+                     size_uint64, out);
+    GF_OPTION_RECONF("write-bandwidth", bw[QOS_CLASS_WRITE], options,
+                     size_uint64, out);
+    GF_OPTION_RECONF("burst-time", burst, options, time, out);
+
+    if (qos_parse_key(key_str, &key) != 0) {
+        gf_msg(this->name, GF_LOG_ERROR, EINVAL, QOS_MSG_INVALID_CONFIG,
+               "invalid key %s", key_str);
+        goto out;
+    }
+
+    /* Requests queued under the previous key, or under limits that are
+     * gone, would be overtaken by the next ones of the same client, which
+     * land on another tenant or are not queued at all. They are let go
+     * first, and what comes in until they are is held behind them. The
+     * old tenants are pruned once idle, the key is part of the tenant name
+     * so they never match. */
+    pthread_mutex_lock(&priv->lock);
+    {
+        rekey = (key != priv->key);
+        __qos_configure(priv, key, iops, bw, burst);
+        if (priv->queued && (rekey || !priv->active)) {
+            __qos_drain(priv, &ready);
+            active = priv->active;
+            priv->active = _gf_true;
+            priv->draining = _gf_true;
+        }
+        pthread_cond_signal(&priv->cond);
+    }
+    pthread_mutex_unlock(&priv->lock);
+
+    qos_resume_drained(priv, &ready, active);
+
+    ret = 0;
+out:
+    return ret;
+}
+
+int32_t
+mem_acct_init(xlator_t *this)
+{
+    int ret = -1;
+
+    ret = xlator_mem_acct_init(this, gf_qos_mt_end + 1);
+    if (ret)
+        gf_msg(this->name, GF_LOG_ERROR, ENOMEM, QOS_MSG_NO_MEMORY,
+               "Memory accounting initialization failed.");
+
+    return ret;
+}
+
+int
+init(xlator_t *this)
+{
+    qos_priv_t *priv = NULL;
+    pthread_condattr_t attr;
+    uint64_t iops[QOS_CLASS_MAX] = {
+        0,
+    };
+    uint64_t bw[QOS_CLASS_MAX] = {
+        0,
+    };
+    uint32_t burst = 0;
+    char *key_str = NULL;
+    qos_key_t key = QOS_KEY_CLIENT;
+    int ret = -1;
+    int i = 0;
+
+    if (!this->children || this->children->next) {
+        gf_msg(this->name, GF_LOG_ERROR, EINVAL, QOS_MSG_INVALID_CONFIG,
+               "'qos' not configured with exactly one child");
+        goto out;
+    }
+
+    if (!this->parents)
+        gf_msg(this->name, GF_LOG_WARNING, 0, QOS_MSG_INVALID_CONFIG,
+               "dangling volume. check volfile ");
+
+    priv = GF_CALLOC(1, sizeof(*priv), gf_qos_mt_priv_t);
+    if (!priv)
+        goto out;
+
+    GF_OPTION_INIT("key", key_str, str, out);
+    GF_OPTION_INIT("read-iops", iops[QOS_CLASS_READ], uint64, out);
+    GF_OPTION_INIT("write-iops", iops[QOS_CLASS_WRITE], uint64, out);
+    GF_OPTION_INIT("metadata-iops", iops[QOS_CLASS_META], uint64, out);
+    GF_OPTION_INIT("read-bandwidth", bw[QOS_CLASS_READ], size_uint64, out);
+    GF_OPTION_INIT("write-bandwidth", bw[QOS_CLASS_WRITE], size_uint64, out);
+    GF_OPTION_INIT("burst-time", burst, time, out);
+
+    if (qos_parse_key(key_str, &key) != 0) {
+        gf_msg(this->name, GF_LOG_ERROR, EINVAL, QOS_MSG_INVALID_CONFIG,
+               "invalid key %s", key_str);
+        goto out;
+    }
+
+    for (i = 0; i < QOS_TENANT_BUCKETS; i++)
+        INIT_LIST_HEAD(&priv->tenants[i]);
+    INIT_LIST_HEAD(&priv->pending);
+    INIT_LIST_HEAD(&priv->held);
+    __qos_configure(priv, key, iops, bw, burst);
+
+    pthread_mutex_init(&priv->lock, NULL);
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&priv->cond, &attr);
+    pthread_condattr_destroy(&attr);
+
+    this->private = priv;
+
+    ret = gf_thread_create(&priv->dispatcher, NULL, qos_dispatcher, this,
+                           "qos");
+    if (ret) {
+        gf_msg(this->name, GF_LOG_ERROR, ret, QOS_MSG_THREAD_CREATE_FAILED,
+               "cannot create dispatcher thread");
+        this->private = NULL;
+        pthread_cond_destroy(&priv->cond);
+        pthread_mutex_destroy(&priv->lock);
+        ret = -1;
+        goto out;
+    }
+    priv->dispatcher_running = _gf_true;
+
+    ret = 0;
+out:
+    if (ret)
+        GF_FREE(priv);
+
+    return ret;
+}
+
+void
+fini(xlator_t *this)
+{
+    qos_priv_t *priv = this->private;
+    qos_tenant_t *tenant = NULL;
+    qos_tenant_t *tmp = NULL;
+    struct list_head ready;
+    int i = 0;
+    int c = 0;
+
+    if (!priv)
+        return;
+
+    INIT_LIST_HEAD(&ready);
+
+    pthread_mutex_lock(&priv->lock);
+    {
+        priv->fini = _gf_true;
+        pthread_cond_signal(&priv->cond);
+    }
+    pthread_mutex_unlock(&priv->lock);
+
+    if (priv->dispatcher_running)
+        pthread_join(priv->dispatcher, NULL);
+
+    /* Anything still queued is let through, as barrier does. */
+    for (i = 0; i < QOS_TENANT_BUCKETS; i++) {
+        list_for_each_entry_safe(tenant, tmp, &priv->tenants[i], hash)
+        {
+            list_del_init(&tenant->hash);
+            for (c = 0; c < QOS_CLASS_MAX; c++)
+                list_splice_init(&tenant->queue[c], &ready);
+            GF_FREE(tenant);
+        }
+    }
+    qos_resume_all(&ready);
+
+    this->private = NULL;
+    pthread_cond_destroy(&priv->cond);
+    pthread_mutex_destroy(&priv->lock);
+    GF_FREE(priv);
+}
+
+static void
+qos_dump_counters(uint64_t *ops, uint64_t *bytes, uint64_t *throttled)
+{
+    char key[GF_DUMP_MAX_BUF_LEN];
+    int i = 0;
+
+    for (i = 0; i < QOS_CLASS_MAX; i++) {
+        snprintf(key, sizeof(key), "%s.ops", qos_class_names[i]);
+        gf_proc_dump_write(key, "%" PRIu64, ops[i]);
+        if (bytes && i != QOS_CLASS_META) {
+            snprintf(key, sizeof(key), "%s.bytes", qos_class_names[i]);
+            gf_proc_dump_write(key, "%" PRIu64, bytes[i]);
+        }
+        snprintf(key, sizeof(key), "%s.throttled", qos_class_names[i]);
+        gf_proc_dump_write(key, "%" PRIu64, throttled[i]);
+    }
+}
+
+int
+qos_priv_dump(xlator_t *this)
+{
+    qos_priv_t *priv = this->private;
+    qos_tenant_t *tenant = NULL;
+    char key[GF_DUMP_MAX_BUF_LEN];
+    int i = 0;
+    int n = 0;
+
+    if (!priv)
+        return 0;
+
+    gf_proc_dump_build_key(key, "xlator.features.qos", "priv");
+    gf_proc_dump_add_section("%s", key);
+
+    pthread_mutex_lock(&priv->lock);
+    {
+        gf_proc_dump_write("key", "%s", qos_key_names[priv->key]);
+        gf_proc_dump_write("burst_time_ns", "%" PRIu64, priv->burst_ns);
+        for (i = 0; i < QOS_CLASS_MAX; i++) {
+            snprintf(key, sizeof(key), "%s.iops_limit", qos_class_names[i]);
+            gf_proc_dump_write(key, "%" PRIu64, priv->iops_limit[i]);
+            snprintf(key, sizeof(key), "%s.bandwidth_limit",
+                     qos_class_names[i]);
+            gf_proc_dump_write(key, "%" PRIu64, priv->bw_limit[i]);
+        }
+        gf_proc_dump_write("tenants", "%u", priv->tenant_count);
+        gf_proc_dump_write("queued", "%u", priv->queued);
+        qos_dump_counters(priv->ops, NULL, priv->throttled);
+
+        for (i = 0; i < QOS_TENANT_BUCKETS; i++) {
+            list_for_each_entry(tenant, &priv->tenants[i], hash)
+            {
+                gf_proc_dump_add_section("xlator.features.qos.tenant.%d", n++);
+                gf_proc_dump_write("tenant", "%s", tenant->key);
+                gf_proc_dump_write("queued", "%u", tenant->queued);
+                qos_dump_counters(tenant->ops, tenant->bytes,
+                                  tenant->throttled);
+            }
+        }
+    }
+    pthread_mutex_unlock(&priv->lock);
+
+    return 0;
+}
+
+struct xlator_fops fops = {
+    .lookup = qos_lookup,
+    .stat = qos_stat,
+    .fstat = qos_fstat,
+    .setattr = qos_setattr,
+    .fsetattr = qos_fsetattr,
+    .access = qos_access,
+    .readlink = qos_readlink,
+    .mknod = qos_mknod,
+    .mkdir = qos_mkdir,
+    .unlink = qos_unlink,
+    .rmdir = qos_rmdir,
+    .symlink = qos_symlink,
+    .rename = qos_rename,
+    .link = qos_link,
+    .open = qos_open,
+    .create = qos_create,
+    .opendir = qos_opendir,
+    .readdir = qos_readdir,
+    .readdirp = qos_readdirp,
+    .statfs = qos_statfs,
+    .getxattr = qos_getxattr,
+    .fgetxattr = qos_fgetxattr,
+    .setxattr = qos_setxattr,
+    .fsetxattr = qos_fsetxattr,
+    .removexattr = qos_removexattr,
+    .fremovexattr = qos_fremovexattr,
+    .readv = qos_readv,
+    .writev = qos_writev,
+    .truncate = qos_truncate,
+    .ftruncate = qos_ftruncate,
+    .fsync = qos_fsync,
+    .fallocate = qos_fallocate,
+    .discard = qos_discard,
+    .zerofill = qos_zerofill,
+    .copy_file_range = qos_copy_file_range,
+};
+
+struct xlator_cbks cbks = {
+    .forget = qos_forget,
+};
+
+struct xlator_dumpops dumpops = {
+    .priv = qos_priv_dump,
+};
+
+struct volume_options options[] = {
+    {.key = {"key"},
+     .type = GF_OPTION_TYPE_STR,
+     .value = {"client", "uid", "directory"},
+     .default_value = "client",
+     .op_version = {GD_OP_VERSION_10_0},
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC,
+     .description = "What requests are accounted to: the client connection, "
+                    "the uid of the caller or the top level directory of "
+                    "the volume the request works in. Every key gets its "
+                    "own set of limits."},
+    {.key = {"read-iops"},
+     .type = GF_OPTION_TYPE_INT,
+     .min = 0,
+     .default_value = "0",
+     .op_version = {GD_OP_VERSION_10_0},
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC,
+     .description = "Reads per second allowed to each key on the brick. "
+                    "0 means unlimited."},
+    {.key = {"write-iops"},
+     .type = GF_OPTION_TYPE_INT,
+     .min = 0,
+     .default_value = "0",
+     .op_version = {GD_OP_VERSION_10_0},
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC,
+     .description = "Writes, truncates, fsyncs, fallocates and copies per "
+                    "second allowed to each key on the brick. 0 means "
+                    "unlimited."},
+    {.key = {"metadata-iops"},
+     .type = GF_OPTION_TYPE_INT,
+     .min = 0,
+     .default_value = "0",
+     .op_version = {GD_OP_VERSION_10_0},
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC,
+     .description = "Namespace, attribute and xattr operations per second "
+                    "allowed to each key on the brick. 0 means unlimited."},
+    {.key = {"read-bandwidth"},
+     .type = GF_OPTION_TYPE_SIZET,
+     .min = 0,
+     .default_value = "0",
+     .op_version = {GD_OP_VERSION_10_0},
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC,
+     .description = "Bytes per second each key may read from the brick. "
+                    "0 means unlimited."},
+    {.key = {"write-bandwidth"},
+     .type = GF_OPTION_TYPE_SIZET,
+     .min = 0,
+     .default_value = "0",
+     .op_version = {GD_OP_VERSION_10_0},
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC,
+     .description = "Bytes per second each key may write or copy to the "
+                    "brick. 0 means unlimited."},
+    {.key = {"burst-time"},
+     .type = GF_OPTION_TYPE_TIME,
+     .min = 1,
+     .max = 3600,
+     .default_value = "1",
+     .op_version = {GD_OP_VERSION_10_0},
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC,
+     .description = "Seconds of credit a key builds up while it is below "
+                    "its limits. It may then go over the limits until the "
+                    "credit is spent."},
+    {.key = {NULL}},
+};
+
+xlator_api_t xlator_api = {
+    .init = init,
+    .fini = fini,
+    .reconfigure = reconfigure,
+    .mem_acct_init = mem_acct_init,
+    .op_version = {GD_OP_VERSION_10_0},
+    .dumpops = &dumpops,
+    .fops = &fops,
+    .cbks = &cbks,
+    .options = options,
+    .identifier = "qos",
+    .category = GF_TECH_PREVIEW,
+};
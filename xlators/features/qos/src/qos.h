@@ -0,0 +1,129 @@
+/*
+   Copyright (c) 2021 Red Hat, Inc. <http://www.redhat.com>
+   This file is part of GlusterFS.
+
+   This file is licensed to you under your choice of the GNU Lesser
+   General Public License, version 3 or any later version (LGPLv3 or
+   later), or the GNU General Public License, version 2 (GPLv2), in all
+   cases as published by the Free Software Foundation.
+*/
+
+#ifndef __QOS_H__
+#define __QOS_H__
+
+#include "qos-mem-types.h"
+#include "qos-messages.h"
+#include <glusterfs/xlator.h>
+#include <glusterfs/call-stub.h>
+#include <glusterfs/defaults.h>
+#include <glusterfs/list.h>
+
+#define QOS_TENANT_BUCKETS 256
+#define QOS_TENANT_KEY_MAX 256
+
+/* Tenants without activity and queued requests for this long are freed. */
+#define QOS_TENANT_IDLE_SECS 300
+
+/* Longest the dispatcher sleeps when nothing is due, in seconds. */
+#define QOS_DISPATCH_IDLE_SECS 10
+
+typedef enum {
+    QOS_KEY_CLIENT,
+    QOS_KEY_UID,
+    QOS_KEY_DIRECTORY,
+} qos_key_t;
+
+typedef enum {
+    QOS_CLASS_READ,
+    QOS_CLASS_WRITE,
+    QOS_CLASS_META,
+    QOS_CLASS_MAX,
+} qos_class_t;
+
+/*
+ * A token bucket kept as a virtual clock: @tat is the time, in nanoseconds,
+ * at which all the credit spent so far is paid back at the configured rate.
+ * A request is admitted while @tat is no more than burst-time ahead of now,
+ * so an idle tenant can spend rate * burst-time tokens at once. Admission
+ * moves @tat forward by the cost of the request, which lets a single large
+ * request borrow past the burst instead of never fitting.
+ */
+typedef struct {
+    uint64_t tat;
+} qos_bucket_t;
+
+typedef struct {
+    struct list_head hash;    /* qos_priv_t->tenants[] */
+    struct list_head pending; /* qos_priv_t->pending */
+    struct list_head queue[QOS_CLASS_MAX];
+    qos_bucket_t iops[QOS_CLASS_MAX];
+    qos_bucket_t bw[QOS_CLASS_MAX];
+    uint64_t ops[QOS_CLASS_MAX];
+    uint64_t bytes[QOS_CLASS_MAX];
+    uint64_t throttled[QOS_CLASS_MAX];
+    uint32_t queued;
+    time_t last_active;
+    char key[];
+} qos_tenant_t;
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    pthread_t dispatcher;
+
+    struct list_head tenants[QOS_TENANT_BUCKETS];
+    struct list_head pending; /* tenants with queued requests */
+    struct list_head held;    /* requests that came in while reconfigure()
+                                 let the queues of the previous key or
+                                 limits go */
+    uint32_t tenant_count;
+    uint32_t queued;
+    gf_boolean_t draining;
+
+    /* per second, 0 when the class is not limited */
+    uint64_t iops_limit[QOS_CLASS_MAX];
+    uint64_t bw_limit[QOS_CLASS_MAX];
+    uint64_t burst_ns;
+    qos_key_t key;
+    gf_boolean_t active; /* any limit configured, or still draining */
+
+    uint64_t ops[QOS_CLASS_MAX];
+    uint64_t throttled[QOS_CLASS_MAX];
+
+    gf_boolean_t fini;
+    gf_boolean_t dispatcher_running;
+} qos_priv_t;
+
+int
+qos_schedule(xlator_t *this, call_frame_t *frame, call_stub_t *stub,
+             qos_class_t class);
+
+#define QOS_FOP(name, class, frame, this, args...)                             \
+    do {                                                                       \
+        qos_priv_t *__priv = this->private;                                    \
+        call_stub_t *__stub = NULL;                                            \
+        int __ret = -1;                                                        \
+                                                                               \
+        if (!__priv->active || frame->root->pid < 0) {                         \
+            default_##name(frame, this, args);                                 \
+            break;                                                             \
+        }                                                                      \
+                                                                               \
+        __stub = fop_##name##_stub(frame, default_##name##_resume, args);      \
+        if (!__stub) {                                                         \
+            __ret = -ENOMEM;                                                   \
+            goto out;                                                          \
+        }                                                                      \
+                                                                               \
+        __ret = qos_schedule(this, frame, __stub, class);                      \
+                                                                               \
+    out:                                                                       \
+        if (__ret < 0) {                                                       \
+            default_##name##_failure_cbk(frame, -__ret);                       \
+            if (__stub != NULL) {                                              \
+                call_stub_destroy(__stub);                                     \
+            }                                                                  \
+        }                                                                      \
+    } while (0)
+
+#endif /* __QOS_H__ */
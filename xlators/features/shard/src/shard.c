@@ -520,6 +520,12 @@ shard_local_wipe(shard_local_t *local)
         GF_FREE(local->int_entrylk.basename);
     if (local->fd)
         fd_unref(local->fd);
+    if (local->fd_in)
+        fd_unref(local->fd_in);
+    if (local->src_fd)
+        fd_unref(local->src_fd);
+    if (local->dst_fd)
+        fd_unref(local->dst_fd);
 
     if (local->xattr_req)
         dict_unref(local->xattr_req);
@@ -839,6 +845,10 @@ shard_common_failure_unwind(glusterfs_fop_t fop, call_frame_t *frame,
             SHARD_STACK_UNWIND(discard, frame, op_ret, op_errno, NULL, NULL,
                                NULL);
             break;
+        case GF_FOP_COPY_FILE_RANGE:
+            SHARD_STACK_UNWIND(copy_file_range, frame, op_ret, op_errno, NULL,
+                               NULL, NULL, NULL);
+            break;
         case GF_FOP_READ:
             SHARD_STACK_UNWIND(readv, frame, op_ret, op_errno, NULL, -1, NULL,
                                NULL, NULL);
@@ -917,6 +927,11 @@ shard_common_inode_write_success_unwind(glusterfs_fop_t fop,
             SHARD_STACK_UNWIND(discard, frame, op_ret, 0, prebuf, postbuf,
                                xattr_rsp);
             break;
+        case GF_FOP_COPY_FILE_RANGE:
+            SHARD_STACK_UNWIND(copy_file_range, frame, op_ret, 0,
+                               ((local) ? &local->src_stbuf : NULL), prebuf,
+                               postbuf, xattr_rsp);
+            break;
         default:
             gf_msg(THIS->name, GF_LOG_WARNING, 0, SHARD_MSG_INVALID_FOP,
                    "Invalid fop id = %d", fop);
@@ -2392,6 +2407,7 @@ shard_common_lookup_shards_cbk(call_frame_t *frame, void *cookie,
             case GF_FOP_ZEROFILL:
             case GF_FOP_DISCARD:
             case GF_FOP_FALLOCATE:
+            case GF_FOP_COPY_FILE_RANGE:
                 if ((!local->first_lookup_done) && (op_errno == ENOENT)) {
                     LOCK(&frame->lock);
                     {
@@ -5459,6 +5475,48 @@ shard_common_inode_write_do_cbk(call_frame_t *frame, void *cookie,
     return 0;
 }
 
+static int
+shard_copy_file_range_do_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                             int32_t op_ret, int32_t op_errno,
+                             struct iatt *stbuf, struct iatt *prebuf_dst,
+                             struct iatt *postbuf_dst, dict_t *xdata)
+{
+    shard_local_t *local = frame->local;
+    shard_inode_ctx_t ctx = {
+        0,
+    };
+
+    if (op_ret >= 0) {
+        /* For a sharded source the block's iatt is not what the caller
+         * wants to see, report the aggregated one instead. */
+        if (!shard_inode_ctx_get_all(local->fd_in->inode, this, &ctx) &&
+            ctx.block_size) {
+            local->src_stbuf = ctx.stat;
+
+            /* A block file that is sparse or short ends before the logical
+             * file does. Returning 0 here would read as EOF to the caller
+             * and truncate the copy, make it fall back to read/write. */
+            if (op_ret == 0 && local->offset_in < ctx.stat.ia_size) {
+                op_ret = -1;
+                op_errno = EXDEV;
+                goto out;
+            }
+        } else if (stbuf) {
+            local->src_stbuf = *stbuf;
+        }
+
+        /* The copy stops early at the end of the source, only account for
+         * what actually landed in the destination. The destination range
+         * never spans blocks, so this is the only answer. */
+        local->total_size = op_ret;
+    }
+out:
+
+    return shard_common_inode_write_do_cbk(frame, cookie, this, op_ret,
+                                           op_errno, prebuf_dst, postbuf_dst,
+                                           xdata);
+}
+
 int
 shard_common_inode_write_wind(call_frame_t *frame, xlator_t *this, fd_t *fd,
                               struct iovec *vec, int count, off_t shard_offset,
@@ -5493,6 +5551,14 @@ shard_common_inode_write_wind(call_frame_t *frame, xlator_t *this, fd_t *fd,
                               FIRST_CHILD(this)->fops->discard, fd,
                               shard_offset, size, local->xattr_req);
             break;
+        case GF_FOP_COPY_FILE_RANGE:
+            STACK_WIND_COOKIE(frame, shard_copy_file_range_do_cbk, fd,
+                              FIRST_CHILD(this),
+                              FIRST_CHILD(this)->fops->copy_file_range,
+                              local->src_fd, local->src_offset, fd,
+                              shard_offset, size, local->flags,
+                              local->xattr_req);
+            break;
         default:
             gf_msg(this->name, GF_LOG_WARNING, 0, SHARD_MSG_INVALID_FOP,
                    "Invalid fop id = %d", local->fop);
@@ -5695,6 +5761,113 @@ shard_common_inode_write_post_resolve_handler(call_frame_t *frame,
     return 0;
 }
 
+static int
+shard_copy_file_range_src_lookup_cbk(call_frame_t *frame, void *cookie,
+                                     xlator_t *this, int32_t op_ret,
+                                     int32_t op_errno, inode_t *inode,
+                                     struct iatt *buf, dict_t *xdata,
+                                     struct iatt *postparent)
+{
+    shard_local_t *local = frame->local;
+    shard_post_fop_handler_t handler = cookie;
+
+    SHARD_UNSET_ROOT_FS_ID(frame, local);
+
+    if (op_ret < 0) {
+        /* A missing block is a hole in the source. There is nothing to
+         * copy on the bricks, the caller will have to write the zeroes. */
+        local->op_ret = -1;
+        local->op_errno = (op_errno == ENOENT) ? EXDEV : op_errno;
+        goto out;
+    }
+
+    local->src_fd = fd_anonymous(inode);
+    if (!local->src_fd) {
+        local->op_ret = -1;
+        local->op_errno = ENOMEM;
+    }
+out:
+    handler(frame, this);
+    return 0;
+}
+
+/* Finds the block of the source the copy reads from. Block 0 is the base
+ * file itself, any other block is opened anonymously after a lookup in the
+ * internal directory, exactly as readv would do for it. */
+static void
+shard_copy_file_range_resolve_src(call_frame_t *frame, xlator_t *this,
+                                  shard_post_fop_handler_t handler)
+{
+    char block_bname[256] = {
+        0,
+    };
+    int ret = 0;
+    uint64_t block_num = 0;
+    uint64_t block_size = 0;
+    inode_t *inode = NULL;
+    shard_local_t *local = frame->local;
+    shard_priv_t *priv = this->private;
+    loc_t loc = {
+        0,
+    };
+
+    shard_inode_ctx_get_block_size(local->fd_in->inode, this, &block_size);
+    if (block_size) {
+        block_num = local->offset_in / block_size;
+        local->src_offset = local->offset_in % block_size;
+    } else {
+        local->src_offset = local->offset_in;
+    }
+
+    if (block_num == 0) {
+        local->src_fd = fd_ref(local->fd_in);
+        goto out;
+    }
+
+    shard_make_block_bname(block_num, local->fd_in->inode->gfid, block_bname,
+                           sizeof(block_bname));
+
+    loc.parent = inode_find(this->itable, priv->dot_shard_gfid);
+    if (!loc.parent) {
+        local->op_ret = -1;
+        local->op_errno = EXDEV;
+        goto out;
+    }
+
+    inode = inode_grep(this->itable, loc.parent, block_bname);
+    if (inode) {
+        local->src_fd = fd_anonymous(inode);
+        inode_unref(inode);
+        if (!local->src_fd) {
+            local->op_ret = -1;
+            local->op_errno = ENOMEM;
+        }
+        goto out;
+    }
+
+    loc.inode = inode_new(this->itable);
+    ret = inode_path(loc.parent, block_bname, (char **)&(loc.path));
+    if (!loc.inode || ret < 0) {
+        local->op_ret = -1;
+        local->op_errno = ENOMEM;
+        goto out;
+    }
+    loc.name = strrchr(loc.path, '/');
+    if (loc.name)
+        loc.name++;
+    gf_uuid_copy(loc.pargfid, priv->dot_shard_gfid);
+
+    SHARD_SET_ROOT_FS_ID(frame, local);
+    STACK_WIND_COOKIE(frame, shard_copy_file_range_src_lookup_cbk, handler,
+                      FIRST_CHILD(this), FIRST_CHILD(this)->fops->lookup, &loc,
+                      NULL);
+    loc_wipe(&loc);
+    return;
+out:
+    loc_wipe(&loc);
+    handler(frame, this);
+}
+
 int
 shard_common_inode_write_post_lookup_handler(call_frame_t *frame,
                                              xlator_t *this)
@@ -5708,6 +5881,12 @@ shard_common_inode_write_post_lookup_handler(call_frame_t *frame,
         return 0;
     }
 
+    if ((local->fop == GF_FOP_COPY_FILE_RANGE) && !local->src_fd) {
+        shard_copy_file_range_resolve_src(
+            frame, this, shard_common_inode_write_post_lookup_handler);
+        return 0;
+    }
+
     local->postbuf = local->prebuf;
 
     /*Adjust offset to EOF so that correct shard is chosen for append*/
@@ -6288,6 +6467,9 @@ shard_readdir_do(call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
             goto err;
         }
 
+        if (dict_get(local->xattr_req, GF_CONTENT_KEY))
+            dict_del(local->xattr_req, GF_CONTENT_KEY);
+
         STACK_WIND(frame, shard_readdir_cbk, FIRST_CHILD(this),
                    FIRST_CHILD(this)->fops->readdirp, fd, size, offset,
                    local->xattr_req);
@@ -6932,7 +7114,8 @@ shard_common_inode_write_begin(call_frame_t *frame, xlator_t *this,
                                glusterfs_fop_t fop, fd_t *fd,
                                struct iovec *vector, int32_t count,
                                off_t offset, uint32_t flags, size_t len,
-                               struct iobref *iobref, dict_t *xdata)
+                               struct iobref *iobref, fd_t *fd_in,
+                               off_t offset_in, dict_t *xdata)
 {
     int ret = 0;
     int i = 0;
@@ -6973,6 +7156,12 @@ shard_common_inode_write_begin(call_frame_t *frame, xlator_t *this,
                                 FIRST_CHILD(this)->fops->discard, fd, offset,
                                 len, xdata);
                 break;
+            case GF_FOP_COPY_FILE_RANGE:
+                STACK_WIND_TAIL(frame, FIRST_CHILD(this),
+                                FIRST_CHILD(this)->fops->copy_file_range,
+                                fd_in, offset_in, fd, offset, len, flags,
+                                xdata);
+                break;
             default:
                 gf_msg(this->name, GF_LOG_WARNING, 0, SHARD_MSG_INVALID_FOP,
                        "Invalid fop id = %d", fop);
@@ -7014,6 +7203,10 @@ shard_common_inode_write_begin(call_frame_t *frame, xlator_t *this,
     if (iobref)
         local->iobref = iobref_ref(iobref);
     local->fd = fd_ref(fd);
+    if (fd_in) {
+        local->fd_in = fd_ref(fd_in);
+        local->offset_in = offset_in;
+    }
     local->block_size = block_size;
     local->resolver_base_inode = local->fd->inode;
     GF_ATOMIC_INIT(local->delta_blocks, 0);
@@ -7035,7 +7228,7 @@ shard_writev(call_frame_t *frame, xlator_t *this, fd_t *fd,
              struct iobref *iobref, dict_t *xdata)
 {
     shard_common_inode_write_begin(frame, this, GF_FOP_WRITE, fd, vector, count,
-                                   offset, flags, 0, iobref, xdata);
+                                   offset, flags, 0, iobref, NULL, 0, xdata);
     return 0;
 }
 
@@ -7048,7 +7241,8 @@ shard_fallocate(call_frame_t *frame, xlator_t *this, fd_t *fd,
         goto out;
 
     shard_common_inode_write_begin(frame, this, GF_FOP_FALLOCATE, fd, NULL, 0,
-                                   offset, keep_size, len, NULL, xdata);
+                                   offset, keep_size, len, NULL, NULL, 0,
+                                   xdata);
     return 0;
 out:
     shard_common_failure_unwind(GF_FOP_FALLOCATE, frame, -1, ENOTSUP);
@@ -7060,7 +7254,7 @@ shard_zerofill(call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
                off_t len, dict_t *xdata)
 {
     shard_common_inode_write_begin(frame, this, GF_FOP_ZEROFILL, fd, NULL, 0,
-                                   offset, 0, len, NULL, xdata);
+                                   offset, 0, len, NULL, NULL, 0, xdata);
     return 0;
 }
 
@@ -7069,7 +7263,153 @@ shard_discard(call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
               size_t len, dict_t *xdata)
 {
     shard_common_inode_write_begin(frame, this, GF_FOP_DISCARD, fd, NULL, 0,
-                                   offset, 0, len, NULL, xdata);
+                                   offset, 0, len, NULL, NULL, 0, xdata);
+    return 0;
+}
+
+/* The copy is mapped onto a single block of the source and a single block
+ * of the destination, and the length is cut at whichever boundary comes
+ * first. copy_file_range() is allowed to return short counts and every
+ * caller loops, so each iteration gets offloaded to the brick holding that
+ * pair of blocks. */
+static int
+shard_copy_file_range_begin(call_frame_t *frame, xlator_t *this, fd_t *fd_in,
+                            off64_t off_in, fd_t *fd_out, off64_t off_out,
+                            size_t len, uint32_t flags, dict_t *xdata)
+{
+    uint64_t src_block_size = 0;
+    uint64_t dst_block_size = 0;
+
+    shard_inode_ctx_get_block_size(fd_in->inode, this, &src_block_size);
+    shard_inode_ctx_get_block_size(fd_out->inode, this, &dst_block_size);
+
+    if (src_block_size && (len > src_block_size - off_in % src_block_size))
+        len = src_block_size - off_in % src_block_size;
+    if (dst_block_size && (len > dst_block_size - off_out % dst_block_size))
+        len = dst_block_size - off_out % dst_block_size;
+
+    shard_common_inode_write_begin(frame, this, GF_FOP_COPY_FILE_RANGE, fd_out,
+                                   NULL, 0, off_out, flags, len, NULL, fd_in,
+                                   off_in, xdata);
+    return 0;
+}
+
+/* Past the end of a sharded source the block files say nothing about the
+ * logical size, so the end has to be taken from the base file. Copies that
+ * start at or after it are at EOF, the rest are clamped. */
+static int
+shard_post_lookup_copy_file_range_handler(call_frame_t *frame,
+                                          xlator_t *this)
+{
+    shard_local_t *local = frame->local;
+    shard_inode_ctx_t dst_ctx = {
+        0,
+    };
+    fd_t *fd_in = NULL;
+    fd_t *fd_out = NULL;
+    dict_t *xdata = NULL;
+    off_t off_in = local->offset_in;
+    off_t off_out = local->offset;
+    size_t len = local->total_size;
+    uint32_t flags = local->flags;
+
+    if (local->op_ret < 0) {
+        shard_common_failure_unwind(GF_FOP_COPY_FILE_RANGE, frame,
+                                    local->op_ret, local->op_errno);
+        return 0;
+    }
+
+    if (off_in >= local->prebuf.ia_size) {
+        shard_inode_ctx_get_all(local->dst_fd->inode, this, &dst_ctx);
+        SHARD_STACK_UNWIND(copy_file_range, frame, 0, 0, &local->prebuf,
+                           &dst_ctx.stat, &dst_ctx.stat, NULL);
+        return 0;
+    }
+    if (len > local->prebuf.ia_size - off_in)
+        len = local->prebuf.ia_size - off_in;
+
+    /* The write path sets up a local of its own */
+    fd_in = fd_ref(local->fd);
+    fd_out = fd_ref(local->dst_fd);
+    xdata = dict_ref(local->xattr_req);
+    frame->local = NULL;
+    shard_local_wipe(local);
+    mem_put(local);
+
+    shard_copy_file_range_begin(frame, this, fd_in, off_in, fd_out, off_out,
+                                len, flags, xdata);
+
+    fd_unref(fd_in);
+    fd_unref(fd_out);
+    dict_unref(xdata);
+    return 0;
+}
+
+int
+shard_copy_file_range(call_frame_t *frame, xlator_t *this, fd_t *fd_in,
+                      off64_t off_in, fd_t *fd_out, off64_t off_out, size_t len,
+                      uint32_t flags, dict_t *xdata)
+{
+    int ret = 0;
+    uint64_t src_block_size = 0;
+    uint64_t dst_block_size = 0;
+    shard_local_t *local = NULL;
+
+    ret = shard_inode_ctx_get_block_size(fd_in->inode, this, &src_block_size);
+    if (!ret)
+        ret = shard_inode_ctx_get_block_size(fd_out->inode, this,
+                                             &dst_block_size);
+    if (ret) {
+        gf_msg(this->name, GF_LOG_ERROR, 0, SHARD_MSG_INODE_CTX_GET_FAILED,
+               "Failed to get block size for copy from %s",
+               uuid_utoa(fd_in->inode->gfid));
+        shard_common_failure_unwind(GF_FOP_COPY_FILE_RANGE, frame, -1, EINVAL);
+        return 0;
+    }
+
+    if (src_block_size && !dst_block_size &&
+        (off_in / src_block_size) != 0) {
+        shard_common_failure_unwind(GF_FOP_COPY_FILE_RANGE, frame, -1, EXDEV);
+        return 0;
+    }
+
+    if (!src_block_size) {
+        shard_copy_file_range_begin(frame, this, fd_in, off_in, fd_out,
+                                    off_out, len, flags, xdata);
+        return 0;
+    }
+
+    if (!this->itable)
+        this->itable = fd_in->inode->table;
+
+    local = mem_get0(this->local_pool);
+    if (!local)
+        goto err;
+
+    frame->local = local;
+
+    ret = syncbarrier_init(&local->barrier);
+    if (ret)
+        goto err;
+    local->fd = fd_ref(fd_in);
+    local->dst_fd = fd_ref(fd_out);
+    local->offset_in = off_in;
+    local->offset = off_out;
+    local->total_size = len;
+    local->flags = flags;
+    local->fop = GF_FOP_COPY_FILE_RANGE;
+    local->xattr_req = (xdata) ? dict_ref(xdata) : dict_new();
+    if (!local->xattr_req)
+        goto err;
+
+    local->loc.inode = inode_ref(fd_in->inode);
+    gf_uuid_copy(local->loc.gfid, fd_in->inode->gfid);
+
+    shard_refresh_base_file(frame, this, NULL, fd_in,
+                            shard_post_lookup_copy_file_range_handler);
+    return 0;
+err:
+    shard_common_failure_unwind(GF_FOP_COPY_FILE_RANGE, frame, -1, ENOMEM);
     return 0;
 }
 
@@ -7294,6 +7634,7 @@ struct xlator_fops fops = {
     .fremovexattr = shard_fremovexattr,
     .fallocate = shard_fallocate,
     .discard = shard_discard,
+    .copy_file_range = shard_copy_file_range,
     .zerofill = shard_zerofill,
     .readdir = shard_readdir,
     .readdirp = shard_readdirp,
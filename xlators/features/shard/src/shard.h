@@ -282,6 +282,13 @@ typedef struct shard_local {
     loc_t loc2;
     loc_t tmp_loc;
     fd_t *fd;
+    fd_t *fd_in;  /* copy_file_range source, as passed by the caller */
+    fd_t *src_fd; /* fd on the block of fd_in the copy reads from */
+    fd_t *dst_fd; /* copy_file_range destination, while fd is the source
+                     whose size is refreshed */
+    off_t offset_in;
+    off_t src_offset;
+    struct iatt src_stbuf;
     dict_t *xattr_req;
     dict_t *xattr_rsp;
     inode_t **inode_list;
@@ -2041,6 +2041,35 @@ out:
     return ret;
 }
 
+static int
+brick_graph_add_qos(volgen_graph_t *graph, glusterd_volinfo_t *volinfo,
+                    dict_t *set_dict, glusterd_brickinfo_t *brickinfo)
+{
+    xlator_t *xl = NULL;
+    int ret = -1;
+    xlator_t *this = THIS;
+    GF_ASSERT(this);
+
+    if (!graph || !volinfo) {
+        gf_smsg(this->name, GF_LOG_ERROR, errno, GD_MSG_INVALID_ARGUMENT, NULL);
+        goto out;
+    }
+
+    if (!dict_get_str_boolean(set_dict, "features.qos", 0)) {
+        /* update only if option is enabled */
+        ret = 0;
+        goto out;
+    }
+
+    xl = volgen_graph_add(graph, "features/qos", volinfo->volname);
+    if (!xl)
+        goto out;
+
+    ret = 0;
+out:
+    return ret;
+}
+
 static int
 brick_graph_add_namespace(volgen_graph_t *graph, glusterd_volinfo_t *volinfo,
                           dict_t *set_dict, glusterd_brickinfo_t *brickinfo)
@@ -2648,6 +2677,7 @@ static volgen_brick_xlator_t server_graph_table[] = {
     {brick_graph_add_barrier, NULL},
     {brick_graph_add_marker, "marker"},
     {brick_graph_add_selinux, "selinux"},
+    {brick_graph_add_qos, "qos"},
     {brick_graph_add_iot, "io-threads"},
     {brick_graph_add_upcall, "upcall"},
     {brick_graph_add_leases, "leases"},
@@ -1423,6 +1423,16 @@ struct volopt_map_entry glusterd_volopt_map[] = {
      .option = "trickling-writes",
      .op_version = GD_OP_VERSION_3_13_1,
      .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "performance.write-behind-append-stream-size",
+     .voltype = "performance/write-behind",
+     .option = "append-stream-size",
+     .op_version = GD_OP_VERSION_10_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "performance.write-behind-append-prealloc-size",
+     .voltype = "performance/write-behind",
+     .option = "append-prealloc-size",
+     .op_version = GD_OP_VERSION_10_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
     {.key = "performance.lazy-open",
      .voltype = "performance/open-behind",
      .option = "lazy-open",
@@ -1433,6 +1443,11 @@ struct volopt_map_entry glusterd_volopt_map[] = {
      .option = "read-after-open",
      .op_version = 3,
      .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "performance.whole-file-read-size",
+     .voltype = "performance/open-behind",
+     .option = "whole-file-read-size",
+     .op_version = GD_OP_VERSION_10_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
     {
         .key = "performance.open-behind-pass-through",
         .voltype = "performance/open-behind",
@@ -1500,6 +1515,15 @@ struct volopt_map_entry glusterd_volopt_map[] = {
      .option = "md-cache-statfs",
      .op_version = GD_OP_VERSION_4_0_0,
      .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "performance.md-cache-dir-leases",
+     .voltype = "performance/md-cache",
+     .option = "dir-leases",
+     .op_version = GD_OP_VERSION_10_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT,
+     .description = "Cache the attributes of directories under directory "
+                    "leases, until another client changes an entry in the "
+                    "directory or its attributes. Needs features.leases "
+                    "to be on."},
     {.key = "performance.xattr-cache-list",
      .voltype = "performance/md-cache",
      .option = "xattr-cache-list",
@@ -1533,6 +1557,14 @@ struct volopt_map_entry glusterd_volopt_map[] = {
      .description = "enable/disable client.ssl flag in the "
                     "volume.",
      .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "client.ssl-ktls",
+     .voltype = "protocol/client",
+     .option = "transport.socket.ssl-ktls",
+     .value = "off",
+     .op_version = GD_OP_VERSION_10_0,
+     .description = "Hand TLS record encryption on client connections to "
+                    "the kernel (kTLS) once the handshake is done.",
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
     {.key = "network.remote-dio",
      .voltype = "protocol/client",
      .option = "filter-O_DIRECT",
@@ -1574,6 +1606,14 @@ struct volopt_map_entry glusterd_volopt_map[] = {
      .op_version = GD_OP_VERSION_3_10_2,
      .value = "9",
      .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "client.zerocopy",
+     .voltype = "protocol/client",
+     .option = "transport.socket.zerocopy",
+     .value = "off",
+     .op_version = GD_OP_VERSION_10_0,
+     .description = "Send large write payloads to the bricks with "
+                    "MSG_ZEROCOPY instead of copying them.",
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
     {.key = "client.strict-locks",
      .voltype = "protocol/client",
      .option = "strict-locks",
@@ -1587,6 +1627,15 @@ struct volopt_map_entry glusterd_volopt_map[] = {
                     "necessary for stricter lock complaince as bricks "
                     "cleanup any granted locks when a client "
                     "disconnects."},
+    {.key = "client.connection-count",
+     .voltype = "protocol/client",
+     .option = "connection-count",
+     .value = "1",
+     .op_version = GD_OP_VERSION_10_0,
+     .description = "Number of TCP connections each client opens to a "
+                    "brick. Non-lock fops are spread over them. Takes "
+                    "effect on remount.",
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
 
     /* Although the following option is named ta-remote-port but it will be
      * added as remote-port in client volfile for ta-bricks only.
@@ -1650,6 +1699,19 @@ struct volopt_map_entry glusterd_volopt_map[] = {
      .option = "rpc.outstanding-rpc-limit",
      .type = GLOBAL_DOC,
      .op_version = 3},
+    {.key = "server.fair-share",
+     .voltype = "protocol/server",
+     .option = "rpc.fair-share",
+     .value = "off",
+     .op_version = GD_OP_VERSION_10_0},
+    {.key = "server.fair-share-weight",
+     .voltype = "protocol/server",
+     .option = "rpc.fair-share-weight",
+     .op_version = GD_OP_VERSION_10_0},
+    {.key = "server.fair-share-internal-weight",
+     .voltype = "protocol/server",
+     .option = "rpc.fair-share-internal-weight",
+     .op_version = GD_OP_VERSION_10_0},
     {.key = "server.ssl",
      .voltype = "protocol/server",
      .value = "off",
@@ -1657,6 +1719,15 @@ struct volopt_map_entry glusterd_volopt_map[] = {
      .description = "enable/disable server.ssl flag in the "
                     "volume.",
      .op_version = 2},
+    {
+        .key = "server.ssl-ktls",
+        .voltype = "protocol/server",
+        .option = "transport.socket.ssl-ktls",
+        .value = "off",
+        .op_version = GD_OP_VERSION_10_0,
+        .description = "Hand TLS record encryption on brick connections to "
+                       "the kernel (kTLS) once the handshake is done.",
+    },
     {
         .key = "auth.ssl-allow",
         .voltype = "protocol/server",
@@ -1729,6 +1800,15 @@ struct volopt_map_entry glusterd_volopt_map[] = {
         .op_version = GD_OP_VERSION_3_10_2,
         .value = "9",
     },
+    {
+        .key = "server.zerocopy",
+        .voltype = "protocol/server",
+        .option = "transport.socket.zerocopy",
+        .value = "off",
+        .op_version = GD_OP_VERSION_10_0,
+        .description = "Send large read replies with MSG_ZEROCOPY instead "
+                       "of copying them.",
+    },
     {
         .key = "transport.listen-backlog",
         .voltype = "protocol/server",
@@ -2394,6 +2474,27 @@ struct volopt_map_entry glusterd_volopt_map[] = {
     {.key = "storage.linux-io_uring",
      .voltype = "storage/posix",
      .op_version = GD_OP_VERSION_9_0},
+    {.key = "storage.parallel-readdirp",
+     .voltype = "storage/posix",
+     .op_version = GD_OP_VERSION_10_0},
+    {.key = "storage.handle-cache-size",
+     .voltype = "storage/posix",
+     .op_version = GD_OP_VERSION_10_0},
+    {.key = "storage.mdata-flush-interval",
+     .voltype = "storage/posix",
+     .op_version = GD_OP_VERSION_10_0},
+    {.key = "storage.lookup-xattr-cache",
+     .voltype = "storage/posix",
+     .op_version = GD_OP_VERSION_10_0},
+    {.key = "storage.reclaim-threshold",
+     .voltype = "storage/posix",
+     .op_version = GD_OP_VERSION_10_0},
+    {.key = "storage.reclaim-rate",
+     .voltype = "storage/posix",
+     .op_version = GD_OP_VERSION_10_0},
+    {.key = "storage.stream-drop-behind",
+     .voltype = "storage/posix",
+     .op_version = GD_OP_VERSION_10_0},
     {.key = "storage.batch-fsync-mode",
      .voltype = "storage/posix",
      .op_version = 3},
@@ -2895,6 +2996,13 @@ struct volopt_map_entry glusterd_volopt_map[] = {
      .flags = VOLOPT_FLAG_CLIENT_OPT,
      .op_version = GD_OP_VERSION_3_9_1,
      .validate_fn = validate_rda_cache_limit},
+    {.key = "performance.rda-content-prefetch-size",
+     .voltype = "performance/readdir-ahead",
+     .option = "rda-content-prefetch-size",
+     .value = "0",
+     .type = DOC,
+     .flags = VOLOPT_FLAG_CLIENT_OPT,
+     .op_version = GD_OP_VERSION_10_0},
     {
         .key = "performance.nl-cache-positive-entry",
         .voltype = "performance/nl-cache",
@@ -3067,6 +3175,42 @@ struct volopt_map_entry glusterd_volopt_map[] = {
         .description = "enable/disable dentry serialization xlator in volume",
         .type = NO_DOC,
     },
+    {
+        .key = "features.qos",
+        .voltype = "features/qos",
+        .value = "off",
+        .option = "!features",
+        .op_version = GD_OP_VERSION_10_0,
+        .description = "enable/disable per tenant I/O limits on the bricks",
+    },
+    {.key = "features.qos-key",
+     .voltype = "features/qos",
+     .option = "key",
+     .op_version = GD_OP_VERSION_10_0},
+    {.key = "features.qos-read-iops",
+     .voltype = "features/qos",
+     .option = "read-iops",
+     .op_version = GD_OP_VERSION_10_0},
+    {.key = "features.qos-write-iops",
+     .voltype = "features/qos",
+     .option = "write-iops",
+     .op_version = GD_OP_VERSION_10_0},
+    {.key = "features.qos-metadata-iops",
+     .voltype = "features/qos",
+     .option = "metadata-iops",
+     .op_version = GD_OP_VERSION_10_0},
+    {.key = "features.qos-read-bandwidth",
+     .voltype = "features/qos",
+     .option = "read-bandwidth",
+     .op_version = GD_OP_VERSION_10_0},
+    {.key = "features.qos-write-bandwidth",
+     .voltype = "features/qos",
+     .option = "write-bandwidth",
+     .op_version = GD_OP_VERSION_10_0},
+    {.key = "features.qos-burst-time",
+     .voltype = "features/qos",
+     .option = "burst-time",
+     .op_version = GD_OP_VERSION_10_0},
     {.key = "features.cloudsync",
      .voltype = "features/cloudsync",
      .value = "off",
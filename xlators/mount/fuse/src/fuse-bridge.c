@@ -11,6 +11,7 @@
 #include <config.h>
 
 #include <sys/wait.h>
+#include <sys/ioctl.h>
 #include "fuse-bridge.h"
 #include <glusterfs/glusterfs.h>
 #include <glusterfs/byte-order.h>
@@ -345,6 +346,48 @@ check_and_dump_fuse_W(fuse_private_t *priv, struct iovec *iov_out, int count,
     return 0;
 }
 
+/*
+ * Each /dev/fuse clone keeps its own list of requests under processing,
+ * so a reply has to go out on the fd its request was read from. Reader
+ * threads record the index of their fd in the padding of the in-header.
+ */
+static int
+fuse_dev_fd(fuse_private_t *priv, uint32_t dev)
+{
+    int *dev_fds = priv->dev_fds; /* cleared by fini() */
+
+    if (dev && dev_fds && dev < priv->reader_thread_count &&
+        dev_fds[dev] != -1)
+        return dev_fds[dev];
+
+    return priv->fd;
+}
+
+/*
+ * The clone a request is pending on, for an INTERRUPT which came before
+ * the request registered its interrupt record: the kernel looks the
+ * interrupted request up in the list of the fd the reply is written to.
+ * Only requests read from a clone are recorded, 0 stands for priv->fd.
+ * An entry overwritten while it is read gives a wrong clone, and the
+ * reply is refused with ENOENT, as it would be without the table.
+ */
+static uint32_t
+fuse_dev_of(fuse_private_t *priv, uint64_t unique)
+{
+    struct fuse_dev_req *req = NULL;
+    uint32_t dev = 0;
+
+    if (!priv->dev_reqs)
+        return 0;
+
+    req = &priv->dev_reqs[unique % FUSE_DEV_REQS];
+    if (__atomic_load_n(&req->unique, __ATOMIC_ACQUIRE) != unique)
+        return 0;
+    dev = req->dev;
+
+    return dev;
+}
+
 /*
  * iov_out should contain a fuse_out_header at zeroth position.
  * The error value of this header is sent to kernel.
@@ -370,7 +413,7 @@ send_fuse_iov(xlator_t *this, fuse_in_header_t *finh, struct iovec *iov_out,
         fouh->len += iov_out[i].iov_len;
     fouh->unique = finh->unique;
 
-    res = sys_writev(priv->fd, iov_out, count);
+    res = sys_writev(fuse_dev_fd(priv, finh->padding), iov_out, count);
     gf_log("glusterfs-fuse", GF_LOG_TRACE, "writev() result %d/%d %s", res,
            fouh->len, res == -1 ? strerror(errno) : "");
 
@@ -587,6 +630,7 @@ fuse_timed_message_new(void)
 
     /* should be NULL if not set */
     dmsg->fuse_message_body = NULL;
+    dmsg->dev = 0;
     INIT_LIST_HEAD(&dmsg->next);
     memset(dmsg->errnomask, 0, sizeof(dmsg->errnomask));
 
@@ -787,6 +831,9 @@ fuse_interrupt(xlator_t *this, fuse_in_header_t *finh, void *msg,
         dmsg->fuse_out_header.unique = finh->unique;
         dmsg->fuse_out_header.len = sizeof(dmsg->fuse_out_header);
         dmsg->fuse_out_header.error = -EAGAIN;
+        /* EAGAIN has the kernel queue the interrupt again, which it only
+           does on the fd the interrupted request was read from */
+        dmsg->dev = fuse_dev_of(this->private, fii->unique);
         if (ENOENT < ERRNOMASK_MAX)
             MASK_ERRNO(dmsg->errnomask, ENOENT);
         timespec_now(&dmsg->scheduled_ts);
@@ -5068,7 +5115,7 @@ timed_response_loop(void *data)
                                  sizeof(struct fuse_out_header)};
         iovs[1] = (struct iovec){dmsg->fuse_message_body,
                                  len - sizeof(struct fuse_out_header)};
-        rv = sys_writev(priv->fd, iovs, 2);
+        rv = sys_writev(fuse_dev_fd(priv, dmsg->dev), iovs, 2);
         check_and_dump_fuse_W(priv, iovs, 2, rv, dmsg->errnomask);
 
         fuse_timed_message_free(dmsg);
@@ -5270,6 +5317,32 @@ fuse_init(xlator_t *this, fuse_in_header_t *finh, void *msg,
         fino.flags |= FUSE_ASYNC_DIO;
 #endif
 
+#if FUSE_KERNEL_MINOR_VERSION >= 25
+    /* lookups and readdirs of a directory need not be serialized by the
+     * kernel, the graph below copes with concurrent directory fops */
+    if (fini->flags & FUSE_PARALLEL_DIROPS)
+        fino.flags |= FUSE_PARALLEL_DIROPS;
+#endif
+
+#if FUSE_KERNEL_MINOR_VERSION >= 28
+    /* a symlink is never changed in place, so its target may be kept
+     * in the page cache */
+    if (fini->flags & FUSE_CACHE_SYMLINKS)
+        fino.flags |= FUSE_CACHE_SYMLINKS;
+
+    /* Until 7.28 a request carries at most 32 pages, so larger writes
+     * only happen if the kernel lets us raise max_pages. */
+    if (fini->flags & FUSE_MAX_PAGES) {
+        fino.flags |= FUSE_MAX_PAGES;
+        fino.max_pages = (priv->max_write + getpagesize() - 1) /
+                         getpagesize();
+        fino.max_write = priv->max_write;
+        fino.max_readahead = priv->max_write;
+    }
+#endif
+    /* readers size their buffers after this from now on */
+    priv->max_write = fino.max_write;
+
     size = sizeof(fino);
 #if FUSE_KERNEL_MINOR_VERSION >= 23
     /* FUSE 7.23 and newer added attributes to the fuse_init_out struct */
@@ -5287,13 +5360,16 @@ fuse_init(xlator_t *this, fuse_in_header_t *finh, void *msg,
 #endif
 
     ret = send_fuse_data(this, finh, &fino, size);
-    if (ret == 0)
+    if (ret == 0) {
         gf_log("glusterfs-fuse", GF_LOG_INFO,
                "FUSE inited with protocol versions:"
                " glusterfs %d.%d kernel %d.%d",
                FUSE_KERNEL_VERSION, FUSE_KERNEL_MINOR_VERSION, fini->major,
                fini->minor);
-    else {
+        gf_log("glusterfs-fuse", GF_LOG_DEBUG,
+               "FUSE init flags 0x%x, max_write %u", fino.flags,
+               fino.max_write);
+    } else {
         gf_log("glusterfs-fuse", GF_LOG_ERROR, "FUSE init failed (%s)",
                strerror(ret));
 
@@ -6045,13 +6121,53 @@ fuse_dispatch(xlator_t *xl, gf_async_t *async)
     else
         priv->fuse_ops[finh->opcode](xl, finh, fasync->msg, iobuf);
 
-    iobuf_unref(iobuf);
+    if (iobuf)
+        iobuf_unref(iobuf);
 }
 
 /* We need 512 extra buffer size for BATCH_FORGET fop. By tests, it is
  * found to be reduces 'REALLOC()' in the loop */
 #define FUSE_EXTRA_ALLOC 512
 
+/* Give a reader thread its own /dev/fuse fd, so that the kernel does not
+ * funnel all requests in processing through the one list of priv->fd. */
+static int
+fuse_dev_clone(xlator_t *this, fuse_private_t *priv)
+{
+#ifdef FUSE_DEV_IOC_CLONE
+    uint32_t master = priv->fd;
+    int fd = -1;
+
+    fd = sys_open("/dev/fuse", O_RDWR | O_CLOEXEC, 0);
+    if (fd == -1) {
+        gf_log(this->name, GF_LOG_INFO, "opening /dev/fuse failed (%s)",
+               strerror(errno));
+        return -1;
+    }
+
+    if (ioctl(fd, FUSE_DEV_IOC_CLONE, &master) == -1) {
+        gf_log(this->name, GF_LOG_INFO,
+               "cloning /dev/fuse failed (%s), reader thread "
+               "stays on the shared fd",
+               strerror(errno));
+        sys_close(fd);
+        return -1;
+    }
+
+    return fd;
+#else
+    return -1;
+#endif
+}
+
+static void
+fuse_reader_unlock(void *data)
+{
+    fuse_private_t *priv = data;
+
+    pthread_mutex_unlock(&priv->sync_mutex);
+}
+
 static void *
 fuse_thread_proc(void *data)
 {
@@ -6074,13 +6190,27 @@ fuse_thread_proc(void *data)
         0,
     }};
     uint32_t psize;
+    uint32_t iobuf_psize = 0;
+    uint32_t dev = 0;
+    int dev_fd = -1;
+    gf_boolean_t cloned = _gf_false;
 
     this = data;
     priv = this->private;
 
     THIS = this;
 
-    psize = ((struct iobuf_pool *)this->ctx->iobuf_pool)->default_page_size;
+    /* fini() may only stop us while we wait for a request, or for the
+     * mount to finish */
+    pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
+
+    pthread_mutex_lock(&priv->sync_mutex);
+    {
+        dev = priv->reader_thread_next++;
+    }
+    pthread_mutex_unlock(&priv->sync_mutex);
+
+    dev_fd = priv->fd;
     priv->msg0_len_p = &msg0_size;
 
     for (;;) {
@@ -6095,7 +6225,13 @@ fuse_thread_proc(void *data)
                 pfd[0].events = POLLIN | POLLHUP | POLLERR;
                 pfd[1].fd = priv->fd;
                 pfd[1].events = POLLIN | POLLHUP | POLLERR;
-                if (poll(pfd, 2, -1) < 0) {
+                /* the other place fini() may stop us */
+                pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, NULL);
+                pthread_cleanup_push(fuse_reader_unlock, priv);
+                res = poll(pfd, 2, -1);
+                pthread_cleanup_pop(0);
+                pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
+                if (res < 0) {
                     gf_log(this->name, GF_LOG_ERROR, "poll error %s",
                            strerror(errno));
                     pthread_mutex_unlock(&priv->sync_mutex);
@@ -6132,11 +6268,28 @@ fuse_thread_proc(void *data)
         if (priv->init_recvd)
             fuse_graph_sync(this);
 
-        /* TODO: This place should always get maximum supported buffer
-           size from 'fuse', which is as of today 128KB. If we bring in
-           support for higher block sizes support, then we should be
-           changing this one too */
-        iobuf = iobuf_get(this->ctx->iobuf_pool);
+        /* The clone can only be attached to a mounted connection. */
+        if (dev && !cloned && priv->dev_fds && priv->mount_finished) {
+            cloned = _gf_true;
+            priv->dev_fds[dev] = fuse_dev_clone(this, priv);
+            if (priv->dev_fds[dev] != -1)
+                dev_fd = priv->dev_fds[dev];
+        }
+
+        /* The kernel refuses to read into a buffer that could not take
+         * a WRITE of max_write bytes. max_write only shrinks once INIT
+         * is answered, so a buffer sized before that stays big enough.
+         * Only a WRITE takes the buffer along, any other request leaves
+         * it for the next read. */
+        psize = priv->max_write;
+        if (iobuf && iobuf_psize != psize) {
+            iobuf_unref(iobuf);
+            iobuf = NULL;
+        }
+        if (!iobuf) {
+            iobuf = iobuf_get2(this->ctx->iobuf_pool, psize);
+            iobuf_psize = psize;
+        }
 
         /* Add extra 512 byte to the first iov so that it can
          * accommodate "ordinary" non-write requests. It's not
@@ -6150,9 +6303,8 @@ fuse_thread_proc(void *data)
 
         if (!iobuf || !iov_in[0].iov_base) {
             gf_log(this->name, GF_LOG_ERROR, "Out of memory");
-            if (iobuf)
-                iobuf_unref(iobuf);
             GF_FREE(iov_in[0].iov_base);
+            iov_in[0].iov_base = NULL;
             sleep(10);
             continue;
         }
@@ -6162,7 +6314,9 @@ fuse_thread_proc(void *data)
         iov_in[0].iov_len = msg0_size;
         iov_in[1].iov_len = psize;
 
-        res = sys_readv(priv->fd, iov_in, 2);
+        pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, NULL);
+        res = sys_readv(dev_fd, iov_in, 2);
+        pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
 
         if (res == -1) {
             if (errno == ENODEV || errno == EBADF) {
@@ -6265,28 +6419,42 @@ fuse_thread_proc(void *data)
         if (priv->uid_map_root && finh->uid == priv->uid_map_root)
             finh->uid = 0;
 
+        /* remember where to send the reply, see fuse_dev_fd() */
+        finh->padding = (dev_fd == priv->fd) ? 0 : dev;
+        if (finh->padding && priv->dev_reqs) {
+            struct fuse_dev_req *req;
+
+            req = &priv->dev_reqs[finh->unique % FUSE_DEV_REQS];
+            req->dev = finh->padding;
+            __atomic_store_n(&req->unique, finh->unique, __ATOMIC_RELEASE);
+        }
+
         if (finh->opcode >= FUSE_OP_HIGH) {
             /* turn down MacFUSE specific messages */
             fuse_enosys(this, finh, msg, NULL);
-            iobuf_unref(iobuf);
         } else {
             fasync = iov_in[0].iov_base + iov_in[0].iov_len;
             fasync->finh = finh;
             fasync->msg = msg;
-            fasync->iobuf = iobuf;
+            fasync->iobuf = NULL;
+            if (finh->opcode == FUSE_WRITE) {
+                fasync->iobuf = iobuf;
+                iobuf = NULL;
+            }
             gf_async(&fasync->async, this, fuse_dispatch);
         }
 
         continue;
 
     cont_err:
-        iobuf_unref(iobuf);
         GF_FREE(iov_in[0].iov_base);
         iov_in[0].iov_base = NULL;
     }
 
     if (iov_in[0].iov_base)
         GF_FREE(iov_in[0].iov_base);
+    if (iobuf)
+        iobuf_unref(iobuf);
 
     /*
      * We could be in all sorts of states with respect to iobuf and iov_in
@@ -6342,6 +6510,9 @@ fuse_priv_dump(xlator_t *this)
 
     gf_proc_dump_write("fd", "%d", private->fd);
     gf_proc_dump_write("proto_minor", "%u", private->proto_minor);
+    gf_proc_dump_write("max_write", "%u", private->max_write);
+    gf_proc_dump_write("reader_thread_count", "%u",
+                       private->reader_thread_count);
     gf_proc_dump_write("volfile", "%s",
                        private->volfile ? private->volfile : "None");
     gf_proc_dump_write("volfile_size", "%" GF_PRI_SIZET, private->volfile_size);
@@ -6532,6 +6703,19 @@ notify(xlator_t *this, int32_t event, void *data, ...)
                 ->fuse_thread = GF_CALLOC(private->reader_thread_count,
                                           sizeof(pthread_t),
                                           gf_fuse_mt_pthread_t);
+               private
+                ->dev_fds = GF_MALLOC(private->reader_thread_count *
+                                          sizeof(int),
+                                      gf_fuse_mt_dev_fds_t);
+                if (private->dev_fds) {
+                    private->dev_fds[0] = private->fd;
+                    for (i = 1; i < private->reader_thread_count; i++)
+                        private->dev_fds[i] = -1;
+                }
+                if (private->reader_thread_count > 1)
+                    private->dev_reqs = GF_CALLOC(FUSE_DEV_REQS,
+                                                  sizeof(struct fuse_dev_req),
+                                                  gf_fuse_mt_dev_reqs_t);
                 for (i = 0; i < private->reader_thread_count; i++) {
                     ret = gf_thread_create(&private->fuse_thread[i], NULL,
                                            fuse_thread_proc, this, "fuseproc");
@@ -6671,6 +6855,7 @@ init(xlator_t *this_xl)
     gf_boolean_t fopen_keep_cache = _gf_false;
     char *mnt_args = NULL;
     eh_t *event = NULL;
+    uint64_t max_write = 0;
 
     if (this_xl == NULL)
         return -1;
@@ -6759,6 +6944,9 @@ init(xlator_t *this_xl)
     GF_OPTION_INIT("reader-thread-count", priv->reader_thread_count, uint32,
                    cleanup_exit);
 
+    GF_OPTION_INIT("fuse-max-write", max_write, size_uint64, cleanup_exit);
+    priv->max_write = max_write;
+
     GF_OPTION_INIT("auto-invalidation", priv->fuse_auto_inval, bool,
                    cleanup_exit);
     GF_OPTION_INIT(ZR_ENTRY_TIMEOUT_OPT, priv->entry_timeout, double,
@@ -7041,6 +7229,8 @@ fini(xlator_t *this_xl)
 {
     fuse_private_t *priv = NULL;
     char *mount_point = NULL;
+    int *dev_fds = NULL;
+    uint32_t i = 0;
 
     if (this_xl == NULL)
         return;
@@ -7074,6 +7264,36 @@ fini(xlator_t *this_xl)
         sys_close(priv->fuse_dump_fd);
         dict_del(this_xl->options, ZR_MOUNTPOINT_OPT);
     }
+
+    /* The readers use the clones and the table of the requests read from
+     * them, stop them before these go. They can only be cancelled while
+     * waiting for a request, see fuse_thread_proc(). Replies
+     * still in flight fall back to priv->fd. */
+    if (priv->fuse_thread) {
+        for (i = 0; i < priv->reader_thread_count; i++) {
+            if (priv->fuse_thread[i] &&
+                !pthread_equal(priv->fuse_thread[i], pthread_self()))
+                (void)pthread_cancel(priv->fuse_thread[i]);
+        }
+        for (i = 0; i < priv->reader_thread_count; i++) {
+            if (priv->fuse_thread[i] &&
+                !pthread_equal(priv->fuse_thread[i], pthread_self()))
+                (void)pthread_join(priv->fuse_thread[i], NULL);
+        }
+    }
+
+    dev_fds = priv->dev_fds;
+    priv->dev_fds = NULL;
+    if (dev_fds) {
+        for (i = 1; i < priv->reader_thread_count; i++) {
+            if (dev_fds[i] != -1)
+                sys_close(dev_fds[i]);
+        }
+        GF_FREE(dev_fds);
+    }
+    GF_FREE(priv->dev_reqs);
+    priv->dev_reqs = NULL;
+
     /* Process should terminate once fuse xlator is finished.
      * Required for AUTH_FAILED event.
      */
@@ -7181,6 +7401,16 @@ struct volume_options options[] = {
         .max = 64,
         .description = "Sets fuse reader thread count.",
     },
+    {
+        .key = {"fuse-max-write"},
+        .type = GF_OPTION_TYPE_SIZET,
+        .default_value = "1MB",
+        .min = 128 * GF_UNIT_KB,
+        .max = 16 * GF_UNIT_MB,
+        .description = "Largest read and write request offered to the fuse "
+                       "kernel module. Requests above 128KB need a kernel "
+                       "supporting FUSE_MAX_PAGES.",
+    },
     {
         .key = {"kernel-writeback-cache"},
         .type = GF_OPTION_TYPE_BOOL,
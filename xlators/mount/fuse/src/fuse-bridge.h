@@ -62,6 +62,14 @@ enum fusedev_errno {
     FUSEDEV_EMAXPLUS
 };
 
+/* A request read from the clone dev_fds[dev]. */
+struct fuse_dev_req {
+    uint64_t unique;
+    uint32_t dev;
+};
+
+#define FUSE_DEV_REQS 1024
+
 struct fuse_private {
     int fd;
     uint32_t proto_minor;
@@ -74,6 +82,17 @@ struct fuse_private {
     uint32_t reader_thread_count;
     char fuse_thread_started;
 
+    /* /dev/fuse fd of each reader thread; dev_fds[0] is fd itself, the
+     * others are FUSE_DEV_IOC_CLONE clones of it (or -1 until cloned) */
+    int *dev_fds;
+    uint32_t reader_thread_next;
+
+    /* clone the latest requests were read from, see fuse_dev_of() */
+    struct fuse_dev_req *dev_reqs;
+
+    /* largest WRITE we accept; the kernel reply of INIT may lower it */
+    uint32_t max_write;
+
     uint32_t direct_io_mode;
     size_t *msg0_len_p;
 
@@ -207,6 +226,7 @@ struct fuse_timed_message {
     struct timespec scheduled_ts;
     errnomask_t errnomask;
     struct list_head next;
+    uint32_t dev; /* index into priv->dev_fds */
 };
 typedef struct fuse_timed_message fuse_timed_message_t;
 
@@ -77,6 +77,10 @@ free_fuse_state(fuse_state_t *state)
         fd_unref(state->fd);
         state->fd = (void *)0xfdfdfdfd;
     }
+    if (state->fd_dst) {
+        fd_unref(state->fd_dst);
+        state->fd_dst = (void *)0xfdfdfdfd;
+    }
     if (state->finh) {
         GF_FREE(state->finh);
         state->finh = NULL;
@@ -368,7 +368,7 @@ fuse_migrate_fd_task(void *data)
         goto out;
     }
 
-    basefd = state->fd;
+    basefd = state->resolve_now->fd;
 
     basefd_ctx = fuse_fd_ctx_get(state->this, basefd);
     if (!basefd_ctx)
@@ -529,7 +529,12 @@ fuse_resolve_fd(fuse_state_t *state)
     }
 
     if (activefd != basefd) {
-        state->fd = fd_ref(activefd);
+        /* The second fd of a fop (the copy_file_range destination) is
+         * kept in fd_dst, don't let it overwrite the first one. */
+        if (resolve == &state->resolve2)
+            state->fd_dst = fd_ref(activefd);
+        else
+            state->fd = fd_ref(activefd);
         fd_unref(basefd);
     }
 
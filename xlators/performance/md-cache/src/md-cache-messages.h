@@ -24,6 +24,6 @@
 
 GLFS_MSGID(MD_CACHE, MD_CACHE_MSG_NO_MEMORY, MD_CACHE_MSG_DISCARD_UPDATE,
            MD_CACHE_MSG_CACHE_UPDATE, MD_CACHE_MSG_IPC_UPCALL_FAILED,
-           MD_CACHE_MSG_NO_XATTR_CACHE);
+           MD_CACHE_MSG_NO_XATTR_CACHE, MD_CACHE_MSG_NO_DIR_LEASE);
 
 #endif /* _MD_CACHE_MESSAGES_H_ */
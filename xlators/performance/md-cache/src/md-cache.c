@@ -56,6 +56,8 @@ struct mdc_statistics {
     gf_atomic_t xattr_invals; /* No. of invalidates received from upcall */
     gf_atomic_t need_lookup;  /* No. of lookups issued, because other
                                  xlators requested for explicit lookup */
+    gf_atomic_t lease_grants;  /* No. of directory leases granted */
+    gf_atomic_t lease_recalls; /* No. of directory lease recalls */
 };
 
 struct mdc_conf {
@@ -78,6 +80,9 @@ struct mdc_conf {
     struct mdc_statfs_cache statfs_cache;
     char *mdc_xattr_str;
     gf_atomic_int32_t generation;
+    gf_boolean_t dir_leases;
+    gf_boolean_t dir_leases_unsupported;
+    char lease_id[LEASE_ID_SIZE];
 };
 
 struct mdc_local;
@@ -115,6 +120,11 @@ struct md_cache {
     char *linkname;
     time_t ia_time;
     time_t xa_time;
+    uint64_t lease_gen; /* directories: moves on with every recall of our
+                           lease on it */
+    time_t lease_time;  /* when the lease was granted */
+    gf_boolean_t dir_lease_pending;
+    gf_boolean_t dir_lease_held;
     gf_boolean_t need_lookup;
     gf_boolean_t valid;
     gf_boolean_t gen_rollover;
@@ -130,6 +140,7 @@ struct mdc_local {
     char *key;
     dict_t *xattr;
     uint64_t incident_time;
+    uint64_t lease_gen;
     bool update_cache;
 };
 
@@ -369,10 +380,11 @@ unlock:
 /* Cache is valid if:
  * - It is not cached before any brick was down. Brick down case is handled by
  *   invalidating all the cache when any brick went down.
- * - The cache time is not expired
+ * - The cache time is not expired, or it was cached after our lease on the
+ *   directory was granted at @lease_time, and the lease is still held
  */
 static gf_boolean_t
-__is_cache_valid(xlator_t *this, time_t mdc_time)
+__is_cache_valid(xlator_t *this, time_t mdc_time, time_t lease_time)
 {
     gf_boolean_t ret = _gf_true;
     struct mdc_conf *conf = NULL;
@@ -397,7 +409,10 @@ __is_cache_valid(xlator_t *this, time_t mdc_time)
     }
 
     if (gf_time() >= (mdc_time + timeout)) {
-        ret = _gf_false;
+        /* the bricks drop the leases of a disconnected client */
+        if (!conf->dir_leases || !timeout || !lease_time ||
+            (mdc_time <= lease_time) || (lease_time <= last_child_down))
+            ret = _gf_false;
     }
 
 out:
@@ -414,7 +429,8 @@ is_md_cache_iatt_valid(xlator_t *this, struct md_cache *mdc)
         if (mdc->valid == _gf_false) {
             ret = mdc->valid;
         } else {
-            ret = __is_cache_valid(this, mdc->ia_time);
+            ret = __is_cache_valid(this, mdc->ia_time,
+                                   mdc->dir_lease_held ? mdc->lease_time : 0);
             if (ret == _gf_false) {
                 mdc->ia_time = 0;
                 mdc->generation = 0;
@@ -433,7 +449,7 @@ is_md_cache_xatt_valid(xlator_t *this, struct md_cache *mdc)
 
     LOCK(&mdc->lock);
     {
-        ret = __is_cache_valid(this, mdc->xa_time);
+        ret = __is_cache_valid(this, mdc->xa_time, 0);
         if (ret == _gf_false)
             mdc->xa_time = 0;
     }
@@ -1202,6 +1218,211 @@ out:
     return 0;
 }
 
+/* Directory leases: while this client holds a lease on a directory, the
+ * cached attributes of the directory stay valid past md-cache-timeout,
+ * until the lease is recalled. The bricks recall it on entry fops in the
+ * directory and on setattr of the directory, from other clients. Only the
+ * attributes cached after the lease was granted are kept. Each recall
+ * moves mdc->lease_gen of the directory on, so that a grant that raced
+ * with it is not taken for a held lease.
+ */
+static int32_t
+mdc_dir_lease_unlock_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                         int32_t op_ret, int32_t op_errno,
+                         struct gf_lease *lease, dict_t *xdata)
+{
+    STACK_DESTROY(frame->root);
+    return 0;
+}
+
+static void
+mdc_dir_lease_release(xlator_t *this, inode_t *inode, uuid_t gfid)
+{
+    struct mdc_conf *conf = this->private;
+    call_frame_t *frame = NULL;
+    struct gf_lease lease = {
+        0,
+    };
+    loc_t loc = {
+        0,
+    };
+
+    frame = create_frame(this, this->ctx->pool);
+    if (!frame)
+        return;
+
+    lease.cmd = GF_UNLK_LEASE;
+    lease.lease_type = GF_DIR_LEASE;
+    memcpy(lease.lease_id, conf->lease_id, LEASE_ID_SIZE);
+
+    loc.inode = inode_ref(inode);
+    gf_uuid_copy(loc.gfid, gfid);
+
+    STACK_WIND(frame, mdc_dir_lease_unlock_cbk, FIRST_CHILD(this),
+               FIRST_CHILD(this)->fops->lease, &loc, &lease, NULL);
+
+    loc_wipe(&loc);
+}
+
+static int32_t
+mdc_dir_lease_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                  int32_t op_ret, int32_t op_errno, struct gf_lease *lease,
+                  dict_t *xdata)
+{
+    struct mdc_conf *conf = this->private;
+    mdc_local_t *local = frame->local;
+    struct md_cache *mdc = NULL;
+
+    frame->local = NULL;
+
+    if ((op_ret < 0) && ((op_errno == ENOSYS) || (op_errno == EOPNOTSUPP))) {
+        if (!conf->dir_leases_unsupported)
+            gf_msg(this->name, GF_LOG_INFO, op_errno, MD_CACHE_MSG_NO_DIR_LEASE,
+                   "directory leases are not enabled on the bricks, "
+                   "caching with md-cache-timeout only");
+        conf->dir_leases_unsupported = _gf_true;
+    }
+
+    if (mdc_inode_ctx_get(this, local->loc.inode, &mdc) != 0 || !mdc)
+        goto out;
+
+    LOCK(&mdc->lock);
+    {
+        /* A recall that raced with the grant has moved the generation on
+         * and already unlocked the lease, a new one may be pending. */
+        if (mdc->lease_gen == local->lease_gen) {
+            if (op_ret == 0) {
+                mdc->dir_lease_held = _gf_true;
+                mdc->lease_time = gf_time();
+                GF_ATOMIC_INC(conf->mdc_counter.lease_grants);
+            }
+            mdc->dir_lease_pending = _gf_false;
+        }
+    }
+    UNLOCK(&mdc->lock);
+out:
+    mdc_local_wipe(this, local);
+    STACK_DESTROY(frame->root);
+    return 0;
+}
+
+static void
+mdc_dir_lease_acquire(xlator_t *this, call_frame_t *frame, inode_t *inode,
+                      uuid_t gfid)
+{
+    struct mdc_conf *conf = this->private;
+    struct md_cache *mdc = NULL;
+    call_frame_t *lease_frame = NULL;
+    mdc_local_t *local = NULL;
+    uint64_t gen = 0;
+    gf_boolean_t wind = _gf_false;
+    struct gf_lease lease = {
+        0,
+    };
+
+    /* The leases translator does not serve internal clients */
+    if (!conf->dir_leases || conf->dir_leases_unsupported ||
+        (frame->root->pid < 0))
+        return;
+
+    mdc = mdc_inode_prep(this, inode);
+    if (!mdc)
+        return;
+
+    LOCK(&mdc->lock);
+    {
+        /* A lease granted before a child went down is gone on the brick */
+        if (mdc->dir_lease_held &&
+            (mdc->lease_time <= conf->last_child_down))
+            mdc->dir_lease_held = _gf_false;
+
+        if (!mdc->dir_lease_pending && !mdc->dir_lease_held) {
+            mdc->dir_lease_pending = _gf_true;
+            gen = mdc->lease_gen;
+            wind = _gf_true;
+        }
+    }
+    UNLOCK(&mdc->lock);
+
+    if (!wind)
+        return;
+
+    lease_frame = copy_frame(frame);
+    if (!lease_frame)
+        goto err;
+
+    local = mdc_local_get(lease_frame, inode);
+    if (!local) {
+        STACK_DESTROY(lease_frame->root);
+        goto err;
+    }
+
+    local->lease_gen = gen;
+    local->loc.inode = inode_ref(inode);
+    gf_uuid_copy(local->loc.gfid, gfid);
+
+    lease.cmd = GF_SET_LEASE;
+    lease.lease_type = GF_DIR_LEASE;
+    memcpy(lease.lease_id, conf->lease_id, LEASE_ID_SIZE);
+
+    STACK_WIND(lease_frame, mdc_dir_lease_cbk, FIRST_CHILD(this),
+               FIRST_CHILD(this)->fops->lease, &local->loc, &lease, NULL);
+    return;
+
+err:
+    LOCK(&mdc->lock);
+    {
+        if (mdc->lease_gen == gen)
+            mdc->dir_lease_pending = _gf_false;
+    }
+    UNLOCK(&mdc->lock);
+}
+
+static void
+mdc_dir_lease_recall(xlator_t *this, struct gf_upcall *up_data)
+{
+    struct mdc_conf *conf = this->private;
+    struct md_cache *mdc = NULL;
+    inode_table_t *itable = NULL;
+    inode_t *inode = NULL;
+
+    if (!conf->dir_leases || (up_data->event_type != GF_UPCALL_RECALL_LEASE))
+        return;
+
+    itable = ((xlator_t *)this->graph->top)->itable;
+    if (!itable)
+        return;
+
+    inode = inode_find(itable, up_data->gfid);
+    if (inode) {
+        /* file leases belong to the application */
+        if (!IA_ISDIR(inode->ia_type))
+            goto out;
+
+        if (mdc_inode_ctx_get(this, inode, &mdc) == 0 && mdc) {
+            LOCK(&mdc->lock);
+            {
+                mdc->lease_gen++;
+                mdc->dir_lease_held = _gf_false;
+                mdc->dir_lease_pending = _gf_false;
+            }
+            UNLOCK(&mdc->lock);
+        }
+
+        GF_ATOMIC_INC(conf->mdc_counter.lease_recalls);
+    } else {
+        /* The directory was forgotten while the lease was held, nothing
+         * is cached under it any more but the lease has to go. */
+        inode = inode_new(itable);
+        if (!inode)
+            return;
+    }
+
+    mdc_dir_lease_release(this, inode, up_data->gfid);
+out:
+    inode_unref(inode);
+}
+
 int
 mdc_lookup_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
                int32_t op_ret, int32_t op_errno, inode_t *inode,
@@ -1242,6 +1463,9 @@ mdc_lookup_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
         if (local->update_cache) {
             mdc_inode_xatt_set(this, local->loc.inode, dict);
         }
+        if (IA_ISDIR(stbuf->ia_type))
+            mdc_dir_lease_acquire(this, frame, local->loc.inode,
+                                  stbuf->ia_gfid);
     }
 out:
     MDC_STACK_UNWIND(lookup, frame, op_ret, op_errno, inode, stbuf, dict,
@@ -1301,6 +1525,8 @@ mdc_lookup(call_frame_t *frame, xlator_t *this, loc_t *loc, dict_t *xdata)
     }
 
     GF_ATOMIC_INC(conf->mdc_counter.stat_hit);
+    if (IA_ISDIR(loc->inode->ia_type))
+        mdc_dir_lease_acquire(this, frame, loc->inode, loc->inode->gfid);
     MDC_STACK_UNWIND(lookup, frame, 0, 0, loc->inode, &stbuf, xattr_rsp,
                      &postparent);
 
@@ -3107,6 +3333,53 @@ mdc_zerofill(call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
     return 0;
 }
 
+int
+mdc_copy_file_range_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                        int32_t op_ret, int32_t op_errno, struct iatt *stbuf,
+                        struct iatt *prebuf_dst, struct iatt *postbuf_dst,
+                        dict_t *xdata)
+{
+    mdc_local_t *local = NULL;
+
+    local = frame->local;
+    if (!local)
+        goto out;
+
+    if (op_ret < 0) {
+        if ((op_errno == ENOENT) || (op_errno == ESTALE))
+            mdc_inode_iatt_invalidate(this, local->fd->inode);
+        goto out;
+    }
+
+    mdc_inode_iatt_set_validate(this, local->fd->inode, prebuf_dst,
+                                postbuf_dst, _gf_true, local->incident_time);
+
+out:
+    MDC_STACK_UNWIND(copy_file_range, frame, op_ret, op_errno, stbuf,
+                     prebuf_dst, postbuf_dst, xdata);
+
+    return 0;
+}
+
+int
+mdc_copy_file_range(call_frame_t *frame, xlator_t *this, fd_t *fd_in,
+                    off64_t off_in, fd_t *fd_out, off64_t off_out, size_t len,
+                    uint32_t flags, dict_t *xdata)
+{
+    mdc_local_t *local;
+
+    local = mdc_local_get(frame, fd_out->inode);
+    if (local != NULL) {
+        local->fd = __fd_ref(fd_out);
+    }
+
+    STACK_WIND(frame, mdc_copy_file_range_cbk, FIRST_CHILD(this),
+               FIRST_CHILD(this)->fops->copy_file_range, fd_in, off_in, fd_out,
+               off_out, len, flags, xdata);
+
+    return 0;
+}
+
 int32_t
 mdc_readlink_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
                  int32_t op_ret, int32_t op_errno, const char *path,
@@ -3261,6 +3534,11 @@ mdc_priv_dump(xlator_t *this)
                        GF_ATOMIC_GET(conf->mdc_counter.stat_invals));
     gf_proc_dump_write("xattr_invalidations_received", "%" PRId64,
                        GF_ATOMIC_GET(conf->mdc_counter.xattr_invals));
+    gf_proc_dump_write("dir_leases", "%d", conf->dir_leases);
+    gf_proc_dump_write("dir_lease_grants_received", "%" PRId64,
+                       GF_ATOMIC_GET(conf->mdc_counter.lease_grants));
+    gf_proc_dump_write("dir_lease_recalls_received", "%" PRId64,
+                       GF_ATOMIC_GET(conf->mdc_counter.lease_recalls));
 
     return 0;
 }
@@ -3647,6 +3925,9 @@ mdc_reconfigure(xlator_t *this, dict_t *options)
 
     GF_OPTION_RECONF("md-cache-statfs", conf->cache_statfs, options, bool, out);
 
+    GF_OPTION_RECONF("dir-leases", conf->dir_leases, options, bool, out);
+    conf->dir_leases_unsupported = _gf_false;
+
     GF_OPTION_RECONF("xattr-cache-list", tmp_str, options, str, out);
 
     ret = mdc_xattr_list_populate(conf, tmp_str);
@@ -3722,6 +4003,9 @@ mdc_init(xlator_t *this)
     pthread_mutex_init(&conf->statfs_cache.lock, NULL);
     GF_OPTION_INIT("md-cache-statfs", conf->cache_statfs, bool, out);
 
+    GF_OPTION_INIT("dir-leases", conf->dir_leases, bool, out);
+    gf_uuid_generate((unsigned char *)conf->lease_id);
+
     GF_OPTION_INIT("xattr-cache-list", tmp_str, str, out);
     mdc_xattr_list_populate(conf, tmp_str);
 
@@ -3738,6 +4022,8 @@ mdc_init(xlator_t *this)
     GF_ATOMIC_INIT(conf->mdc_counter.stat_invals, 0);
     GF_ATOMIC_INIT(conf->mdc_counter.xattr_invals, 0);
     GF_ATOMIC_INIT(conf->mdc_counter.need_lookup, 0);
+    GF_ATOMIC_INIT(conf->mdc_counter.lease_grants, 0);
+    GF_ATOMIC_INIT(conf->mdc_counter.lease_recalls, 0);
     GF_ATOMIC_INIT(conf->generation, 0);
 
     /* If timeout is greater than 60s (default before the patch that added
@@ -3784,6 +4070,7 @@ mdc_notify(xlator_t *this, int event, void *data, ...)
             mdc_update_child_down_time(this, gf_time());
             break;
         case GF_EVENT_UPCALL:
+            mdc_dir_lease_recall(this, data);
             if (conf->mdc_invalidation)
                 ret = mdc_invalidate(this, data);
             break;
@@ -3839,6 +4126,7 @@ struct xlator_fops mdc_fops = {
     .fallocate = mdc_fallocate,
     .discard = mdc_discard,
     .zerofill = mdc_zerofill,
+    .copy_file_range = mdc_copy_file_range,
     .statfs = mdc_statfs,
     .readlink = mdc_readlink,
     .fsyncdir = mdc_fsyncdir,
@@ -3984,6 +4272,19 @@ struct volume_options mdc_options[] = {
         .flags = OPT_FLAG_SETTABLE | OPT_FLAG_CLIENT_OPT | OPT_FLAG_DOC,
         .description = "Cache statfs information of filesystem on the client",
     },
+    {
+        .key = {"dir-leases"},
+        .type = GF_OPTION_TYPE_BOOL,
+        .default_value = "off",
+        .op_version = {GD_OP_VERSION_10_0},
+        .flags = OPT_FLAG_SETTABLE | OPT_FLAG_CLIENT_OPT | OPT_FLAG_DOC,
+        .description = "Take a lease on every directory that is looked up, "
+                       "and keep the attributes of the directory cached "
+                       "beyond md-cache-timeout until the bricks recall the "
+                       "lease, on an entry being created, removed or renamed "
+                       "in it or on its attributes being set by another "
+                       "client. Needs features.leases on the volume.",
+    },
     {
         .key = {"xattr-cache-list"},
         .type = GF_OPTION_TYPE_STR,
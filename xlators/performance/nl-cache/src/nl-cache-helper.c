@@ -35,20 +35,23 @@
  *
  *   Data structures to store cache?
  *      The cache of any directory is stored in the inode_ctx of the directory.
- *      Negative entries are stored as list of strings.
- *             Search - O(n)
- *             Add    - O(1)
- *             Delete - O(n) - as it has to be searched before deleting
+ *      Negative entries are stored as list of strings, indexed by a hash of
+ *      the name and guarded by a counting bloom filter (nlc_name_index_t).
+ *             Search - O(1) - a miss is mostly answered by the filter alone
+ *             Add    - O(1) - amortized, the index doubles as it fills up
+ *             Delete - O(1)
  *      Positive entries are stored as a list, each list node has a pointer
  *          to the inode of the positive entry or the name of the entry.
  *          Since the client side inode table already will have inodes for
  *          positive entries, we just take a ref of that inode and store as
  *          positive entry cache. In cases like hardlinks and readdirp where
  *          inode is NULL, we store the names.
- *          Name Search - O(n)
+ *          Names are indexed the same way as negative entries, without the
+ *          filter.
+ *          Name Search - O(1)
  *          Inode Search - O(1) - Actually complexity of inode_find()
  *          Name/inode Add - O(1)
- *          Name Delete - O(n)
+ *          Name Delete - O(1)
  *          Inode Delete - O(1)
  *
  * Locking order:
@@ -201,6 +204,252 @@ nlc_inode_ctx_get(xlator_t *this, inode_t *inode, nlc_ctx_t **nlc_ctx_p)
     return;
 }
 
+/* FNV-1a over the case folded name, so that the same bucket serves both
+ * the exact and the case insensitive (get_real_filename) searches. */
+static uint32_t
+nlc_name_hash(const char *name)
+{
+    uint32_t hash = 2166136261U;
+    const unsigned char *p = (const unsigned char *)name;
+
+    while (*p) {
+        hash ^= (uint32_t)tolower(*p++);
+        hash *= 16777619U;
+    }
+
+    return hash;
+}
+
+static size_t
+nlc_index_mem_size(nlc_name_index_t *index, uint32_t nbuckets)
+{
+    size_t size = nbuckets * sizeof(struct list_head);
+
+    if (index->has_filter)
+        size += nbuckets * NLC_FILTER_SLOTS_PER_BUCKET;
+
+    return size;
+}
+
+/* Double hashing (Kirsch-Mitzenmacher): the k filter slots are derived from
+ * the single name hash, the second hash is forced odd so that it is coprime
+ * with the (power of 2) number of slots. */
+static void
+__nlc_index_filter_update(nlc_name_index_t *index, uint32_t hashval,
+                          int delta)
+{
+    uint32_t slots = index->nbuckets * NLC_FILTER_SLOTS_PER_BUCKET;
+    uint32_t h2 = ((hashval >> 17) | (hashval << 15)) | 1;
+    uint32_t slot = 0;
+    int i = 0;
+
+    if (!index->filter)
+        return;
+
+    for (i = 0; i < NLC_FILTER_HASHES; i++) {
+        slot = (hashval + i * h2) & (slots - 1);
+        /* A saturated counter can no longer be decremented safely, it
+         * sticks until the index is destroyed or resized. */
+        if (index->filter[slot] == UINT8_MAX)
+            continue;
+        if (delta > 0)
+            index->filter[slot]++;
+        else if (index->filter[slot] > 0)
+            index->filter[slot]--;
+    }
+}
+
+static gf_boolean_t
+__nlc_index_filter_test(nlc_name_index_t *index, uint32_t hashval)
+{
+    uint32_t slots = index->nbuckets * NLC_FILTER_SLOTS_PER_BUCKET;
+    uint32_t h2 = ((hashval >> 17) | (hashval << 15)) | 1;
+    int i = 0;
+
+    if (!index->filter)
+        return _gf_true;
+
+    for (i = 0; i < NLC_FILTER_HASHES; i++) {
+        if (index->filter[(hashval + i * h2) & (slots - 1)] == 0)
+            return _gf_false;
+    }
+
+    return _gf_true;
+}
+
+static int
+__nlc_index_resize(xlator_t *this, nlc_ctx_t *nlc_ctx, nlc_name_index_t *index,
+                   uint32_t nbuckets)
+{
+    nlc_conf_t *conf = NULL;
+    struct list_head *old_buckets = NULL;
+    uint8_t *old_filter = NULL;
+    uint32_t old_nbuckets = 0;
+    nlc_name_node_t *node = NULL;
+    nlc_name_node_t *tmp = NULL;
+    size_t old_size = 0;
+    size_t new_size = 0;
+    uint32_t i = 0;
+
+    conf = this->private;
+
+    old_buckets = index->buckets;
+    old_filter = index->filter;
+    old_nbuckets = index->nbuckets;
+
+    index->buckets = GF_MALLOC(nbuckets * sizeof(struct list_head),
+                               gf_nlc_mt_nlc_index_t);
+    if (!index->buckets)
+        goto err;
+
+    if (index->has_filter) {
+        index->filter = GF_CALLOC(nbuckets, NLC_FILTER_SLOTS_PER_BUCKET,
+                                  gf_nlc_mt_nlc_index_t);
+        if (!index->filter)
+            goto err;
+    }
+
+    for (i = 0; i < nbuckets; i++)
+        INIT_LIST_HEAD(&index->buckets[i]);
+    index->nbuckets = nbuckets;
+
+    for (i = 0; i < old_nbuckets; i++) {
+        list_for_each_entry_safe(node, tmp, &old_buckets[i], hash)
+        {
+            list_move(&node->hash,
+                      &index->buckets[node->hashval & (nbuckets - 1)]);
+            __nlc_index_filter_update(index, node->hashval, 1);
+        }
+    }
+
+    if (old_buckets)
+        old_size = nlc_index_mem_size(index, old_nbuckets);
+    new_size = nlc_index_mem_size(index, nbuckets);
+    nlc_ctx->cache_size += new_size - old_size;
+    GF_ATOMIC_ADD(conf->current_cache_size, new_size);
+    GF_ATOMIC_SUB(conf->current_cache_size, old_size);
+
+    GF_FREE(old_buckets);
+    GF_FREE(old_filter);
+
+    return 0;
+err:
+    GF_FREE(index->buckets);
+    index->buckets = old_buckets;
+    index->filter = old_filter;
+    index->nbuckets = old_nbuckets;
+    return -1;
+}
+
+static int
+__nlc_index_add(xlator_t *this, nlc_ctx_t *nlc_ctx, nlc_name_index_t *index,
+                nlc_name_node_t *node, const char *name)
+{
+    int ret = 0;
+
+    if (!index->buckets) {
+        ret = __nlc_index_resize(this, nlc_ctx, index, NLC_INDEX_MIN_BUCKETS);
+        if (ret < 0)
+            goto out;
+    } else if ((index->count >= index->nbuckets * NLC_INDEX_MAX_LOAD) &&
+               (index->nbuckets < NLC_INDEX_MAX_BUCKETS)) {
+        /* Failing to grow only makes the chains longer */
+        (void)__nlc_index_resize(this, nlc_ctx, index, index->nbuckets * 2);
+    }
+
+    node->hashval = nlc_name_hash(name);
+    list_add(&node->hash,
+             &index->buckets[node->hashval & (index->nbuckets - 1)]);
+    __nlc_index_filter_update(index, node->hashval, 1);
+    index->count++;
+out:
+    return ret;
+}
+
+static void
+__nlc_index_del(nlc_name_index_t *index, nlc_name_node_t *node)
+{
+    if (list_empty(&node->hash))
+        return;
+
+    list_del_init(&node->hash);
+    __nlc_index_filter_update(index, node->hashval, -1);
+    index->count--;
+}
+
+static void
+__nlc_index_destroy(xlator_t *this, nlc_ctx_t *nlc_ctx,
+                    nlc_name_index_t *index)
+{
+    nlc_conf_t *conf = NULL;
+    size_t size = 0;
+
+    conf = this->private;
+
+    if (!index->buckets)
+        return;
+
+    size = nlc_index_mem_size(index, index->nbuckets);
+    nlc_ctx->cache_size -= size;
+    GF_ATOMIC_SUB(conf->current_cache_size, size);
+
+    GF_FREE(index->buckets);
+    GF_FREE(index->filter);
+    index->buckets = NULL;
+    index->filter = NULL;
+    index->nbuckets = 0;
+    index->count = 0;
+}
+
+static nlc_ne_t *
+__nlc_lookup_ne(nlc_ctx_t *nlc_ctx, const char *name)
+{
+    nlc_name_index_t *index = &nlc_ctx->ne_index;
+    nlc_ne_t *ne = NULL;
+    uint32_t hashval = 0;
+
+    if (!index->buckets)
+        goto out;
+
+    hashval = nlc_name_hash(name);
+    if (!__nlc_index_filter_test(index, hashval))
+        goto out;
+
+    list_for_each_entry(ne, &index->buckets[hashval & (index->nbuckets - 1)],
+                        node.hash)
+    {
+        if ((ne->node.hashval == hashval) && (strcmp(ne->name, name) == 0))
+            return ne;
+    }
+out:
+    return NULL;
+}
+
+static nlc_pe_t *
+__nlc_lookup_pe(nlc_ctx_t *nlc_ctx, const char *name,
+                gf_boolean_t case_insensitive)
+{
+    nlc_name_index_t *index = &nlc_ctx->pe_index;
+    nlc_pe_t *pe = NULL;
+    uint32_t hashval = 0;
+
+    if (!index->buckets)
+        goto out;
+
+    hashval = nlc_name_hash(name);
+    list_for_each_entry(pe, &index->buckets[hashval & (index->nbuckets - 1)],
+                        node.hash)
+    {
+        if (pe->node.hashval != hashval)
+            continue;
+        if (case_insensitive ? (strcasecmp(pe->name, name) == 0)
+                             : (strcmp(pe->name, name) == 0))
+            return pe;
+    }
+out:
+    return NULL;
+}
+
 static void
 __nlc_inode_clear_entries(xlator_t *this, nlc_ctx_t *nlc_ctx)
 {
@@ -224,6 +473,9 @@ __nlc_inode_clear_entries(xlator_t *this, nlc_ctx_t *nlc_ctx)
             __nlc_free_ne(this, nlc_ctx, ne);
         }
 
+    __nlc_index_destroy(this, nlc_ctx, &nlc_ctx->pe_index);
+    __nlc_index_destroy(this, nlc_ctx, &nlc_ctx->ne_index);
+
     nlc_ctx->cache_time = 0;
     nlc_ctx->state = 0;
     GF_ASSERT(nlc_ctx->cache_size == sizeof(*nlc_ctx));
@@ -308,6 +560,7 @@ nlc_inode_ctx_get_set(xlator_t *this, inode_t *inode, nlc_ctx_t **nlc_ctx_p)
         LOCK_INIT(&nlc_ctx->lock);
         INIT_LIST_HEAD(&nlc_ctx->pe);
         INIT_LIST_HEAD(&nlc_ctx->ne);
+        nlc_ctx->ne_index.has_filter = _gf_true;
 
         ret = __nlc_inode_ctx_timer_start(this, inode, nlc_ctx);
         if (ret < 0)
@@ -657,6 +910,7 @@ __nlc_free_pe(xlator_t *this, nlc_ctx_t *nlc_ctx, nlc_pe_t *pe)
         inode_unref(pe->inode);
     }
     list_del(&pe->list);
+    __nlc_index_del(&nlc_ctx->pe_index, &pe->node);
 
     nlc_ctx->cache_size -= sizeof(*pe) + sizeof(pe->name);
     GF_ATOMIC_SUB(conf->current_cache_size, (sizeof(*pe) + sizeof(pe->name)));
@@ -679,6 +933,7 @@ __nlc_free_ne(xlator_t *this, nlc_ctx_t *nlc_ctx, nlc_ne_t *ne)
     conf = this->private;
 
     list_del(&ne->list);
+    __nlc_index_del(&nlc_ctx->ne_index, &ne->node);
     GF_FREE(ne->name);
     GF_FREE(ne);
 
@@ -717,7 +972,6 @@ __nlc_del_pe(xlator_t *this, nlc_ctx_t *nlc_ctx, inode_t *entry_ino,
              const char *name, gf_boolean_t multilink)
 {
     nlc_pe_t *pe = NULL;
-    nlc_pe_t *tmp = NULL;
     gf_boolean_t found = _gf_false;
     uint64_t pe_int = 0;
 
@@ -729,12 +983,10 @@ __nlc_del_pe(xlator_t *this, nlc_ctx_t *nlc_ctx, inode_t *entry_ino,
 
     /* If there are hardlinks first search names, followed by inodes */
     if (multilink) {
-        list_for_each_entry_safe(pe, tmp, &nlc_ctx->pe, list)
-        {
-            if (pe->name && (strcmp(pe->name, name) == 0)) {
-                found = _gf_true;
-                goto out;
-            }
+        pe = __nlc_lookup_pe(nlc_ctx, name, _gf_false);
+        if (pe) {
+            found = _gf_true;
+            goto out;
         }
         inode_ctx_reset1(entry_ino, this, &pe_int);
         if (pe_int) {
@@ -753,14 +1005,10 @@ __nlc_del_pe(xlator_t *this, nlc_ctx_t *nlc_ctx, inode_t *entry_ino,
     }
 
 name_search:
-    list_for_each_entry_safe(pe, tmp, &nlc_ctx->pe, list)
-    {
-        if (pe->name && (strcmp(pe->name, name) == 0)) {
-            found = _gf_true;
-            break;
-            /* TODO: can there be duplicates? */
-        }
-    }
+    /* TODO: can there be duplicates? */
+    pe = __nlc_lookup_pe(nlc_ctx, name, _gf_false);
+    if (pe)
+        found = _gf_true;
 
 out:
     if (found)
@@ -773,18 +1021,13 @@ static void
 __nlc_del_ne(xlator_t *this, nlc_ctx_t *nlc_ctx, const char *name)
 {
     nlc_ne_t *ne = NULL;
-    nlc_ne_t *tmp = NULL;
 
     if (!IS_NE_VALID(nlc_ctx->state))
         goto out;
 
-    list_for_each_entry_safe(ne, tmp, &nlc_ctx->ne, list)
-    {
-        if (strcmp(ne->name, name) == 0) {
-            __nlc_free_ne(this, nlc_ctx, ne);
-            break;
-        }
-    }
+    ne = __nlc_lookup_ne(nlc_ctx, name);
+    if (ne)
+        __nlc_free_ne(this, nlc_ctx, ne);
 out:
     return;
 }
@@ -802,13 +1045,14 @@ __nlc_add_pe(xlator_t *this, nlc_ctx_t *nlc_ctx, inode_t *entry_ino,
 
     /* TODO: There can be no duplicate entries, as it is added only
     during create. In case there arises duplicate entries, search PE
-    found = __nlc_search (entries, name, _gf_false);
-    can use bit vector to have simple search than sequential search */
+    found = __nlc_lookup_pe (nlc_ctx, name, _gf_false); */
 
     pe = GF_CALLOC(sizeof(*pe), 1, gf_nlc_mt_nlc_pe_t);
     if (!pe)
         goto out;
 
+    INIT_LIST_HEAD(&pe->node.hash);
+
     if (entry_ino) {
         pe->inode = inode_ref(entry_ino);
         nlc_inode_ctx_set(this, entry_ino, NULL, pe);
@@ -816,6 +1060,11 @@ __nlc_add_pe(xlator_t *this, nlc_ctx_t *nlc_ctx, inode_t *entry_ino,
         pe->name = gf_strdup(name);
         if (!pe->name)
             goto out;
+        if (__nlc_index_add(this, nlc_ctx, &nlc_ctx->pe_index, &pe->node,
+                            name) < 0) {
+            GF_FREE(pe->name);
+            goto out;
+        }
     }
 
     list_add(&pe->list, &nlc_ctx->pe);
@@ -846,17 +1095,24 @@ __nlc_add_ne(xlator_t *this, nlc_ctx_t *nlc_ctx, const char *name)
     conf = this->private;
 
     /* TODO: search ne before adding to get rid of duplicate entries
-    found = __nlc_search (entries, name, _gf_false);
-    can use bit vector to have faster search than sequential search */
+    found = __nlc_search_ne (nlc_ctx, name); */
 
     ne = GF_CALLOC(sizeof(*ne), 1, gf_nlc_mt_nlc_ne_t);
     if (!ne)
         goto out;
 
+    INIT_LIST_HEAD(&ne->node.hash);
+
     ne->name = gf_strdup(name);
     if (!ne->name)
         goto out;
 
+    if (__nlc_index_add(this, nlc_ctx, &nlc_ctx->ne_index, &ne->node, name) <
+        0) {
+        GF_FREE(ne->name);
+        goto out;
+    }
+
     list_add(&ne->list, &nlc_ctx->ne);
 
     nlc_ctx->cache_size += sizeof(*ne) + sizeof(ne->name);
@@ -962,19 +1218,12 @@ gf_boolean_t
 __nlc_search_ne(nlc_ctx_t *nlc_ctx, const char *name)
 {
     gf_boolean_t found = _gf_false;
-    nlc_ne_t *ne = NULL;
-    nlc_ne_t *tmp = NULL;
 
     if (!IS_NE_VALID(nlc_ctx->state))
         goto out;
 
-    list_for_each_entry_safe(ne, tmp, &nlc_ctx->ne, list)
-    {
-        if (strcmp(ne->name, name) == 0) {
-            found = _gf_true;
-            break;
-        }
-    }
+    if (__nlc_lookup_ne(nlc_ctx, name))
+        found = _gf_true;
 out:
     return found;
 }
@@ -983,19 +1232,12 @@ static gf_boolean_t
 __nlc_search_pe(nlc_ctx_t *nlc_ctx, const char *name)
 {
     gf_boolean_t found = _gf_false;
-    nlc_pe_t *pe = NULL;
-    nlc_pe_t *tmp = NULL;
 
     if (!IS_PE_VALID(nlc_ctx->state))
         goto out;
 
-    list_for_each_entry_safe(pe, tmp, &nlc_ctx->pe, list)
-    {
-        if (pe->name && (strcmp(pe->name, name) == 0)) {
-            found = _gf_true;
-            break;
-        }
-    }
+    if (__nlc_lookup_pe(nlc_ctx, name, _gf_false))
+        found = _gf_true;
 out:
     return found;
 }
@@ -1006,28 +1248,13 @@ __nlc_get_pe(nlc_ctx_t *nlc_ctx, const char *name,
 {
     char *found = NULL;
     nlc_pe_t *pe = NULL;
-    nlc_pe_t *tmp = NULL;
 
     if (!IS_PE_VALID(nlc_ctx->state))
         goto out;
 
-    if (case_insensitive) {
-        list_for_each_entry_safe(pe, tmp, &nlc_ctx->pe, list)
-        {
-            if (pe->name && (strcasecmp(pe->name, name) == 0)) {
-                found = pe->name;
-                break;
-            }
-        }
-    } else {
-        list_for_each_entry_safe(pe, tmp, &nlc_ctx->pe, list)
-        {
-            if (pe->name && (strcmp(pe->name, name) == 0)) {
-                found = pe->name;
-                break;
-            }
-        }
-    }
+    pe = __nlc_lookup_pe(nlc_ctx, name, case_insensitive);
+    if (pe)
+        found = pe->name;
 out:
     return found;
 }
@@ -1176,6 +1403,10 @@ nlc_dump_inodectx(xlator_t *this, inode_t *inode)
         gf_proc_dump_write("cache-time", "%ld", nlc_ctx->cache_time);
         gf_proc_dump_write("cache-size", "%zu", nlc_ctx->cache_size);
         gf_proc_dump_write("refd-inodes", "%" PRIu64, nlc_ctx->refd_inodes);
+        gf_proc_dump_write("pe-index", "%" PRIu32 " names, %" PRIu32 " buckets",
+                           nlc_ctx->pe_index.count, nlc_ctx->pe_index.nbuckets);
+        gf_proc_dump_write("ne-index", "%" PRIu32 " names, %" PRIu32 " buckets",
+                           nlc_ctx->ne_index.count, nlc_ctx->ne_index.nbuckets);
 
         if (IS_PE_VALID(nlc_ctx->state))
             list_for_each_entry_safe(pe, tmp, &nlc_ctx->pe, list)
@@ -27,6 +27,19 @@
     ((state != NLC_INVALID) && (state & (NLC_PE_FULL | NLC_PE_PARTIAL)))
 #define IS_NE_VALID(state) ((state != NLC_INVALID) && (state & NLC_NE_VALID))
 
+/* Name index of the positive/negative entries of a directory. The index
+ * starts with NLC_INDEX_MIN_BUCKETS buckets on the first entry and doubles
+ * whenever the average chain length crosses NLC_INDEX_MAX_LOAD, up to
+ * NLC_INDEX_MAX_BUCKETS. The negative entry index additionally keeps a
+ * counting bloom filter of NLC_FILTER_SLOTS_PER_BUCKET counters per bucket,
+ * so that most lookups of names that were never cached are rejected
+ * without walking a chain. All of it is accounted against nl-cache-limit. */
+#define NLC_INDEX_MIN_BUCKETS 8
+#define NLC_INDEX_MAX_BUCKETS 8192
+#define NLC_INDEX_MAX_LOAD 4
+#define NLC_FILTER_SLOTS_PER_BUCKET 16
+#define NLC_FILTER_HASHES 3
+
 #define IS_PEC_ENABLED(conf) (conf->positive_entry_cache)
 #define IS_CACHE_ENABLED(conf) ((!conf->cache_disabled))
 
@@ -48,14 +61,31 @@ enum nlc_cache_clear_reason {
     NLC_LRU_PRUNE,
 };
 
+struct nlc_name_node {
+    struct list_head hash; /* link in the bucket of nlc_name_index */
+    uint32_t hashval;
+};
+typedef struct nlc_name_node nlc_name_node_t;
+
+struct nlc_name_index {
+    struct list_head *buckets;
+    uint8_t *filter; /* counting bloom filter, NULL if !has_filter */
+    uint32_t nbuckets;
+    uint32_t count;
+    gf_boolean_t has_filter;
+};
+typedef struct nlc_name_index nlc_name_index_t;
+
 struct nlc_ne {
     struct list_head list;
+    nlc_name_node_t node;
     char *name;
 };
 typedef struct nlc_ne nlc_ne_t;
 
 struct nlc_pe {
     struct list_head list;
+    nlc_name_node_t node; /* indexed only if name != NULL */
     inode_t *inode;
     char *name;
 };
@@ -76,6 +106,8 @@ typedef struct nlc_lru_node nlc_lru_node_t;
 struct nlc_ctx {
     struct list_head pe; /* list of positive entries */
     struct list_head ne; /* list of negative entries */
+    nlc_name_index_t pe_index;
+    nlc_name_index_t ne_index;
     uint64_t state;
     time_t cache_time;
     struct gf_tw_timer_list *timer;
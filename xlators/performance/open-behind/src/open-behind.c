@@ -26,6 +26,15 @@
  *       that it's not a read, causes the open request to be sent to the
  *       bricks, and all future operations will be executed synchronously,
  *       including opens (it's reset once all fd's are closed).
+ *
+ *       When quick-read doesn't have the content cached, the first read of a
+ *       small file can still be served without opening it: if it starts at
+ *       offset 0 and it's not bigger than whole-file-read-size, the read is
+ *       sent on an anonymous fd asking for whole-file-read-size bytes. The
+ *       brick then opens, reads and closes the file in a single request. If
+ *       the answer is shorter than requested, the whole file has been read
+ *       and the remaining reads on the same fd are served from that data
+ *       while the open is still pending.
  */
 
 typedef struct ob_conf {
@@ -42,8 +51,20 @@ typedef struct ob_conf {
                                            first and then send readv i.e
                                            similar to what writev does
                                         */
+    uint64_t whole_read_size;      /* read files up to this size entirely
+                                      on an anonymous fd on the first read */
 } ob_conf_t;
 
+/* Time (in seconds) the content of a file read entirely on an anonymous fd
+ * can be used to serve further reads on the fd whose open is pending. */
+#define OB_WHOLE_READ_TIMEOUT 1
+
+typedef struct ob_read_local {
+    fd_t *fd;
+    size_t size;
+    uint64_t limit;
+} ob_read_local_t;
+
 /* A negative state represents an errno value negated. In this case the
  * current operation cannot be processed. */
 typedef enum _ob_state {
@@ -93,6 +114,18 @@ typedef struct ob_inode {
     /* This flag is set as soon as we know that the open will be
      * sent to the bricks, even before the stub is ready. */
     bool triggered;
+
+    /* Whole content of the file read on an anonymous fd on behalf of
+     * whole_fd while its open was pending. It's only used by whole_fd,
+     * and it's dropped as soon as the open is triggered or the fd is
+     * closed. whole_fd doesn't hold a reference. */
+    fd_t *whole_fd;
+    struct iovec *whole_vec;
+    struct iobref *whole_iobref;
+    struct iatt whole_stbuf;
+    time_t whole_time;
+    size_t whole_size;
+    int32_t whole_count;
 } ob_inode_t;
 
 /* Dummy pointer used temporarily while the actual open stub is being created */
@@ -194,6 +227,29 @@ ob_inode_get_locked(xlator_t *this, inode_t *inode)
     return ob_inode;
 }
 
+static void
+__ob_whole_read_detach(ob_inode_t *ob_inode, struct iovec **pvec,
+                       struct iobref **piobref)
+{
+    *pvec = ob_inode->whole_vec;
+    *piobref = ob_inode->whole_iobref;
+
+    ob_inode->whole_fd = NULL;
+    ob_inode->whole_vec = NULL;
+    ob_inode->whole_iobref = NULL;
+    ob_inode->whole_size = 0;
+    ob_inode->whole_count = 0;
+}
+
+static void
+ob_whole_read_release(struct iovec *vec, struct iobref *iobref)
+{
+    if (iobref != NULL) {
+        iobref_unref(iobref);
+    }
+    GF_FREE(vec);
+}
+
 static ob_state_t
 ob_open_and_resume_inode(xlator_t *xl, inode_t *inode, fd_t *fd,
                          int32_t open_count, bool synchronous, bool trigger,
@@ -202,6 +258,8 @@ ob_open_and_resume_inode(xlator_t *xl, inode_t *inode, fd_t *fd,
     ob_conf_t *conf;
     ob_inode_t *ob_inode;
     call_stub_t *open_stub;
+    struct iovec *whole_vec;
+    struct iobref *whole_iobref;
 
     if (inode == NULL) {
         return OB_STATE_READY;
@@ -246,8 +304,14 @@ ob_open_and_resume_inode(xlator_t *xl, inode_t *inode, fd_t *fd,
             ob_inode->first_open = NULL;
             ob_inode->triggered = true;
 
+            /* Once the file is really opened, cached content can't be
+             * trusted anymore. */
+            __ob_whole_read_detach(ob_inode, &whole_vec, &whole_iobref);
+
             UNLOCK(&inode->lock);
 
+            ob_whole_read_release(whole_vec, whole_iobref);
+
             if ((open_stub != NULL) && (open_stub != OB_OPEN_PREPARING)) {
                 call_resume(open_stub);
             }
@@ -391,6 +455,8 @@ ob_open_completed(xlator_t *xl, ob_inode_t *ob_inode, fd_t *fd, int32_t op_ret,
                   int32_t op_errno)
 {
     struct list_head list;
+    struct iovec *whole_vec = NULL;
+    struct iobref *whole_iobref = NULL;
 
     INIT_LIST_HEAD(&list);
 
@@ -407,10 +473,13 @@ ob_open_completed(xlator_t *xl, ob_inode_t *ob_inode, fd_t *fd, int32_t op_ret,
             ob_inode->first_fd = NULL;
             ob_inode->first_open = NULL;
             ob_inode->triggered = false;
+            __ob_whole_read_detach(ob_inode, &whole_vec, &whole_iobref);
         }
     }
     UNLOCK(&ob_inode->inode->lock);
 
+    ob_whole_read_release(whole_vec, whole_iobref);
+
     ob_resume_pending(&list);
 
     fd_unref(fd);
@@ -566,6 +635,175 @@ ob_create(call_frame_t *frame, xlator_t *this, loc_t *loc, int flags,
     return default_create_failure_cbk(frame, -state);
 }
 
+static int32_t
+ob_whole_read_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                  int32_t op_ret, int32_t op_errno, struct iovec *vector,
+                  int32_t count, struct iatt *stbuf, struct iobref *iobref,
+                  dict_t *xdata)
+{
+    ob_read_local_t *local;
+    ob_inode_t *ob_inode;
+    fd_t *fd;
+    struct iovec *whole_vec = NULL;
+    struct iovec *vec = NULL;
+
+    local = frame->local;
+    frame->local = NULL;
+    fd = local->fd;
+
+    if (op_ret < 0) {
+        goto unwind;
+    }
+
+    /* A short read means that we have got the whole file. */
+    if (op_ret < local->limit) {
+        whole_vec = iov_dup(vector, count);
+    }
+    if (whole_vec != NULL) {
+        LOCK(&fd->inode->lock);
+        {
+            ob_inode = ob_inode_get_locked(this, fd->inode);
+            if ((ob_inode != NULL) && (ob_inode->first_fd == fd) &&
+                !ob_inode->triggered && (ob_inode->whole_fd == NULL)) {
+                ob_inode->whole_fd = fd;
+                ob_inode->whole_vec = whole_vec;
+                ob_inode->whole_iobref = iobref_ref(iobref);
+                ob_inode->whole_stbuf = *stbuf;
+                ob_inode->whole_time = gf_time();
+                ob_inode->whole_size = op_ret;
+                ob_inode->whole_count = count;
+                whole_vec = NULL;
+            }
+        }
+        UNLOCK(&fd->inode->lock);
+
+        GF_FREE(whole_vec);
+    }
+
+    /* Only return what the caller asked for. */
+    if (op_ret > local->size) {
+        count = iov_subset(vector, count, 0, local->size, &vec, 0);
+        if (count < 0) {
+            op_ret = -1;
+            op_errno = ENOMEM;
+            goto unwind;
+        }
+        vector = vec;
+        op_ret = local->size;
+    }
+
+unwind:
+    STACK_UNWIND_STRICT(readv, frame, op_ret, op_errno, vector, count, stbuf,
+                        iobref, xdata);
+
+    GF_FREE(vec);
+    fd_unref(fd);
+    GF_FREE(local);
+
+    return 0;
+}
+
+/* Serves a read on an fd whose open is still pending, either from the
+ * content already read by a previous call, or by reading the whole file
+ * on an anonymous fd. Returns false if the read needs to be processed as
+ * usual. */
+static bool
+ob_whole_read(call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
+              off_t offset, uint32_t flags, dict_t *xdata)
+{
+    ob_conf_t *conf = this->private;
+    ob_inode_t *ob_inode;
+    ob_read_local_t *local;
+    fd_t *anon_fd;
+    struct iovec *whole_vec = NULL;
+    struct iobref *whole_iobref = NULL;
+    struct iovec *vec = NULL;
+    struct iobref *iobref = NULL;
+    struct iatt stbuf;
+    uint64_t err;
+    int32_t count = 0;
+    bool pending = false;
+    bool cached = false;
+
+    if ((fd_ctx_get(fd, this, &err) == 0) && (err != 0)) {
+        return false;
+    }
+
+    LOCK(&fd->inode->lock);
+    {
+        ob_inode = ob_inode_get_locked(this, fd->inode);
+        if ((ob_inode == NULL) || (ob_inode->first_fd != fd) ||
+            ob_inode->triggered) {
+            goto unlock;
+        }
+        pending = true;
+
+        if (ob_inode->whole_fd != fd) {
+            goto unlock;
+        }
+
+        if (gf_time() - ob_inode->whole_time >= OB_WHOLE_READ_TIMEOUT) {
+            __ob_whole_read_detach(ob_inode, &whole_vec, &whole_iobref);
+            goto unlock;
+        }
+
+        cached = true;
+        stbuf = ob_inode->whole_stbuf;
+        iobref = iobref_ref(ob_inode->whole_iobref);
+        if (offset < ob_inode->whole_size) {
+            count = iov_subset(ob_inode->whole_vec, ob_inode->whole_count,
+                               offset,
+                               min(size, ob_inode->whole_size - offset), &vec,
+                               0);
+        }
+    }
+unlock:
+    UNLOCK(&fd->inode->lock);
+
+    ob_whole_read_release(whole_vec, whole_iobref);
+
+    if (cached) {
+        if (count < 0) {
+            default_readv_failure_cbk(frame, ENOMEM);
+        } else {
+            STACK_UNWIND_STRICT(readv, frame, iov_length(vec, count), 0, vec,
+                                count, &stbuf, iobref, NULL);
+        }
+        GF_FREE(vec);
+        iobref_unref(iobref);
+
+        return true;
+    }
+
+    if (!pending || (offset != 0) || (size > conf->whole_read_size)) {
+        return false;
+    }
+
+    local = GF_MALLOC(sizeof(*local), gf_ob_mt_local_t);
+    if (local == NULL) {
+        return false;
+    }
+
+    anon_fd = fd_anonymous_with_flags(fd->inode, fd->flags);
+    if (anon_fd == NULL) {
+        GF_FREE(local);
+        return false;
+    }
+
+    local->fd = fd_ref(fd);
+    local->size = size;
+    local->limit = conf->whole_read_size;
+    frame->local = local;
+
+    STACK_WIND(frame, ob_whole_read_cbk, FIRST_CHILD(this),
+               FIRST_CHILD(this)->fops->readv, anon_fd, local->limit, 0, flags,
+               xdata);
+
+    fd_unref(anon_fd);
+
+    return true;
+}
+
 static int32_t
 ob_readv(call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
          off_t offset, uint32_t flags, dict_t *xdata)
@@ -573,6 +811,12 @@ ob_readv(call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
     ob_conf_t *conf = this->private;
     bool trigger = conf->read_after_open || !conf->use_anonymous_fd;
 
+    /* the whole read goes on an anonymous fd, only when readvs may */
+    if ((conf->whole_read_size != 0) && !trigger &&
+        ob_whole_read(frame, this, fd, size, offset, flags, xdata)) {
+        return 0;
+    }
+
     OB_POST_FD(readv, this, frame, fd, trigger, fd, size, offset, flags, xdata);
 
     return 0;
@@ -788,6 +1032,8 @@ ob_fdclose(xlator_t *this, fd_t *fd)
     struct list_head list;
     ob_inode_t *ob_inode;
     call_stub_t *stub;
+    struct iovec *whole_vec = NULL;
+    struct iobref *whole_iobref = NULL;
 
     INIT_LIST_HEAD(&list);
     stub = NULL;
@@ -801,6 +1047,10 @@ ob_fdclose(xlator_t *this, fd_t *fd)
             /* If this fd is the same as ob_inode->first_fd, it means that
              * the initial open has not fully completed. We'll try to cancel
              * it. */
+            if (ob_inode->whole_fd == fd) {
+                __ob_whole_read_detach(ob_inode, &whole_vec, &whole_iobref);
+            }
+
             if (ob_inode->first_fd == fd) {
                 if (ob_inode->first_open == OB_OPEN_PREPARING) {
                     /* In this case ob_open_dispatch() has not been called yet.
@@ -833,6 +1083,8 @@ ob_fdclose(xlator_t *this, fd_t *fd)
     }
     UNLOCK(&fd->inode->lock);
 
+    ob_whole_read_release(whole_vec, whole_iobref);
+
     if (stub != NULL) {
         ob_open_destroy(stub, fd);
     }
@@ -848,6 +1100,7 @@ ob_forget(xlator_t *this, inode_t *inode)
 
     if ((inode_ctx_del(inode, this, &value) == 0) && (value != 0)) {
         ob_inode = (ob_inode_t *)(uintptr_t)value;
+        ob_whole_read_release(ob_inode->whole_vec, ob_inode->whole_iobref);
         GF_FREE(ob_inode);
     }
 
@@ -874,6 +1127,9 @@ ob_priv_dump(xlator_t *this)
 
     gf_proc_dump_write("lazy_open", "%d", conf->lazy_open);
 
+    gf_proc_dump_write("whole_file_read_size", "%" PRIu64,
+                       conf->whole_read_size);
+
     return 0;
 }
 
@@ -937,6 +1193,9 @@ reconfigure(xlator_t *this, dict_t *options)
     GF_OPTION_RECONF("read-after-open", conf->read_after_open, options, bool,
                      out);
 
+    GF_OPTION_RECONF("whole-file-read-size", conf->whole_read_size, options,
+                     size_uint64, out);
+
     GF_OPTION_RECONF("pass-through", this->pass_through, options, bool, out);
     ret = 0;
 out:
@@ -971,6 +1230,9 @@ init(xlator_t *this)
 
     GF_OPTION_INIT("read-after-open", conf->read_after_open, bool, err);
 
+    GF_OPTION_INIT("whole-file-read-size", conf->whole_read_size, size_uint64,
+                   err);
+
     GF_OPTION_INIT("pass-through", this->pass_through, bool, err);
 
     this->private = conf;
@@ -1075,6 +1337,25 @@ struct volume_options options[] = {
         .tags = {},
         /* option_validation_fn validate_fn; */
     },
+    {
+        .key = {"whole-file-read-size"},
+        .type = GF_OPTION_TYPE_SIZET,
+        .min = 0,
+        .max = 1 * GF_UNIT_MB,
+        .default_value = "0",
+        .description = "If the first read on a file not yet opened in the "
+                       "backend starts at offset 0 and is not bigger than "
+                       "this value, read up to this many bytes on an "
+                       "anonymous fd without opening the file. Files "
+                       "smaller than this value are then read, opened and "
+                       "closed with a single request to the bricks. Only "
+                       "used when reads may go on anonymous fds, i.e. "
+                       "with use-anonymous-fd on and read-after-open "
+                       "off. 0 disables it.",
+        .op_version = {GD_OP_VERSION_10_0},
+        .flags = OPT_FLAG_SETTABLE | OPT_FLAG_CLIENT_OPT,
+        .tags = {"open-behind"},
+    },
     {.key = {"pass-through"},
      .type = GF_OPTION_TYPE_BOOL,
      .default_value = "false",
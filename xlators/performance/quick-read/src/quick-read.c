@@ -670,8 +670,11 @@ qr_readdirp_cbk(call_frame_t *frame, void *cookie, xlator_t *this, int op_ret,
     gf_dirent_t *entry = NULL;
     qr_inode_t *qr_inode = NULL;
     qr_local_t *local = NULL;
+    qr_private_t *priv = NULL;
+    void *content = NULL;
 
     local = frame->local;
+    priv = this->private;
 
     if (op_ret <= 0)
         goto unwind;
@@ -681,6 +684,26 @@ qr_readdirp_cbk(call_frame_t *frame, void *cookie, xlator_t *this, int op_ret,
         if (!entry->inode)
             continue;
 
+        /* readdir-ahead can ask the bricks for the content of small files
+         * along with the entries (rda-content-prefetch-size), cache it
+         * just like the content that comes with a lookup. */
+        content = NULL;
+        if (entry->dict && IA_ISREG(entry->d_stat.ia_type) &&
+            qr_size_fits(&priv->conf, &entry->d_stat))
+            content = qr_content_extract(entry->dict);
+
+        if (content) {
+            qr_inode = qr_inode_ctx_get_or_new(this, entry->inode);
+            if (!qr_inode) {
+                GF_FREE(content);
+                continue;
+            }
+
+            qr_content_update(this, qr_inode, content, &entry->d_stat,
+                              local->incident_gen);
+            continue;
+        }
+
         qr_inode = qr_inode_ctx_get(this, entry->inode);
         if (!qr_inode)
             /* no harm */
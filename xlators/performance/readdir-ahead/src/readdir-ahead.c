@@ -21,6 +21,14 @@
  * The translator is currently designed to handle the simple, sequential case
  * only. If a non-sequential directory read occurs, readdir-ahead disables
  * preloads on the directory.
+ *
+ * With rda-content-prefetch-size set, the internal readdirp requests also ask
+ * the bricks for the content of regular files up to that size. The content
+ * rides along in the dirent dict and is cached by quick-read (and the stat by
+ * md-cache) when the entries are served, so that a opendir/readdir/stat/read
+ * of every entry costs no round trip per entry. The content is accounted in
+ * the preload buffer and hence is bounded by the same watermarks and
+ * rda-cache-limit.
  */
 
 #include <math.h>
@@ -34,6 +42,74 @@
 static int
 rda_fill_fd(call_frame_t *, xlator_t *, fd_t *);
 
+/*
+ * Build the xdata sent with the internal readdirp requests out of the keys
+ * requested by the layers above (md-cache). The caller's dict is not modified
+ * as it is shared with the application's request.
+ */
+static dict_t *
+rda_prefetch_xattrs(xlator_t *this, dict_t *xdata)
+{
+    struct rda_priv *priv = this->private;
+    dict_t *xattrs = NULL;
+    int ret = 0;
+
+    if (!priv->rda_content_size)
+        return xdata ? dict_ref(xdata) : NULL;
+
+    xattrs = xdata ? dict_copy_with_ref(xdata, NULL) : dict_new();
+    if (!xattrs)
+        return NULL;
+
+    ret = dict_set_uint64(xattrs, GF_CONTENT_KEY, priv->rda_content_size);
+    if (ret < 0)
+        gf_msg_debug(this->name, -ret, "failed to request content of small "
+                     "files in readdirp");
+
+    return xattrs;
+}
+
+/*
+ * Memory consumed by a preloaded entry, including any file content fetched
+ * along with it.
+ */
+static size_t
+rda_dirent_size(gf_dirent_t *dirent)
+{
+    size_t size = gf_dirent_size(dirent->d_name);
+    data_t *data = NULL;
+
+    if (dirent->dict) {
+        data = dict_get_sizen(dirent->dict, GF_CONTENT_KEY);
+        if (data)
+            size += data->len;
+    }
+
+    return size;
+}
+
+/*
+ * Content fetched during the preload is only good as long as the file did
+ * not change since. Drop it if the latest known stat differs from the one it
+ * was read with.
+ */
+static void
+rda_dirent_drop_stale_content(gf_dirent_t *dirent, struct iatt *fetched,
+                              struct iatt *latest)
+{
+    if (!dirent->dict)
+        return;
+
+    if ((latest->ia_ctime == fetched->ia_ctime) &&
+        (latest->ia_ctime_nsec == fetched->ia_ctime_nsec) &&
+        (latest->ia_mtime == fetched->ia_mtime) &&
+        (latest->ia_mtime_nsec == fetched->ia_mtime_nsec) &&
+        (latest->ia_size == fetched->ia_size))
+        return;
+
+    dict_del_sizen(dirent->dict, GF_CONTENT_KEY);
+}
+
 static void
 rda_local_wipe(struct rda_local *local)
 {
@@ -308,6 +384,7 @@ __rda_fill_readdirp(xlator_t *this, gf_dirent_t *entries, size_t request_size,
 {
     gf_dirent_t *dirent, *tmp;
     size_t dirent_size, size = 0;
+    size_t cache_size = 0;
     int32_t count = 0;
     struct rda_priv *priv = NULL;
     struct iatt tmp_stat = {
@@ -322,19 +399,22 @@ __rda_fill_readdirp(xlator_t *this, gf_dirent_t *entries, size_t request_size,
         if (size + dirent_size > request_size)
             break;
 
+        cache_size = rda_dirent_size(dirent);
+
         memset(&tmp_stat, 0, sizeof(tmp_stat));
 
         if (dirent->inode && (!((strcmp(dirent->d_name, ".") == 0) ||
                                 (strcmp(dirent->d_name, "..") == 0)))) {
             rda_inode_ctx_get_iatt(dirent->inode, this, &tmp_stat);
+            rda_dirent_drop_stale_content(dirent, &dirent->d_stat, &tmp_stat);
             dirent->d_stat = tmp_stat;
         }
 
         size += dirent_size;
         list_del_init(&dirent->list);
-        ctx->cur_size -= dirent_size;
+        ctx->cur_size -= cache_size;
 
-        GF_ATOMIC_SUB(priv->rda_cache_size, dirent_size);
+        GF_ATOMIC_SUB(priv->rda_cache_size, cache_size);
 
         list_add_tail(&dirent->list, &entries->list);
         ctx->cur_offset = dirent->d_off;
@@ -415,7 +495,7 @@ rda_readdirp(call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
          * call and use that for all subsequent internal readdirp()
          * requests issued by this xlator.
          */
-        ctx->xattrs = dict_ref(xdata);
+        ctx->xattrs = rda_prefetch_xattrs(this, xdata);
         fill = 1;
     }
 
@@ -451,7 +531,7 @@ rda_readdirp(call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
         if (!(ctx->state & RDA_FD_RUNNING)) {
             fill = 1;
             if (!ctx->xattrs)
-                ctx->xattrs = dict_ref(xdata);
+                ctx->xattrs = rda_prefetch_xattrs(this, xdata);
             ctx->state |= RDA_FD_RUNNING;
         }
     }
@@ -499,6 +579,9 @@ rda_fill_fd_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
     };
     uint64_t generation = 0;
     call_frame_t *fill_frame = NULL;
+    struct iatt fetched_stat = {
+        0,
+    };
 
     INIT_LIST_HEAD(&serve_entries.list);
     LOCK(&ctx->lock);
@@ -538,13 +621,16 @@ rda_fill_fd_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
 
                 if (!((strcmp(dirent->d_name, ".") == 0) ||
                       (strcmp(dirent->d_name, "..") == 0))) {
+                    fetched_stat = dirent->d_stat;
                     rda_inode_ctx_update_iatts(dirent->inode, this,
                                                &dirent->d_stat, &dirent->d_stat,
                                                generation);
+                    rda_dirent_drop_stale_content(dirent, &fetched_stat,
+                                                  &dirent->d_stat);
                 }
             }
 
-            dirent_size = gf_dirent_size(dirent->d_name);
+            dirent_size = rda_dirent_size(dirent);
 
             ctx->cur_size += dirent_size;
 
@@ -685,7 +771,7 @@ rda_fill_fd(call_frame_t *frame, xlator_t *this, fd_t *fd)
 
         if (!ctx->xattrs && orig_local && orig_local->xattrs) {
             /* when this function is invoked by rda_opendir_cbk */
-            ctx->xattrs = dict_ref(orig_local->xattrs);
+            ctx->xattrs = rda_prefetch_xattrs(this, orig_local->xattrs);
         }
     } else {
         nframe = ctx->fill_frame;
@@ -1205,6 +1291,8 @@ reconfigure(xlator_t *this, dict_t *options)
                      size_uint64, err);
     GF_OPTION_RECONF("rda-cache-limit", priv->rda_cache_limit, options,
                      size_uint64, err);
+    GF_OPTION_RECONF("rda-content-prefetch-size", priv->rda_content_size,
+                     options, size_uint64, err);
     GF_OPTION_RECONF("parallel-readdir", priv->parallel_readdir, options, bool,
                      err);
     GF_OPTION_RECONF("pass-through", this->pass_through, options, bool, err);
@@ -1250,6 +1338,8 @@ init(xlator_t *this)
     GF_OPTION_INIT("rda-low-wmark", priv->rda_low_wmark, size_uint64, err);
     GF_OPTION_INIT("rda-high-wmark", priv->rda_high_wmark, size_uint64, err);
     GF_OPTION_INIT("rda-cache-limit", priv->rda_cache_limit, size_uint64, err);
+    GF_OPTION_INIT("rda-content-prefetch-size", priv->rda_content_size,
+                   size_uint64, err);
     GF_OPTION_INIT("parallel-readdir", priv->parallel_readdir, bool, err);
     GF_OPTION_INIT("pass-through", this->pass_through, bool, err);
 
@@ -1348,6 +1438,20 @@ struct volume_options options[] = {
                        "value, irrespective of the number/size of "
                        "directories cached",
     },
+    {
+        .key = {"rda-content-prefetch-size"},
+        .type = GF_OPTION_TYPE_SIZET,
+        .min = 0,
+        .max = 1 * GF_UNIT_MB,
+        .default_value = "0",
+        .op_version = {GD_OP_VERSION_10_0},
+        .flags = OPT_FLAG_SETTABLE | OPT_FLAG_CLIENT_OPT | OPT_FLAG_DOC,
+        .tags = {"readdir-ahead"},
+        .description = "fetch the content of regular files up to this size "
+                       "along with the directory entries preloaded by "
+                       "readdir-ahead, to be cached by quick-read. "
+                       "0 disables content prefetch",
+    },
     {.key = {"parallel-readdir"},
      .type = GF_OPTION_TYPE_BOOL,
      .op_version = {GD_OP_VERSION_3_10_0},
@@ -26,6 +26,10 @@
 #define WB_AGGREGATE_SIZE 131072 /* 128 KB */
 #define WB_WINDOW_SIZE 1048576   /* 1MB */
 
+/* Number of consecutive writes at the end of the file needed to consider
+ * that an inode is being written as an append stream. */
+#define WB_APPEND_STREAM_WRITES 4
+
 typedef struct list_head list_head_t;
 struct wb_conf;
 struct wb_inode;
@@ -124,6 +128,14 @@ typedef struct wb_inode {
     gf_atomic_int32_t readdirps;
     gf_atomic_int8_t invalidate;
 
+    off_t append_next;    /* offset expected for the next write
+                             if the inode is being appended to */
+    int append_writes;    /* consecutive writes at end of file, up
+                             to WB_APPEND_STREAM_WRITES */
+    off_t prealloc_end;   /* end of the range already preallocated
+                             with fallocate(KEEP_SIZE) hints */
+    int prealloc_failed;  /* backend doesn't support the hints */
+
 } wb_inode_t;
 
 typedef struct wb_request {
@@ -147,6 +159,10 @@ typedef struct wb_request {
                            STACK_WIND to server and therefore the
                            amount by which we shrink the window.
                         */
+    size_t capacity;    /* size of the buffer allocated when
+                           collapsing small writes. Valid only if
+                           @iobref is set.
+                        */
 
     int op_ret;
     int op_errno;
@@ -156,6 +172,8 @@ typedef struct wb_request {
     glusterfs_fop_t fop;
     gf_lkowner_t lk_owner;
     pid_t client_pid;
+    uid_t client_uid; /* for the preallocation sent on its behalf */
+    gid_t client_gid;
     struct iobref *iobref;
     uint64_t gen; /* inode liability state at the time of
                      request arrival */
@@ -190,6 +208,8 @@ typedef struct wb_conf {
     gf_boolean_t strict_write_ordering;
     gf_boolean_t strict_O_DIRECT;
     gf_boolean_t resync_after_fsync;
+    uint64_t append_stream_size;
+    uint64_t append_prealloc_size;
 } wb_conf_t;
 
 wb_inode_t *
@@ -506,6 +526,49 @@ out:
     return req;
 }
 
+static void
+__wb_track_append_stream(wb_inode_t *wb_inode, off_t offset, size_t size)
+{
+    wb_conf_t *conf = wb_inode->this->private;
+
+    if (!conf->append_stream_size && !conf->append_prealloc_size)
+        return;
+
+    /* a write at the current end of file which continues the previous
+       one extends the stream. Anything else breaks it.
+    */
+    if ((offset == wb_inode->size) && (offset == wb_inode->append_next)) {
+        if (wb_inode->append_writes < WB_APPEND_STREAM_WRITES)
+            wb_inode->append_writes++;
+    } else {
+        wb_inode->append_writes = 0;
+    }
+
+    wb_inode->append_next = offset + size;
+}
+
+static gf_boolean_t
+__wb_is_append_stream(wb_inode_t *wb_inode)
+{
+    return (wb_inode->append_writes >= WB_APPEND_STREAM_WRITES);
+}
+
+/* Size up to which writes of an append stream are aggregated before
+   sending them. It's never bigger than the window so that the
+   application is not blocked waiting for a write which will never
+   be sent.
+*/
+static ssize_t
+__wb_append_stream_size(wb_inode_t *wb_inode)
+{
+    wb_conf_t *conf = wb_inode->this->private;
+
+    if (!conf->append_stream_size || !__wb_is_append_stream(wb_inode))
+        return 0;
+
+    return min((ssize_t)conf->append_stream_size, wb_inode->window_conf);
+}
+
 gf_boolean_t
 wb_enqueue_common(wb_inode_t *wb_inode, call_stub_t *stub, int tempted)
 {
@@ -561,11 +624,16 @@ wb_enqueue_common(wb_inode_t *wb_inode, call_stub_t *stub, int tempted)
 
     req->lk_owner = stub->frame->root->lk_owner;
     req->client_pid = stub->frame->root->pid;
+    req->client_uid = stub->frame->root->uid;
+    req->client_gid = stub->frame->root->gid;
 
     switch (stub->fop) {
         case GF_FOP_WRITE:
             LOCK(&wb_inode->lock);
             {
+                __wb_track_append_stream(wb_inode, stub->args.offset,
+                                         req->write_size);
+
                 if (wb_inode->size < stub->args.offset) {
                     req->ordering.off = wb_inode->size;
                     req->ordering.size = stub->args.offset + req->write_size -
@@ -1112,6 +1180,169 @@ wb_fulfill_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
     return 0;
 }
 
+int
+wb_append_prealloc_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                       int32_t op_ret, int32_t op_errno, struct iatt *prebuf,
+                       struct iatt *postbuf, dict_t *xdata)
+{
+    wb_inode_t *wb_inode = NULL;
+    fd_t *fd = cookie;
+
+    /* these are only hints, errors are ignored. But there's no point in
+       sending more of them if they are not supported.
+    */
+    if ((op_ret < 0) && ((op_errno == EOPNOTSUPP) || (op_errno == ENOTSUP) ||
+                         (op_errno == ENOSYS))) {
+        wb_inode = wb_inode_ctx_get(this, fd->inode);
+        if (wb_inode) {
+            LOCK(&wb_inode->lock);
+            {
+                wb_inode->prealloc_failed = 1;
+            }
+            UNLOCK(&wb_inode->lock);
+        }
+    }
+
+    fd_unref(fd);
+    STACK_DESTROY(frame->root);
+
+    return 0;
+}
+
+/* check if the range ahead of a write of an append stream ending at
+   @end needs to be preallocated, and return it in @offset and @len.
+*/
+static gf_boolean_t
+__wb_append_prealloc_range(wb_inode_t *wb_inode, off_t end, off_t *offset,
+                           size_t *len)
+{
+    wb_conf_t *conf = wb_inode->this->private;
+    off_t target = 0;
+
+    if (!conf->append_prealloc_size || wb_inode->prealloc_failed ||
+        !__wb_is_append_stream(wb_inode))
+        return _gf_false;
+
+    /* keep at least half of the preallocated range ahead of the writes */
+    if (end + (off_t)(conf->append_prealloc_size / 2) <= wb_inode->prealloc_end)
+        return _gf_false;
+
+    target = end + conf->append_prealloc_size;
+
+    *offset = max(end, wb_inode->prealloc_end);
+    *len = target - *offset;
+
+    wb_inode->prealloc_end = target;
+
+    return _gf_true;
+}
+
+void
+wb_append_prealloc(wb_inode_t *wb_inode, wb_request_t *head, off_t offset,
+                   size_t len)
+{
+    call_frame_t *frame = NULL;
+    fd_t *fd = NULL;
+
+    frame = create_frame(wb_inode->this, wb_inode->this->ctx->pool);
+    if (!frame)
+        return;
+
+    frame->root->lk_owner = head->lk_owner;
+    frame->root->pid = head->client_pid;
+    frame->root->uid = head->client_uid;
+    frame->root->gid = head->client_gid;
+
+    fd = fd_ref(head->fd);
+
+    STACK_WIND_COOKIE(frame, wb_append_prealloc_cbk, fd,
+                      FIRST_CHILD(frame->this),
+                      FIRST_CHILD(frame->this)->fops->fallocate, fd,
+                      FALLOC_FL_KEEP_SIZE, offset, len, NULL);
+}
+
+/* a truncate frees the blocks preallocated past the end of file */
+void
+wb_append_prealloc_reset(wb_inode_t *wb_inode)
+{
+    LOCK(&wb_inode->lock);
+    {
+        wb_inode->prealloc_end = 0;
+    }
+    UNLOCK(&wb_inode->lock);
+}
+
+int
+wb_append_prealloc_trim_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                            int32_t op_ret, int32_t op_errno,
+                            struct iatt *prebuf, struct iatt *postbuf,
+                            dict_t *xdata)
+{
+    fd_t *fd = cookie;
+
+    fd_unref(fd);
+    STACK_DESTROY(frame->root);
+
+    return 0;
+}
+
+/* Give back what is still preallocated past the end of file when the
+   last fd of the inode is flushed. The bricks do nothing if the file has
+   been written to since @size was taken.
+*/
+void
+wb_append_prealloc_trim(call_frame_t *frame, xlator_t *this, fd_t *fd)
+{
+    wb_inode_t *wb_inode = NULL;
+    call_frame_t *trim_frame = NULL;
+    dict_t *xdata = NULL;
+    gf_boolean_t trim = _gf_false;
+    gf_boolean_t last = _gf_false;
+    off_t size = 0;
+
+    wb_inode = wb_inode_ctx_get(this, fd->inode);
+    if (!wb_inode)
+        return;
+
+    LOCK(&fd->inode->lock);
+    {
+        last = (fd->inode->fd_count <= 1);
+    }
+    UNLOCK(&fd->inode->lock);
+
+    LOCK(&wb_inode->lock);
+    {
+        if (last && !wb_inode->prealloc_failed &&
+            (wb_inode->prealloc_end > wb_inode->size)) {
+            trim = _gf_true;
+            size = wb_inode->size;
+            wb_inode->prealloc_end = 0;
+        }
+    }
+    UNLOCK(&wb_inode->lock);
+
+    if (!trim)
+        return;
+
+    xdata = dict_new();
+    if (!xdata || dict_set_int32_sizen(xdata, GLUSTERFS_TRIM_PREALLOC, 1))
+        goto out;
+
+    /* with the credentials of the fop it is sent from */
+    trim_frame = copy_frame(frame);
+    if (!trim_frame)
+        goto out;
+
+    fd = fd_ref(fd);
+
+    STACK_WIND_COOKIE(trim_frame, wb_append_prealloc_trim_cbk, fd,
+                      FIRST_CHILD(this), FIRST_CHILD(this)->fops->ftruncate,
+                      fd, size, xdata);
+out:
+    if (xdata)
+        dict_unref(xdata);
+}
+
 #define WB_IOV_LOAD(vec, cnt, req, head)                                       \
     do {                                                                       \
         memcpy(&vec[cnt], req->stub->args.vector,                              \
@@ -1127,6 +1358,9 @@ wb_fulfill_head(wb_inode_t *wb_inode, wb_request_t *head)
     int count = 0;
     wb_request_t *req = NULL;
     call_frame_t *frame = NULL;
+    gf_boolean_t prealloc = _gf_false;
+    off_t prealloc_offset = 0;
+    size_t prealloc_len = 0;
 
     /* make sure head->total_size is updated before we run into any
      * errors
@@ -1153,9 +1387,19 @@ wb_fulfill_head(wb_inode_t *wb_inode, wb_request_t *head)
     LOCK(&wb_inode->lock);
     {
         wb_inode->transit += head->total_size;
+
+        prealloc = __wb_append_prealloc_range(
+            wb_inode, head->stub->args.offset + head->total_size,
+            &prealloc_offset, &prealloc_len);
     }
     UNLOCK(&wb_inode->lock);
 
+    /* tell the backend that the file is going to grow, so that it can
+       allocate bigger extents before the writes arrive.
+    */
+    if (prealloc)
+        wb_append_prealloc(wb_inode, head, prealloc_offset, prealloc_len);
+
     STACK_WIND(frame, wb_fulfill_cbk, FIRST_CHILD(frame->this),
                FIRST_CHILD(frame->this)->fops->writev, head->fd, vector, count,
                head->stub->args.offset, head->stub->args.flags,
@@ -1307,7 +1551,7 @@ __wb_pick_unwinds(wb_inode_t *wb_inode, list_head_t *lies)
 }
 
 int
-__wb_collapse_small_writes(wb_conf_t *conf, wb_request_t *holder,
+__wb_collapse_small_writes(ssize_t page_size, wb_request_t *holder,
                            wb_request_t *req)
 {
     char *ptr = NULL;
@@ -1323,7 +1567,7 @@ __wb_collapse_small_writes(wb_conf_t *conf, wb_request_t *holder,
                                 holder->stub->args.count);
         req_len = iov_length(req->stub->args.vector, req->stub->args.count);
 
-        required_size = max((conf->page_size), (holder_len + req_len));
+        required_size = max(page_size, (ssize_t)(holder_len + req_len));
         iobuf = iobuf_get2(req->wb_inode->this->ctx->iobuf_pool, required_size);
         if (iobuf == NULL) {
             goto out;
@@ -1356,6 +1600,7 @@ __wb_collapse_small_writes(wb_conf_t *conf, wb_request_t *holder,
         iobuf_unref(iobuf);
 
         holder->iobref = iobref_ref(iobref);
+        holder->capacity = required_size;
     }
 
     ptr = holder->stub->args.vector[0].iov_base + holder->write_size;
@@ -1382,6 +1627,8 @@ __wb_preprocess_winds(wb_inode_t *wb_inode)
     wb_conf_t *conf = NULL;
     int ret = 0;
     ssize_t page_size = 0;
+    ssize_t stream_size = 0;
+    ssize_t held = 0;
     char gfid[64] = {
         0,
     };
@@ -1398,6 +1645,16 @@ __wb_preprocess_winds(wb_inode_t *wb_inode)
     conf = wb_inode->this->private;
     page_size = conf->page_size;
 
+    /* Writes of an append stream are collapsed into bigger buffers, and
+       full buffers are held back until stream_size bytes are ready to
+       be sent.
+    */
+    stream_size = __wb_append_stream_size(wb_inode);
+    if (stream_size > page_size)
+        page_size = stream_size;
+    else
+        stream_size = 0;
+
     list_for_each_entry_safe(req, tmp, &wb_inode->todo, todo)
     {
         if (wb_inode->dontsync && req->ordering.lied) {
@@ -1456,15 +1713,19 @@ __wb_preprocess_winds(wb_inode_t *wb_inode)
             continue;
         }
 
-        space_left = page_size - holder->write_size;
+        if (holder->iobref)
+            space_left = holder->capacity - holder->write_size;
+        else
+            space_left = page_size - holder->write_size;
 
         if (space_left < req->write_size) {
-            holder->ordering.go = 1;
+            if (!stream_size)
+                holder->ordering.go = 1;
             holder = req;
             continue;
         }
 
-        ret = __wb_collapse_small_writes(conf, holder, req);
+        ret = __wb_collapse_small_writes(page_size, holder, req);
         if (ret)
             continue;
 
@@ -1488,9 +1749,35 @@ __wb_preprocess_winds(wb_inode_t *wb_inode)
        writes if there are no outstanding requests
     */
 
-    if (conf->trickling_writes && !wb_inode->transit && holder)
+    if (conf->trickling_writes && !wb_inode->transit && holder &&
+        !stream_size)
         holder->ordering.go = 1;
 
+    if (stream_size) {
+        /* the writes still held back are contiguous. Release them
+           all once there's enough data.
+        */
+        list_for_each_entry(req, &wb_inode->todo, todo)
+        {
+            if (wb_inode->dontsync && req->ordering.lied)
+                continue;
+
+            if (req->ordering.tempted && !req->ordering.go)
+                held += req->write_size;
+        }
+
+        if (held >= stream_size) {
+            list_for_each_entry(req, &wb_inode->todo, todo)
+            {
+                if (wb_inode->dontsync && req->ordering.lied)
+                    continue;
+
+                if (req->ordering.tempted)
+                    req->ordering.go = 1;
+            }
+        }
+    }
+
     if (wb_inode->dontsync > 0)
         wb_inode->dontsync--;
 
@@ -1799,6 +2086,10 @@ wb_set_inode_size(wb_inode_t *wb_inode, struct iatt *postbuf)
 
     LOCK(&wb_inode->lock);
     {
+        /* shrunk with none of our writes pending: truncated by someone
+           else, which freed what was preallocated past the end */
+        if ((postbuf->ia_size < wb_inode->size) && list_empty(&wb_inode->all))
+            wb_inode->prealloc_end = 0;
         wb_inode->size = postbuf->ia_size;
     }
     UNLOCK(&wb_inode->lock);
@@ -1978,6 +2269,9 @@ wb_flush_helper(call_frame_t *frame, xlator_t *this, fd_t *fd, dict_t *xdata)
         goto unwind;
     }
 
+    /* the writes of the fd are done, and so is the stream */
+    wb_append_prealloc_trim(frame, this, fd);
+
     if (conf->flush_behind)
         goto flushbehind;
 
@@ -2173,8 +2467,10 @@ wb_truncate_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
 {
     GF_ASSERT(frame->local);
 
-    if (op_ret == 0)
+    if (op_ret == 0) {
         wb_set_inode_size(frame->local, postbuf);
+        wb_append_prealloc_reset(frame->local);
+    }
 
     frame->local = NULL;
 
@@ -2232,8 +2528,10 @@ wb_ftruncate_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
 {
     GF_ASSERT(frame->local);
 
-    if (op_ret == 0)
+    if (op_ret == 0) {
         wb_set_inode_size(frame->local, postbuf);
+        wb_append_prealloc_reset(frame->local);
+    }
 
     frame->local = NULL;
 
@@ -2779,6 +3077,99 @@ noqueue:
     return 0;
 }
 
+int32_t
+wb_copy_file_range_helper(call_frame_t *frame, xlator_t *this, fd_t *fd_in,
+                          off64_t off_in, fd_t *fd_out, off64_t off_out,
+                          size_t len, uint32_t flags, dict_t *xdata)
+{
+    STACK_WIND_TAIL(frame, FIRST_CHILD(this),
+                    FIRST_CHILD(this)->fops->copy_file_range, fd_in, off_in,
+                    fd_out, off_out, len, flags, xdata);
+    return 0;
+}
+
+/* Called once the writes cached for the source are out, so that the bricks
+ * copy what the application wrote. The copy is then ordered after the
+ * writes cached for the destination, as any other modifying fop. */
+int32_t
+wb_copy_file_range_dst(call_frame_t *frame, xlator_t *this, fd_t *fd_in,
+                       off64_t off_in, fd_t *fd_out, off64_t off_out,
+                       size_t len, uint32_t flags, dict_t *xdata)
+{
+    wb_inode_t *wb_inode = NULL;
+    call_stub_t *stub = NULL;
+
+    wb_inode = wb_inode_ctx_get(this, fd_out->inode);
+    if (!wb_inode)
+        goto noqueue;
+
+    stub = fop_copy_file_range_stub(frame, wb_copy_file_range_helper, fd_in,
+                                    off_in, fd_out, off_out, len, flags, xdata);
+    if (!stub)
+        goto unwind;
+
+    if (!wb_enqueue(wb_inode, stub))
+        goto unwind;
+
+    wb_process_queue(wb_inode);
+
+    return 0;
+
+unwind:
+    STACK_UNWIND_STRICT(copy_file_range, frame, -1, ENOMEM, NULL, NULL, NULL,
+                        NULL);
+
+    if (stub)
+        call_stub_destroy(stub);
+    return 0;
+
+noqueue:
+    STACK_WIND_TAIL(frame, FIRST_CHILD(this),
+                    FIRST_CHILD(this)->fops->copy_file_range, fd_in, off_in,
+                    fd_out, off_out, len, flags, xdata);
+    return 0;
+}
+
+int32_t
+wb_copy_file_range(call_frame_t *frame, xlator_t *this, fd_t *fd_in,
+                   off64_t off_in, fd_t *fd_out, off64_t off_out, size_t len,
+                   uint32_t flags, dict_t *xdata)
+{
+    wb_inode_t *wb_inode = NULL;
+    call_stub_t *stub = NULL;
+
+    if (fd_in->inode == fd_out->inode)
+        goto dst;
+
+    wb_inode = wb_inode_ctx_get(this, fd_in->inode);
+    if (!wb_inode)
+        goto dst;
+
+    stub = fop_copy_file_range_stub(frame, wb_copy_file_range_dst, fd_in,
+                                    off_in, fd_out, off_out, len, flags, xdata);
+    if (!stub)
+        goto unwind;
+
+    if (!wb_enqueue(wb_inode, stub))
+        goto unwind;
+
+    wb_process_queue(wb_inode);
+
+    return 0;
+
+unwind:
+    STACK_UNWIND_STRICT(copy_file_range, frame, -1, ENOMEM, NULL, NULL, NULL,
+                        NULL);
+
+    if (stub)
+        call_stub_destroy(stub);
+    return 0;
+
+dst:
+    return wb_copy_file_range_dst(frame, this, fd_in, off_in, fd_out, off_out,
+                                  len, flags, xdata);
+}
+
 int32_t
 wb_rename(call_frame_t *frame, xlator_t *this, loc_t *oldloc, loc_t *newloc,
           dict_t *xdata)
@@ -2867,6 +3258,10 @@ wb_priv_dump(xlator_t *this)
     gf_proc_dump_write("window_size", "%" PRIu64, conf->window_size);
     gf_proc_dump_write("flush_behind", "%d", conf->flush_behind);
     gf_proc_dump_write("trickling_writes", "%d", conf->trickling_writes);
+    gf_proc_dump_write("append_stream_size", "%" PRIu64,
+                       conf->append_stream_size);
+    gf_proc_dump_write("append_prealloc_size", "%" PRIu64,
+                       conf->append_prealloc_size);
 
     ret = 0;
 out:
@@ -2985,6 +3380,12 @@ wb_inode_dump(xlator_t *this, inode_t *inode)
 
     gf_proc_dump_write("dontsync", "%d", wb_inode->dontsync);
 
+    gf_proc_dump_write("append_stream", "%d",
+                       wb_inode->append_writes >= WB_APPEND_STREAM_WRITES);
+
+    gf_proc_dump_write("prealloc_end", "%" PRId64,
+                       (int64_t)wb_inode->prealloc_end);
+
     ret = TRY_LOCK(&wb_inode->lock);
     if (!ret) {
         if (!list_empty(&wb_inode->all)) {
@@ -3049,6 +3450,12 @@ reconfigure(xlator_t *this, dict_t *options)
     GF_OPTION_RECONF("resync-failed-syncs-after-fsync",
                      conf->resync_after_fsync, options, bool, out);
 
+    GF_OPTION_RECONF("append-stream-size", conf->append_stream_size, options,
+                     size_uint64, out);
+
+    GF_OPTION_RECONF("append-prealloc-size", conf->append_prealloc_size,
+                     options, size_uint64, out);
+
     GF_OPTION_RECONF("pass-through", pass_through, options, bool, out);
     if (pass_through != this->pass_through) {
         gf_msg(this->name, GF_LOG_WARNING, ENOTSUP,
@@ -3124,6 +3531,12 @@ init(xlator_t *this)
     GF_OPTION_INIT("resync-failed-syncs-after-fsync", conf->resync_after_fsync,
                    bool, out);
 
+    GF_OPTION_INIT("append-stream-size", conf->append_stream_size, size_uint64,
+                   out);
+
+    GF_OPTION_INIT("append-prealloc-size", conf->append_prealloc_size,
+                   size_uint64, out);
+
     GF_OPTION_INIT("pass-through", this->pass_through, bool, out);
 
     this->private = conf;
@@ -3172,6 +3585,7 @@ struct xlator_fops fops = {
     .fallocate = wb_fallocate,
     .discard = wb_discard,
     .zerofill = wb_zerofill,
+    .copy_file_range = wb_copy_file_range,
     .rename = wb_rename,
 };
 
@@ -3280,6 +3694,37 @@ struct volume_options options[] = {
                        " so that writes are aggregated till a max of "
                        "\"aggregate-size\" bytes",
     },
+    {
+        .key = {"append-stream-size"},
+        .type = GF_OPTION_TYPE_SIZET,
+        .min = 0,
+        .max = 64 * GF_UNIT_MB,
+        .default_value = "0",
+        .op_version = {GD_OP_VERSION_10_0},
+        .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC | OPT_FLAG_CLIENT_OPT,
+        .tags = {"write-behind"},
+        .description = "When a file is being written sequentially at its "
+                       "end (logs, backups), aggregate its writes up to "
+                       "this size (limited by the write-behind window) "
+                       "before sending them, regardless of "
+                       "\"aggregate-size\" and trickling-writes. 0 "
+                       "disables it.",
+    },
+    {
+        .key = {"append-prealloc-size"},
+        .type = GF_OPTION_TYPE_SIZET,
+        .min = 0,
+        .max = 1 * GF_UNIT_GB,
+        .default_value = "0",
+        .op_version = {GD_OP_VERSION_10_0},
+        .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC | OPT_FLAG_CLIENT_OPT,
+        .tags = {"write-behind"},
+        .description = "When a file is being written sequentially at its "
+                       "end, keep this many bytes ahead of the writes "
+                       "preallocated with fallocate(FALLOC_FL_KEEP_SIZE) "
+                       "to reduce fragmentation on the bricks. 0 disables "
+                       "it.",
+    },
     {.key = {NULL}},
 };
 
@@ -860,6 +860,8 @@ client_setvolume_cbk(struct rpc_req *req, struct iovec *iov, int count,
     conf->connected = 1;
 
     client_post_handshake(frame, frame->this);
+
+    client_lanes_start(this);
 out:
     if (auth_fail) {
         gf_smsg(this->name, GF_LOG_INFO, 0, PC_MSG_AUTH_FAILED, NULL);
@@ -1073,6 +1075,104 @@ fail:
     return ret;
 }
 
+static int
+client_lane_setvolume_cbk(struct rpc_req *req, struct iovec *iov, int count,
+                          void *myframe)
+{
+    call_frame_t *frame = myframe;
+    xlator_t *this = frame->this;
+    clnt_conf_t *conf = this->private;
+    clnt_lane_t *lane = frame->cookie;
+    gf_setvolume_rsp rsp = {
+        0,
+    };
+    int32_t op_ret = -1;
+    int32_t op_errno = ENOTCONN;
+    gf_boolean_t ready = _gf_false;
+
+    if (-1 == req->rpc_status)
+        goto out;
+
+    if (xdr_to_generic(*iov, &rsp, (xdrproc_t)xdr_gf_setvolume_rsp) < 0) {
+        op_errno = EINVAL;
+        goto out;
+    }
+
+    op_ret = rsp.op_ret;
+    op_errno = gf_error_to_errno(rsp.op_errno);
+
+out:
+    pthread_mutex_lock(&conf->lock);
+    {
+        lane->joining = 0;
+        /* The main connection may have gone away (and come back with a new
+         * identity) while this SETVOLUME was in flight. */
+        if (op_ret >= 0 && conf->connected && lane->connected &&
+            lane->setvol_count == conf->setvol_count)
+            lane->ready = ready = _gf_true;
+    }
+    pthread_mutex_unlock(&conf->lock);
+
+    if (ready) {
+        gf_smsg(this->name, GF_LOG_INFO, 0, PC_MSG_LANE_CONNECTED,
+                "conn-name=%s", lane->rpc->conn.name, NULL);
+    } else {
+        if (op_ret < 0)
+            gf_smsg(this->name, GF_LOG_WARNING, op_errno,
+                    PC_MSG_LANE_SETVOLUME_FAIL, "conn-name=%s",
+                    lane->rpc->conn.name, NULL);
+        rpc_transport_disconnect(lane->rpc->conn.trans, _gf_false);
+    }
+
+    free(rsp.dict.dict_val);
+    STACK_DESTROY(frame->root);
+    return 0;
+}
+
+/* Attach an additional connection to the client_t the main connection is
+ * bound to on the brick. this->options still carries everything the main
+ * connection's SETVOLUME sent, including its process-uuid. */
+int
+client_lane_setvolume(xlator_t *this, clnt_lane_t *lane)
+{
+    int ret = -1;
+    gf_setvolume_req req = {
+        {
+            0,
+        },
+    };
+    call_frame_t *fr = NULL;
+    clnt_conf_t *conf = this->private;
+
+    ret = dict_allocate_and_serialize(this->options,
+                                      (char **)&req.dict.dict_val,
+                                      &req.dict.dict_len);
+    if (ret != 0) {
+        ret = -1;
+        gf_smsg(this->name, GF_LOG_ERROR, 0, PC_MSG_DICT_SERIALIZE_FAIL, NULL);
+        goto out;
+    }
+
+    fr = create_frame(this, this->ctx->pool);
+    if (!fr) {
+        ret = -1;
+        goto out;
+    }
+    fr->cookie = lane;
+
+    /* RPC_TRANSPORT_CONNECT resets the auth flavour of the lane */
+    lane->rpc->auth_value = conf->rpc->auth_value;
+
+    ret = client_submit_request_rpc(
+        this, lane->rpc, &req, fr, conf->handshake, GF_HNDSK_SETVOLUME,
+        client_lane_setvolume_cbk, NULL, (xdrproc_t)xdr_gf_setvolume_req);
+
+out:
+    GF_FREE(req.dict.dict_val);
+
+    return ret;
+}
+
 static int
 select_server_supported_programs(xlator_t *this, gf_prog_detail *prog)
 {
@@ -1214,6 +1314,7 @@ client_query_portmap_cbk(struct rpc_req *req, struct iovec *iov, int count,
     conf->disconnect_err_logged = 0;
     config.remote_port = rsp.port;
     rpc_clnt_reconfig(conf->rpc, &config);
+    conf->brick_port = rsp.port;
 
     conf->skip_notify = 1;
     conf->quick_reconnect = 1;
@@ -169,10 +169,57 @@ client_notify_dispatch(xlator_t *this, int32_t event, void *data, ...)
     return ret;
 }
 
+/* Pick the connection a request goes out on. Only fops are striped over
+ * the lanes; lock fops always use the main connection so that a lock and
+ * its unlock (and the lock heal on reconnect) can not overtake each other. */
+static struct rpc_clnt *
+client_pick_rpc(clnt_conf_t *conf, rpc_clnt_prog_t *prog, int procnum)
+{
+    clnt_lane_t *lane = NULL;
+    uint64_t idx = 0;
+
+    if (!conf->lane_count || prog != conf->fops)
+        return conf->rpc;
+
+    switch (procnum) {
+        case GFS3_OP_LK:
+        case GFS3_OP_INODELK:
+        case GFS3_OP_FINODELK:
+        case GFS3_OP_ENTRYLK:
+        case GFS3_OP_FENTRYLK:
+        case GFS3_OP_LEASE:
+            return conf->rpc;
+        default:
+            break;
+    }
+
+    idx = GF_ATOMIC_INC(conf->lane_next) % conf->connection_count;
+    if (idx == 0)
+        return conf->rpc;
+
+    lane = &conf->lanes[idx - 1];
+    if (!lane->ready)
+        return conf->rpc;
+
+    return lane->rpc;
+}
+
 int
 client_submit_request(xlator_t *this, void *req, call_frame_t *frame,
                       rpc_clnt_prog_t *prog, int procnum, fop_cbk_fn_t cbkfn,
                       client_payload_t *cp, xdrproc_t xdrproc)
+{
+    return client_submit_request_rpc(this, NULL, req, frame, prog, procnum,
+                                     cbkfn, cp, xdrproc);
+}
+
+/* Same as client_submit_request(), on the given connection. A NULL @rpc
+ * lets the request be striped over conf->rpc and the lanes. */
+int
+client_submit_request_rpc(xlator_t *this, struct rpc_clnt *rpc, void *req,
+                          call_frame_t *frame, rpc_clnt_prog_t *prog,
+                          int procnum, fop_cbk_fn_t cbkfn, client_payload_t *cp,
+                          xdrproc_t xdrproc)
 {
     int ret = -1;
     clnt_conf_t *conf = NULL;
@@ -258,16 +305,18 @@ client_submit_request(xlator_t *this, void *req, call_frame_t *frame,
         frame->root->ngrps = 1;
     }
 
+    if (!rpc)
+        rpc = client_pick_rpc(conf, prog, procnum);
+
     /* Send the msg */
     if (cp) {
-        ret = rpc_clnt_submit(conf->rpc, prog, procnum, cbkfn, &iov, count,
+        ret = rpc_clnt_submit(rpc, prog, procnum, cbkfn, &iov, count,
                               cp->payload, cp->payload_cnt, new_iobref, frame,
                               cp->rsphdr, cp->rsphdr_cnt, cp->rsp_payload,
                               cp->rsp_payload_cnt, cp->rsp_iobref);
     } else {
-        ret = rpc_clnt_submit(conf->rpc, prog, procnum, cbkfn, &iov, count,
-                              NULL, 0, new_iobref, frame, NULL, 0, NULL, 0,
-                              NULL);
+        ret = rpc_clnt_submit(rpc, prog, procnum, cbkfn, &iov, count, NULL, 0,
+                              new_iobref, frame, NULL, 0, NULL, 0, NULL);
     }
 
     if (ret < 0) {
@@ -2176,6 +2225,137 @@ client_mark_fd_bad(xlator_t *this)
     pthread_spin_unlock(&conf->fd_lock);
 }
 
+void
+client_lane_join(xlator_t *this, clnt_lane_t *lane)
+{
+    clnt_conf_t *conf = this->private;
+    gf_boolean_t join = _gf_false;
+
+    pthread_mutex_lock(&conf->lock);
+    {
+        if (conf->connected && lane->connected && !lane->joining &&
+            !lane->ready) {
+            lane->joining = 1;
+            lane->setvol_count = conf->setvol_count;
+            join = _gf_true;
+        }
+    }
+    pthread_mutex_unlock(&conf->lock);
+
+    if (join && client_lane_setvolume(this, lane)) {
+        pthread_mutex_lock(&conf->lock);
+        {
+            lane->joining = 0;
+        }
+        pthread_mutex_unlock(&conf->lock);
+    }
+}
+
+/* Called once the main connection completed its SETVOLUME: point the lanes
+ * at the brick port and (re)connect them. */
+void
+client_lanes_start(xlator_t *this)
+{
+    clnt_conf_t *conf = this->private;
+    struct rpc_clnt_config config = {
+        0,
+    };
+    int i = 0;
+
+    if (!conf->lane_count)
+        return;
+
+    config.remote_port = conf->brick_port ? conf->brick_port
+                                          : conf->rpc_conf.remote_port;
+
+    for (i = 0; i < conf->lane_count; i++) {
+        rpc_clnt_reconfig(conf->lanes[i].rpc, &config);
+        rpc_clnt_start(conf->lanes[i].rpc);
+        client_lane_join(this, &conf->lanes[i]);
+    }
+}
+
+/* The lanes are bound to the client_t of the main connection, they go down
+ * with it and are started again after the next successful handshake. */
+void
+client_lanes_stop(xlator_t *this)
+{
+    clnt_conf_t *conf = this->private;
+    int i = 0;
+
+    if (!conf->lane_count)
+        return;
+
+    pthread_mutex_lock(&conf->lock);
+    {
+        for (i = 0; i < conf->lane_count; i++)
+            conf->lanes[i].ready = 0;
+    }
+    pthread_mutex_unlock(&conf->lock);
+
+    for (i = 0; i < conf->lane_count; i++)
+        rpc_clnt_disable(conf->lanes[i].rpc);
+}
+
+static int
+client_lane_rpc_notify(struct rpc_clnt *rpc, void *mydata,
+                       rpc_clnt_event_t event, void *data)
+{
+    clnt_lane_t *lane = mydata;
+    xlator_t *this = NULL;
+    clnt_conf_t *conf = NULL;
+    struct rpc_clnt_config config = {
+        0,
+    };
+
+    if (!lane)
+        goto out;
+
+    this = lane->this;
+    conf = this->private;
+
+    switch (event) {
+        case RPC_CLNT_CONNECT:
+            pthread_mutex_lock(&conf->lock);
+            {
+                lane->connected = 1;
+            }
+            pthread_mutex_unlock(&conf->lock);
+
+            client_lane_join(this, lane);
+            break;
+
+        case RPC_CLNT_DISCONNECT:
+            pthread_mutex_lock(&conf->lock);
+            {
+                lane->connected = 0;
+                lane->ready = 0;
+                lane->joining = 0;
+                /* rpc-clnt falls back to the glusterd port after every
+                 * disconnect, keep the lane pointed at the brick */
+                if (conf->connected)
+                    config.remote_port = conf->brick_port
+                                             ? conf->brick_port
+                                             : conf->rpc_conf.remote_port;
+            }
+            pthread_mutex_unlock(&conf->lock);
+
+            if (config.remote_port)
+                rpc_clnt_reconfig(rpc, &config);
+            else
+                gf_msg_debug(this->name, 0, "lane %d disconnected",
+                             lane->idx);
+            break;
+
+        default:
+            gf_msg_trace(this->name, 0, "got some other RPC event %d", event);
+            break;
+    }
+
+out:
+    return 0;
+}
+
 int
 client_rpc_notify(struct rpc_clnt *rpc, void *mydata, rpc_clnt_event_t event,
                   void *data)
@@ -2220,6 +2400,7 @@ client_rpc_notify(struct rpc_clnt *rpc, void *mydata, rpc_clnt_event_t event,
             gf_msg_debug(this->name, 0, "got RPC_CLNT_DISCONNECT");
 
             client_mark_fd_bad(this);
+            client_lanes_stop(this);
 
             if (!conf->skip_notify) {
                 if (conf->can_log_disconnect) {
@@ -2331,6 +2512,7 @@ notify(xlator_t *this, int32_t event, void *data, ...)
             }
             pthread_mutex_unlock(&conf->lock);
 
+            client_lanes_stop(this);
             ret = rpc_clnt_disable(conf->rpc);
             if (ret == -1 && graph) {
                 pthread_mutex_lock(&graph->mutex);
@@ -2412,6 +2594,8 @@ build_client_config(xlator_t *this, clnt_conf_t *conf)
     GF_OPTION_INIT("testing.old-protocol", conf->old_protocol, bool, out);
     GF_OPTION_INIT("strict-locks", conf->strict_locks, bool, out);
 
+    GF_OPTION_INIT("connection-count", conf->connection_count, int32, out);
+
     conf->client_id = glusterfs_leaf_position(this);
 
     ret = client_check_remote_host(this, this->options);
@@ -2441,6 +2625,76 @@ mem_acct_init(xlator_t *this)
     return ret;
 }
 
+static void
+client_destroy_lanes(xlator_t *this)
+{
+    clnt_conf_t *conf = this->private;
+    struct rpc_clnt *rpc = NULL;
+    int i = 0;
+
+    for (i = 0; i < conf->lane_count; i++) {
+        rpc = conf->lanes[i].rpc;
+        if (!rpc)
+            continue;
+        rpc_clnt_register_notify(rpc, NULL, NULL);
+        rpc_clnt_disable(rpc);
+        rpc_clnt_connection_cleanup(&rpc->conn);
+        conf->lanes[i].rpc = rpc_clnt_unref(rpc);
+    }
+
+    conf->lane_count = 0;
+    GF_FREE(conf->lanes);
+    conf->lanes = NULL;
+}
+
+static int
+client_init_lanes(xlator_t *this)
+{
+    clnt_conf_t *conf = this->private;
+    clnt_lane_t *lane = NULL;
+    char name[NAME_MAX];
+    int count = conf->connection_count - 1;
+    int ret = 0;
+    int i = 0;
+
+    if (count <= 0)
+        return 0;
+
+    conf->lanes = GF_CALLOC(count, sizeof(*conf->lanes),
+                            gf_client_mt_clnt_lane_t);
+    if (!conf->lanes)
+        return -1;
+
+    for (i = 0; i < count; i++) {
+        lane = &conf->lanes[i];
+        lane->this = this;
+        lane->idx = i + 1;
+
+        snprintf(name, sizeof(name), "%s-lane-%d", this->name, lane->idx);
+        lane->rpc = rpc_clnt_new(this->options, this, name, 0);
+        if (!lane->rpc) {
+            gf_smsg(this->name, GF_LOG_ERROR, 0, PC_MSG_RPC_INIT_FAILED, NULL);
+            ret = -1;
+            break;
+        }
+        conf->lane_count++;
+
+        rpc_clnt_register_notify(lane->rpc, client_lane_rpc_notify, lane);
+
+        /* upcalls are sent on whichever connection the brick finds first */
+        ret = rpcclnt_cbk_program_register(lane->rpc, &gluster_cbk_prog, this);
+        if (ret) {
+            gf_smsg(this->name, GF_LOG_ERROR, 0, PC_MSG_RPC_CBK_FAILED, NULL);
+            break;
+        }
+    }
+
+    if (ret)
+        client_destroy_lanes(this);
+
+    return ret;
+}
+
 static int
 client_destroy_rpc(xlator_t *this)
 {
@@ -2451,6 +2705,8 @@ client_destroy_rpc(xlator_t *this)
     if (!conf)
         goto out;
 
+    client_destroy_lanes(this);
+
     if (conf->rpc) {
         /* cleanup the saved-frames before last unref */
         rpc_clnt_connection_cleanup(&conf->rpc->conn);
@@ -2502,7 +2758,9 @@ client_init_rpc(xlator_t *this)
         goto out;
     }
 
-    ret = 0;
+    ret = client_init_lanes(this);
+    if (ret)
+        goto out;
 
     gf_msg_debug(this->name, 0, "client init successful");
 out:
@@ -2679,6 +2937,7 @@ fini(xlator_t *this)
 
     conf->fini_completed = _gf_false;
     conf->destroy = 1;
+    client_destroy_lanes(this);
     if (conf->rpc) {
         /* cleanup the saved-frames before last unref */
         rpc_clnt_connection_cleanup(&conf->rpc->conn);
@@ -2801,6 +3060,21 @@ client_priv_dump(xlator_t *this)
         gf_proc_dump_write("ping_msgs_sent", "%" PRIu64, conn->pingcnt);
         gf_proc_dump_write("msgs_sent", "%" PRIu64, conn->msgcnt);
     }
+
+    gf_proc_dump_write("connection_count", "%d", conf->connection_count);
+    for (i = 0; i < conf->lane_count; i++) {
+        conn = &conf->lanes[i].rpc->conn;
+        snprintf(key, sizeof(key), "lane.%d.ready", conf->lanes[i].idx);
+        gf_proc_dump_write(key, "%d", conf->lanes[i].ready);
+        snprintf(key, sizeof(key), "lane.%d.total_bytes_read",
+                 conf->lanes[i].idx);
+        gf_proc_dump_write(key, "%" PRIu64, conn->trans->total_bytes_read);
+        snprintf(key, sizeof(key), "lane.%d.total_bytes_written",
+                 conf->lanes[i].idx);
+        gf_proc_dump_write(key, "%" PRIu64, conn->trans->total_bytes_write);
+        snprintf(key, sizeof(key), "lane.%d.msgs_sent", conf->lanes[i].idx);
+        gf_proc_dump_write(key, "%" PRIu64, conn->msgcnt);
+    }
     pthread_mutex_unlock(&conf->lock);
 
     return 0;
@@ -2982,6 +3256,18 @@ struct volume_options options[] = {
                     "necessary for stricter lock complaince as bricks "
                     "cleanup any granted locks when a client "
                     "disconnects."},
+    {.key = {"connection-count"},
+     .type = GF_OPTION_TYPE_INT,
+     .min = 1,
+     .max = 16,
+     .default_value = "1",
+     .op_version = {GD_OP_VERSION_10_0},
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC,
+     .description = "Number of TCP connections opened to each brick. Fops "
+                    "other than locks are spread over all of them, which "
+                    "lets a single mount use more than one event thread "
+                    "and socket buffer per brick. Takes effect on the next "
+                    "mount."},
     {.key = {NULL}},
 };
 
@@ -85,6 +85,22 @@ struct clnt_options {
     int ping_timeout;
 };
 
+/* An additional connection to the brick, opened when connection-count is
+ * more than 1. Lanes present the process-uuid of the main connection in
+ * their SETVOLUME, so the brick binds them to the same client_t and fds and
+ * locks are shared. They only carry fop traffic, everything else (handshake,
+ * fd reopen, lock heal, CHILD_UP/DOWN) stays with conf->rpc. */
+typedef struct clnt_lane {
+    struct rpc_clnt *rpc;
+    xlator_t *this;
+    uint64_t setvol_count; /* conf->setvol_count this lane joined under */
+    int idx;
+    char connected;
+    char joining; /* SETVOLUME in flight */
+    char ready;   /* may carry fops */
+    char _pad[1];
+} clnt_lane_t;
+
 typedef struct clnt_conf {
     struct rpc_clnt *rpc;
     struct clnt_options opt;
@@ -159,6 +175,12 @@ typedef struct clnt_conf {
 
     gf_boolean_t connection_to_brick; /*True from attempt to connect to brick
                                         till disconnection to brick*/
+
+    int32_t connection_count; /* lane_count + 1 */
+    int32_t brick_port;       /* last port handed out by the portmapper */
+    int32_t lane_count;
+    clnt_lane_t *lanes;
+    gf_atomic_t lane_next; /* round-robin cursor over conf->rpc and lanes */
 } clnt_conf_t;
 
 typedef struct _client_fd_ctx {
@@ -290,6 +312,11 @@ int
 client_submit_request(xlator_t *this, void *req, call_frame_t *frame,
                       rpc_clnt_prog_t *prog, int procnum, fop_cbk_fn_t cbk,
                       client_payload_t *cp, xdrproc_t xdrproc);
+int
+client_submit_request_rpc(xlator_t *this, struct rpc_clnt *rpc, void *req,
+                          call_frame_t *frame, rpc_clnt_prog_t *prog,
+                          int procnum, fop_cbk_fn_t cbk, client_payload_t *cp,
+                          xdrproc_t xdrproc);
 
 int
 unserialize_rsp_dirent(xlator_t *this, struct gfs3_readdir_rsp *rsp,
@@ -391,4 +418,13 @@ client_add_lock_for_recovery(fd_t *fd, struct gf_flock *flock,
 int
 client_is_setlk(int32_t cmd);
 
+void
+client_lanes_start(xlator_t *this);
+void
+client_lanes_stop(xlator_t *this);
+void
+client_lane_join(xlator_t *this, clnt_lane_t *lane);
+int
+client_lane_setvolume(xlator_t *this, clnt_lane_t *lane);
+
 #endif /* !_CLIENT_H */
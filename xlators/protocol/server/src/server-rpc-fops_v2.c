@@ -5928,7 +5928,8 @@ out:
 
 static rpcsvc_actor_t glusterfs4_0_fop_actors[] = {
     [GFS3_OP_NULL] = {"NULL", server_null, NULL, GFS3_OP_NULL, 0},
-    [GFS3_OP_STAT] = {"STAT", server4_0_stat, NULL, GFS3_OP_STAT, 0},
+    [GFS3_OP_STAT] = {"STAT", server4_0_stat, NULL, GFS3_OP_STAT, 0,
+                      .express = _gf_true},
     [GFS3_OP_READLINK] = {"READLINK", server4_0_readlink, NULL,
                           GFS3_OP_READLINK, 0},
     [GFS3_OP_MKNOD] = {"MKNOD", server4_0_mknod, NULL, GFS3_OP_MKNOD, 0},
@@ -5945,7 +5946,8 @@ static rpcsvc_actor_t glusterfs4_0_fop_actors[] = {
     [GFS3_OP_READ] = {"READ", server4_0_readv, NULL, GFS3_OP_READ, 0},
     [GFS3_OP_WRITE] = {"WRITE", server4_0_writev, server4_0_writev_vecsizer,
                        GFS3_OP_WRITE, 0},
-    [GFS3_OP_STATFS] = {"STATFS", server4_0_statfs, NULL, GFS3_OP_STATFS, 0},
+    [GFS3_OP_STATFS] = {"STATFS", server4_0_statfs, NULL, GFS3_OP_STATFS, 0,
+                        .express = _gf_true},
     [GFS3_OP_FLUSH] = {"FLUSH", server4_0_flush, NULL, GFS3_OP_FLUSH, 0},
     [GFS3_OP_FSYNC] = {"FSYNC", server4_0_fsync, NULL, GFS3_OP_FSYNC, 0},
     [GFS3_OP_GETXATTR] = {"GETXATTR", server4_0_getxattr, NULL,
@@ -5958,13 +5960,16 @@ static rpcsvc_actor_t glusterfs4_0_fop_actors[] = {
                          0},
     [GFS3_OP_FSYNCDIR] = {"FSYNCDIR", server4_0_fsyncdir, NULL,
                           GFS3_OP_FSYNCDIR, 0},
-    [GFS3_OP_ACCESS] = {"ACCESS", server4_0_access, NULL, GFS3_OP_ACCESS, 0},
+    [GFS3_OP_ACCESS] = {"ACCESS", server4_0_access, NULL, GFS3_OP_ACCESS, 0,
+                        .express = _gf_true},
     [GFS3_OP_CREATE] = {"CREATE", server4_0_create, NULL, GFS3_OP_CREATE, 0},
     [GFS3_OP_FTRUNCATE] = {"FTRUNCATE", server4_0_ftruncate, NULL,
                            GFS3_OP_FTRUNCATE, 0},
-    [GFS3_OP_FSTAT] = {"FSTAT", server4_0_fstat, NULL, GFS3_OP_FSTAT, 0},
+    [GFS3_OP_FSTAT] = {"FSTAT", server4_0_fstat, NULL, GFS3_OP_FSTAT, 0,
+                       .express = _gf_true},
     [GFS3_OP_LK] = {"LK", server4_0_lk, NULL, GFS3_OP_LK, 0},
-    [GFS3_OP_LOOKUP] = {"LOOKUP", server4_0_lookup, NULL, GFS3_OP_LOOKUP, 0},
+    [GFS3_OP_LOOKUP] = {"LOOKUP", server4_0_lookup, NULL, GFS3_OP_LOOKUP, 0,
+                        .express = _gf_true},
     [GFS3_OP_READDIR] = {"READDIR", server4_0_readdir, NULL, GFS3_OP_READDIR,
                          0},
     [GFS3_OP_INODELK] = {"INODELK", server4_0_inodelk, NULL, GFS3_OP_INODELK,
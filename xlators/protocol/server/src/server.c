@@ -239,6 +239,7 @@ server_priv(xlator_t *this)
     };
     uint64_t total_read = 0;
     uint64_t total_write = 0;
+    uint64_t dispatched = 0;
     int32_t ret = -1;
 
     GF_VALIDATE_OR_GOTO("server", this, out);
@@ -258,6 +259,20 @@ server_priv(xlator_t *this)
         {
             total_read += xprt->total_bytes_read;
             total_write += xprt->total_bytes_write;
+
+            dispatched = GF_ATOMIC_GET(xprt->fq_dispatched);
+            if (!dispatched || !xprt->xl_private)
+                continue;
+
+            gf_proc_dump_build_key(key, "fair-share", "%s",
+                                   xprt->peerinfo.identifier);
+            gf_proc_dump_write(key,
+                               "client_uid=%s, queued=%" PRId64
+                               ", dispatched=%" PRIu64
+                               ", avg_wait_usec=%" PRIu64,
+                               xprt->xl_private->client_uid,
+                               GF_ATOMIC_GET(xprt->fq_depth), dispatched,
+                               GF_ATOMIC_GET(xprt->fq_wait_usec) / dispatched);
         }
     }
     pthread_mutex_unlock(&conf->mutex);
@@ -992,6 +1007,8 @@ do_rpc:
         goto out;
     }
 
+    rpcsvc_set_fair_share(rpc_conf, options);
+
     list_for_each_entry(listeners, &(rpc_conf->listeners), list)
     {
         if (listeners->trans != NULL) {
@@ -1232,6 +1249,8 @@ server_init(xlator_t *this)
         goto out;
     }
 
+    rpcsvc_set_fair_share(conf->rpc, this->options);
+
     /*
      * This is the only place where we want secure_srvr to reflect
      * the data-plane setting.
@@ -1914,6 +1933,34 @@ struct volume_options server_options[] = {
                     "potentially run out of memory)",
      .op_version = {1},
      .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC | OPT_FLAG_GLOBAL},
+    {.key = {"rpc.fair-share"},
+     .type = GF_OPTION_TYPE_BOOL,
+     .default_value = "off",
+     .description = "Serve the queued requests of the clients deficit "
+                    "round robin instead of first come first served, so "
+                    "that one busy client can not starve the others. "
+                    "Lookup, stat and similar calls are served first.",
+     .op_version = {GD_OP_VERSION_10_0},
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC},
+    {.key = {"rpc.fair-share-weight"},
+     .type = GF_OPTION_TYPE_INT,
+     .min = 1,
+     .max = RPCSVC_MAX_FQ_WEIGHT,
+     .default_value = TOSTRING(RPCSVC_DEFAULT_FQ_WEIGHT),
+     .description = "Share of a client (mount) with rpc.fair-share, in "
+                    "4KB of requests per round.",
+     .op_version = {GD_OP_VERSION_10_0},
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC},
+    {.key = {"rpc.fair-share-internal-weight"},
+     .type = GF_OPTION_TYPE_INT,
+     .min = 1,
+     .max = RPCSVC_MAX_FQ_WEIGHT,
+     .default_value = TOSTRING(RPCSVC_DEFAULT_FQ_WEIGHT_INTERNAL),
+     .description = "Share of the requests of internal clients "
+                    "(rebalance, self-heal, quota and other daemons) with "
+                    "rpc.fair-share, in 4KB of requests per round.",
+     .op_version = {GD_OP_VERSION_10_0},
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC},
     {.key = {"manage-gids"},
      .type = GF_OPTION_TYPE_BOOL,
      .default_value = "off",
@@ -36,6 +36,7 @@
 #endif /* HAVE_LINKAT */
 
 #include "posix-inode-handle.h"
+#include "posix-metadata.h"
 #include <glusterfs/compat-errno.h>
 #include <glusterfs/compat.h>
 #include <glusterfs/byte-order.h>
@@ -119,6 +120,24 @@ posix_priv(xlator_t *this)
     gf_proc_dump_write("max_read", "%" PRId64, GF_ATOMIC_GET(priv->read_value));
     gf_proc_dump_write("max_write", "%" PRId64,
                        GF_ATOMIC_GET(priv->write_value));
+    posix_handle_cache_dump(this);
+    gf_proc_dump_write("mdata_flush_interval", "%u",
+                       priv->mdata_flush_interval);
+    gf_proc_dump_write("mdata_dirty_count", "%u", priv->mdata_dirty_count);
+    gf_proc_dump_write("fsync_gap_usec", "%u", priv->fsync_gap_usec);
+    gf_proc_dump_write("fsync_batches", "%" PRIu64,
+                       GF_ATOMIC_GET(priv->fsync_batches));
+    gf_proc_dump_write("fsync_groups", "%" PRIu64,
+                       GF_ATOMIC_GET(priv->fsync_groups));
+    gf_proc_dump_write("xattr_cache_hits", "%" PRIu64,
+                       GF_ATOMIC_GET(priv->xattr_cache_hits));
+    gf_proc_dump_write("xattr_cache_misses", "%" PRIu64,
+                       GF_ATOMIC_GET(priv->xattr_cache_misses));
+    posix_reclaim_dump(this);
+    gf_proc_dump_write("stream_drop_behind", "%" PRIu64,
+                       priv->stream_drop_behind);
+    gf_proc_dump_write("streams_detected", "%" PRIu64,
+                       GF_ATOMIC_GET(priv->streams_detected));
 
     return 0;
 }
@@ -304,6 +323,8 @@ set_batch_fsync_mode(struct posix_private *priv, const char *str)
         priv->batch_fsync_mode = BATCH_SYNCFS_REVERSE_FSYNC;
     else if (strcmp(str, "reverse-fsync") == 0)
         priv->batch_fsync_mode = BATCH_REVERSE_FSYNC;
+    else if (strcmp(str, "group-commit") == 0)
+        priv->batch_fsync_mode = BATCH_GROUP_COMMIT;
     else
         return -1;
 
@@ -341,6 +362,7 @@ posix_reconfigure(xlator_t *this, dict_t *options)
     int32_t force_directory_mode = -1;
     int32_t create_mask = -1;
     int32_t create_directory_mask = -1;
+    uint32_t handle_cache_size = 0;
     double old_disk_reserve = 0.0;
 
     priv = this->private;
@@ -489,6 +511,30 @@ posix_reconfigure(xlator_t *this, dict_t *options)
 
     GF_OPTION_RECONF("ctime", priv->ctime, options, bool, out);
 
+    GF_OPTION_RECONF("mdata-flush-interval", priv->mdata_flush_interval,
+                     options, uint32, out);
+
+    GF_OPTION_RECONF("lookup-xattr-cache", priv->xattr_cache, options, bool,
+                     out);
+
+    GF_OPTION_RECONF("reclaim-threshold", priv->reclaim_threshold, options,
+                     size_uint64, out);
+
+    GF_OPTION_RECONF("reclaim-rate", priv->reclaim_rate, options, size_uint64,
+                     out);
+    if (posix_reclaim_set_rate(this) != 0)
+        goto out;
+
+    GF_OPTION_RECONF("stream-drop-behind", priv->stream_drop_behind, options,
+                     size_uint64, out);
+
+    GF_OPTION_RECONF("parallel-readdirp", priv->parallel_readdirp, options,
+                     bool, out);
+
+    GF_OPTION_RECONF("handle-cache-size", handle_cache_size, options, uint32,
+                     out);
+    posix_handle_cache_resize(this, handle_cache_size);
+
     ret = 0;
 out:
     return ret;
@@ -1154,6 +1200,11 @@ posix_init(xlator_t *this)
     pthread_cond_init(&_private->janitor_cond, NULL);
     pthread_cond_init(&_private->fd_cond, NULL);
     INIT_LIST_HEAD(&_private->fsyncs);
+    GF_ATOMIC_INIT(_private->fsync_batches, 0);
+    GF_ATOMIC_INIT(_private->fsync_groups, 0);
+    GF_ATOMIC_INIT(_private->streams_detected, 0);
+    GF_ATOMIC_INIT(_private->xattr_cache_hits, 0);
+    GF_ATOMIC_INIT(_private->xattr_cache_misses, 0);
     _private->rel_fdcount = 0;
     ret = posix_spawn_ctx_janitor_thread(this);
     if (ret)
@@ -1168,6 +1219,50 @@ posix_init(xlator_t *this)
         goto out;
     }
 
+    pthread_mutex_init(&_private->mdata_lock, NULL);
+    pthread_cond_init(&_private->mdata_cond, NULL);
+    INIT_LIST_HEAD(&_private->mdata_dirty);
+
+    GF_OPTION_INIT("mdata-flush-interval", _private->mdata_flush_interval,
+                   uint32, out);
+
+    GF_OPTION_INIT("lookup-xattr-cache", _private->xattr_cache, bool, out);
+
+    GF_OPTION_INIT("stream-drop-behind", _private->stream_drop_behind,
+                   size_uint64, out);
+
+    ret = gf_thread_create(&_private->mdata_flusher, NULL, posix_mdata_flusher,
+                           this, "posixmdf");
+    if (ret) {
+        gf_msg(this->name, GF_LOG_ERROR, errno,
+               P_MSG_FSYNCER_THREAD_CREATE_FAILED,
+               "mdata flusher thread creation failed");
+        goto out;
+    }
+
+    pthread_mutex_init(&_private->reclaim_lock, NULL);
+    pthread_cond_init(&_private->reclaim_cond, NULL);
+    INIT_LIST_HEAD(&_private->reclaim_queue);
+
+    GF_OPTION_INIT("reclaim-threshold", _private->reclaim_threshold,
+                   size_uint64, out);
+    GF_OPTION_INIT("reclaim-rate", _private->reclaim_rate, size_uint64, out);
+
+    _private->reclaim_tbf = tbf_init(NULL, 0);
+    if (!_private->reclaim_tbf || posix_reclaim_set_rate(this) != 0) {
+        ret = -1;
+        goto out;
+    }
+
+    ret = gf_thread_create(&_private->reclaimer, NULL, posix_reclaimer, this,
+                           "posixrcl");
+    if (ret) {
+        gf_msg(this->name, GF_LOG_ERROR, errno,
+               P_MSG_FSYNCER_THREAD_CREATE_FAILED,
+               "reclaimer thread creation failed");
+        goto out;
+    }
+
     GF_OPTION_INIT("batch-fsync-mode", batch_fsync_mode_str, str, out);
 
     if (set_batch_fsync_mode(_private, batch_fsync_mode_str) != 0) {
@@ -1232,6 +1327,16 @@ posix_init(xlator_t *this)
 
     GF_OPTION_INIT("ctime", _private->ctime, bool, out);
 
+    GF_OPTION_INIT("parallel-readdirp", _private->parallel_readdirp, bool,
+                   out);
+
+    GF_OPTION_INIT("handle-cache-size", _private->handle_cache_size, uint32,
+                   out);
+    if (posix_handle_cache_init(this) != 0) {
+        ret = -1;
+        goto out;
+    }
+
 out:
     if (ret) {
         if (_private) {
@@ -1344,6 +1449,34 @@ posix_fini(xlator_t *this)
         priv->fsyncer = 0;
     }
 
+    if (priv->mdata_flusher) {
+        /* writes out whatever is still dirty before exiting */
+        pthread_mutex_lock(&priv->mdata_lock);
+        {
+            priv->mdata_flusher_exit = _gf_true;
+            pthread_cond_signal(&priv->mdata_cond);
+        }
+        pthread_mutex_unlock(&priv->mdata_lock);
+        pthread_join(priv->mdata_flusher, NULL);
+        priv->mdata_flusher = 0;
+    }
+
+    if (priv->reclaimer) {
+        /* lift the rate limit so that a throttled chunk returns now */
+        priv->reclaim_rate = 0;
+        (void)posix_reclaim_set_rate(this);
+
+        pthread_mutex_lock(&priv->reclaim_lock);
+        {
+            priv->reclaimer_exit = _gf_true;
+            pthread_cond_signal(&priv->reclaim_cond);
+        }
+        pthread_mutex_unlock(&priv->reclaim_lock);
+        pthread_join(priv->reclaimer, NULL);
+        priv->reclaimer = 0;
+    }
+    tbf_fini(priv->reclaim_tbf);
+
     /*unlock brick dir*/
     if (priv->mount_lock >= 0) {
         (void)sys_close(priv->mount_lock);
@@ -1356,8 +1489,13 @@ posix_fini(xlator_t *this)
     pthread_cond_destroy(&priv->fsync_cond);
     pthread_mutex_destroy(&priv->janitor_mutex);
     pthread_cond_destroy(&priv->janitor_cond);
+    pthread_mutex_destroy(&priv->mdata_lock);
+    pthread_cond_destroy(&priv->mdata_cond);
+    pthread_mutex_destroy(&priv->reclaim_lock);
+    pthread_cond_destroy(&priv->reclaim_cond);
     GF_FREE(priv->hostname);
     GF_FREE(priv->trash_path);
+    posix_handle_cache_fini(this);
     GF_FREE(priv);
     this->private = NULL;
 
@@ -1398,6 +1536,81 @@ struct volume_options posix_options[] = {
      .description = "Support for Linux io_uring",
      .op_version = {GD_OP_VERSION_9_0},
      .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC},
+    {.key = {"parallel-readdirp"},
+     .type = GF_OPTION_TYPE_BOOL,
+     .default_value = "off",
+     .description = "Stat the entries of large readdirp replies, and "
+                    "fetch their xattrs, in parallel synctasks instead of "
+                    "one after the other. Not done when the brick runs "
+                    "on the global thread pool.",
+     .op_version = {GD_OP_VERSION_10_0},
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC},
+    {.key = {"mdata-flush-interval"},
+     .type = GF_OPTION_TYPE_INT,
+     .min = 0,
+     .max = 60,
+     .default_value = "0",
+     .description = "Seconds for which updates to the time attributes "
+                    "kept by the ctime feature may stay in memory only, "
+                    "so that several updates to a file cost one xattr "
+                    "write. They are also written on fsync. 0 writes them "
+                    "on every update.",
+     .op_version = {GD_OP_VERSION_10_0},
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC},
+    {.key = {"lookup-xattr-cache"},
+     .type = GF_OPTION_TYPE_BOOL,
+     .default_value = "off",
+     .description = "Keep the extended attributes of files looked up "
+                    "in memory, and answer later lookups of a file whose "
+                    "ctime has not changed from there instead of reading "
+                    "every attribute from disk again.",
+     .op_version = {GD_OP_VERSION_10_0},
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC},
+    {.key = {"reclaim-threshold"},
+     .type = GF_OPTION_TYPE_SIZET,
+     .min = 0,
+     .max = 1 * GF_UNIT_PB,
+     .default_value = "0",
+     .description = "Files holding at least this much data are freed by "
+                    "a background thread after they are unlinked, by "
+                    "punching holes in them a chunk at a time, instead "
+                    "of by one long truncate in the filesystem that "
+                    "stalls other operations on the brick. 0 disables "
+                    "this.",
+     .op_version = {GD_OP_VERSION_10_0},
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC},
+    {.key = {"reclaim-rate"},
+     .type = GF_OPTION_TYPE_SIZET,
+     .min = 0,
+     .max = 1 * GF_UNIT_PB,
+     .default_value = "0",
+     .description = "Bytes per second the background reclaimer frees at "
+                    "most. 0 frees as fast as the filesystem allows.",
+     .op_version = {GD_OP_VERSION_10_0},
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC},
+    {.key = {"stream-drop-behind"},
+     .type = GF_OPTION_TYPE_SIZET,
+     .min = 0,
+     .max = 1 * GF_UNIT_TB,
+     .default_value = "0",
+     .description = "Once a file descriptor has read or written this "
+                    "many bytes sequentially, the pages it leaves behind "
+                    "are written back and dropped from the page cache, so "
+                    "that large streams do not evict the working set of "
+                    "other clients. 0 disables this.",
+     .op_version = {GD_OP_VERSION_10_0},
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC},
+    {.key = {"handle-cache-size"},
+     .type = GF_OPTION_TYPE_INT,
+     .min = 0,
+     .max = 1048576,
+     .default_value = "0",
+     .description = "Number of directories whose gfid handle is kept "
+                    "resolved to a path on the brick, so that gfid based "
+                    "operations in deep trees do not read every handle "
+                    "symlink up to the root. 0 disables the cache.",
+     .op_version = {GD_OP_VERSION_10_0},
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC},
     {.key = {"brick-uid"},
      .type = GF_OPTION_TYPE_INT,
      .min = -1,
@@ -1462,14 +1675,18 @@ struct volume_options posix_options[] = {
          " of fsyncs and fsync() each file in the batch in reverse order.\n"
          " in reverse order.\n"
          "\t- reverse-fsync: Perform fsync() of each file in the batch in"
-         " reverse order.",
+         " reverse order.\n"
+         "\t- group-commit: Perform one fsync() (or fdatasync()) per file"
+         " of the batch, in parallel, and answer the whole batch once they"
+         " are all done. The wait for more requests adapts to their rate.",
      .op_version = {3},
      .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC},
     {.key = {"batch-fsync-delay-usec"},
      .type = GF_OPTION_TYPE_INT,
      .default_value = "0",
      .description = "Num of usecs to wait for aggregating fsync"
-                    " requests",
+                    " requests. With group-commit, the upper bound of the"
+                    " adaptive wait (0 means 1000).",
      .op_version = {3},
      .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC},
     {.key = {"update-link-count-parent"},
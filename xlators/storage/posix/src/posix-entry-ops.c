@@ -1208,6 +1208,8 @@ posix_unlink(call_frame_t *frame, xlator_t *this, loc_t *loc, int xflag,
     dict_t *unwind_dict = NULL;
     gf_boolean_t get_link_count = _gf_false;
     posix_inode_ctx_t *ctx = NULL;
+    int reclaim_fd = -1;
+    uint32_t fd_count = 0;
 
     DECLARE_OLD_FS_ID_VAR;
 
@@ -1288,6 +1290,16 @@ posix_unlink(call_frame_t *frame, xlator_t *this, loc_t *loc, int xflag,
         }
     }
 
+    /* Keep the last link of a large file open, so that the reclaimer can
+     * free it in chunks once it is unlinked. If it cannot be opened for
+     * writing, it is freed at once as usual.
+     */
+    if (priv->reclaim_threshold && IA_ISREG(loc->inode->ia_type) &&
+        (stbuf.ia_nlink == 1) &&
+        (stbuf.ia_blocks * 512 >= priv->reclaim_threshold)) {
+        reclaim_fd = sys_open(real_path, O_WRONLY, 0);
+    }
+
     if (priv->update_pgfid_nlinks && (stbuf.ia_nlink > 1)) {
         MAKE_PGFID_XATTR_KEY(pgfid_xattr_key, PGFID_XATTR_KEY_PREFIX,
                              loc->pargfid);
@@ -1349,6 +1361,19 @@ posix_unlink(call_frame_t *frame, xlator_t *this, loc_t *loc, int xflag,
         goto out;
     }
 
+    if (reclaim_fd != -1) {
+        LOCK(&loc->inode->lock);
+        {
+            fd_count = loc->inode->fd_count;
+        }
+        UNLOCK(&loc->inode->lock);
+
+        /* open fds still see the data, leave it to their last close */
+        if (!fd_count &&
+            posix_reclaim_queue(this, reclaim_fd, stbuf.ia_gfid) == 0)
+            reclaim_fd = -1;
+    }
+
     if (fdstat_requested) {
         op_ret = posix_fdstat(this, loc->inode, fd, &postbuf);
         if (op_ret == -1) {
@@ -1390,6 +1415,10 @@ out:
         sys_close(fd);
     }
 
+    if (reclaim_fd != -1) {
+        sys_close(reclaim_fd);
+    }
+
     /* unref unwind_dict*/
     if (unwind_dict) {
         dict_unref(unwind_dict);
@@ -1833,8 +1862,12 @@ posix_rename(call_frame_t *frame, xlator_t *this, loc_t *oldloc, loc_t *newloc,
         }
     }
 
-    if (IA_ISDIR(oldloc->inode->ia_type))
+    if (IA_ISDIR(oldloc->inode->ia_type)) {
         posix_handle_unset(this, oldloc->inode->gfid, NULL);
+        /* retire the paths under the old name before they go, and again
+         * after the rename for those resolved meanwhile */
+        posix_handle_cache_invalidate(this);
+    }
 
     pthread_mutex_lock(&ctx_old->pgfid_lock);
     {
@@ -1932,6 +1965,8 @@ unlock:
         posix_handle_unset(this, victim, NULL);
 
     if (IA_ISDIR(oldloc->inode->ia_type)) {
+        /* every path below the old one is stale now */
+        posix_handle_cache_invalidate(this);
         posix_handle_soft(this, real_newpath, newloc, oldloc->inode->gfid,
                           NULL);
     }
@@ -2313,8 +2348,12 @@ ignore:
     }
 
 fill_stat:
-    op_ret = posix_gfid_set(this, real_path, loc, xdata, frame->root->pid,
-                            &op_errno);
+    if (was_present)
+        op_ret = posix_gfid_set(this, real_path, loc, xdata, frame->root->pid,
+                                &op_errno);
+    else
+        op_ret = posix_gfid_set_fd(this, _fd, real_path, loc, xdata,
+                                   frame->root->pid, &op_errno);
     if (op_ret) {
         gf_msg(this->name, GF_LOG_ERROR, op_errno, P_MSG_GFID_FAILED,
                "setting gfid on %s failed", real_path);
@@ -2331,7 +2370,7 @@ fill_stat:
         goto out;
     }
 
-    posix_set_ctime(frame, this, real_path, -1, loc->inode, &stbuf);
+    posix_set_ctime(frame, this, real_path, _fd, loc->inode, &stbuf);
 
     op_ret = posix_pstat(this, loc->parent, loc->pargfid, par_path, &postparent,
                          _gf_false);
@@ -23,6 +23,7 @@
 #include "posix-metadata.h"
 
 #include <glusterfs/compat-errno.h>
+#include <glusterfs/statedump.h>
 
 int
 posix_handle_mkdir_hashes(xlator_t *this, int dfd, uuid_t gfid);
@@ -389,6 +390,429 @@ err:
     return -1;
 }
 
+/*
+  Cache of the brick-relative paths of directory handles.
+
+  Resolving a directory gfid to a path walks the chain of handle
+  symlinks up to the brick root, one readlink per level. For deep trees
+  that walk dominates gfid based fops, so the resolved path of each
+  directory (and of the ancestors met on the way) is remembered here.
+
+  An entry is only used after the handle symlink of its gfid has been
+  stat'ed, and only if that symlink is still the one seen when the entry
+  was filled (same inode), so removed or re-created directories never
+  hit. Renaming a directory changes the path of its whole subtree; it
+  bumps the generation of the cache before and after the rename, which
+  retires every older entry.
+*/
+#define POSIX_HANDLE_CACHE_BUCKETS 4096
+#define POSIX_HANDLE_CACHE_LEVELS 64
+
+struct posix_handle_cache {
+    pthread_mutex_t lock;
+    struct list_head lru;
+    struct list_head buckets[POSIX_HANDLE_CACHE_BUCKETS];
+    uint64_t gen;
+    uint32_t count;
+    gf_atomic_t hits;
+    gf_atomic_t misses;
+};
+
+struct posix_handle_cache_entry {
+    struct list_head hash;
+    struct list_head lru;
+    uuid_t gfid;
+    uint64_t gen;
+    ino_t ino; /* of the handle symlink */
+    int len;
+    char path[]; /* "/dir/.../name", relative to the brick root */
+};
+
+static struct list_head *
+posix_handle_cache_bucket(struct posix_handle_cache *cache, uuid_t gfid)
+{
+    uint32_t hash = (gfid[12] << 24) | (gfid[13] << 16) | (gfid[14] << 8) |
+                    gfid[15];
+
+    return &cache->buckets[hash % POSIX_HANDLE_CACHE_BUCKETS];
+}
+
+static void
+__posix_handle_cache_unlink(struct posix_handle_cache *cache,
+                            struct posix_handle_cache_entry *entry)
+{
+    list_del(&entry->hash);
+    list_del(&entry->lru);
+    cache->count--;
+    GF_FREE(entry);
+}
+
+static struct posix_handle_cache_entry *
+__posix_handle_cache_get(struct posix_handle_cache *cache, uuid_t gfid)
+{
+    struct posix_handle_cache_entry *entry = NULL;
+    struct list_head *head = posix_handle_cache_bucket(cache, gfid);
+
+    list_for_each_entry(entry, head, hash)
+    {
+        if (gf_uuid_compare(entry->gfid, gfid) != 0)
+            continue;
+
+        if (entry->gen != cache->gen) {
+            __posix_handle_cache_unlink(cache, entry);
+            return NULL;
+        }
+
+        list_move(&entry->lru, &cache->lru);
+        return entry;
+    }
+
+    return NULL;
+}
+
+static void
+__posix_handle_cache_trim(struct posix_handle_cache *cache, uint32_t limit)
+{
+    struct posix_handle_cache_entry *entry = NULL;
+
+    while (cache->count > limit) {
+        entry = list_entry(cache->lru.prev, struct posix_handle_cache_entry,
+                           lru);
+        __posix_handle_cache_unlink(cache, entry);
+    }
+}
+
+static void
+__posix_handle_cache_set(struct posix_handle_cache *cache, uint32_t limit,
+                         uuid_t gfid, ino_t ino, const char *path, int len)
+{
+    struct posix_handle_cache_entry *entry = NULL;
+    struct list_head *head = posix_handle_cache_bucket(cache, gfid);
+
+    list_for_each_entry(entry, head, hash)
+    {
+        if (gf_uuid_compare(entry->gfid, gfid) == 0) {
+            __posix_handle_cache_unlink(cache, entry);
+            break;
+        }
+    }
+
+    entry = GF_MALLOC(sizeof(*entry) + len + 1,
+                      gf_posix_mt_handle_cache_entry_t);
+    if (!entry)
+        return;
+
+    gf_uuid_copy(entry->gfid, gfid);
+    entry->gen = cache->gen;
+    entry->ino = ino;
+    entry->len = len;
+    memcpy(entry->path, path, len);
+    entry->path[len] = '\0';
+
+    list_add(&entry->hash, head);
+    list_add(&entry->lru, &cache->lru);
+    cache->count++;
+
+    __posix_handle_cache_trim(cache, limit);
+}
+
+/* Copies the cached path of @gfid in front of @pos in @buf. Returns the
+   new start of the path, or -1 if @gfid is not cached (or was re-created
+   since it was cached, when @ino is given). */
+static int
+posix_handle_cache_prepend(struct posix_handle_cache *cache, uuid_t gfid,
+                           ino_t ino, char *buf, int pos)
+{
+    struct posix_handle_cache_entry *entry = NULL;
+    int ret = -1;
+
+    pthread_mutex_lock(&cache->lock);
+    {
+        entry = __posix_handle_cache_get(cache, gfid);
+        if (!entry)
+            goto unlock;
+
+        if (ino && entry->ino != ino) {
+            __posix_handle_cache_unlink(cache, entry);
+            goto unlock;
+        }
+
+        if (entry->len > pos)
+            goto unlock;
+
+        ret = pos - entry->len;
+        memcpy(buf + ret, entry->path, entry->len);
+    }
+unlock:
+    pthread_mutex_unlock(&cache->lock);
+
+    return ret;
+}
+
+/*
+  Resolves @gfid by reading the handle symlinks up to the brick root, or
+  up to the first ancestor found in the cache, and caches the result for
+  @gfid and each ancestor read on the way. The path is built backwards
+  at the end of @buf; returns its start, or -1.
+*/
+static int
+posix_handle_cache_fill(xlator_t *this, struct posix_handle_cache *cache,
+                        uuid_t gfid, ino_t ino, char *buf, int size)
+{
+    struct posix_private *priv = this->private;
+    struct {
+        uuid_t gfid;
+        ino_t ino;
+        int end;
+    } levels[POSIX_HANDLE_CACHE_LEVELS];
+    char linkname[512];
+    char handle[POSIX_GFID_HASH2_LEN];
+    char pgfid_str[UUID_CANONICAL_FORM_LEN + 1];
+    struct stat stbuf;
+    uuid_t cur;
+    uint64_t gen = 0;
+    int nlevels = 0;
+    int pos = size;
+    int dfd = -1;
+    int ret = -1;
+    int i = 0;
+
+    pthread_mutex_lock(&cache->lock);
+    {
+        gen = cache->gen;
+    }
+    pthread_mutex_unlock(&cache->lock);
+
+    gf_uuid_copy(cur, gfid);
+
+    while (!__is_root_gfid(cur)) {
+        if (nlevels > 0) {
+            ret = posix_handle_cache_prepend(cache, cur, 0, buf, pos);
+            if (ret >= 0) {
+                pos = ret;
+                break;
+            }
+        }
+
+        dfd = priv->arrdfd[cur[0]];
+        snprintf(handle, sizeof(handle), "%02x/%s", cur[1], uuid_utoa(cur));
+
+        if (nlevels > 0) {
+            if (sys_fstatat(dfd, handle, &stbuf, AT_SYMLINK_NOFOLLOW) != 0)
+                return -1;
+            ino = stbuf.st_ino;
+        }
+
+        ret = readlinkat(dfd, handle, linkname, sizeof(linkname) - 1);
+        if (ret < 0)
+            return -1;
+        linkname[ret] = '\0';
+
+        /* "../../xx/yy/<pgfid>/<name>" */
+        if (ret < 50 || posix_is_malformed_link(this, handle, linkname, ret))
+            return -1;
+
+        if (ret - 49 + 1 > pos)
+            return -1;
+
+        if (nlevels < POSIX_HANDLE_CACHE_LEVELS) {
+            gf_uuid_copy(levels[nlevels].gfid, cur);
+            levels[nlevels].ino = ino;
+            levels[nlevels].end = pos;
+            nlevels++;
+        }
+
+        pos -= ret - 49;
+        memcpy(buf + pos, linkname + 49, ret - 49);
+        buf[--pos] = '/';
+
+        memcpy(pgfid_str, linkname + 12, UUID_CANONICAL_FORM_LEN);
+        pgfid_str[UUID_CANONICAL_FORM_LEN] = '\0';
+        if (gf_uuid_parse(pgfid_str, cur) != 0)
+            return -1;
+
+        if (gf_uuid_compare(cur, gfid) == 0)
+            return -1;
+    }
+
+    pthread_mutex_lock(&cache->lock);
+    {
+        if (cache->gen != gen)
+            goto unlock;
+
+        for (i = nlevels - 1; i >= 0; i--)
+            __posix_handle_cache_set(cache, priv->handle_cache_size,
+                                     levels[i].gfid, levels[i].ino, buf + pos,
+                                     levels[i].end - pos);
+    }
+unlock:
+    pthread_mutex_unlock(&cache->lock);
+
+    return pos;
+}
+
+/* Fills @buf with the path of the directory @gfid (plus @basename) out of
+   the cache, filling the cache on a miss. @stbuf is the stat of the
+   handle symlink of @gfid. Returns the length of the path, or -1. */
+static int
+posix_handle_cache_path(xlator_t *this, uuid_t gfid, struct stat *stbuf,
+                        const char *basename, char *buf, int maxlen)
+{
+    struct posix_private *priv = this->private;
+    struct posix_handle_cache *cache = priv->handle_cache;
+    char *rel = NULL;
+    int pos = -1;
+    int len = 0;
+
+    if (!cache || !priv->handle_cache_size || __is_root_gfid(gfid))
+        return -1;
+
+    rel = alloca(PATH_MAX);
+
+    pos = posix_handle_cache_prepend(cache, gfid, stbuf->st_ino, rel,
+                                     PATH_MAX);
+    if (pos >= 0) {
+        GF_ATOMIC_INC(cache->hits);
+    } else {
+        GF_ATOMIC_INC(cache->misses);
+        pos = posix_handle_cache_fill(this, cache, gfid, stbuf->st_ino, rel,
+                                      PATH_MAX);
+        if (pos < 0)
+            return -1;
+    }
+
+    if (basename)
+        len = snprintf(buf, maxlen, "%s%.*s/%s", priv->base_path,
+                       PATH_MAX - pos, rel + pos, basename);
+    else
+        len = snprintf(buf, maxlen, "%s%.*s", priv->base_path, PATH_MAX - pos,
+                       rel + pos);
+
+    if (len >= maxlen)
+        return -1;
+
+    return len;
+}
+
+int
+posix_handle_cache_init(xlator_t *this)
+{
+    struct posix_private *priv = this->private;
+    struct posix_handle_cache *cache = NULL;
+    int i = 0;
+
+    cache = GF_CALLOC(1, sizeof(*cache), gf_posix_mt_handle_cache_t);
+    if (!cache)
+        return -1;
+
+    pthread_mutex_init(&cache->lock, NULL);
+    INIT_LIST_HEAD(&cache->lru);
+    for (i = 0; i < POSIX_HANDLE_CACHE_BUCKETS; i++)
+        INIT_LIST_HEAD(&cache->buckets[i]);
+
+    GF_ATOMIC_INIT(cache->hits, 0);
+    GF_ATOMIC_INIT(cache->misses, 0);
+    priv->handle_cache = cache;
+
+    return 0;
+}
+
+void
+posix_handle_cache_fini(xlator_t *this)
+{
+    struct posix_private *priv = this->private;
+    struct posix_handle_cache *cache = priv->handle_cache;
+
+    if (!cache)
+        return;
+
+    priv->handle_cache = NULL;
+
+    __posix_handle_cache_trim(cache, 0);
+    pthread_mutex_destroy(&cache->lock);
+    GF_FREE(cache);
+}
+
+/* Called when the handle of @gfid goes away. */
+void
+posix_handle_cache_forget(xlator_t *this, uuid_t gfid)
+{
+    struct posix_private *priv = this->private;
+    struct posix_handle_cache *cache = priv->handle_cache;
+    struct posix_handle_cache_entry *entry = NULL;
+
+    if (!cache)
+        return;
+
+    pthread_mutex_lock(&cache->lock);
+    {
+        entry = __posix_handle_cache_get(cache, gfid);
+        if (entry)
+            __posix_handle_cache_unlink(cache, entry);
+    }
+    pthread_mutex_unlock(&cache->lock);
+}
+
+/* Called when a directory is renamed: the paths of all its descendants
+   change, and those are not tracked, so retire every entry. */
+void
+posix_handle_cache_invalidate(xlator_t *this)
+{
+    struct posix_private *priv = this->private;
+    struct posix_handle_cache *cache = priv->handle_cache;
+
+    if (!cache)
+        return;
+
+    pthread_mutex_lock(&cache->lock);
+    {
+        cache->gen++;
+    }
+    pthread_mutex_unlock(&cache->lock);
+}
+
+/* Applies a new handle-cache-size. */
+void
+posix_handle_cache_resize(xlator_t *this, uint32_t limit)
+{
+    struct posix_private *priv = this->private;
+    struct posix_handle_cache *cache = priv->handle_cache;
+
+    if (!cache)
+        return;
+
+    pthread_mutex_lock(&cache->lock);
+    {
+        priv->handle_cache_size = limit;
+        __posix_handle_cache_trim(cache, limit);
+    }
+    pthread_mutex_unlock(&cache->lock);
+}
+
+void
+posix_handle_cache_dump(xlator_t *this)
+{
+    struct posix_private *priv = this->private;
+    struct posix_handle_cache *cache = priv->handle_cache;
+    uint32_t count = 0;
+
+    if (!cache)
+        return;
+
+    pthread_mutex_lock(&cache->lock);
+    {
+        count = cache->count;
+    }
+    pthread_mutex_unlock(&cache->lock);
+
+    gf_proc_dump_write("handle_cache_size", "%u", priv->handle_cache_size);
+    gf_proc_dump_write("handle_cache_count", "%u", count);
+    gf_proc_dump_write("handle_cache_hits", "%" PRIu64,
+                       GF_ATOMIC_GET(cache->hits));
+    gf_proc_dump_write("handle_cache_misses", "%" PRIu64,
+                       GF_ATOMIC_GET(cache->misses));
+}
+
 /*
   posix_handle_path differs from posix_handle_gfid_path in the way that the
   path filled in @buf by posix_handle_path will return type IA_IFDIR when
@@ -452,6 +876,12 @@ posix_handle_path(xlator_t *this, uuid_t gfid, const char *basename, char *ubuf,
     if (!(ret == 0 && S_ISLNK(stat.st_mode) && stat.st_nlink == 1))
         goto out;
 
+    ret = posix_handle_cache_path(this, gfid, &stat, basename, buf, maxlen);
+    if (ret > 0) {
+        len = ret;
+        goto out;
+    }
+
     do {
         errno = 0;
         ret = posix_handle_pump(this, buf, len, maxlen, base_str, base_len,
@@ -793,6 +1223,43 @@ posix_handle_hard(xlator_t *this, const char *oldpath, uuid_t gfid,
     return ret;
 }
 
+/* Links the handle of a file that was just created through @fd, so the
+ * handle is known to point to that inode without looking it up again.
+ * Needs CAP_DAC_READ_SEARCH; the caller falls back to posix_handle_hard().
+ */
+int
+posix_handle_hard_fd(xlator_t *this, int fd, uuid_t gfid)
+{
+    struct posix_private *priv = this->private;
+    int ret = -1;
+    int dfd = -1;
+    char *newstr = NULL;
+
+    if (priv->no_handle_link_fd)
+        return -1;
+
+    MAKE_HANDLE_ABSPATH_FD(newstr, this, gfid, dfd);
+
+    ret = linkat(fd, "", dfd, newstr, AT_EMPTY_PATH);
+    if (ret == -1 && errno == ENOENT) {
+        if (posix_handle_mkdir_hashes(this, dfd, gfid))
+            return -1;
+        ret = linkat(fd, "", dfd, newstr, AT_EMPTY_PATH);
+    }
+
+    /* Without CAP_DAC_READ_SEARCH linkat() refuses AT_EMPTY_PATH with
+     * ENOENT, which is only told apart from a missing hash dir once the
+     * hash dir is known to exist, i.e. on the second attempt.
+     */
+    if (ret == -1 && errno != EEXIST) {
+        /* not allowed here, don't try again */
+        gf_msg_debug(this->name, errno, "linking handles to fds disabled");
+        priv->no_handle_link_fd = _gf_true;
+    }
+
+    return ret;
+}
+
 int
 posix_handle_soft(xlator_t *this, const char *real_path, loc_t *loc,
                   uuid_t gfid, struct stat *oldbuf)
@@ -906,6 +1373,8 @@ posix_handle_unset_gfid(xlator_t *this, uuid_t gfid)
     if (ret) {
         gf_msg(this->name, GF_LOG_WARNING, errno, P_MSG_HANDLE_DELETE,
                "unlink %s is failed", newstr);
+    } else if (S_ISLNK(stat.st_mode)) {
+        posix_handle_cache_forget(this, gfid);
     }
 
 out:
@@ -202,6 +202,9 @@ int
 posix_handle_hard(xlator_t *this, const char *path, uuid_t gfid,
                   struct stat *buf);
 
+int
+posix_handle_hard_fd(xlator_t *this, int fd, uuid_t gfid);
+
 int
 posix_handle_soft(xlator_t *this, const char *real_path, loc_t *loc,
                   uuid_t gfid, struct stat *buf);
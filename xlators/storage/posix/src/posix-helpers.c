@@ -33,6 +33,10 @@
 #endif /* GF_BSD_HOST_OS */
 
 #include <fnmatch.h>
+#ifdef HAVE_FICLONERANGE
+#include <sys/ioctl.h>
+#include <linux/fs.h>
+#endif
 #include "posix.h"
 #include "posix-messages.h"
 #include "posix-metadata.h"
@@ -210,17 +214,15 @@ posix_xattr_ignorable(char *key)
     return gf_get_index_by_elem(posix_ignore_xattrs, key) >= 0;
 }
 
-static int
-_posix_xattr_get_set_from_backend(posix_xattr_filler_t *filler, char *key)
+/* Fetch the value of @key into a buffer allocated with one spare byte,
+ * which the caller frees. Returns the size of the value, or -1.
+ */
+static ssize_t
+posix_xattr_get_value(posix_xattr_filler_t *filler, char *key, char **valuep)
 {
     ssize_t xattr_size = 256; /* guesstimated initial size of xattr */
-    int ret = -1;
     char *value = NULL;
 
-    if (!gf_is_valid_xattr_namespace(key)) {
-        goto out;
-    }
-
     /* Most of the gluster internal xattrs don't exceed 256 bytes. So try
      * getxattr with ~256 bytes. If it gives ERANGE then go the old way
      * of getxattr with NULL buf to find the length and then getxattr with
@@ -262,6 +264,7 @@ _posix_xattr_get_set_from_backend(posix_xattr_filler_t *filler, char *key)
 
         value = GF_MALLOC(xattr_size + 1, gf_posix_mt_char);
         if (!value) {
+            xattr_size = -1;
             goto out;
         }
 
@@ -287,6 +290,303 @@ _posix_xattr_get_set_from_backend(posix_xattr_filler_t *filler, char *key)
     }
 
     value[xattr_size] = '\0';
+    *valuep = value;
+out:
+    return xattr_size;
+}
+
+static inode_t *
+_get_filler_inode(posix_xattr_filler_t *filler)
+{
+    if (filler->fd)
+        return filler->fd->inode;
+    else if (filler->loc && filler->loc->inode)
+        return filler->loc->inode;
+    else
+        return NULL;
+}
+
+static void
+_get_list_xattr(posix_xattr_filler_t *filler)
+{
+    ssize_t size = 0;
+
+    if ((!filler) || ((!filler->real_path) && (filler->fdnum < 0)))
+        goto out;
+
+    if (filler->real_path)
+        size = sys_llistxattr(filler->real_path, NULL, 0);
+    else
+        size = sys_flistxattr(filler->fdnum, NULL, 0);
+
+    if (size <= 0)
+        goto out;
+
+    filler->list = GF_CALLOC(1, size, gf_posix_mt_char);
+    if (!filler->list)
+        goto out;
+
+    if (filler->real_path)
+        size = sys_llistxattr(filler->real_path, filler->list, size);
+    else
+        size = sys_flistxattr(filler->fdnum, filler->list, size);
+
+    filler->list_size = size;
+out:
+    return;
+}
+
+/* A snapshot of all the xattrs of an inode, kept in its posix inode ctx
+ * so that lookups which come back for it are answered without a
+ * listxattr and a getxattr per key. It is valid as long as the inode
+ * number and the kernel ctime of the backend file are the ones it was
+ * taken with: setting or removing an xattr updates the ctime, whoever
+ * does it. To not miss an update made within the same clock tick as
+ * the snapshot, only files whose ctime is older than
+ * POSIX_XATTR_CACHE_SETTLE are cached.
+ */
+#define POSIX_XATTR_CACHE_SETTLE 1        /* seconds */
+#define POSIX_XATTR_CACHE_MAX_KEYS 64
+#define POSIX_XATTR_CACHE_MAX_BYTES 65536 /* of values */
+
+struct posix_xattr_cache_value {
+    const char *name; /* points into list */
+    char *value;
+    ssize_t size;
+};
+
+struct posix_xattr_cache {
+    gf_atomic_t ref;
+    ino_t ino;
+    time_t ctime_sec;
+    long ctime_nsec;
+    char *list; /* llistxattr() output */
+    size_t list_size;
+    int count;
+    struct posix_xattr_cache_value values[];
+};
+
+void
+posix_xattr_cache_unref(struct posix_xattr_cache *cache)
+{
+    int i = 0;
+
+    if (!cache || GF_ATOMIC_DEC(cache->ref) != 0)
+        return;
+
+    for (i = 0; i < cache->count; i++)
+        GF_FREE(cache->values[i].value);
+    GF_FREE(cache->list);
+    GF_FREE(cache);
+}
+
+void
+posix_xattr_cache_invalidate(xlator_t *this, inode_t *inode)
+{
+    posix_inode_ctx_t *ctx = NULL;
+    struct posix_xattr_cache *cache = NULL;
+    uint64_t ctx_uint = 0;
+
+    if (!inode)
+        return;
+
+    LOCK(&inode->lock);
+    {
+        if (__inode_ctx_get(inode, this, &ctx_uint) == 0) {
+            ctx = (posix_inode_ctx_t *)(uintptr_t)ctx_uint;
+            cache = ctx->xattr_cache;
+            ctx->xattr_cache = NULL;
+        }
+    }
+    UNLOCK(&inode->lock);
+
+    posix_xattr_cache_unref(cache);
+}
+
+static int
+posix_xattr_cache_find(struct posix_xattr_cache *cache, const char *key)
+{
+    int i = 0;
+
+    for (i = 0; i < cache->count; i++) {
+        if (strcmp(cache->values[i].name, key) == 0)
+            return i;
+    }
+
+    return -1;
+}
+
+/* Read the values of all the names in filler->list. The cache takes over
+ * the list.
+ */
+static struct posix_xattr_cache *
+posix_xattr_cache_build(posix_xattr_filler_t *filler, struct stat *stbuf)
+{
+    struct posix_xattr_cache *cache = NULL;
+    ssize_t remaining_size = 0;
+    size_t total = 0;
+    char *key = NULL;
+    int count = 0;
+    int len = 0;
+
+    remaining_size = filler->list_size;
+    for (key = filler->list; remaining_size > 0; key += len + 1) {
+        len = strlen(key);
+        remaining_size -= len + 1;
+        count++;
+    }
+    if (count > POSIX_XATTR_CACHE_MAX_KEYS)
+        return NULL;
+
+    cache = GF_CALLOC(1, sizeof(*cache) + count * sizeof(cache->values[0]),
+                      gf_posix_mt_xattr_cache_t);
+    if (!cache)
+        return NULL;
+
+    GF_ATOMIC_INIT(cache->ref, 1);
+    cache->ino = stbuf->st_ino;
+    cache->ctime_sec = stbuf->st_ctime;
+    cache->ctime_nsec = ST_CTIM_NSEC(stbuf);
+
+    remaining_size = filler->list_size;
+    for (key = filler->list; remaining_size > 0; key += len + 1) {
+        len = strlen(key);
+        remaining_size -= len + 1;
+
+        if (!gf_is_valid_xattr_namespace(key))
+            continue;
+
+        cache->values[cache->count].size = posix_xattr_get_value(
+            filler, key, &cache->values[cache->count].value);
+        if (cache->values[cache->count].size == -1) {
+            posix_xattr_cache_unref(cache);
+            return NULL;
+        }
+
+        cache->values[cache->count].name = key;
+        total += cache->values[cache->count].size;
+        cache->count++;
+
+        if (total > POSIX_XATTR_CACHE_MAX_BYTES) {
+            posix_xattr_cache_unref(cache);
+            return NULL;
+        }
+    }
+
+    cache->list = filler->list;
+    cache->list_size = filler->list_size;
+
+    return cache;
+}
+
+/* Returns a reference to the xattr snapshot of the inode being filled,
+ * taking one if there is none, and sets filler->list from it. NULL if
+ * the xattrs have to be read from the backend.
+ */
+static struct posix_xattr_cache *
+posix_xattr_cache_get(xlator_t *this, posix_xattr_filler_t *filler)
+{
+    struct posix_private *priv = this->private;
+    struct posix_xattr_cache *cache = NULL;
+    struct posix_xattr_cache *old = NULL;
+    posix_inode_ctx_t *ctx = NULL;
+    inode_t *inode = NULL;
+    struct stat stbuf = {
+        0,
+    };
+    int ret = -1;
+
+    inode = _get_filler_inode(filler);
+    if (!inode)
+        return NULL;
+
+    if (filler->real_path)
+        ret = sys_lstat(filler->real_path, &stbuf);
+    else
+        ret = sys_fstat(filler->fdnum, &stbuf);
+    if (ret != 0)
+        return NULL;
+
+    LOCK(&inode->lock);
+    {
+        if (__posix_inode_ctx_get_all(inode, this, &ctx) < 0)
+            ctx = NULL;
+        if (ctx && ctx->xattr_cache) {
+            cache = ctx->xattr_cache;
+            if (cache->ino == stbuf.st_ino &&
+                cache->ctime_sec == stbuf.st_ctime &&
+                cache->ctime_nsec == ST_CTIM_NSEC(&stbuf)) {
+                GF_ATOMIC_INC(cache->ref);
+            } else {
+                old = cache;
+                ctx->xattr_cache = NULL;
+                cache = NULL;
+            }
+        }
+    }
+    UNLOCK(&inode->lock);
+
+    posix_xattr_cache_unref(old);
+
+    if (cache) {
+        GF_ATOMIC_INC(priv->xattr_cache_hits);
+        goto out;
+    }
+
+    GF_ATOMIC_INC(priv->xattr_cache_misses);
+    if (!ctx || stbuf.st_ctime + POSIX_XATTR_CACHE_SETTLE > gf_time())
+        return NULL;
+
+    _get_list_xattr(filler);
+    if (!filler->list)
+        return NULL;
+
+    cache = posix_xattr_cache_build(filler, &stbuf);
+    if (!cache)
+        return NULL;
+
+    GF_ATOMIC_INC(cache->ref);
+    LOCK(&inode->lock);
+    {
+        old = ctx->xattr_cache;
+        ctx->xattr_cache = cache;
+    }
+    UNLOCK(&inode->lock);
+
+    posix_xattr_cache_unref(old);
+out:
+    filler->list = cache->list;
+    filler->list_size = cache->list_size;
+    return cache;
+}
+
+static int
+_posix_xattr_get_set_from_backend(posix_xattr_filler_t *filler, char *key)
+{
+    ssize_t xattr_size = -1;
+    int ret = -1;
+    int i = 0;
+    char *value = NULL;
+
+    if (!gf_is_valid_xattr_namespace(key)) {
+        goto out;
+    }
+
+    if (filler->cache) {
+        i = posix_xattr_cache_find(filler->cache, key);
+        if (i < 0)
+            goto out;
+        xattr_size = filler->cache->values[i].size;
+        value = GF_MALLOC(xattr_size + 1, gf_posix_mt_char);
+        if (!value)
+            goto out;
+        memcpy(value, filler->cache->values[i].value, xattr_size + 1);
+    } else {
+        xattr_size = posix_xattr_get_value(filler, key, &value);
+        if (xattr_size == -1)
+            goto out;
+    }
+
     ret = dict_set_bin(filler->xattr, key, value, xattr_size);
 
     if (ret < 0) {
@@ -407,17 +707,6 @@ _posix_get_marker_quota_contributions(posix_xattr_filler_t *filler, char *key)
     return ret;
 }
 
-static inode_t *
-_get_filler_inode(posix_xattr_filler_t *filler)
-{
-    if (filler->fd)
-        return filler->fd->inode;
-    else if (filler->loc && filler->loc->inode)
-        return filler->loc->inode;
-    else
-        return NULL;
-}
-
 static int
 _posix_xattr_get_set(dict_t *xattr_req, char *key, data_t *data,
                      void *xattrargs)
@@ -796,9 +1085,10 @@ out:
     return ret;
 }
 
-int
-posix_pstat(xlator_t *this, inode_t *inode, uuid_t gfid, const char *path,
-            struct iatt *buf_p, gf_boolean_t inode_locked)
+static int
+__posix_pstat(xlator_t *this, inode_t *inode, uuid_t gfid, int dirfd,
+              const char *name, const char *path, struct iatt *buf_p,
+              gf_boolean_t inode_locked)
 {
     struct stat lstatbuf = {
         0,
@@ -818,7 +1108,10 @@ posix_pstat(xlator_t *this, inode_t *inode, uuid_t gfid, const char *path,
         posix_fill_gfid_path(this, path, &stbuf);
     stbuf.ia_flags |= IATT_GFID;
 
-    ret = sys_lstat(path, &lstatbuf);
+    if (name)
+        ret = sys_fstatat(dirfd, name, &lstatbuf, AT_SYMLINK_NOFOLLOW);
+    else
+        ret = sys_lstat(path, &lstatbuf);
     if (ret == -1) {
         if (errno != ENOENT) {
             op_errno = errno;
@@ -876,34 +1169,22 @@ out:
     return ret;
 }
 
-static void
-_get_list_xattr(posix_xattr_filler_t *filler)
+int
+posix_pstat(xlator_t *this, inode_t *inode, uuid_t gfid, const char *path,
+            struct iatt *buf_p, gf_boolean_t inode_locked)
 {
-    ssize_t size = 0;
-
-    if ((!filler) || ((!filler->real_path) && (filler->fdnum < 0)))
-        goto out;
-
-    if (filler->real_path)
-        size = sys_llistxattr(filler->real_path, NULL, 0);
-    else
-        size = sys_flistxattr(filler->fdnum, NULL, 0);
-
-    if (size <= 0)
-        goto out;
-
-    filler->list = GF_CALLOC(1, size, gf_posix_mt_char);
-    if (!filler->list)
-        goto out;
-
-    if (filler->real_path)
-        size = sys_llistxattr(filler->real_path, filler->list, size);
-    else
-        size = sys_flistxattr(filler->fdnum, filler->list, size);
+    return __posix_pstat(this, inode, gfid, -1, NULL, path, buf_p,
+                         inode_locked);
+}
 
-    filler->list_size = size;
-out:
-    return;
+/* As posix_pstat(), but the entry is stat'ed as @name relative to the
+ * directory @dirfd. @path is still needed for the xattrs. */
+int
+posix_pstatat(xlator_t *this, inode_t *inode, uuid_t gfid, int dirfd,
+              const char *name, const char *path, struct iatt *buf_p)
+{
+    return __posix_pstat(this, inode, gfid, dirfd, name, path, buf_p,
+                         _gf_false);
 }
 
 static void
@@ -943,6 +1224,25 @@ _handle_list_xattr(posix_xattr_filler_t *filler)
     return;
 }
 
+/* The inode of a lookup may be a new one not linked yet, the dirty mdata
+ * is then held by the one already in the table. */
+static void
+posix_xattr_fill_flush_mdata(xlator_t *this, loc_t *loc, fd_t *fd, int fdnum,
+                             struct iatt *buf)
+{
+    inode_t *inode = fd ? fd->inode : (loc ? loc->inode : NULL);
+
+    if (!inode || !buf || gf_uuid_is_null(buf->ia_gfid))
+        return;
+
+    inode = inode_find(inode->table, buf->ia_gfid);
+    if (!inode)
+        return;
+
+    posix_mdata_flush(this, inode, fdnum);
+    inode_unref(inode);
+}
+
 dict_t *
 posix_xattr_fill(xlator_t *this, const char *real_path, loc_t *loc, fd_t *fd,
                  int fdnum, dict_t *xattr_req, struct iatt *buf)
@@ -951,6 +1251,7 @@ posix_xattr_fill(xlator_t *this, const char *real_path, loc_t *loc, fd_t *fd,
     posix_xattr_filler_t filler = {
         0,
     };
+    struct posix_private *priv = this->private;
     gf_boolean_t list = _gf_false;
 
     if (dict_get_sizen(xattr_req, "list-xattr")) {
@@ -958,6 +1259,9 @@ posix_xattr_fill(xlator_t *this, const char *real_path, loc_t *loc, fd_t *fd,
         list = _gf_true;
     }
 
+    if (list || dict_get_sizen(xattr_req, GF_XATTR_MDATA_KEY))
+        posix_xattr_fill_flush_mdata(this, loc, fd, fdnum, buf);
+
     xattr = dict_new();
     if (!xattr) {
         goto out;
@@ -971,12 +1275,18 @@ posix_xattr_fill(xlator_t *this, const char *real_path, loc_t *loc, fd_t *fd,
     filler.fd = fd;
     filler.fdnum = fdnum;
 
-    _get_list_xattr(&filler);
+    if (priv->xattr_cache)
+        filler.cache = posix_xattr_cache_get(this, &filler);
+    if (!filler.cache && !filler.list)
+        _get_list_xattr(&filler);
     dict_foreach(xattr_req, _posix_xattr_get_set, &filler);
     if (list)
         _handle_list_xattr(&filler);
 
-    GF_FREE(filler.list);
+    if (filler.cache)
+        posix_xattr_cache_unref(filler.cache);
+    else
+        GF_FREE(filler.list);
 out:
     return xattr;
 }
@@ -1076,6 +1386,156 @@ out:
     return ret;
 }
 
+/* posix_gfid_set() for a file this brick has just created through @fd:
+ * the gfid xattr cannot be there yet and the handle can be linked to the
+ * fd, which saves the lookups of the path and of the handle (two syscalls
+ * instead of seven). Anything unexpected goes the posix_gfid_set() way.
+ */
+int
+posix_gfid_set_fd(xlator_t *this, int fd, const char *path, loc_t *loc,
+                  dict_t *xattr_req, pid_t pid, int *op_errno)
+{
+    uuid_t uuid_req;
+
+    *op_errno = 0;
+
+    if (!xattr_req || dict_get_gfuuid(xattr_req, "gfid-req", &uuid_req) ||
+        gf_uuid_is_null(uuid_req))
+        goto slow;
+
+    if (sys_fsetxattr(fd, GFID_XATTR_KEY, uuid_req, 16, XATTR_CREATE) != 0)
+        goto slow;
+
+    if (posix_handle_hard_fd(this, fd, uuid_req) == 0)
+        return 0;
+
+slow:
+    return posix_gfid_set(this, path, loc, xattr_req, pid, op_errno);
+}
+
+/* Page cache left behind a stream is dropped in steps of this size, and
+ * this much of it is kept in case the stream comes back.
+ */
+#define POSIX_STREAM_WINDOW ((off_t)(8 * GF_UNIT_MB))
+
+/* Called after each read or write of @len bytes at @offset through @pfd.
+ * Once the fd has moved stream-drop-behind bytes sequentially, the pages
+ * it leaves behind are dropped from the page cache, so a backup or media
+ * stream does not push the working set of everyone else out of it.
+ * Written pages have their writeback started one window behind the
+ * stream and are dropped one window later, once they are clean.
+ *
+ * The state is updated without a lock: concurrent fops on one fd are not
+ * a stream anyway, and the worst outcome is a misplaced advice.
+ */
+void
+posix_stream_advise(xlator_t *this, struct posix_fd *pfd, off_t offset,
+                    size_t len, gf_boolean_t write)
+{
+    struct posix_private *priv = this->private;
+    uint64_t threshold = priv->stream_drop_behind;
+    off_t end = 0;
+
+    if (!threshold || (pfd->flags & O_DIRECT) || !len)
+        return;
+
+    if (offset != pfd->stream_next) {
+        pfd->stream_run = 0;
+        pfd->stream_flushed = offset;
+        pfd->stream_dropped = offset;
+    }
+
+    pfd->stream_next = offset + len;
+    pfd->stream_run += len;
+
+    if ((uint64_t)pfd->stream_run < threshold)
+        return;
+
+    if ((uint64_t)(pfd->stream_run - len) < threshold)
+        GF_ATOMIC_INC(priv->streams_detected);
+
+    if (!write) {
+        pfd->stream_flushed = pfd->stream_next;
+    } else {
+        /* all signed: a stream still within its first window, or one
+           that restarted lower, must not turn into a huge range */
+        end = pfd->stream_next - POSIX_STREAM_WINDOW;
+        if (end > pfd->stream_flushed &&
+            end - pfd->stream_flushed >= POSIX_STREAM_WINDOW) {
+#ifdef GF_LINUX_HOST_OS
+            (void)sync_file_range(pfd->fd, pfd->stream_flushed,
+                                  end - pfd->stream_flushed,
+                                  SYNC_FILE_RANGE_WRITE);
+#endif
+            pfd->stream_flushed = end;
+        }
+    }
+
+    end = pfd->stream_flushed - POSIX_STREAM_WINDOW;
+    if (end > pfd->stream_dropped &&
+        end - pfd->stream_dropped >= POSIX_STREAM_WINDOW) {
+        (void)posix_fadvise(pfd->fd, pfd->stream_dropped,
+                            end - pfd->stream_dropped, POSIX_FADV_DONTNEED);
+        pfd->stream_dropped = end;
+    }
+}
+
+/* Copies @len bytes of @fd_in at @off_in to @fd_out at @off_out and
+ * returns how many were copied, which is less than @len only when the end
+ * of the source is reached. When both ranges start on a block boundary the
+ * extents are shared with FICLONERANGE, so cloning a VM image on xfs or
+ * btrfs costs no data copy at all. Whatever the clone refuses (other
+ * filesystem, unaligned ranges, no reflink support) goes through
+ * copy_file_range(), which can stop short and is repeated.
+ */
+ssize_t
+posix_copy_range(int fd_in, off64_t off_in, int fd_out, off64_t off_out,
+                 size_t len, uint32_t flags)
+{
+    ssize_t ret = 0;
+    size_t done = 0;
+#ifdef HAVE_FICLONERANGE
+    struct file_clone_range range = {
+        0,
+    };
+    struct stat st = {
+        0,
+    };
+
+    if (!flags && (sys_fstat(fd_in, &st) == 0) && (st.st_blksize > 0)) {
+        if (off_in >= st.st_size)
+            return 0;
+        if (len > st.st_size - off_in)
+            len = st.st_size - off_in;
+
+        if (!(off_in % st.st_blksize) && !(off_out % st.st_blksize) &&
+            (!(len % st.st_blksize) || (off_in + len == st.st_size))) {
+            range.src_fd = fd_in;
+            range.src_offset = off_in;
+            range.src_length = len;
+            range.dest_offset = off_out;
+            if (ioctl(fd_out, FICLONERANGE, &range) == 0)
+                return len;
+        }
+    }
+#endif
+
+    while (done < len) {
+        ret = sys_copy_file_range(fd_in, &off_in, fd_out, &off_out, len - done,
+                                  flags);
+        if (ret < 0) {
+            if (done)
+                break;
+            return -1;
+        }
+        if (ret == 0)
+            break;
+        done += ret;
+    }
+
+    return done;
+}
+
 #ifdef HAVE_SYS_ACL_H
 static int
 posix_pacl_set(const char *path, int fdnum, const char *key, const char *acl_s)
@@ -2480,10 +2940,12 @@ posix_fsyncer_process(xlator_t *this, call_stub_t *stub, gf_boolean_t do_fsync)
     }
 
     if (do_fsync && pfd) {
-        if (stub->args.datasync)
+        if (stub->args.datasync) {
             ret = sys_fdatasync(pfd->fd);
-        else
+        } else {
+            posix_mdata_flush(this, stub->args.fd->inode, pfd->fd);
             ret = sys_fsync(pfd->fd);
+        }
     } else {
         ret = 0;
     }
@@ -2511,6 +2973,201 @@ posix_fsyncer_syncfs(xlator_t *this, struct list_head *head)
         (void)gf_syncfs(pfd->fd);
 }
 
+/* Group commit: the fsyncs of a batch are folded into one per inode, the
+ * folded fsyncs run in parallel synctasks, and the whole batch is answered
+ * once the last of them is done.
+ */
+#define POSIX_GROUP_COMMIT_WORKERS 16
+#define POSIX_GROUP_COMMIT_MAX_DELAY_USEC 1000
+
+struct posix_fsync_group {
+    inode_t *inode;
+    int fd;
+    gf_boolean_t datasync; /* all of the waiters asked for fdatasync */
+    int op_ret;
+    int op_errno;
+    struct list_head stubs;
+};
+
+struct posix_fsync_batch {
+    xlator_t *this;
+    struct posix_fsync_group *groups;
+    int count;
+    int next;
+    gf_lock_t lock;
+    syncbarrier_t barrier;
+};
+
+static int
+posix_fsync_group_worker(void *data)
+{
+    struct posix_fsync_batch *batch = data;
+    struct posix_fsync_group *group = NULL;
+    int i = 0;
+
+    for (;;) {
+        LOCK(&batch->lock);
+        {
+            i = batch->next++;
+        }
+        UNLOCK(&batch->lock);
+
+        if (i >= batch->count)
+            break;
+
+        group = &batch->groups[i];
+        if (group->datasync) {
+            group->op_ret = sys_fdatasync(group->fd);
+        } else {
+            posix_mdata_flush(batch->this, group->inode, group->fd);
+            group->op_ret = sys_fsync(group->fd);
+        }
+        group->op_errno = (group->op_ret == -1) ? errno : 0;
+    }
+
+    return 0;
+}
+
+static int
+posix_fsync_group_worker_done(int ret, call_frame_t *frame, void *data)
+{
+    struct posix_fsync_batch *batch = data;
+
+    syncbarrier_wake(&batch->barrier);
+
+    return 0;
+}
+
+/* Longest a batch waits for more fsyncs, in microseconds. */
+uint32_t
+posix_group_commit_cap(struct posix_private *priv)
+{
+    if (priv->batch_fsync_delay_usec)
+        return priv->batch_fsync_delay_usec;
+
+    return POSIX_GROUP_COMMIT_MAX_DELAY_USEC;
+}
+
+/* Time to wait for more fsyncs before starting a batch: about one arrival
+ * gap if they come in faster than the cap, nothing if they are sparse.
+ */
+static uint64_t
+posix_group_commit_delay(struct posix_private *priv)
+{
+    if (priv->fsync_gap_usec >= posix_group_commit_cap(priv))
+        return 0;
+
+    return priv->fsync_gap_usec;
+}
+
+static void
+posix_fsyncer_group_commit(xlator_t *this)
+{
+    struct posix_private *priv = this->private;
+    struct posix_fsync_group *groups = NULL;
+    struct posix_fsync_group *group = NULL;
+    struct posix_fsync_batch batch;
+    struct posix_fd *pfd = NULL;
+    call_stub_t *stub = NULL;
+    call_stub_t *tmp = NULL;
+    struct list_head list;
+    uint64_t delay = 0;
+    int ngroups = 0;
+    int workers = 0;
+    int launched = 0;
+    int count = 0;
+    int i = 0;
+
+    pthread_mutex_lock(&priv->fsync_mutex);
+    {
+        while (list_empty(&priv->fsyncs))
+            pthread_cond_wait(&priv->fsync_cond, &priv->fsync_mutex);
+        delay = posix_group_commit_delay(priv);
+    }
+    pthread_mutex_unlock(&priv->fsync_mutex);
+
+    if (delay)
+        gf_nanosleep(delay * GF_US_IN_NS);
+
+    INIT_LIST_HEAD(&list);
+    count = posix_fsyncer_pick(this, &list);
+
+    groups = GF_CALLOC(count, sizeof(*groups), gf_posix_mt_fsync_group_t);
+    if (!groups) {
+        list_for_each_entry_safe(stub, tmp, &list, list)
+        {
+            list_del_init(&stub->list);
+            posix_fsyncer_process(this, stub, _gf_true);
+        }
+        return;
+    }
+
+    list_for_each_entry_safe(stub, tmp, &list, list)
+    {
+        list_del_init(&stub->list);
+
+        if (posix_fd_ctx_get(stub->args.fd, this, &pfd, NULL) < 0 || !pfd) {
+            call_unwind_error(stub, -1, EBADF);
+            continue;
+        }
+
+        for (i = 0; i < ngroups; i++) {
+            if (groups[i].inode == stub->args.fd->inode)
+                break;
+        }
+
+        group = &groups[i];
+        if (i == ngroups) {
+            group->inode = stub->args.fd->inode;
+            group->fd = pfd->fd;
+            group->datasync = _gf_true;
+            INIT_LIST_HEAD(&group->stubs);
+            ngroups++;
+        }
+        if (!stub->args.datasync)
+            group->datasync = _gf_false;
+        list_add_tail(&stub->list, &group->stubs);
+    }
+
+    batch.this = this;
+    batch.groups = groups;
+    batch.count = ngroups;
+    batch.next = 0;
+    LOCK_INIT(&batch.lock);
+
+    workers = min(ngroups, POSIX_GROUP_COMMIT_WORKERS);
+    if (workers > 1 && syncbarrier_init(&batch.barrier) == 0) {
+        for (i = 0; i < workers - 1; i++) {
+            if (synctask_new(this->ctx->env, posix_fsync_group_worker,
+                             posix_fsync_group_worker_done, NULL,
+                             &batch) == 0)
+                launched++;
+        }
+        posix_fsync_group_worker(&batch);
+        syncbarrier_wait(&batch.barrier, launched);
+        syncbarrier_destroy(&batch.barrier);
+    } else {
+        posix_fsync_group_worker(&batch);
+    }
+    LOCK_DESTROY(&batch.lock);
+
+    for (i = 0; i < ngroups; i++) {
+        list_for_each_entry_safe(stub, tmp, &groups[i].stubs, list)
+        {
+            list_del_init(&stub->list);
+            call_unwind_error(stub, groups[i].op_ret, groups[i].op_errno);
+        }
+    }
+
+    GF_ATOMIC_INC(priv->fsync_batches);
+    GF_ATOMIC_ADD(priv->fsync_groups, ngroups);
+
+    gf_msg_debug(this->name, 0, "group commit of %d fsyncs as %d", count,
+                 ngroups);
+
+    GF_FREE(groups);
+}
+
 void *
 posix_fsyncer(void *d)
 {
@@ -2525,6 +3182,11 @@ posix_fsyncer(void *d)
     priv = this->private;
 
     for (;;) {
+        if (priv->batch_fsync_mode == BATCH_GROUP_COMMIT) {
+            posix_fsyncer_group_commit(this);
+            continue;
+        }
+
         INIT_LIST_HEAD(&list);
 
         count = posix_fsyncer_pick(this, &list);
@@ -2536,6 +3198,7 @@ posix_fsyncer(void *d)
         switch (priv->batch_fsync_mode) {
             case BATCH_NONE:
             case BATCH_REVERSE_FSYNC:
+            case BATCH_GROUP_COMMIT:
                 break;
             case BATCH_SYNCFS:
             case BATCH_SYNCFS_SINGLE_FSYNC:
@@ -2561,6 +3224,204 @@ posix_fsyncer(void *d)
     }
 }
 
+/* Files are freed this much at a time by the reclaimer. The rate limit
+ * is enforced in tokens of one byte each, generated POSIX_RECLAIM_TICKS
+ * times per second.
+ */
+#define POSIX_RECLAIM_CHUNK (32 * GF_UNIT_MB)
+#define POSIX_RECLAIM_TICKS 10
+
+struct posix_reclaim {
+    struct list_head list;
+    uuid_t gfid;
+    int fd; /* the last reference to the unlinked file */
+    off_t size;
+    off_t offset; /* freed up to here */
+};
+
+/* Takes over @fd, open on an unlinked file, and frees its blocks in
+ * chunks in the background. Returns -1 if the caller has to close @fd.
+ */
+int
+posix_reclaim_queue(xlator_t *this, int fd, uuid_t gfid)
+{
+    struct posix_private *priv = this->private;
+    struct posix_reclaim *rcl = NULL;
+    struct stat stbuf = {
+        0,
+    };
+
+    /* still linked elsewhere: closing it would free nothing */
+    if (sys_fstat(fd, &stbuf) != 0 || stbuf.st_nlink != 0)
+        return -1;
+
+    if ((uint64_t)stbuf.st_blocks * 512 < priv->reclaim_threshold)
+        return -1;
+
+    rcl = GF_CALLOC(1, sizeof(*rcl), gf_posix_mt_reclaim_t);
+    if (!rcl)
+        return -1;
+
+    INIT_LIST_HEAD(&rcl->list);
+    gf_uuid_copy(rcl->gfid, gfid);
+    rcl->fd = fd;
+    rcl->size = stbuf.st_size;
+
+    pthread_mutex_lock(&priv->reclaim_lock);
+    {
+        list_add_tail(&rcl->list, &priv->reclaim_queue);
+        priv->reclaim_count++;
+        priv->reclaim_pending += rcl->size;
+        pthread_cond_signal(&priv->reclaim_cond);
+    }
+    pthread_mutex_unlock(&priv->reclaim_lock);
+
+    return 0;
+}
+
+int
+posix_reclaim_set_rate(xlator_t *this)
+{
+    struct posix_private *priv = this->private;
+    tbf_opspec_t spec = {
+        0,
+    };
+
+    spec.op = TBF_OP_RECLAIM;
+    spec.token_gen_interval = 1000000 / POSIX_RECLAIM_TICKS; /* usecs */
+    spec.rate = priv->reclaim_rate / POSIX_RECLAIM_TICKS;
+    if (priv->reclaim_rate && !spec.rate)
+        spec.rate = 1;
+    /* a chunk must always fit, or it would wait forever */
+    spec.maxlimit = max(priv->reclaim_rate, (uint64_t)POSIX_RECLAIM_CHUNK);
+
+    return tbf_mod(priv->reclaim_tbf, &spec);
+}
+
+/* Punch out the next chunk holding data. Returns 1 once the whole file
+ * is freed, -1 if it cannot be punched.
+ */
+static int
+posix_reclaim_chunk(xlator_t *this, struct posix_reclaim *rcl, off_t *freed)
+{
+    struct posix_private *priv = this->private;
+    off_t offset = 0;
+    off_t len = 0;
+
+    offset = sys_lseek(rcl->fd, rcl->offset, SEEK_DATA);
+    if (offset < 0 || offset >= rcl->size) {
+        *freed = rcl->size - rcl->offset;
+        return 1;
+    }
+
+    len = min(rcl->size - offset, (off_t)POSIX_RECLAIM_CHUNK);
+    tbf_throttle(priv->reclaim_tbf, TBF_OP_RECLAIM, len);
+
+#ifdef FALLOC_FL_PUNCH_HOLE
+    if (sys_fallocate(rcl->fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+                      offset, len) != 0)
+        return -1;
+#else
+    return -1;
+#endif
+
+    *freed = offset + len - rcl->offset;
+    rcl->offset = offset + len;
+
+    return (rcl->offset >= rcl->size);
+}
+
+void *
+posix_reclaimer(void *d)
+{
+    xlator_t *this = d;
+    struct posix_private *priv = this->private;
+    struct posix_reclaim *rcl = NULL;
+    struct posix_reclaim *tmp = NULL;
+    off_t freed = 0;
+    int ret = 0;
+
+    for (;;) {
+        pthread_mutex_lock(&priv->reclaim_lock);
+        {
+            while (list_empty(&priv->reclaim_queue) && !priv->reclaimer_exit)
+                pthread_cond_wait(&priv->reclaim_cond, &priv->reclaim_lock);
+
+            if (!priv->reclaimer_exit)
+                rcl = list_first_entry(&priv->reclaim_queue,
+                                       struct posix_reclaim, list);
+            priv->reclaim_current = rcl;
+        }
+        pthread_mutex_unlock(&priv->reclaim_lock);
+
+        if (!rcl)
+            break;
+
+        freed = 0;
+        ret = posix_reclaim_chunk(this, rcl, &freed);
+        if (ret < 0) {
+            gf_msg(this->name, GF_LOG_WARNING, errno, P_MSG_UNLINK_FAILED,
+                   "cannot free gfid %s in chunks, freeing it at once",
+                   uuid_utoa(rcl->gfid));
+            freed = rcl->size - rcl->offset;
+        }
+
+        pthread_mutex_lock(&priv->reclaim_lock);
+        {
+            priv->reclaim_pending -= freed;
+            priv->reclaim_freed += freed;
+            if (ret != 0) {
+                list_del_init(&rcl->list);
+                priv->reclaim_count--;
+                priv->reclaim_current = NULL;
+            }
+        }
+        pthread_mutex_unlock(&priv->reclaim_lock);
+
+        if (ret != 0) {
+            sys_close(rcl->fd);
+            GF_FREE(rcl);
+        }
+        rcl = NULL;
+    }
+
+    /* whatever is left is freed by the close, as without the reclaimer */
+    list_for_each_entry_safe(rcl, tmp, &priv->reclaim_queue, list)
+    {
+        list_del_init(&rcl->list);
+        sys_close(rcl->fd);
+        GF_FREE(rcl);
+    }
+    priv->reclaim_count = 0;
+    priv->reclaim_pending = 0;
+
+    return NULL;
+}
+
+void
+posix_reclaim_dump(xlator_t *this)
+{
+    struct posix_private *priv = this->private;
+
+    pthread_mutex_lock(&priv->reclaim_lock);
+    {
+        gf_proc_dump_write("reclaim_queued", "%u", priv->reclaim_count);
+        gf_proc_dump_write("reclaim_pending_bytes", "%" PRIu64,
+                           priv->reclaim_pending);
+        gf_proc_dump_write("reclaim_freed_bytes", "%" PRIu64,
+                           priv->reclaim_freed);
+        if (priv->reclaim_current) {
+            gf_proc_dump_write("reclaim_current", "%s",
+                               uuid_utoa(priv->reclaim_current->gfid));
+            gf_proc_dump_write("reclaim_current_progress",
+                               "%" PRId64 "/%" PRId64,
+                               (int64_t)priv->reclaim_current->offset,
+                               (int64_t)priv->reclaim_current->size);
+        }
+    }
+    pthread_mutex_unlock(&priv->reclaim_lock);
+}
+
 /**
  * TODO: move fd/inode interfaces into a single routine..
  */
@@ -2859,6 +3720,7 @@ __posix_inode_ctx_get(inode_t *inode, xlator_t *this)
     pthread_mutex_init(&ctx_p->xattrop_lock, NULL);
     pthread_mutex_init(&ctx_p->write_atomic_lock, NULL);
     pthread_mutex_init(&ctx_p->pgfid_lock, NULL);
+    pthread_rwlock_init(&ctx_p->prealloc_lock, NULL);
 
     ctx_uint = (uint64_t)(uintptr_t)ctx_p;
     ret = __inode_ctx_set(inode, this, &ctx_uint);
@@ -2866,6 +3728,7 @@ __posix_inode_ctx_get(inode_t *inode, xlator_t *this)
         pthread_mutex_destroy(&ctx_p->xattrop_lock);
         pthread_mutex_destroy(&ctx_p->write_atomic_lock);
         pthread_mutex_destroy(&ctx_p->pgfid_lock);
+        pthread_rwlock_destroy(&ctx_p->prealloc_lock);
         GF_FREE(ctx_p);
         return NULL;
     }
@@ -47,6 +47,7 @@
 #include <glusterfs/statedump.h>
 #include <glusterfs/locking.h>
 #include <glusterfs/timer.h>
+#include <glusterfs/syncop.h>
 #include "glusterfs3-xdr.h"
 #include <glusterfs/glusterfs-acl.h>
 #include "posix-messages.h"
@@ -696,6 +697,7 @@ posix_do_fallocate(call_frame_t *frame, xlator_t *this, fd_t *fd, int32_t flags,
     int32_t op_errno = 0;
     struct posix_fd *pfd = NULL;
     gf_boolean_t locked = _gf_false;
+    gf_boolean_t prealloc_locked = _gf_false;
     posix_inode_ctx_t *ctx = NULL;
     struct posix_private *priv = NULL;
     gf_boolean_t check_space_error = _gf_false;
@@ -738,6 +740,9 @@ overwrite:
         goto out;
     }
 
+    prealloc_locked = _gf_true;
+    pthread_rwlock_rdlock(&ctx->prealloc_lock);
+
     if (xdata && dict_get(xdata, GLUSTERFS_WRITE_UPDATE_ATOMIC)) {
         locked = _gf_true;
         pthread_mutex_lock(&ctx->write_atomic_lock);
@@ -787,6 +792,10 @@ unlock:
         pthread_mutex_unlock(&ctx->write_atomic_lock);
         locked = _gf_false;
     }
+    if (prealloc_locked) {
+        pthread_rwlock_unlock(&ctx->prealloc_lock);
+        prealloc_locked = _gf_false;
+    }
 
     if (op_errno == ENOSPC && priv->disk_space_full && !check_space_error) {
 #ifdef FALLOC_FL_KEEP_SIZE
@@ -944,6 +953,7 @@ posix_do_zerofill(call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
     int32_t flags = 0;
     struct posix_fd *pfd = NULL;
     gf_boolean_t locked = _gf_false;
+    gf_boolean_t prealloc_locked = _gf_false;
     posix_inode_ctx_t *ctx = NULL;
 
     DECLARE_OLD_FS_ID_VAR;
@@ -966,6 +976,9 @@ posix_do_zerofill(call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
         goto out;
     }
 
+    prealloc_locked = _gf_true;
+    pthread_rwlock_rdlock(&ctx->prealloc_lock);
+
     if (dict_get(xdata, GLUSTERFS_WRITE_UPDATE_ATOMIC)) {
         locked = _gf_true;
         pthread_mutex_lock(&ctx->write_atomic_lock);
@@ -1043,6 +1056,8 @@ out:
         pthread_mutex_unlock(&ctx->write_atomic_lock);
         locked = _gf_false;
     }
+    if (prealloc_locked)
+        pthread_rwlock_unlock(&ctx->prealloc_lock);
     SET_TO_OLD_FS_ID();
 
     return ret;
@@ -1742,6 +1757,7 @@ posix_readv(call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
     }
 
     GF_ATOMIC_ADD(priv->read_value, op_ret);
+    posix_stream_advise(this, pfd, offset, op_ret, _gf_false);
 
     vec.iov_base = iobuf->ptr;
     vec.iov_len = op_ret;
@@ -1940,6 +1956,7 @@ posix_writev(call_frame_t *frame, xlator_t *this, fd_t *fd,
     dict_t *rsp_xdata = NULL;
     int is_append = 0;
     gf_boolean_t locked = _gf_false;
+    gf_boolean_t prealloc_locked = _gf_false;
     gf_boolean_t write_append = _gf_false;
     gf_boolean_t update_atomic = _gf_false;
     posix_inode_ctx_t *ctx = NULL;
@@ -2019,6 +2036,9 @@ overwrite:
         goto out;
     }
 
+    prealloc_locked = _gf_true;
+    pthread_rwlock_rdlock(&ctx->prealloc_lock);
+
     if (write_append || update_atomic) {
         locked = _gf_true;
         pthread_mutex_lock(&ctx->write_atomic_lock);
@@ -2098,6 +2118,7 @@ overwrite:
     }
 
     GF_ATOMIC_ADD(priv->write_value, op_ret);
+    posix_stream_advise(this, pfd, offset, op_ret, _gf_true);
 
 out:
 
@@ -2105,6 +2126,10 @@ out:
         pthread_mutex_unlock(&ctx->write_atomic_lock);
         locked = _gf_false;
     }
+    if (prealloc_locked) {
+        pthread_rwlock_unlock(&ctx->prealloc_lock);
+        prealloc_locked = _gf_false;
+    }
 
     if (op_errno == ENOSPC && priv->disk_space_full && !check_space_error) {
         ret = posix_fd_ctx_get(fd, this, &pfd, &op_errno);
@@ -2169,6 +2194,7 @@ posix_copy_file_range(call_frame_t *frame, xlator_t *this, fd_t *fd_in,
     dict_t *rsp_xdata = NULL;
     int is_append = 0;
     gf_boolean_t locked = _gf_false;
+    gf_boolean_t prealloc_locked = _gf_false;
     gf_boolean_t update_atomic = _gf_false;
     posix_inode_ctx_t *ctx = NULL;
     char in_uuid_str[64] = {0}, out_uuid_str[64] = {0};
@@ -2253,6 +2279,9 @@ posix_copy_file_range(call_frame_t *frame, xlator_t *this, fd_t *fd_in,
         goto out;
     }
 
+    prealloc_locked = _gf_true;
+    pthread_rwlock_rdlock(&ctx->prealloc_lock);
+
     if (update_atomic) {
         ret = pthread_mutex_lock(&ctx->write_atomic_lock);
         if (!ret)
@@ -2290,21 +2319,7 @@ posix_copy_file_range(call_frame_t *frame, xlator_t *this, fd_t *fd_in,
         }
     }
 
-    /*
-     * NOTE: This is just doing a single execution of copy_file_range
-     *       system call. If the returned value of this system call is less
-     *       than len, then should we keep doing it in a for loop until the
-     *       copy_file_range of all the len bytes is done?
-     *       Check the  example program provided in the man page of
-     *       copy_file_range.
-     *       If so, then a separate variables for both off_in and off_out
-     *       should be used which are initialized to off_in and off_out
-     *       that this function call receives, but then advanced by the
-     *       value returned by sys_copy_file_range and then use that as
-     *       off_in and off_out for next instance of copy_file_range execution.
-     */
-    op_ret = sys_copy_file_range(_fd_in, &off_in, _fd_out, &off_out, len,
-                                 flags);
+    op_ret = posix_copy_range(_fd_in, off_in, _fd_out, off_out, len, flags);
 
     if (op_ret < 0) {
         op_errno = errno;
@@ -2399,6 +2414,8 @@ out:
         pthread_mutex_unlock(&ctx->write_atomic_lock);
         locked = _gf_false;
     }
+    if (prealloc_locked)
+        pthread_rwlock_unlock(&ctx->prealloc_lock);
 
     STACK_UNWIND_STRICT(copy_file_range, frame, op_ret, op_errno, &stbuf,
                         &preop_dst, &postop_dst, rsp_xdata);
@@ -2554,6 +2571,9 @@ posix_batch_fsync(call_frame_t *frame, xlator_t *this, fd_t *fd, int datasync,
 {
     call_stub_t *stub = NULL;
     struct posix_private *priv = NULL;
+    struct timespec now;
+    int64_t gap = 0;
+    uint32_t cap = 0;
 
     priv = this->private;
 
@@ -2563,11 +2583,32 @@ posix_batch_fsync(call_frame_t *frame, xlator_t *this, fd_t *fd, int datasync,
         return 0;
     }
 
+    timespec_now(&now);
+
     pthread_mutex_lock(&priv->fsync_mutex);
     {
         list_add_tail(&stub->list, &priv->fsyncs);
         priv->fsync_queue_count++;
         pthread_cond_signal(&priv->fsync_cond);
+
+        /* Smoothed arrival gap, for the group-commit delay. A sample
+           longer than the cap only says the fsyncs are sparse, so it is
+           clamped there and one long pause cannot keep batching off for
+           the next burst. The first arrival has no gap, it starts as
+           sparse. */
+        cap = posix_group_commit_cap(priv);
+        if (!priv->fsync_last.tv_sec && !priv->fsync_last.tv_nsec) {
+            priv->fsync_gap_usec = cap;
+        } else {
+            gap = gf_tsdiff(&priv->fsync_last, &now) / 1000;
+            if (gap > cap)
+                gap = cap;
+            if (gap < 0)
+                gap = 0;
+            gap += 7 * (int64_t)priv->fsync_gap_usec;
+            priv->fsync_gap_usec = gap / 8;
+        }
+        priv->fsync_last = now;
     }
     pthread_mutex_unlock(&priv->fsync_mutex);
 
@@ -2640,6 +2681,7 @@ posix_fsync(call_frame_t *frame, xlator_t *this, fd_t *fd, int32_t datasync,
             goto out;
         }
     } else {
+        posix_mdata_flush(this, fd->inode, _fd);
         op_ret = sys_fsync(_fd);
         if (op_ret == -1) {
             op_errno = errno;
@@ -2752,6 +2794,8 @@ posix_setxattr(call_frame_t *frame, xlator_t *this, loc_t *loc, dict_t *dict,
         goto out;
     }
 
+    posix_xattr_cache_invalidate(this, loc->inode);
+
     ret = dict_get_mdata(dict, CTIME_MDATA_XDATA_KEY, &mdata_iatt);
     if (ret == 0) {
         /* This is initiated by lookup when ctime feature is enabled to create
@@ -3563,6 +3607,8 @@ posix_getxattr(call_frame_t *frame, xlator_t *this, loc_t *loc,
         goto out;
     }
 
+    posix_mdata_flush_key(this, loc->inode, -1, name);
+
     if (name && posix_is_gfid2path_xattr(name)) {
         op_ret = -1;
         op_errno = ENOATTR;
@@ -4077,6 +4123,7 @@ posix_fgetxattr(call_frame_t *frame, xlator_t *this, fd_t *fd, const char *name,
     }
 
     _fd = pfd->fd;
+    posix_mdata_flush_key(this, fd->inode, _fd, name);
 
     /* Get the total size */
     dict = dict_new();
@@ -4389,6 +4436,8 @@ posix_fsetxattr(call_frame_t *frame, xlator_t *this, fd_t *fd, dict_t *dict,
     }
     _fd = pfd->fd;
 
+    posix_xattr_cache_invalidate(this, fd->inode);
+
     ret = posix_fdstat(this, fd->inode, pfd->fd, &preop);
     if (ret == -1) {
         op_errno = errno;
@@ -4555,6 +4604,8 @@ posix_common_removexattr(call_frame_t *frame, loc_t *loc, fd_t *fd,
         inode = fd->inode;
     }
 
+    posix_xattr_cache_invalidate(this, inode);
+
     if (posix_is_gfid2path_xattr(name)) {
         op_ret = -1;
         *op_errno = ENOATTR;
@@ -5111,6 +5162,7 @@ do_xattrop(call_frame_t *frame, xlator_t *this, loc_t *loc, fd_t *fd,
 
     op_ret = dict_foreach(xattr, _posix_handle_xattr_keyvalue_pair, &filler);
     op_errno = filler.op_errno;
+    posix_xattr_cache_invalidate(this, inode);
     if (op_ret < 0)
         goto out;
 
@@ -5216,6 +5268,8 @@ posix_ftruncate(call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
     int ret = -1;
     struct posix_private *priv = NULL;
     dict_t *rsp_xdata = NULL;
+    posix_inode_ctx_t *ctx = NULL;
+    gf_boolean_t trim = _gf_false;
 
     DECLARE_OLD_FS_ID_VAR;
     SET_FS_ID(frame->root->uid, frame->root->gid);
@@ -5236,6 +5290,17 @@ posix_ftruncate(call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
 
     _fd = pfd->fd;
 
+    /* The size check and the truncate must not be split by a write past
+       the end, from this client or any other, which would be cut off. */
+    if (xdata && dict_get(xdata, GLUSTERFS_TRIM_PREALLOC)) {
+        if (posix_inode_ctx_get_all(fd->inode, this, &ctx) < 0) {
+            op_errno = ENOMEM;
+            goto out;
+        }
+        trim = _gf_true;
+        pthread_rwlock_wrlock(&ctx->prealloc_lock);
+    }
+
     op_ret = posix_fdstat(this, fd->inode, _fd, &preop);
     if (op_ret == -1) {
         op_errno = errno;
@@ -5244,6 +5309,26 @@ posix_ftruncate(call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
         goto out;
     }
 
+    if (trim) {
+        postop = preop;
+        /* written to since, the blocks past the end are in use */
+        if (preop.ia_size != offset)
+            goto out;
+
+        op_ret = sys_ftruncate(_fd, offset);
+        if (op_ret == -1) {
+            op_errno = errno;
+            goto out;
+        }
+
+        /* the data did not change, neither do the times seen by the
+           clients */
+        op_ret = posix_fdstat(this, fd->inode, _fd, &postop);
+        if (op_ret == -1)
+            op_errno = errno;
+        goto out;
+    }
+
     if (xdata) {
         op_ret = posix_cs_maintenance(this, fd, NULL, &_fd, &preop, NULL, xdata,
                                       &rsp_xdata, _gf_false);
@@ -5278,6 +5363,9 @@ posix_ftruncate(call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
     op_ret = 0;
 
 out:
+    if (trim)
+        pthread_rwlock_unlock(&ctx->prealloc_lock);
+
     SET_TO_OLD_FS_ID();
 
     STACK_UNWIND_STRICT(ftruncate, frame, op_ret, op_errno, &preop, &postop,
@@ -5632,82 +5720,220 @@ posix_entry_xattr_fill(xlator_t *this, inode_t *inode, fd_t *fd,
     return posix_xattr_fill(this, entry_path, &tmp_loc, NULL, -1, dict, stbuf);
 }
 
-int
-posix_readdirp_fill(xlator_t *this, fd_t *fd, gf_dirent_t *entries,
-                    dict_t *dict)
+/* Fill in the stat, inode and xattrs of one entry. @hpath holds the
+ * handle path of the directory, followed by a '/' at @len. */
+static void
+posix_readdirp_fill_entry(xlator_t *this, fd_t *fd, int dirfd,
+                          gf_dirent_t *entry, dict_t *dict, char *hpath,
+                          int len)
 {
-    gf_dirent_t *entry = NULL;
-    inode_table_t *itable = NULL;
+    inode_table_t *itable = fd->inode->table;
     inode_t *inode = NULL;
-    char *hpath = NULL;
-    int len = 0;
     struct iatt stbuf = {
         0,
     };
     uuid_t gfid;
     int ret = -1;
 
-    if (list_empty(&entries->list))
-        return 0;
+    inode = inode_grep(itable, fd->inode, entry->d_name);
+    if (inode)
+        gf_uuid_copy(gfid, inode->gfid);
+    else
+        bzero(gfid, 16);
 
-    itable = fd->inode->table;
+    strcpy(&hpath[len + 1], entry->d_name);
+
+    if (dirfd >= 0)
+        ret = posix_pstatat(this, inode, gfid, dirfd, entry->d_name, hpath,
+                            &stbuf);
+    else
+        ret = posix_pstat(this, inode, gfid, hpath, &stbuf, _gf_false);
+
+    if (ret == -1) {
+        if (inode)
+            inode_unref(inode);
+        return;
+    }
+
+    posix_update_iatt_buf(&stbuf, -1, hpath, dict);
+
+    if (!inode)
+        inode = inode_find(itable, stbuf.ia_gfid);
+
+    if (!inode)
+        inode = inode_new(itable);
+
+    entry->inode = inode;
+
+    if (dict) {
+        entry->dict = posix_entry_xattr_fill(this, entry->inode, fd, hpath,
+                                             dict, &stbuf);
+    }
+
+    entry->d_stat = stbuf;
+    if (stbuf.ia_ino)
+        entry->d_ino = stbuf.ia_ino;
+
+    if (entry->d_type == DT_UNKNOWN && !IA_ISINVAL(stbuf.ia_type)) {
+        /* The platform supports d_type but the underlying
+           filesystem doesn't. We set d_type to the correct
+           value from ia_type */
+        entry->d_type = gf_d_type_from_ia_type(stbuf.ia_type);
+    }
+}
+
+/* Entries filled by one synctask when parallel-readdirp is on. Below two
+ * batches, a reply is filled by the fop thread alone. */
+#define POSIX_READDIRP_BATCH 64
+
+struct posix_readdirp_batch {
+    xlator_t *this;
+    fd_t *fd;
+    dict_t *dict;
+    int dirfd;
+    const char *hpath; /* handle path of the directory */
+    int len;
+    gf_dirent_t **entries;
+    int count;
+    syncbarrier_t *barrier;
+};
+
+static int
+posix_readdirp_batch_fill(void *data)
+{
+    struct posix_readdirp_batch *batch = data;
+    char *hpath = NULL;
+    int i = 0;
 
     hpath = alloca(PATH_MAX);
-    len = posix_handle_path(this, fd->inode->gfid, NULL, hpath, PATH_MAX);
-    if (len <= 0) {
-        gf_msg(this->name, GF_LOG_WARNING, 0, P_MSG_HANDLEPATH_FAILED,
-               "Failed to create handle path, fd=%p, gfid=%s", fd,
-               uuid_utoa(fd->inode->gfid));
+    memcpy(hpath, batch->hpath, batch->len + 1);
+
+    for (i = 0; i < batch->count; i++)
+        posix_readdirp_fill_entry(batch->this, batch->fd, batch->dirfd,
+                                  batch->entries[i], batch->dict, hpath,
+                                  batch->len);
+
+    return 0;
+}
+
+static int
+posix_readdirp_batch_done(int ret, call_frame_t *frame, void *data)
+{
+    struct posix_readdirp_batch *batch = data;
+
+    syncbarrier_wake(batch->barrier);
+
+    return 0;
+}
+
+static int
+posix_readdirp_fill_parallel(xlator_t *this, fd_t *fd, int dirfd,
+                             gf_dirent_t *entries, int count, dict_t *dict,
+                             char *hpath, int len)
+{
+    struct posix_readdirp_batch *batches = NULL;
+    gf_dirent_t **array = NULL;
+    gf_dirent_t *entry = NULL;
+    syncbarrier_t barrier;
+    int nbatches = 0;
+    int launched = 0;
+    int i = 0;
+
+    /* On the global thread pool the synctasks would be queued to the
+     * workers, this thread being one of them. Waiting for them here could
+     * take every worker with a few large readdirps, and nothing would be
+     * left to run the batches: fill the reply inline then. */
+    if (this->ctx->env->async)
+        return -1;
+
+    nbatches = (count + POSIX_READDIRP_BATCH - 1) / POSIX_READDIRP_BATCH;
+
+    array = GF_MALLOC(count * sizeof(*array), gf_posix_mt_readdirp_batch_t);
+    batches = GF_CALLOC(nbatches, sizeof(*batches),
+                        gf_posix_mt_readdirp_batch_t);
+    if (!array || !batches || syncbarrier_init(&barrier)) {
+        GF_FREE(array);
+        GF_FREE(batches);
         return -1;
     }
-    len = strlen(hpath);
-    hpath[len] = '/';
 
     list_for_each_entry(entry, &entries->list, list)
     {
-        inode = inode_grep(fd->inode->table, fd->inode, entry->d_name);
-        if (inode)
-            gf_uuid_copy(gfid, inode->gfid);
+        array[i++] = entry;
+    }
+
+    for (i = 0; i < nbatches; i++) {
+        batches[i].this = this;
+        batches[i].fd = fd;
+        batches[i].dict = dict;
+        batches[i].dirfd = dirfd;
+        batches[i].hpath = hpath;
+        batches[i].len = len;
+        batches[i].entries = &array[i * POSIX_READDIRP_BATCH];
+        batches[i].count = min(POSIX_READDIRP_BATCH,
+                               count - i * POSIX_READDIRP_BATCH);
+        batches[i].barrier = &barrier;
+    }
+
+    /* The last batch is ours, and so is any the syncenv refuses. */
+    for (i = 0; i < nbatches - 1; i++) {
+        if (synctask_new(this->ctx->env, posix_readdirp_batch_fill,
+                         posix_readdirp_batch_done, NULL, &batches[i]) == 0)
+            launched++;
         else
-            bzero(gfid, 16);
-
-        strcpy(&hpath[len + 1], entry->d_name);
+            posix_readdirp_batch_fill(&batches[i]);
+    }
+    posix_readdirp_batch_fill(&batches[nbatches - 1]);
 
-        ret = posix_pstat(this, inode, gfid, hpath, &stbuf, _gf_false);
+    syncbarrier_wait(&barrier, launched);
+    syncbarrier_destroy(&barrier);
 
-        if (ret == -1) {
-            if (inode)
-                inode_unref(inode);
-            continue;
-        }
+    GF_FREE(array);
+    GF_FREE(batches);
 
-        posix_update_iatt_buf(&stbuf, -1, hpath, dict);
-
-        if (!inode)
-            inode = inode_find(itable, stbuf.ia_gfid);
+    return 0;
+}
 
-        if (!inode)
-            inode = inode_new(itable);
+int
+posix_readdirp_fill(xlator_t *this, fd_t *fd, gf_dirent_t *entries,
+                    dict_t *dict, int count)
+{
+    struct posix_private *priv = this->private;
+    struct posix_fd *pfd = NULL;
+    gf_dirent_t *entry = NULL;
+    char *hpath = NULL;
+    int dfd = -1;
+    int len = 0;
 
-        entry->inode = inode;
+    if (list_empty(&entries->list))
+        return 0;
 
-        if (dict) {
-            entry->dict = posix_entry_xattr_fill(this, entry->inode, fd, hpath,
-                                                 dict, &stbuf);
-        }
+    hpath = alloca(PATH_MAX);
+    len = posix_handle_path(this, fd->inode->gfid, NULL, hpath, PATH_MAX);
+    if (len <= 0) {
+        gf_msg(this->name, GF_LOG_WARNING, 0, P_MSG_HANDLEPATH_FAILED,
+               "Failed to create handle path, fd=%p, gfid=%s", fd,
+               uuid_utoa(fd->inode->gfid));
+        return -1;
+    }
+    len = strlen(hpath);
+    hpath[len] = '/';
 
-        entry->d_stat = stbuf;
-        if (stbuf.ia_ino)
-            entry->d_ino = stbuf.ia_ino;
+    /* Entries are stat'ed relative to the open directory, which saves
+     * resolving the handle path of the directory for each of them. */
+    if (posix_fd_ctx_get(fd, this, &pfd, NULL) == 0 && pfd->dir)
+        dfd = dirfd(pfd->dir);
 
-        if (entry->d_type == DT_UNKNOWN && !IA_ISINVAL(stbuf.ia_type)) {
-            /* The platform supports d_type but the underlying
-               filesystem doesn't. We set d_type to the correct
-               value from ia_type */
-            entry->d_type = gf_d_type_from_ia_type(stbuf.ia_type);
-        }
+    if (priv->parallel_readdirp && count >= 2 * POSIX_READDIRP_BATCH &&
+        this->ctx->env) {
+        if (posix_readdirp_fill_parallel(this, fd, dfd, entries, count,
+                                         dict, hpath, len) == 0)
+            return 0;
+    }
 
-        inode = NULL;
+    list_for_each_entry(entry, &entries->list, list)
+    {
+        posix_readdirp_fill_entry(this, fd, dfd, entry, dict, hpath, len);
     }
 
     return 0;
@@ -5778,7 +6004,7 @@ posix_do_readdir(call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
     if (whichop != GF_FOP_READDIRP)
         goto out;
 
-    posix_readdirp_fill(this, fd, &entries, dict);
+    posix_readdirp_fill(this, fd, &entries, dict, count);
 
 out:
     if (whichop == GF_FOP_READDIR)
@@ -5997,9 +6223,11 @@ posix_forget(xlator_t *this, inode_t *inode)
         ret = sys_unlink(unlink_path);
     }
 ctx_free:
+    posix_xattr_cache_unref(ctx->xattr_cache);
     pthread_mutex_destroy(&ctx->xattrop_lock);
     pthread_mutex_destroy(&ctx->write_atomic_lock);
     pthread_mutex_destroy(&ctx->pgfid_lock);
+    pthread_rwlock_destroy(&ctx->prealloc_lock);
     GF_FREE(ctx);
 
 check_ctx2:
@@ -115,4 +115,22 @@ posix_handle_init(xlator_t *this);
 int
 posix_handle_trash_init(xlator_t *this);
 
+int
+posix_handle_cache_init(xlator_t *this);
+
+void
+posix_handle_cache_fini(xlator_t *this);
+
+void
+posix_handle_cache_forget(xlator_t *this, uuid_t gfid);
+
+void
+posix_handle_cache_invalidate(xlator_t *this);
+
+void
+posix_handle_cache_resize(xlator_t *this, uint32_t limit);
+
+void
+posix_handle_cache_dump(xlator_t *this);
+
 #endif /* !_POSIX_INODE_HANDLE_H */
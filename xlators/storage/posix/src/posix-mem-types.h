@@ -22,6 +22,13 @@ enum gf_posix_mem_types_ {
     gf_posix_mt_mdata_attr,
     gf_posix_mt_uring_ctx,
     gf_posix_mt_diskxl_t,
+    gf_posix_mt_readdirp_batch_t,
+    gf_posix_mt_handle_cache_t,
+    gf_posix_mt_handle_cache_entry_t,
+    gf_posix_mt_mdata_dirty_t,
+    gf_posix_mt_fsync_group_t,
+    gf_posix_mt_xattr_cache_t,
+    gf_posix_mt_reclaim_t,
     gf_posix_mt_end
 };
 #endif
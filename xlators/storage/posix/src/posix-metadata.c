@@ -370,6 +370,158 @@ posix_compare_timespec(struct timespec *first, struct timespec *second)
         return first->tv_sec - second->tv_sec;
 }
 
+static gf_boolean_t
+posix_mdata_times_equal(posix_mdata_t *a, posix_mdata_t *b)
+{
+    return (posix_compare_timespec(&a->ctime, &b->ctime) == 0 &&
+            posix_compare_timespec(&a->mtime, &b->mtime) == 0 &&
+            posix_compare_timespec(&a->atime, &b->atime) == 0);
+}
+
+struct posix_mdata_dirty {
+    struct list_head list;
+    inode_t *inode;
+};
+
+/* Hands an inode whose mdata just became dirty to the flusher. The entry
+ * holds a ref, so the inode (and its mdata) stays around until flushed.
+ */
+static void
+posix_mdata_queue(xlator_t *this, inode_t *inode)
+{
+    struct posix_private *priv = this->private;
+    struct posix_mdata_dirty *entry = NULL;
+
+    entry = GF_MALLOC(sizeof(*entry), gf_posix_mt_mdata_dirty_t);
+    if (!entry) {
+        /* write it now instead */
+        posix_mdata_flush(this, inode, -1);
+        return;
+    }
+    entry->inode = inode_ref(inode);
+
+    pthread_mutex_lock(&priv->mdata_lock);
+    {
+        if (list_empty(&priv->mdata_dirty))
+            pthread_cond_signal(&priv->mdata_cond);
+        list_add_tail(&entry->list, &priv->mdata_dirty);
+        priv->mdata_dirty_count++;
+    }
+    pthread_mutex_unlock(&priv->mdata_lock);
+}
+
+/* Writes the in-memory mdata of @inode to disk if it is dirty. */
+void
+posix_mdata_flush(xlator_t *this, inode_t *inode, int fd)
+{
+    posix_mdata_t *mdata = NULL;
+    posix_mdata_disk_t disk_metadata;
+    char *real_path = NULL;
+    uint64_t ctx = 0;
+    int ret = 0;
+
+    LOCK(&inode->lock);
+    {
+        ret = __inode_ctx_get1(inode, this, &ctx);
+        mdata = (posix_mdata_t *)(uintptr_t)ctx;
+        if (ret != 0 || !mdata || !mdata->dirty)
+            goto unlock;
+
+        posix_mdata_to_disk(&disk_metadata, mdata);
+        if (fd != -1) {
+            ret = sys_fsetxattr(fd, GF_XATTR_MDATA_KEY, &disk_metadata,
+                                sizeof(disk_metadata), 0);
+        } else {
+            MAKE_HANDLE_PATH(real_path, this, inode->gfid, NULL);
+            ret = real_path ? sys_lsetxattr(real_path, GF_XATTR_MDATA_KEY,
+                                            &disk_metadata,
+                                            sizeof(disk_metadata), 0)
+                            : -1;
+        }
+
+        /* an unlinked file has nothing left to update */
+        if (ret == 0 || errno == ENOENT) {
+            mdata->dirty = 0;
+            goto unlock;
+        }
+
+        gf_msg(this->name, GF_LOG_ERROR, errno, P_MSG_STOREMDATA_FAILED,
+               "gfid: %s key:%s ", uuid_utoa(inode->gfid), GF_XATTR_MDATA_KEY);
+    }
+unlock:
+    UNLOCK(&inode->lock);
+}
+
+/* The mdata xattr on disk lags the inode while it is dirty, so whoever
+ * reads @name (all the xattrs when NULL) from disk writes it out first. */
+void
+posix_mdata_flush_key(xlator_t *this, inode_t *inode, int fd,
+                      const char *name)
+{
+    if (!inode)
+        return;
+    if (name && strcmp(name, GF_XATTR_MDATA_KEY) != 0)
+        return;
+
+    posix_mdata_flush(this, inode, fd);
+}
+
+/* Writes the mdata of the inodes dirtied since the last pass, once every
+ * mdata-flush-interval seconds. Whatever is dirty is written on exit.
+ *
+ * On a crash, up to an interval of time updates is lost. The xattr on disk
+ * never goes ahead of memory, and files whose xattr was never written are
+ * healed from the backend times on lookup, like files created before ctime
+ * was enabled. Replicas keep converging on the largest time as before.
+ */
+void *
+posix_mdata_flusher(void *data)
+{
+    xlator_t *this = data;
+    struct posix_private *priv = this->private;
+    struct posix_mdata_dirty *entry = NULL;
+    struct posix_mdata_dirty *tmp = NULL;
+    struct timespec deadline;
+    struct list_head head;
+    gf_boolean_t exit = _gf_false;
+
+    THIS = this;
+
+    while (!exit) {
+        INIT_LIST_HEAD(&head);
+
+        pthread_mutex_lock(&priv->mdata_lock);
+        {
+            while (!priv->mdata_flusher_exit &&
+                   list_empty(&priv->mdata_dirty))
+                pthread_cond_wait(&priv->mdata_cond, &priv->mdata_lock);
+
+            /* let updates to the same inodes pile up for an interval */
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_sec += priv->mdata_flush_interval;
+            while (!priv->mdata_flusher_exit &&
+                   pthread_cond_timedwait(&priv->mdata_cond, &priv->mdata_lock,
+                                          &deadline) != ETIMEDOUT)
+                ;
+
+            exit = priv->mdata_flusher_exit;
+            list_splice_init(&priv->mdata_dirty, &head);
+            priv->mdata_dirty_count = 0;
+        }
+        pthread_mutex_unlock(&priv->mdata_lock);
+
+        list_for_each_entry_safe(entry, tmp, &head, list)
+        {
+            list_del(&entry->list);
+            posix_mdata_flush(this, entry->inode, -1);
+            inode_unref(entry->inode);
+            GF_FREE(entry);
+        }
+    }
+
+    return NULL;
+}
+
 int
 posix_set_mdata_xattr_legacy_files(xlator_t *this, inode_t *inode,
                                    const char *realpath,
@@ -456,6 +608,7 @@ posix_set_mdata_xattr_legacy_files(xlator_t *this, inode_t *inode,
             *op_errno = errno;
             goto unlock;
         }
+        mdata->dirty = 0;
     }
 unlock:
     UNLOCK(&inode->lock);
@@ -473,8 +626,12 @@ posix_set_mdata_xattr(xlator_t *this, const char *real_path, int fd,
                       struct iatt *stbuf, posix_mdata_flag_t *flag,
                       gf_boolean_t update_utime)
 {
+    struct posix_private *priv = this->private;
     uint64_t ctx;
     posix_mdata_t *mdata = NULL;
+    posix_mdata_t old;
+    gf_boolean_t created = _gf_false;
+    gf_boolean_t queue = _gf_false;
     int ret = -1;
     int op_errno = 0;
 
@@ -549,12 +706,15 @@ posix_set_mdata_xattr(xlator_t *this, const char *real_path, int fd,
                 mdata->atime.tv_nsec = time->tv_nsec;
                 mdata->mtime.tv_sec = time->tv_sec;
                 mdata->mtime.tv_nsec = time->tv_nsec;
+                created = _gf_true;
 
                 ctx = (uint64_t)(uintptr_t)mdata;
                 __inode_ctx_set1(inode, this, &ctx);
             }
         }
 
+        old = *mdata;
+
         /* In distributed systems, there could be races with fops
          * updating mtime/atime which could result in different
          * mtime/atime for same file. So this makes sure, only the
@@ -598,11 +758,22 @@ posix_set_mdata_xattr(xlator_t *this, const char *real_path, int fd,
             /*  ret = posix_store_mdata_xattr (this, loc, fd,
              *                                 mdata); */
         }
-        /*
-         * With this patch set, we are setting the xattr for each update
-         * We should evaluate the performance, and based on that we can
-         * decide on asynchronous updation.
+        /* Only write what is newer than the xattr on disk. With
+         * mdata-flush-interval set, leave the write to the flusher, which
+         * coalesces all updates to an inode within the interval.
          */
+        if (!created && !old.dirty && posix_mdata_times_equal(&old, mdata)) {
+            ret = 0;
+            goto unlock;
+        }
+
+        if (priv->mdata_flush_interval && inode->ia_type != IA_INVAL) {
+            queue = !old.dirty;
+            mdata->dirty = 1;
+            ret = 0;
+            goto unlock;
+        }
+
         ret = posix_store_mdata_xattr(this, real_path, fd, inode, mdata);
         if (ret) {
             gf_msg(this->name, GF_LOG_ERROR, errno, P_MSG_STOREMDATA_FAILED,
@@ -610,9 +781,13 @@ posix_set_mdata_xattr(xlator_t *this, const char *real_path, int fd,
                    uuid_utoa(inode->gfid), GF_XATTR_MDATA_KEY);
             goto unlock;
         }
+        mdata->dirty = 0;
     }
 unlock:
     UNLOCK(&inode->lock);
+
+    if (queue)
+        posix_mdata_queue(this, inode);
 out:
     if (ret == 0 && stbuf) {
         stbuf->ia_ctime = mdata->ctime.tv_sec;
@@ -22,8 +22,10 @@ typedef struct {
     struct timespec atime;
     /* version of structure, bumped up if any new member is added */
     uint8_t version;
+    /* newer than the xattr on disk, see posix_mdata_flusher() */
+    uint8_t dirty;
 
-    char _pad[7]; /* manual padding */
+    char _pad[6]; /* manual padding */
 } posix_mdata_t;
 
 typedef struct {
@@ -67,5 +69,12 @@ posix_set_mdata_xattr_legacy_files(xlator_t *this, inode_t *inode,
                                    int *op_errno);
 void
 posix_mdata_iatt_from_disk(struct mdata_iatt *out, posix_mdata_disk_t *in);
+void
+posix_mdata_flush(xlator_t *this, inode_t *inode, int fd);
+void
+posix_mdata_flush_key(xlator_t *this, inode_t *inode, int fd,
+                      const char *name);
+void *
+posix_mdata_flusher(void *data);
 
 #endif /* _POSIX_METADATA_H */
@@ -32,6 +32,7 @@
 #include <glusterfs/timer.h>
 #include "posix-mem-types.h"
 #include <glusterfs/call-stub.h>
+#include <glusterfs/throttle-tbf.h>
 
 #ifdef HAVE_LIBAIO
 #include <libaio.h>
@@ -128,6 +129,11 @@ struct posix_fd {
     int32_t flags;         /* flags for open/creat      */
     DIR *dir;              /* handle returned by the kernel */
     off_t dir_eof;         /* offset at dir EOF */
+    /* sequential stream detection, see posix_stream_advise() */
+    off_t stream_next;    /* where the next sequential access starts */
+    off_t stream_run;     /* bytes accessed sequentially so far */
+    off_t stream_flushed; /* writeback started up to here */
+    off_t stream_dropped; /* page cache dropped up to here */
     struct list_head list; /* to add to the janitor list */
     int odirect;
     xlator_t *xl;
@@ -179,6 +185,29 @@ struct posix_private {
     pthread_cond_t fsync_cond;
     pthread_mutex_t janitor_mutex;
     pthread_cond_t janitor_cond;
+
+    /* write-back of the mdata xattr, see posix_mdata_flusher() */
+    pthread_t mdata_flusher;
+    pthread_mutex_t mdata_lock;
+    pthread_cond_t mdata_cond;
+    struct list_head mdata_dirty;
+    uint32_t mdata_dirty_count;
+    uint32_t mdata_flush_interval;
+    gf_boolean_t mdata_flusher_exit;
+
+    /* chunked freeing of large unlinked files, see posix_reclaimer() */
+    pthread_t reclaimer;
+    pthread_mutex_t reclaim_lock;
+    pthread_cond_t reclaim_cond;
+    struct list_head reclaim_queue;
+    struct posix_reclaim *reclaim_current;
+    uint32_t reclaim_count;
+    uint64_t reclaim_pending; /* bytes left in the queued files */
+    uint64_t reclaim_freed;   /* bytes punched out so far */
+    uint64_t reclaim_threshold;
+    uint64_t reclaim_rate;
+    tbf_t *reclaim_tbf;
+    gf_boolean_t reclaimer_exit;
     pthread_cond_t fd_cond;
     pthread_cond_t disk_cond;
     int fsync_queue_count;
@@ -189,10 +218,16 @@ struct posix_private {
         BATCH_SYNCFS,
         BATCH_SYNCFS_SINGLE_FSYNC,
         BATCH_REVERSE_FSYNC,
-        BATCH_SYNCFS_REVERSE_FSYNC
+        BATCH_SYNCFS_REVERSE_FSYNC,
+        BATCH_GROUP_COMMIT
     } batch_fsync_mode;
 
     uint32_t batch_fsync_delay_usec;
+    /* group-commit: smoothed gap between batched fsyncs, and counters */
+    struct timespec fsync_last;
+    uint32_t fsync_gap_usec;
+    gf_atomic_t fsync_batches;
+    gf_atomic_t fsync_groups;
     char gfid2path_sep[8];
 
     /* seconds to sleep between health checks */
@@ -233,6 +268,24 @@ struct posix_private {
 
     gf_boolean_t fips_mode_rchecksum;
     gf_boolean_t ctime;
+    gf_boolean_t parallel_readdirp;
+
+    /* serve lookup xattrs from a per-inode snapshot, see
+     * posix_xattr_cache_get() */
+    gf_boolean_t xattr_cache;
+    gf_atomic_t xattr_cache_hits;
+    gf_atomic_t xattr_cache_misses;
+
+    /* drop the page cache behind fds streaming more than this */
+    uint64_t stream_drop_behind;
+    gf_atomic_t streams_detected;
+
+    /* the brick cannot linkat() an fd, see posix_handle_hard_fd() */
+    gf_boolean_t no_handle_link_fd;
+
+    /* gfid -> path cache for directory handles, see posix-handle.c */
+    struct posix_handle_cache *handle_cache;
+    uint32_t handle_cache_size;
     gf_boolean_t janitor_task_stop;
 
     char disk_unit;
@@ -293,6 +346,7 @@ typedef struct {
     int flags;
     char *list;
     size_t list_size;
+    struct posix_xattr_cache *cache; /* values of the names in list */
     int32_t op_errno;
 
     char _pad[4]; /* manual padding */
@@ -303,6 +357,10 @@ typedef struct {
     pthread_mutex_t xattrop_lock;
     pthread_mutex_t write_atomic_lock;
     pthread_mutex_t pgfid_lock;
+    /* shared by the fops that write data, exclusive for the trim of the
+       append preallocation, see posix_ftruncate() */
+    pthread_rwlock_t prealloc_lock;
+    struct posix_xattr_cache *xattr_cache; /* under inode->lock */
 } posix_inode_ctx_t;
 
 #define POSIX_BASE_PATH(this)                                                  \
@@ -348,6 +406,22 @@ int
 posix_gfid_set(xlator_t *this, const char *path, loc_t *loc, dict_t *xattr_req,
                pid_t pid, int *op_errno);
 int
+posix_gfid_set_fd(xlator_t *this, int fd, const char *path, loc_t *loc,
+                  dict_t *xattr_req, pid_t pid, int *op_errno);
+void
+posix_xattr_cache_invalidate(xlator_t *this, inode_t *inode);
+
+void
+posix_xattr_cache_unref(struct posix_xattr_cache *cache);
+
+void
+posix_stream_advise(xlator_t *this, struct posix_fd *pfd, off_t offset,
+                    size_t len, gf_boolean_t write);
+
+ssize_t
+posix_copy_range(int fd_in, off64_t off_in, int fd_out, off64_t off_out,
+                 size_t len, uint32_t flags);
+int
 posix_fdstat(xlator_t *this, inode_t *inode, int fd, struct iatt *stbuf_p);
 int
 posix_istat(xlator_t *this, inode_t *inode, uuid_t gfid, const char *basename,
@@ -355,6 +429,9 @@ posix_istat(xlator_t *this, inode_t *inode, uuid_t gfid, const char *basename,
 int
 posix_pstat(xlator_t *this, inode_t *inode, uuid_t gfid, const char *real_path,
             struct iatt *iatt, gf_boolean_t inode_locked);
+int
+posix_pstatat(xlator_t *this, inode_t *inode, uuid_t gfid, int dirfd,
+              const char *name, const char *path, struct iatt *buf_p);
 
 dict_t *
 posix_xattr_fill(xlator_t *this, const char *path, loc_t *loc, fd_t *fd,
@@ -396,6 +473,22 @@ posix_spawn_disk_space_check_thread(xlator_t *this);
 
 void *
 posix_fsyncer(void *);
+
+void *
+posix_reclaimer(void *);
+
+int
+posix_reclaim_queue(xlator_t *this, int fd, uuid_t gfid);
+
+int
+posix_reclaim_set_rate(xlator_t *this);
+
+void
+posix_reclaim_dump(xlator_t *this);
+
+uint32_t
+posix_group_commit_cap(struct posix_private *priv);
+
 int
 posix_get_ancestry(xlator_t *this, inode_t *leaf_inode, gf_dirent_t *head,
                    char **path, int type, int32_t *op_errno, dict_t *xdata);